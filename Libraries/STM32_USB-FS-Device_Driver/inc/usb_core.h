@@ -253,6 +253,8 @@ extern DEVICE_INFO Device_Info;
 /* cells saving status during interrupt servicing */
 extern __IO uint16_t SaveRState;
 extern __IO uint16_t SaveTState;
+/* RX packet of the transfer in CTR_LP_Service(), NULL: read the PMA */
+extern uint8_t *pCtrRxData;
 
 #endif /* __USB_CORE_H */
 
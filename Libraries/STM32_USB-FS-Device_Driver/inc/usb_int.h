@@ -32,11 +32,28 @@
 
 /* Includes ------------------------------------------------------------------*/
 /* Exported types ------------------------------------------------------------*/
+#ifndef CTR_EVENT_RX_SIZE
+#define CTR_EVENT_RX_SIZE 64  /* endpoint 0 max packet size */
+#endif
+
+/* Control endpoint transfer captured in the ISR, serviced later */
+typedef struct _CTR_EVENT
+{
+  uint16_t wIstr;     /* ISTR CTR, DIR and EP_ID bits of the transfer */
+  uint16_t wEPVal;    /* endpoint register value at the interrupt */
+  uint16_t wRState;   /* RX status before the endpoint was NAKed */
+  uint16_t wTState;   /* TX status before the endpoint was NAKed */
+  uint16_t wRxCount;  /* bytes in wRxData, SETUP or OUT only */
+  uint16_t wRxData[CTR_EVENT_RX_SIZE / 2]; /* copy of the RX buffer */
+} CTR_EVENT;
+
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
 void CTR_LP(void);
 void CTR_HP(void);
+uint8_t CTR_LP_Capture(CTR_EVENT *pEvt);
+void CTR_LP_Service(CTR_EVENT const *pEvt);
 
 /* External variables --------------------------------------------------------*/
 
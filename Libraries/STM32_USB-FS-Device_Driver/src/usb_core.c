@@ -461,7 +461,19 @@ void DataStageOut(void)
     Buffer = (*pEPinfo->CopyData)(Length);
     pEPinfo->Usb_rLength -= Length;
     pEPinfo->Usb_rOffset += Length;
-    PMAToUserBufferCopy(Buffer, GetEPRxAddr(ENDP0), Length);
+    if (pCtrRxData != NULL)
+    {
+      /* deferred: packet copied by CTR_LP_Capture() */
+      uint32_t i;
+      for (i = 0; i < Length; i++)
+      {
+        Buffer[i] = pCtrRxData[i];
+      }
+    }
+    else
+    {
+      PMAToUserBufferCopy(Buffer, GetEPRxAddr(ENDP0), Length);
+    }
 
   }
 
@@ -869,7 +881,16 @@ uint8_t Setup0_Process(void)
   } pBuf;
   uint16_t offset = 1;
   
-  pBuf.b = PMAAddr + (uint8_t *)(_GetEPRxAddr(ENDP0) * 2); /* *2 for 32 bits addr */
+  if (pCtrRxData != NULL)
+  {
+    /* deferred: packet copied by CTR_LP_Capture(), no 32 bits addressing */
+    pBuf.b = pCtrRxData;
+    offset = 0;
+  }
+  else
+  {
+    pBuf.b = PMAAddr + (uint8_t *)(_GetEPRxAddr(ENDP0) * 2); /* *2 for 32 bits addr */
+  }
 
   if (pInformation->ControlState != PAUSE)
   {
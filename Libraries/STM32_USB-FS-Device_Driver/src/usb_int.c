@@ -34,6 +34,7 @@
 /* Private variables ---------------------------------------------------------*/
 __IO uint16_t SaveRState;
 __IO uint16_t SaveTState;
+uint8_t *pCtrRxData;
 
 /* Extern variables ----------------------------------------------------------*/
 extern void (*pEpInt_IN[7])(void);    /*  Handles IN  interrupts   */
@@ -150,6 +151,127 @@ void CTR_LP(void)
   }/* while(...) */
 }
 
+/*******************************************************************************
+* Function Name  : CTR_LP_Capture.
+* Description    : Deferred variant of CTR_LP() for the interrupt side.
+*                  Non control endpoints are serviced here as in CTR_LP().
+*                  A control endpoint transfer is only captured: endpoint 0
+*                  is NAKed in both directions, its interrupt flag cleared
+*                  and its state saved to pEvt, to be serviced at task
+*                  level by CTR_LP_Service(). The host retries the NAKed
+*                  transactions until then. A received packet is copied
+*                  too: a SETUP is ACKed even while the endpoint is NAKed
+*                  and would overwrite the RX buffer before the service.
+* Input          : pEvt: where to save a control endpoint transfer.
+* Output         : None.
+* Return         : 1 if a control endpoint transfer was captured, 0 if no
+*                  transfer is pending anymore.
+*******************************************************************************/
+uint8_t CTR_LP_Capture(CTR_EVENT *pEvt)
+{
+  uint16_t wEPVal;
+  uint16_t wCount;
+  /* stay in loop while pending interrupts */
+  while (((wIstr = _GetISTR()) & ISTR_CTR) != 0)
+  {
+    /* extract highest priority endpoint number */
+    EPindex = (uint8_t)(wIstr & ISTR_EP_ID);
+    if (EPindex == 0)
+    {
+      /* save RX & TX status and set both to NAK */
+      wEPVal = _GetENDPOINT(ENDP0);
+      /* the transfer only, a RESET flag set meanwhile is not its kind */
+      pEvt->wIstr = wIstr & (ISTR_CTR | ISTR_DIR | ISTR_EP_ID);
+      pEvt->wEPVal = wEPVal;
+      pEvt->wRState = wEPVal & EPRX_STAT;
+      pEvt->wTState = wEPVal & EPTX_STAT;
+
+      _SetEPRxTxStatus(ENDP0,EP_RX_NAK,EP_TX_NAK);
+
+      if ((wIstr & ISTR_DIR) == 0)
+      {
+        /* DIR = 0 => IN int */
+        _ClearEP_CTR_TX(ENDP0);
+      }
+      else
+      {
+        /* DIR = 1 => SETUP or OUT int, SETUP bit saved in wEPVal above */
+        wCount = _GetEPRxCount(ENDP0);
+        if (wCount > CTR_EVENT_RX_SIZE)
+        {
+          wCount = CTR_EVENT_RX_SIZE;
+        }
+        pEvt->wRxCount = wCount;
+        PMAToUserBufferCopy((uint8_t *)pEvt->wRxData, _GetEPRxAddr(ENDP0), wCount);
+
+        _ClearEP_CTR_RX(ENDP0);
+      }
+      return 1;
+    }
+    else
+    {
+      /* process related endpoint register */
+      wEPVal = _GetENDPOINT(EPindex);
+      if ((wEPVal & EP_CTR_RX) != 0)
+      {
+        /* clear int flag */
+        _ClearEP_CTR_RX(EPindex);
+
+        /* call OUT service function */
+        (*pEpInt_OUT[EPindex-1])();
+      }
+
+      if ((wEPVal & EP_CTR_TX) != 0)
+      {
+        /* clear int flag */
+        _ClearEP_CTR_TX(EPindex);
+
+        /* call IN service function */
+        (*pEpInt_IN[EPindex-1])();
+      }
+    }
+  }
+  return 0;
+}
+
+/*******************************************************************************
+* Function Name  : CTR_LP_Service.
+* Description    : Deferred variant of CTR_LP() for the task side. Runs the
+*                  control endpoint state machine for a transfer captured by
+*                  CTR_LP_Capture(), then sets the endpoint 0 status.
+*                  Transfers must be serviced in the order of capture,
+*                  with the USB interrupt masked: the endpoint registers
+*                  are read-modify-written here and by the interrupt.
+* Input          : pEvt: control endpoint transfer.
+* Output         : None.
+* Return         : None.
+*******************************************************************************/
+void CTR_LP_Service(CTR_EVENT const *pEvt)
+{
+  SaveRState = pEvt->wRState;
+  SaveTState = pEvt->wTState;
+  /* SETUP and OUT data come from the copy, not from the PMA */
+  pCtrRxData = (uint8_t *)pEvt->wRxData;
+
+  if ((pEvt->wIstr & ISTR_DIR) == 0)
+  {
+    In0_Process();
+  }
+  else if ((pEvt->wEPVal & EP_SETUP) != 0)
+  {
+    Setup0_Process();
+  }
+  else
+  {
+    Out0_Process();
+  }
+
+  pCtrRxData = NULL;
+
+  /* before terminate set Tx & Rx status */
+  _SetEPRxTxStatus(ENDP0,SaveRState,SaveTState);
+}
+
 /*******************************************************************************
 * Function Name  : CTR_HP.
 * Description    : High Priority Endpoint Correct Transfer interrupt's service 
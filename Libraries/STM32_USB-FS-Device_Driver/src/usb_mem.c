@@ -31,6 +31,9 @@
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
+/* The PMA is 16 bits wide but mapped on 32-bit words: the halfword n of a
+   buffer lives at byte offset 4*n of the APB1 view, the upper half reads 0 */
+#define PMA_PTR(wPMABufAddr)  ((uint32_t *)((wPMABufAddr) * 2 + PMAAddr))
 /* Private variables ---------------------------------------------------------*/
 /* Extern variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
@@ -39,6 +42,9 @@
 /*******************************************************************************
 * Function Name  : UserToPMABufferCopy
 * Description    : Copy a buffer from user memory area to packet memory area (PMA)
+*                  A word aligned source is read one word per two PMA
+*                  halfwords, 8 bytes per loop pass; any other source is read
+*                  bytewise, unrolled the same way.
 * Input          : - pbUsrBuf: pointer to user memory area.
 *                  - wPMABufAddr: address into PMA.
 *                  - wNBytes: no. of bytes to be copied.
@@ -47,24 +53,62 @@
 *******************************************************************************/
 void UserToPMABufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
 {
-  uint32_t n = (wNBytes + 1) >> 1;   /* n = (wNBytes + 1) / 2 */
-  uint32_t i, temp1, temp2;
+  uint32_t n = wNBytes >> 3;         /* n = wNBytes / 8 */
+  uint32_t temp1, temp2;
   uint16_t *pdwVal;
-  pdwVal = (uint16_t *)(wPMABufAddr * 2 + PMAAddr);
-  for (i = n; i != 0; i--)
+  pdwVal = (uint16_t *)PMA_PTR(wPMABufAddr);
+
+  if (((uint32_t)pbUsrBuf & 3) == 0)
+  {
+    /* aligned source: two word loads feed four PMA halfwords */
+    uint32_t *pwUsrBuf = (uint32_t *)pbUsrBuf;
+    for (; n != 0; n--)
+    {
+      temp1 = pwUsrBuf[0];
+      temp2 = pwUsrBuf[1];
+      pdwVal[0] = (uint16_t)temp1;
+      pdwVal[2] = (uint16_t)(temp1 >> 16);
+      pdwVal[4] = (uint16_t)temp2;
+      pdwVal[6] = (uint16_t)(temp2 >> 16);
+      pdwVal += 8;
+      pwUsrBuf += 2;
+    }
+    pbUsrBuf = (uint8_t *)pwUsrBuf;
+  }
+  else
   {
-    temp1 = (uint16_t) * pbUsrBuf;
-    pbUsrBuf++;
-    temp2 = temp1 | (uint16_t) * pbUsrBuf << 8;
-    *pdwVal++ = temp2;
-    pdwVal++;
-    pbUsrBuf++;
+    /* unaligned source: assemble the halfwords bytewise */
+    for (; n != 0; n--)
+    {
+      pdwVal[0] = (uint16_t)(pbUsrBuf[0] | (pbUsrBuf[1] << 8));
+      pdwVal[2] = (uint16_t)(pbUsrBuf[2] | (pbUsrBuf[3] << 8));
+      pdwVal[4] = (uint16_t)(pbUsrBuf[4] | (pbUsrBuf[5] << 8));
+      pdwVal[6] = (uint16_t)(pbUsrBuf[6] | (pbUsrBuf[7] << 8));
+      pdwVal += 8;
+      pbUsrBuf += 8;
+    }
+  }
+
+  /* remaining 0..7 bytes */
+  for (n = (wNBytes & 7) >> 1; n != 0; n--)
+  {
+    *pdwVal = (uint16_t)(pbUsrBuf[0] | (pbUsrBuf[1] << 8));
+    pdwVal += 2;
+    pbUsrBuf += 2;
+  }
+  if (wNBytes & 1)
+  {
+    /* the last byte goes alone, the source is not read past its end */
+    *pdwVal = (uint16_t)pbUsrBuf[0];
   }
 }
 
 /*******************************************************************************
 * Function Name  : PMAToUserBufferCopy
-* Description    : Copy a buffer from user memory area to packet memory area (PMA)
+* Description    : Copy a buffer from packet memory area (PMA) to user memory area
+*                  A word aligned destination is written one word per two PMA
+*                  halfwords, 8 bytes per loop pass; any other destination is
+*                  written bytewise. Exactly wNBytes bytes are written.
 * Input          : - pbUsrBuf    = pointer to user memory area.
 *                  - wPMABufAddr = address into PMA.
 *                  - wNBytes     = no. of bytes to be copied.
@@ -73,14 +117,60 @@ void UserToPMABufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNByt
 *******************************************************************************/
 void PMAToUserBufferCopy(uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes)
 {
-  uint32_t n = (wNBytes + 1) >> 1;/* /2*/
-  uint32_t i;
+  uint32_t n = wNBytes >> 3;         /* n = wNBytes / 8 */
+  uint32_t temp1, temp2;
   uint32_t *pdwVal;
-  pdwVal = (uint32_t *)(wPMABufAddr * 2 + PMAAddr);
-  for (i = n; i != 0; i--)
+  pdwVal = PMA_PTR(wPMABufAddr);
+
+  if (((uint32_t)pbUsrBuf & 3) == 0)
+  {
+    /* aligned destination: four PMA halfwords feed two word stores */
+    uint32_t *pwUsrBuf = (uint32_t *)pbUsrBuf;
+    for (; n != 0; n--)
+    {
+      temp1 = (pdwVal[0] & 0xFFFF) | (pdwVal[1] << 16);
+      temp2 = (pdwVal[2] & 0xFFFF) | (pdwVal[3] << 16);
+      pwUsrBuf[0] = temp1;
+      pwUsrBuf[1] = temp2;
+      pdwVal += 4;
+      pwUsrBuf += 2;
+    }
+    pbUsrBuf = (uint8_t *)pwUsrBuf;
+  }
+  else
+  {
+    /* unaligned destination: store the halfwords bytewise */
+    for (; n != 0; n--)
+    {
+      temp1 = pdwVal[0];
+      temp2 = pdwVal[1];
+      pbUsrBuf[0] = (uint8_t)temp1;
+      pbUsrBuf[1] = (uint8_t)(temp1 >> 8);
+      pbUsrBuf[2] = (uint8_t)temp2;
+      pbUsrBuf[3] = (uint8_t)(temp2 >> 8);
+      temp1 = pdwVal[2];
+      temp2 = pdwVal[3];
+      pbUsrBuf[4] = (uint8_t)temp1;
+      pbUsrBuf[5] = (uint8_t)(temp1 >> 8);
+      pbUsrBuf[6] = (uint8_t)temp2;
+      pbUsrBuf[7] = (uint8_t)(temp2 >> 8);
+      pdwVal += 4;
+      pbUsrBuf += 8;
+    }
+  }
+
+  /* remaining 0..7 bytes */
+  for (n = (wNBytes & 7) >> 1; n != 0; n--)
+  {
+    temp1 = *pdwVal++;
+    pbUsrBuf[0] = (uint8_t)temp1;
+    pbUsrBuf[1] = (uint8_t)(temp1 >> 8);
+    pbUsrBuf += 2;
+  }
+  if (wNBytes & 1)
   {
-    *(uint16_t*)pbUsrBuf++ = *pdwVal++;
-    pbUsrBuf++;
+    /* the last byte only, the user buffer is not written past its end */
+    pbUsrBuf[0] = (uint8_t)*pdwVal;
   }
 }
 
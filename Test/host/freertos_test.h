@@ -0,0 +1,129 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#ifndef _FREERTOS_TEST_H
+#define _FREERTOS_TEST_H
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* for the kernel's event pools and queues */
+#define QP_IMPL
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "qpc.h"
+#include "qf_pkg.h"
+
+#include "bsp_dwt.h"
+
+#include "test.h"
+
+Q_DEFINE_THIS_MODULE( "freertos_test" )
+
+/*
+ * the QP/C port to FreeRTOS on the FreeRTOS kernel itself, with the host
+ * portable layer in port/freertos. the test starts its active objects and
+ * runs QF_run(), every pass of the idle task calls freertos_test_idle(),
+ * which plays the interrupts with vPortHostInterrupt() and the ticks with
+ * vPortHostTick(), and ends the run with freertos_test_end().
+ *
+ * the cycle counter is virtual: it only moves by freertos_test_work(), so
+ * the run time statistics of the run are exact.
+ */
+
+static void freertos_test_idle( void );
+
+static jmp_buf freertos_test_done;
+static uint8_t freertos_test_ended;
+static uint64_t freertos_test_cycles;
+
+void Q_onAssert( char const * const module, int_t const location )
+{
+	/* QF_run() after the scheduler returned */
+	if( freertos_test_ended && 0 == strcmp( module, "qf_port" ) && 110 == location )
+	{
+		longjmp( freertos_test_done, 1 );
+	}
+
+	printf( "assert %s:%d\n", module, (int)location );
+	exit( 1 );
+}
+
+void QF_onStartup( void )
+{
+}
+
+void QF_onCleanup( void )
+{
+}
+
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+									StackType_t **ppxIdleTaskStackBuffer,
+									uint32_t *pulIdleTaskStackSize )
+{
+	static StaticTask_t tcb;
+	static StackType_t stack[ configMINIMAL_STACK_SIZE ];
+
+	*ppxIdleTaskTCBBuffer = &tcb;
+	*ppxIdleTaskStackBuffer = stack;
+	*pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+/* as main.c: the FreeRTOS tick drives the QF ticks */
+void vApplicationTickHook( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QF_TICK_X_FROM_ISR( 0U, &woken, (void *)0 );
+	portEND_SWITCHING_ISR( woken );
+}
+
+void vApplicationIdleHook( void )
+{
+	if( !freertos_test_ended )
+	{
+		freertos_test_idle();
+	}
+}
+
+void bsp_dwt_init( void )
+{
+	freertos_test_cycles = 0;
+}
+
+uint64_t bsp_dwt_get_cycles64( void )
+{
+	return freertos_test_cycles;
+}
+
+/* the running task or interrupt spends this many cycles */
+static inline void freertos_test_work( uint32_t cycles )
+{
+	freertos_test_cycles += cycles;
+}
+
+/* from the idle hook: stop the scheduler, QF_run() comes back */
+static void freertos_test_end( void )
+{
+	freertos_test_ended = 1;
+	vTaskEndScheduler();
+}
+
+/* start the active objects before, return after freertos_test_end() */
+static void freertos_test_run( void )
+{
+	if( 0 == setjmp( freertos_test_done ) )
+	{
+		(void)QF_run();
+	}
+}
+
+#endif /* _FREERTOS_TEST_H */
@@ -0,0 +1,197 @@
+/* host portable layer of the FreeRTOS kernel, see portmacro.h. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* host stacks, the target stack buffers given to the kernel are too small
+ * for the host code and only hold the fill pattern.
+ */
+#define HOST_STACK_SIZE		( 256U * 1024U )
+
+typedef struct
+{
+	ucontext_t uc;
+	TaskFunction_t code;
+	void *param;
+} HOST_TASK;
+
+/* the first member of the TCB is pxTopOfStack, which holds the HOST_TASK */
+typedef struct
+{
+	HOST_TASK *volatile task;
+} HOST_TCB;
+
+extern HOST_TCB *volatile pxCurrentTCB;
+
+static ucontext_t host_main;		/* of vTaskStartScheduler() */
+static uint8_t host_running;
+static uint32_t host_masked;		/* BASEPRI raised */
+static UBaseType_t host_nesting;	/* critical sections */
+static uint8_t host_isr;			/* running an interrupt */
+static uint8_t host_pend;			/* PendSV pending */
+
+void vPortHostAssert( char const *file, int line )
+{
+	printf( "configASSERT %s:%d\n", file, line );
+	exit( 1 );
+}
+
+static void host_entry( uint32_t lo, uint32_t hi )
+{
+	HOST_TASK *t = (HOST_TASK *)( ( (uintptr_t)hi << 16 << 16 ) | lo );
+
+	t->code( t->param );
+
+	/* a FreeRTOS task must not return */
+	vPortHostAssert( __FILE__, __LINE__ );
+}
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t pxCode, void *pvParameters )
+{
+	HOST_TASK *t = calloc( 1, sizeof( HOST_TASK ) );
+	uintptr_t p = (uintptr_t)t;
+
+	(void)pxTopOfStack;
+
+	configASSERT( t != NULL );
+	t->code = pxCode;
+	t->param = pvParameters;
+
+	getcontext( &t->uc );
+	t->uc.uc_stack.ss_sp = malloc( HOST_STACK_SIZE );
+	t->uc.uc_stack.ss_size = HOST_STACK_SIZE;
+	t->uc.uc_link = NULL;
+	configASSERT( t->uc.uc_stack.ss_sp != NULL );
+
+	makecontext( &t->uc, (void ( * )( void ))host_entry, 2, (uint32_t)p, (uint32_t)( p >> 16 >> 16 ) );
+
+	return (StackType_t *)t;
+}
+
+/* the PendSV handler */
+static void host_switch( void )
+{
+	HOST_TASK *from = pxCurrentTCB->task;
+
+	host_pend = 0;
+	vTaskSwitchContext();
+
+	if( pxCurrentTCB->task != from )
+	{
+		swapcontext( &from->uc, &pxCurrentTCB->task->uc );
+	}
+}
+
+static void host_pendsv( void )
+{
+	if( host_pend && host_running && !host_masked && !host_isr )
+	{
+		host_switch();
+	}
+}
+
+BaseType_t xPortStartScheduler( void )
+{
+	host_running = 1;
+	host_masked = 0;
+	host_nesting = 0;
+	host_pend = 0;
+
+	swapcontext( &host_main, &pxCurrentTCB->task->uc );
+
+	/* back from vPortEndScheduler() */
+	host_running = 0;
+	host_masked = 0;
+
+	return pdFALSE;
+}
+
+void vPortEndScheduler( void )
+{
+	swapcontext( &pxCurrentTCB->task->uc, &host_main );
+}
+
+void vPortYield( void )
+{
+	host_pend = 1;
+	host_pendsv();
+}
+
+void vPortDisableInterrupts( void )
+{
+	host_masked = 1;
+}
+
+void vPortEnableInterrupts( void )
+{
+	host_masked = 0;
+	host_pendsv();
+}
+
+void vPortEnterCritical( void )
+{
+	vPortDisableInterrupts();
+	++host_nesting;
+}
+
+void vPortExitCritical( void )
+{
+	configASSERT( host_nesting != 0 );
+
+	if( 0 == --host_nesting )
+	{
+		vPortEnableInterrupts();
+	}
+}
+
+uint32_t ulPortSetInterruptMask( void )
+{
+	uint32_t mask = host_masked;
+
+	host_masked = 1;
+	return mask;
+}
+
+void vPortClearInterruptMask( uint32_t ulMask )
+{
+	host_masked = ulMask;
+	host_pendsv();
+}
+
+void vPortHostInterrupt( void ( *isr )( void ) )
+{
+	/* not nested and not while the task masks them */
+	configASSERT( !host_isr && !host_masked );
+
+	host_isr = 1;
+	isr();
+	host_isr = 0;
+
+	host_pendsv();
+}
+
+uint32_t __get_IPSR( void )
+{
+	/* SysTick or any other, only 0 matters */
+	return host_isr ? 15U : 0U;
+}
+
+static void host_tick_isr( void )
+{
+	uint32_t mask = ulPortSetInterruptMask();
+
+	if( xTaskIncrementTick() != pdFALSE )
+	{
+		host_pend = 1;
+	}
+	vPortClearInterruptMask( mask );
+}
+
+void vPortHostTick( void )
+{
+	vPortHostInterrupt( host_tick_isr );
+}
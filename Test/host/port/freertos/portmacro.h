@@ -0,0 +1,77 @@
+/* host portable layer of the FreeRTOS kernel, for the tests that run the
+ * real tasks.c with the QP/C port to FreeRTOS.
+ *
+ * one thread of execution, the tasks are ucontext coroutines with stacks
+ * of their own. a yield switches at once, or when the critical section or
+ * the interrupt that asked for it ends, as the PendSV does on the target.
+ * the test plays the interrupts and the ticks from the idle hook, see
+ * vPortHostInterrupt() and vPortHostTick().
+ */
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+#define portCHAR		char
+#define portFLOAT		float
+#define portDOUBLE		double
+#define portLONG		long
+#define portSHORT		short
+#define portSTACK_TYPE	uintptr_t
+#define portBASE_TYPE	long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+typedef uint32_t TickType_t;
+#define portMAX_DELAY ( TickType_t ) 0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC 1
+
+#define portSTACK_GROWTH			( -1 )
+#define portTICK_PERIOD_MS			( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT			8
+
+void vPortYield( void );
+void vPortEnterCritical( void );
+void vPortExitCritical( void );
+void vPortDisableInterrupts( void );
+void vPortEnableInterrupts( void );
+uint32_t ulPortSetInterruptMask( void );
+void vPortClearInterruptMask( uint32_t ulMask );
+
+#define portYIELD()									vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )	if( xSwitchRequired != pdFALSE ) portYIELD()
+#define portYIELD_FROM_ISR( x )						portEND_SWITCHING_ISR( x )
+
+#define portDISABLE_INTERRUPTS()				vPortDisableInterrupts()
+#define portENABLE_INTERRUPTS()					vPortEnableInterrupts()
+#define portENTER_CRITICAL()					vPortEnterCritical()
+#define portEXIT_CRITICAL()						vPortExitCritical()
+#define portSET_INTERRUPT_MASK_FROM_ISR()		ulPortSetInterruptMask()
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )	vPortClearInterruptMask( x )
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#define portNOP()
+#define portINLINE			__inline
+#define portFORCE_INLINE	inline __attribute__(( always_inline ))
+
+/* run isr() as an interrupt of the running task, then switch if it asked */
+void vPortHostInterrupt( void ( *isr )( void ) );
+
+/* one SysTick interrupt */
+void vPortHostTick( void );
+
+/* the test runs from the idle hook, a kernel assertion fails the test */
+#undef configUSE_IDLE_HOOK
+#define configUSE_IDLE_HOOK	1
+
+void vPortHostAssert( char const *file, int line );
+
+#undef configASSERT
+#define configASSERT( x )	if( ( x ) == 0 ) vPortHostAssert( __FILE__, __LINE__ )
+
+#endif /* PORTMACRO_H */
@@ -0,0 +1,23 @@
+/* host QK port: QK_ISR_EXIT() as on the target, the test runs the pended
+ * PendSV, which calls QK_activate_() as the target activator does.
+ */
+
+#ifndef qk_port_h
+#define qk_port_h
+
+#define QK_ISR_CONTEXT_()	( qp_host_isr != 0U )
+
+#define QK_ISR_ENTRY()		( (void)0 )
+
+#define QK_ISR_EXIT() do { \
+	QF_INT_DISABLE(); \
+	if( QK_sched_() != (uint_fast8_t)0 ) \
+	{ \
+		qp_host_pendsv = 1U; \
+	} \
+	QF_INT_ENABLE(); \
+} while( 0 )
+
+#include "qk.h"
+
+#endif /* qk_port_h */
@@ -0,0 +1,17 @@
+/* host stand-in for the kernel ports: one thread of execution, the test
+ * plays the interrupts. the critical section is a flag the test checks for
+ * nesting, the ISR context and the pended PendSV are flags it sets.
+ */
+
+#ifndef qp_host_h
+#define qp_host_h
+
+#include <stdint.h>
+
+extern uint8_t qp_host_isr;		/* running an "interrupt" */
+extern uint8_t qp_host_pendsv;	/* the kernel asked for PendSV */
+
+void qp_host_int_disable( void );
+void qp_host_int_enable( void );
+
+#endif /* qp_host_h */
@@ -0,0 +1,11 @@
+/* host QEP port for the kernel tests, as the target one. */
+
+#ifndef qep_port_h
+#define qep_port_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "qep.h"
+
+#endif /* qep_port_h */
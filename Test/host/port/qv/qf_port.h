@@ -0,0 +1,20 @@
+/* host QF port for the QV kernel test, see qp_host.h. */
+
+#ifndef qf_port_h
+#define qf_port_h
+
+#define QF_MAX_ACTIVE			8
+#define QF_MAX_TICK_RATE		1
+
+#define QF_INT_DISABLE()		qp_host_int_disable()
+#define QF_INT_ENABLE()			qp_host_int_enable()
+
+#define QF_CRIT_ENTRY( dummy )	QF_INT_DISABLE()
+#define QF_CRIT_EXIT( dummy )	QF_INT_ENABLE()
+
+#include "qp_host.h"
+#include "qep_port.h"
+#include "qv_port.h"
+#include "qf.h"
+
+#endif /* qf_port_h */
@@ -0,0 +1,12 @@
+/* host QV port: no sleep, QV_CPU_SLEEP() only enables the interrupts the
+ * target enables while it enters WFI.
+ */
+
+#ifndef qv_port_h
+#define qv_port_h
+
+#define QV_CPU_SLEEP()		QF_INT_ENABLE()
+
+#include "qv.h"
+
+#endif /* qv_port_h */
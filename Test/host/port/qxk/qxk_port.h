@@ -0,0 +1,27 @@
+/* host QXK port: basic threads only, there is no private stack to switch
+ * to. QXK_CONTEXT_SWITCH_() pends PendSV as on the target, the test runs it
+ * after the interrupt and QXK_activate_() the way the target handler
+ * returns to it.
+ */
+
+#ifndef qxk_port_h
+#define qxk_port_h
+
+#define QXK_ISR_CONTEXT_()		( qp_host_isr != 0U )
+
+#define QXK_CONTEXT_SWITCH_()	( qp_host_pendsv = 1U )
+
+#define QXK_ISR_ENTRY()			( (void)0 )
+
+#define QXK_ISR_EXIT() do { \
+	QF_INT_DISABLE(); \
+	if( QXK_sched_() != (uint_fast8_t)0 ) \
+	{ \
+		QXK_CONTEXT_SWITCH_(); \
+	} \
+	QF_INT_ENABLE(); \
+} while( 0 )
+
+#include "qxk.h"
+
+#endif /* qxk_port_h */
@@ -0,0 +1,275 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#ifndef _QP_KERNEL_TEST_H
+#define _QP_KERNEL_TEST_H
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* for the kernel's event pools and queues */
+#define QP_IMPL
+
+#include "qpc.h"
+#include "qf_pkg.h"
+
+#include "test.h"
+
+Q_DEFINE_THIS_MODULE( "qp_kernel_test" )
+
+/*
+ * scheduling of a QP kernel built for the host port in port/, the test of
+ * each kernel includes this once. three active objects L, M and H at the
+ * priorities 1, 2, 3 trace their run to completion steps: the capital
+ * letter when a step starts, the small one when it ends, so "LHhl" is H
+ * preempting L.
+ *
+ * each scenario posts to one of them from the idle loop, as a thread or as
+ * an interrupt, and the event carries what that step does in turn:
+ *
+ *   tP	post to priority P as a thread
+ *   iP	post to priority P from an interrupt
+ *   lC	lock the scheduler up to the ceiling C
+ *   u	unlock it
+ *
+ * the next idle call checks the trace against the kernel's expectation.
+ *
+ * before including, the test defines
+ *   QP_HOST_ISR_EXIT()		the kernel's interrupt exit
+ *   QP_HOST_PENDSV()		what the PendSV handler of the port does
+ *   QP_HOST_STK_SIZE		stack size passed to QACTIVE_START()
+ * and for the lock, QP_HOST_LOCK( ceiling ) and QP_HOST_UNLOCK( stat ).
+ */
+
+enum
+{
+	WORK_SIG = Q_USER_SIG
+};
+
+typedef struct
+{
+	QEvt super;
+
+	char const *ops;
+} WORK_EVT;
+
+typedef struct
+{
+	uint8_t isr;			/* first post from an interrupt */
+	uint8_t prio;			/* to */
+	char const *ops;		/* for the first step */
+	uint8_t copies;			/* more posts, no ops */
+	char const *expect;
+} SCENARIO;
+
+uint8_t qp_host_isr;
+uint8_t qp_host_pendsv;
+static uint8_t qp_host_int_off;
+
+void qp_host_int_disable( void )
+{
+	CHECK( !qp_host_int_off );
+	qp_host_int_off = 1;
+}
+
+void qp_host_int_enable( void )
+{
+	qp_host_int_off = 0;
+}
+
+void Q_onAssert( char const * const module, int_t const location )
+{
+	printf( "assert %s:%d\n", module, (int)location );
+	exit( 1 );
+}
+
+void QF_onStartup( void )
+{
+}
+
+void QF_onCleanup( void )
+{
+}
+
+typedef struct
+{
+	QActive super;
+
+	char name;
+} TAO;
+
+static TAO tao[ 4 ];		/* by priority, 0 unused */
+static QEvt const *tao_queue[ 4 ][ 8 ];
+
+static char trace[ 64 ];
+static unsigned trace_len;
+
+static SCENARIO const *scn;
+static unsigned scn_n;
+static unsigned scn_i;
+static jmp_buf scn_done;
+
+static void trace_add( char c )
+{
+	if( trace_len < sizeof( trace ) - 1 )
+	{
+		trace[ trace_len++ ] = c;
+		trace[ trace_len ] = '\0';
+	}
+}
+
+static void work_post( uint8_t isr, uint8_t prio, char const *ops )
+{
+	WORK_EVT *e = Q_NEW( WORK_EVT, WORK_SIG );
+
+	e->ops = ops;
+
+	if( !isr )
+	{
+		QACTIVE_POST( &tao[ prio ].super, &e->super, (void *)0 );
+		return;
+	}
+
+	qp_host_isr = 1U;
+	QACTIVE_POST( &tao[ prio ].super, &e->super, (void *)0 );
+	QP_HOST_ISR_EXIT();
+	qp_host_isr = 0U;
+
+	/* tail chained after the last interrupt */
+	if( qp_host_pendsv )
+	{
+		qp_host_pendsv = 0U;
+		QP_HOST_PENDSV();
+	}
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e );
+
+static QState tao_initial( TAO * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &tao_active );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e )
+{
+	char const *op;
+#ifdef QP_HOST_LOCK
+	QSchedStatus lock = 0;
+#endif
+
+	if( e->sig != WORK_SIG )
+	{
+		return Q_SUPER( &QHsm_top );
+	}
+
+	trace_add( me->name );
+
+	for( op = ( (WORK_EVT const *)e )->ops; op != NULL && *op != '\0'; op += 2 )
+	{
+		switch( op[ 0 ] )
+		{
+			case 't':
+			case 'i':
+				work_post( 'i' == op[ 0 ], (uint8_t)( op[ 1 ] - '0' ), NULL );
+				break;
+
+#ifdef QP_HOST_LOCK
+			case 'l':
+				lock = QP_HOST_LOCK( (uint_fast8_t)( op[ 1 ] - '0' ) );
+				break;
+
+			case 'u':
+				QP_HOST_UNLOCK( lock );
+				--op;
+				break;
+#endif
+
+			default:
+				CHECK( 0 );
+				return Q_HANDLED();
+		}
+	}
+
+	trace_add( (char)( me->name - 'A' + 'a' ) );
+
+	return Q_HANDLED();
+}
+
+/* called from the kernel's idle callback, interrupts enabled */
+static void qp_kernel_idle( void )
+{
+	SCENARIO const *s;
+	uint8_t i;
+
+	CHECK( !qp_host_int_off );
+
+	if( scn_i != 0 )
+	{
+		s = &scn[ scn_i - 1 ];
+		if( strcmp( trace, s->expect ) != 0 )
+		{
+			printf( "scenario %u: \"%s\", expected \"%s\"\n", scn_i, trace, s->expect );
+			++test_failed;
+		}
+	}
+
+	if( scn_i == scn_n )
+	{
+		longjmp( scn_done, 1 );
+	}
+
+	s = &scn[ scn_i++ ];
+	trace_len = 0;
+	trace[ 0 ] = '\0';
+
+	work_post( s->isr, s->prio, s->ops );
+	for( i = 0; i < s->copies; i++ )
+	{
+		work_post( s->isr, s->prio, NULL );
+	}
+}
+
+/* start the kernel, return after the last scenario was checked */
+static void qp_kernel_run( SCENARIO const *s, unsigned n )
+{
+	static QF_MPOOL_EL( WORK_EVT ) pool[ 16 ];
+	QMPoolCtr n_free;
+	uint8_t p;
+
+	scn = s;
+	scn_n = n;
+	scn_i = 0;
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+	n_free = QF_pool_[ 0 ].nFree;
+
+	for( p = 1; p <= 3; p++ )
+	{
+		tao[ p ].name = "LMH"[ p - 1 ];
+		QActive_ctor( &tao[ p ].super, Q_STATE_CAST( &tao_initial ) );
+		QACTIVE_START( &tao[ p ].super, p, tao_queue[ p ], Q_DIM( tao_queue[ p ] ),
+					   (void *)0, QP_HOST_STK_SIZE, (QEvt *)0 );
+	}
+
+	if( 0 == setjmp( scn_done ) )
+	{
+		(void)QF_run();
+	}
+
+	/* every event back in the pool, no queue left with one */
+	CHECK( n_free == QF_pool_[ 0 ].nFree );
+	for( p = 1; p <= 3; p++ )
+	{
+		CHECK( NULL == tao[ p ].super.eQueue.frontEvt );
+	}
+}
+
+#endif /* _QP_KERNEL_TEST_H */
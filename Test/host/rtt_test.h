@@ -0,0 +1,71 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#ifndef _RTT_TEST_H
+#define _RTT_TEST_H
+
+#include <string.h>
+
+#include "SEGGER_RTT.h"
+
+/*
+ * the J-Link side of the real SEGGER_RTT.c built on the host: it takes the
+ * bytes of the up buffers and types into the down buffers of _SEGGER_RTT,
+ * as the probe does over SWD. a test built with
+ * -Wl,--wrap=SEGGER_RTT_Write counts the locked writes of the callers
+ * outside SEGGER_RTT.c, SEGGER_RTT_printf() among them.
+ */
+
+static uint32_t rtt_test_writes;
+
+unsigned __real_SEGGER_RTT_Write( unsigned BufferIndex, const void *pBuffer, unsigned NumBytes );
+
+unsigned __wrap_SEGGER_RTT_Write( unsigned BufferIndex, const void *pBuffer, unsigned NumBytes )
+{
+	++rtt_test_writes;
+	return __real_SEGGER_RTT_Write( BufferIndex, pBuffer, NumBytes );
+}
+
+/* take what the up buffer holds, terminated, return its length */
+static inline unsigned rtt_test_read( unsigned index, char *out, unsigned size )
+{
+	SEGGER_RTT_BUFFER_UP *up = &_SEGGER_RTT.aUp[ index ];
+	unsigned n = 0;
+
+	while( up->RdOff != up->WrOff && n + 1 < size )
+	{
+		out[ n++ ] = up->pBuffer[ up->RdOff ];
+		up->RdOff = up->RdOff + 1 == up->SizeOfBuffer ? 0 : up->RdOff + 1;
+	}
+	out[ n ] = '\0';
+
+	return n;
+}
+
+/* type into the down buffer what fits, return the bytes taken */
+static inline unsigned rtt_test_type( unsigned index, char const *s )
+{
+	SEGGER_RTT_BUFFER_DOWN *down = &_SEGGER_RTT.aDown[ index ];
+	unsigned n = 0, next;
+
+	for( ; s[ n ] != '\0'; n++ )
+	{
+		next = down->WrOff + 1 == down->SizeOfBuffer ? 0 : down->WrOff + 1;
+		if( next == down->RdOff )
+		{
+			break;
+		}
+
+		down->pBuffer[ down->WrOff ] = s[ n ];
+		down->WrOff = next;
+	}
+
+	return n;
+}
+
+#endif /* _RTT_TEST_H */
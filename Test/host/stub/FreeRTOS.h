@@ -0,0 +1,10 @@
+/* host stand-in for FreeRTOS, the mutexes the tested modules use. */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stdint.h>
+
+#define portMAX_DELAY		0xFFFFFFFFU
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,10 @@
+/* host stand-in for RTT: the up buffers go to stdout. */
+
+#ifndef SEGGER_RTT_H
+#define SEGGER_RTT_H
+
+#include <stdio.h>
+
+#define SEGGER_RTT_printf( index_, ... )	printf( __VA_ARGS__ )
+
+#endif /* SEGGER_RTT_H */
@@ -0,0 +1,75 @@
+/* host stand-in for QP/C, the events and assertions the tested modules use. */
+
+#ifndef qpc_h
+#define qpc_h
+
+#include <stdint.h>
+
+typedef int enum_t;
+typedef uint16_t QSignal;
+typedef long BaseType_t;
+
+typedef struct
+{
+	QSignal sig;
+	uint8_t poolId_;
+	uint8_t volatile refCtr_;
+} QEvt;
+
+typedef uint_fast8_t QState;
+typedef QState ( *QStateHandler )( void * const me, QEvt const * const e );
+
+/* the tests dispatch to the state handlers themselves */
+typedef struct QActive
+{
+	QStateHandler state;
+} QActive;
+
+enum
+{
+	Q_RET_SUPER,
+	Q_RET_HANDLED,
+	Q_RET_TRAN
+};
+
+enum
+{
+	Q_ENTRY_SIG = 1,
+	Q_EXIT_SIG,
+	Q_INIT_SIG,
+	Q_USER_SIG
+};
+
+#define Q_STATE_CAST( handler_ )	( (QStateHandler)( handler_ ) )
+#define Q_HANDLED()					( (QState)Q_RET_HANDLED )
+#define Q_TRAN( target_ )			( (void)( target_ ), (QState)Q_RET_TRAN )
+#define Q_SUPER( super_ )			( (void)( super_ ), (QState)Q_RET_SUPER )
+
+QState QHsm_top( void const * const me, QEvt const * const e );
+
+#define QActive_ctor( me_, initial_ )	( (me_)->state = ( initial_ ) )
+
+/* provided by the test: the events are recorded, not queued */
+QEvt *test_evt_new( uint32_t size, enum_t sig );
+void test_post( QActive *ao, QEvt const *e );
+void test_assert( char const *module, int loc );
+
+#define Q_NEW( evtT_, sig_ )			( (evtT_ *)test_evt_new( sizeof( evtT_ ), ( sig_ ) ) )
+#define Q_NEW_FROM_ISR( evtT_, sig_ )	Q_NEW( evtT_, sig_ )
+
+#define QACTIVE_POST( me_, e_, sender_ )					test_post( ( me_ ), ( e_ ) )
+#define QACTIVE_POST_FROM_ISR( me_, e_, woken_, sender_ )	test_post( ( me_ ), ( e_ ) )
+
+#define pdFALSE							0
+#define portEND_SWITCHING_ISR( woken_ )	( (void)( woken_ ) )
+
+#define Q_DEFINE_THIS_MODULE( name_ )	static char const Q_this_module_[] __attribute__(( unused )) = name_;
+
+#define Q_ASSERT_ID( id_, test_ )	( ( test_ ) ? (void)0 : test_assert( Q_this_module_, ( id_ ) ) )
+#define Q_REQUIRE_ID( id_, test_ )	Q_ASSERT_ID( id_, test_ )
+#define Q_ENSURE_ID( id_, test_ )	Q_ASSERT_ID( id_, test_ )
+#define Q_ASSERT( test_ )			Q_ASSERT_ID( __LINE__, test_ )
+#define Q_REQUIRE( test_ )			Q_ASSERT_ID( __LINE__, test_ )
+#define Q_ERROR_ID( id_ )			test_assert( Q_this_module_, ( id_ ) )
+
+#endif /* qpc_h */
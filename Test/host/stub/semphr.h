@@ -0,0 +1,22 @@
+/* host stand-in for the FreeRTOS mutexes: one thread, so a take of a held
+ * mutex is the deadlock it would be on the target.
+ */
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+typedef struct
+{
+	int held;
+} StaticSemaphore_t;
+
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+void test_mutex_deadlock( SemaphoreHandle_t m );
+
+#define xSemaphoreCreateMutexStatic( buf_ )	( ( buf_ )->held = 0, ( buf_ ) )
+#define xSemaphoreTake( m_, ticks_ ) \
+	( ( m_ )->held ? test_mutex_deadlock( m_ ) : (void)0, ( m_ )->held = 1 )
+#define xSemaphoreGive( m_ )				( ( m_ )->held = 0 )
+
+#endif /* SEMAPHORE_H */
@@ -0,0 +1,358 @@
+/* host stand-in for the device header, only what the tested drivers use. */
+
+#ifndef __STM32F10x_H
+#define __STM32F10x_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus;
+
+/* the core clock, defined by the test */
+extern uint32_t SystemCoreClock;
+
+/* the CRC unit model: every access through CRC first folds the word
+ * written to DR since the previous access into the result.
+ */
+typedef struct
+{
+	volatile uint32_t DR;
+	volatile uint8_t IDR;
+	uint8_t RESERVED0;
+	uint16_t RESERVED1;
+	volatile uint32_t CR;
+} CRC_TypeDef;
+
+CRC_TypeDef *crc_unit_sync( void );
+
+#define CRC				( crc_unit_sync() )
+#define CRC_CR_RESET	( (uint8_t)0x01 )
+
+typedef struct
+{
+	volatile uint32_t CCR;
+	volatile uint32_t CNDTR;
+	volatile uint32_t CPAR;
+	volatile uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+extern DMA_Channel_TypeDef dma1_channel1_model;
+extern DMA_Channel_TypeDef dma1_channel2_model;
+extern DMA_Channel_TypeDef dma1_channel3_model;
+extern DMA_Channel_TypeDef dma1_channel4_model;
+
+/* the interrupt flags of DMA1, set by the test */
+extern uint32_t dma1_isr_model;
+
+#define DMA1_Channel1		( &dma1_channel1_model )
+#define DMA1_Channel1_IRQn	11
+#define DMA1_IT_TC1			( (uint32_t)0x00000002 )
+#define DMA1_IT_HT1			( (uint32_t)0x00000004 )
+#define DMA1_Channel2		( &dma1_channel2_model )
+#define DMA1_Channel2_IRQn	12
+#define DMA1_IT_TC2			( (uint32_t)0x00000020 )
+#define DMA1_Channel3		( &dma1_channel3_model )
+#define DMA1_Channel3_IRQn	13
+#define DMA1_IT_TC3			( (uint32_t)0x00000200 )
+#define DMA1_Channel4		( &dma1_channel4_model )
+#define DMA1_Channel4_IRQn	14
+#define DMA1_IT_TC4			( (uint32_t)0x00002000 )
+
+#define DMA_CCR1_EN			( (uint16_t)0x0001 )
+
+typedef struct
+{
+	uint32_t DMA_PeripheralBaseAddr;
+	uint32_t DMA_MemoryBaseAddr;
+	uint32_t DMA_DIR;
+	uint32_t DMA_BufferSize;
+	uint32_t DMA_PeripheralInc;
+	uint32_t DMA_MemoryInc;
+	uint32_t DMA_PeripheralDataSize;
+	uint32_t DMA_MemoryDataSize;
+	uint32_t DMA_Mode;
+	uint32_t DMA_Priority;
+	uint32_t DMA_M2M;
+} DMA_InitTypeDef;
+
+#define DMA_DIR_PeripheralDST			0x0010
+#define DMA_DIR_PeripheralSRC			0x0000
+#define DMA_PeripheralInc_Disable		0x0000
+#define DMA_MemoryInc_Enable			0x0080
+#define DMA_PeripheralDataSize_Byte		0x0000
+#define DMA_PeripheralDataSize_HalfWord	0x0100
+#define DMA_PeripheralDataSize_Word		0x0200
+#define DMA_MemoryDataSize_Byte			0x0000
+#define DMA_MemoryDataSize_HalfWord		0x0400
+#define DMA_MemoryDataSize_Word			0x0800
+#define DMA_Mode_Circular				0x0020
+#define DMA_Mode_Normal					0x0000
+#define DMA_Priority_Low				0x0000
+#define DMA_Priority_High				0x2000
+#define DMA_Priority_VeryHigh			0x3000
+#define DMA_M2M_Disable					0x0000
+#define DMA_M2M_Enable					0x4000
+#define DMA_IT_TC						0x0002
+#define DMA_IT_HT						0x0004
+
+typedef struct
+{
+	uint8_t NVIC_IRQChannel;
+	uint8_t NVIC_IRQChannelPreemptionPriority;
+	uint8_t NVIC_IRQChannelSubPriority;
+	FunctionalState NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+
+#define RCC_AHBPeriph_DMA1		0x0001
+#define RCC_AHBPeriph_CRC		0x0040
+#define RCC_APB2Periph_GPIOA	0x0004
+#define RCC_APB2Periph_GPIOB	0x0008
+#define RCC_APB2Periph_ADC1		0x0200
+#define RCC_APB2Periph_SPI1		0x1000
+#define RCC_APB1Periph_TIM3		0x0002
+#define RCC_PCLK2_Div6			0x8000
+
+/* the GPIO outputs, the test defines GPIO_SetBits() and GPIO_ResetBits() */
+typedef struct
+{
+	volatile uint32_t ODR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef gpioa_model;
+extern GPIO_TypeDef gpiob_model;
+
+#define GPIOA		( &gpioa_model )
+#define GPIOB		( &gpiob_model )
+
+#define GPIO_Pin_0		( (uint16_t)0x0001 )
+#define GPIO_Pin_1		( (uint16_t)0x0002 )
+#define GPIO_Pin_2		( (uint16_t)0x0004 )
+#define GPIO_Pin_3		( (uint16_t)0x0008 )
+#define GPIO_Pin_4		( (uint16_t)0x0010 )
+#define GPIO_Pin_5		( (uint16_t)0x0020 )
+#define GPIO_Pin_6		( (uint16_t)0x0040 )
+#define GPIO_Pin_7		( (uint16_t)0x0080 )
+
+typedef struct
+{
+	uint16_t GPIO_Pin;
+	uint32_t GPIO_Speed;
+	uint32_t GPIO_Mode;
+} GPIO_InitTypeDef;
+
+#define GPIO_Speed_50MHz		3
+#define GPIO_Mode_AIN			0x00
+#define GPIO_Mode_IN_FLOATING	0x04
+#define GPIO_Mode_Out_PP		0x10
+#define GPIO_Mode_AF_PP			0x18
+
+void GPIO_SetBits( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin );
+void GPIO_ResetBits( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin );
+
+/* the SPI unit model: every access through SPI1 first shifts a byte
+ * written to DR since the previous access, the received byte is left in
+ * DR with bit 8 set and RXNE.
+ */
+typedef struct
+{
+	volatile uint16_t CR1;
+	uint16_t RESERVED0;
+	volatile uint16_t CR2;
+	uint16_t RESERVED1;
+	volatile uint16_t SR;
+	uint16_t RESERVED2;
+	volatile uint16_t DR;
+	uint16_t RESERVED3;
+} SPI_TypeDef;
+
+SPI_TypeDef *spi1_unit_sync( void );
+
+#define SPI1					( spi1_unit_sync() )
+#define SPI_I2S_FLAG_RXNE		( (uint16_t)0x0001 )
+#define SPI_I2S_FLAG_TXE		( (uint16_t)0x0002 )
+#define SPI_I2S_DMAReq_Tx		( (uint16_t)0x0002 )
+#define SPI_I2S_DMAReq_Rx		( (uint16_t)0x0001 )
+
+typedef struct
+{
+	uint16_t SPI_Direction;
+	uint16_t SPI_Mode;
+	uint16_t SPI_DataSize;
+	uint16_t SPI_CPOL;
+	uint16_t SPI_CPHA;
+	uint16_t SPI_NSS;
+	uint16_t SPI_BaudRatePrescaler;
+	uint16_t SPI_FirstBit;
+	uint16_t SPI_CRCPolynomial;
+} SPI_InitTypeDef;
+
+#define SPI_Direction_2Lines_FullDuplex	0x0000
+#define SPI_Mode_Master					0x0104
+#define SPI_DataSize_8b					0x0000
+#define SPI_CPOL_Low					0x0000
+#define SPI_CPHA_1Edge					0x0000
+#define SPI_NSS_Soft					0x0200
+#define SPI_BaudRatePrescaler_8			0x0010
+#define SPI_FirstBit_MSB				0x0000
+
+/* the timer that triggers the ADC scans, only the count and the enable */
+typedef struct
+{
+	volatile uint16_t CR1;
+	uint16_t RESERVED0;
+	volatile uint16_t CNT;
+	uint16_t RESERVED1;
+	volatile uint16_t ARR;
+	uint16_t RESERVED2;
+} TIM_TypeDef;
+
+extern TIM_TypeDef tim3_model;
+
+#define TIM3	( &tim3_model )
+
+typedef struct
+{
+	uint16_t TIM_Prescaler;
+	uint16_t TIM_CounterMode;
+	uint16_t TIM_Period;
+	uint16_t TIM_ClockDivision;
+	uint8_t TIM_RepetitionCounter;
+} TIM_TimeBaseInitTypeDef;
+
+#define TIM_CKD_DIV1				0x0000
+#define TIM_CounterMode_Up			0x0000
+#define TIM_TRGOSource_Update		0x0020
+#define TIM_CR1_CEN					( (uint16_t)0x0001 )
+
+#define TIM_TimeBaseInit( tim, init )		( (void)( ( tim )->ARR = ( init )->TIM_Period ) )
+#define TIM_SelectOutputTrigger( tim, src )	( (void)0 )
+#define TIM_SetCounter( tim, n )			( (void)( ( tim )->CNT = ( n ) ) )
+#define TIM_Cmd( tim, state ) \
+	( ( state ) ? (void)( ( tim )->CR1 |= TIM_CR1_CEN ) : (void)( ( tim )->CR1 &= ~TIM_CR1_CEN ) )
+
+/* the ADC, the test writes the scans through the DMA channel */
+typedef struct
+{
+	volatile uint32_t SR;
+	volatile uint32_t CR1;
+	volatile uint32_t CR2;
+	uint32_t RESERVED[ 16 ];
+	volatile uint32_t DR;
+} ADC_TypeDef;
+
+extern ADC_TypeDef adc1_model;
+
+#define ADC1	( &adc1_model )
+
+typedef struct
+{
+	uint32_t ADC_Mode;
+	FunctionalState ADC_ScanConvMode;
+	FunctionalState ADC_ContinuousConvMode;
+	uint32_t ADC_ExternalTrigConv;
+	uint32_t ADC_DataAlign;
+	uint8_t ADC_NbrOfChannel;
+} ADC_InitTypeDef;
+
+#define ADC_Mode_Independent			0x00000000
+#define ADC_ExternalTrigConv_T3_TRGO	0x00080000
+#define ADC_DataAlign_Right				0x00000000
+#define ADC_Channel_0					( (uint8_t)0x00 )
+#define ADC_Channel_1					( (uint8_t)0x01 )
+#define ADC_Channel_2					( (uint8_t)0x02 )
+#define ADC_Channel_3					( (uint8_t)0x03 )
+#define ADC_SampleTime_55Cycles5		( (uint8_t)0x05 )
+
+#define ADC_DeInit( adc )							( (void)0 )
+#define ADC_Init( adc, init )						( (void)( init ) )
+#define ADC_RegularChannelConfig( adc, ch, rank, t )	( (void)( ch ) )
+#define ADC_DMACmd( adc, state )					( (void)0 )
+#define ADC_Cmd( adc, state )						( (void)0 )
+#define ADC_ResetCalibration( adc )					( (void)0 )
+#define ADC_GetResetCalibrationStatus( adc )		RESET
+#define ADC_StartCalibration( adc )					( (void)0 )
+#define ADC_GetCalibrationStatus( adc )				RESET
+#define ADC_ExternalTrigConvCmd( adc, state )		( (void)0 )
+
+/* the clocks, pins and the SPI and ADC setup are not modelled. a DMA
+ * channel keeps its configuration, count, addresses and EN bit, a test that
+ * plays a channel defines its model.
+ */
+#define RCC_AHBPeriphClockCmd( periph, state )	( (void)0 )
+#define RCC_APB2PeriphClockCmd( periph, state )	( (void)0 )
+#define RCC_APB1PeriphClockCmd( periph, state )	( (void)0 )
+#define RCC_ADCCLKConfig( div )					( (void)0 )
+#define GPIO_Init( port, init )					( (void)( port ), (void)( init ) )
+#define SPI_Init( spi, init )					( (void)( init ) )
+#define SPI_I2S_DMACmd( spi, req, state )		( (void)0 )
+#define SPI_Cmd( spi, state )					( (void)0 )
+#define DMA_DeInit( ch ) \
+	( (void)( ( ch )->CCR = 0, ( ch )->CNDTR = 0, ( ch )->CPAR = 0, ( ch )->CMAR = 0 ) )
+#define DMA_Init( ch, init ) \
+	( (void)( ( ch )->CPAR = ( init )->DMA_PeripheralBaseAddr, \
+			  ( ch )->CMAR = ( init )->DMA_MemoryBaseAddr, \
+			  ( ch )->CNDTR = ( init )->DMA_BufferSize, \
+			  ( ch )->CCR = ( init )->DMA_DIR | ( init )->DMA_PeripheralInc | ( init )->DMA_MemoryInc | \
+							( init )->DMA_PeripheralDataSize | ( init )->DMA_MemoryDataSize | \
+							( init )->DMA_Mode | ( init )->DMA_Priority | ( init )->DMA_M2M ) )
+#define DMA_ITConfig( ch, it, state )			( (void)( ch ) )
+#define DMA_Cmd( ch, state ) \
+	( ( state ) ? (void)( ( ch )->CCR |= DMA_CCR1_EN ) : (void)( ( ch )->CCR &= ~(uint32_t)DMA_CCR1_EN ) )
+#define DMA_GetITStatus( it )					( ( dma1_isr_model & ( it ) ) ? SET : RESET )
+#define DMA_ClearITPendingBit( it )				( (void)( dma1_isr_model &= ~(uint32_t)( it ) ) )
+#define NVIC_Init( init )						( (void)( init ) )
+
+typedef struct
+{
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+/* a read of the cycle counter is a point where the test may interrupt */
+DWT_Type *test_dwt( void );
+
+#define DWT		( test_dwt() )
+
+/* the exclusive monitor of the test, an interrupt between the load and the
+ * store makes the store fail as the exception return does on the target.
+ */
+uint32_t test_ldrex( volatile uint32_t *addr );
+uint32_t test_strex( uint32_t value, volatile uint32_t *addr );
+void test_clrex( void );
+
+#define __LDREXW( addr_ )			test_ldrex( addr_ )
+#define __STREXW( value_, addr_ )	test_strex( ( value_ ), ( addr_ ) )
+#define __CLREX()					test_clrex()
+#define __DMB()						__sync_synchronize()
+
+/* the flash model of the test */
+typedef enum
+{
+	FLASH_BUSY = 1,
+	FLASH_ERROR_PG,
+	FLASH_ERROR_WRP,
+	FLASH_COMPLETE,
+	FLASH_TIMEOUT
+} FLASH_Status;
+
+#define FLASH_FLAG_EOP			0x20
+#define FLASH_FLAG_PGERR		0x04
+#define FLASH_FLAG_WRPRTERR		0x10
+
+void FLASH_Unlock( void );
+void FLASH_Lock( void );
+void FLASH_ClearFlag( uint32_t flags );
+FLASH_Status FLASH_ProgramHalfWord( uint32_t addr, uint16_t data );
+FLASH_Status FLASH_ErasePage( uint32_t addr );
+
+/* one thread, nothing to mask */
+#define __get_PRIMASK()			0U
+#define __set_PRIMASK( x )		( (void)( x ) )
+#define __disable_irq()			( (void)0 )
+
+/* the exception number, from the host FreeRTOS port: non zero inside
+ * vPortHostInterrupt()
+ */
+uint32_t __get_IPSR( void );
+
+#endif /* __STM32F10x_H */
@@ -0,0 +1,123 @@
+/* host stand-in for the USB FS device library, for usb_mem.c, the
+ * endpoint registers that bsp_usb_stream.c uses and the interrupt side of
+ * usb_int.c. test_usb_stream.c and test_usb_ao.c define the endpoint model.
+ */
+
+#ifndef __USB_LIB_H
+#define __USB_LIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef __IO
+#define __IO volatile
+#endif
+
+#include "usb_int.h"
+
+/* the PMA model: 512 halfwords, each in the low half of a 32-bit word */
+extern uint32_t pma_model[ 512 ];
+
+#define PMAAddr		( (uintptr_t)pma_model )
+
+void UserToPMABufferCopy( uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes );
+void PMAToUserBufferCopy( uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes );
+
+/* the endpoint registers, the CTR, SETUP, STAT and DTOG bits */
+extern uint16_t usb_ep_model[ 8 ];
+
+#define EP_CTR_RX		( 0x8000 )
+#define EP_DTOG_RX		( 0x4000 )
+#define EPRX_STAT		( 0x3000 )
+#define EP_SETUP		( 0x0800 )
+#define EP_CTR_TX		( 0x0080 )
+#define EP_DTOG_TX		( 0x0040 )
+#define EPTX_STAT		( 0x0030 )
+
+#define EP_BULK			( 0x0000 )
+#define EP_TX_DIS		( 0x0000 )
+#define EP_TX_STALL		( 0x0010 )
+#define EP_TX_NAK		( 0x0020 )
+#define EP_TX_VALID		( 0x0030 )
+#define EP_RX_DIS		( 0x0000 )
+#define EP_RX_STALL		( 0x1000 )
+#define EP_RX_NAK		( 0x2000 )
+#define EP_RX_VALID		( 0x3000 )
+
+#define ENDP0			( (uint8_t)0 )
+
+/* the interrupt status: CTR, DIR and EP_ID follow the endpoint flags */
+#define ISTR_CTR		( 0x8000 )
+#define ISTR_RESET		( 0x0400 )
+#define ISTR_DIR		( 0x0010 )
+#define ISTR_EP_ID		( 0x000F )
+#define CLR_CTR			( ~ISTR_CTR )
+#define CLR_RESET		( ~ISTR_RESET )
+
+uint16_t usb_istr_get( void );
+void usb_istr_set( uint16_t wRegValue );
+
+#define _GetISTR()		usb_istr_get()
+#define _SetISTR( w )	usb_istr_set( w )
+
+typedef enum _EP_DBUF_DIR
+{
+	EP_DBUF_ERR,
+	EP_DBUF_OUT,
+	EP_DBUF_IN
+} EP_DBUF_DIR;
+
+#define _GetENDPOINT( bEpNum )							( usb_ep_model[ bEpNum ] )
+#define _SetEPDblBuf0Count( bEpNum, bDir, wCount )		usb_ep_set_count( bEpNum, 0, wCount )
+#define _SetEPDblBuf1Count( bEpNum, bDir, wCount )		usb_ep_set_count( bEpNum, 1, wCount )
+#define _GetEPDblBuf0Count( bEpNum )					usb_ep_get_count( bEpNum, 0 )
+#define _GetEPDblBuf1Count( bEpNum )					usb_ep_get_count( bEpNum, 1 )
+
+void usb_ep_set_count( uint8_t bEpNum, uint8_t buf, uint16_t wCount );
+uint16_t usb_ep_get_count( uint8_t bEpNum, uint8_t buf );
+
+/* the single buffered receive of endpoint 0 */
+extern uint16_t usb_ep_rx_addr_model[ 8 ];
+extern uint16_t usb_ep_rx_count_model[ 8 ];
+
+#define _GetEPRxAddr( bEpNum )		( usb_ep_rx_addr_model[ bEpNum ] )
+#define _GetEPRxCount( bEpNum )		( usb_ep_rx_count_model[ bEpNum ] )
+
+#define _SetEPRxTxStatus( bEpNum, wStaterx, wStatetx ) \
+	( usb_ep_model[ bEpNum ] = (uint16_t)( ( usb_ep_model[ bEpNum ] & ~( EPRX_STAT | EPTX_STAT ) ) \
+										   | ( wStaterx ) | ( wStatetx ) ) )
+#define _ClearEP_CTR_RX( bEpNum )	( usb_ep_model[ bEpNum ] &= (uint16_t)~EP_CTR_RX )
+#define _ClearEP_CTR_TX( bEpNum )	( usb_ep_model[ bEpNum ] &= (uint16_t)~EP_CTR_TX )
+
+void SetEPType( uint8_t bEpNum, uint16_t wType );
+void SetEPTxStatus( uint8_t bEpNum, uint16_t wState );
+void SetEPRxStatus( uint8_t bEpNum, uint16_t wState );
+void SetEPDoubleBuff( uint8_t bEpNum );
+void SetEPDblBuffAddr( uint8_t bEpNum, uint16_t wBuf0Addr, uint16_t wBuf1Addr );
+void SetEPDblBuffCount( uint8_t bEpNum, uint8_t bDir, uint16_t wCount );
+void ClearDTOG_RX( uint8_t bEpNum );
+void ClearDTOG_TX( uint8_t bEpNum );
+void FreeUserBuffer( uint8_t bEpNum, uint8_t bDir );
+
+/* the core of the library, usb_int.c calls the control endpoint state
+ * machine and the endpoint callbacks.
+ */
+typedef struct _DEVICE_PROP
+{
+	void ( *Reset )( void );
+} DEVICE_PROP;
+
+extern DEVICE_PROP *pProperty;
+extern uint16_t wInterrupt_Mask;
+extern uint8_t EPindex;
+extern __IO uint16_t wIstr;
+extern __IO uint16_t SaveRState;
+extern __IO uint16_t SaveTState;
+extern uint8_t *pCtrRxData;
+
+uint8_t In0_Process( void );
+uint8_t Out0_Process( void );
+uint8_t Setup0_Process( void );
+void NOP_Process( void );
+
+#endif /* __USB_LIB_H */
@@ -0,0 +1,32 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#ifndef _TEST_H
+#define _TEST_H
+
+#include <stdio.h>
+
+/* minimal checks for the host tests, one executable per module. */
+
+static int test_failed;
+
+#define CHECK( cond ) \
+	do \
+	{ \
+		if( !( cond ) ) \
+		{ \
+			printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #cond ); \
+			++test_failed; \
+		} \
+	} while( 0 )
+
+/* return value of main() */
+#define TEST_RESULT( name ) \
+	( printf( "%s: %s\n", ( name ), test_failed ? "FAILED" : "ok" ), test_failed != 0 )
+
+#endif /* _TEST_H */
@@ -0,0 +1,247 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+#include "app_signals.h"
+#include "adc_acq.h"
+
+/*
+ * the adc pipeline on the FreeRTOS port: bsp_adc.c and adc_acq.c with a
+ * model of the circular DMA of ADC1. the idle task plays the TIM3
+ * triggered scans up to the next half of the buffer and runs the half and
+ * full transfer interrupts, the averaged samples follow the scans.
+ *
+ * then the DMA goes on while a block is processed (at the cycle counter
+ * read before it), with its interrupt run or held off: the block is intact
+ * as long as the DMA has not written into it, whatever the interrupt did.
+ * the report comes last, with a nominal processing cost.
+ *
+ * built without PIE, so the static buffer fits in CMAR.
+ */
+
+#define BLOCK			( BSP_ADC_BLOCK_FRAMES * BSP_ADC_CHANNELS )
+#define BLOCK_CYCLES	2000		/* nominal, for the report */
+
+/* the host stand-ins of the registers */
+DMA_Channel_TypeDef dma1_channel1_model;
+uint32_t dma1_isr_model;
+TIM_TypeDef tim3_model;
+ADC_TypeDef adc1_model;
+uint32_t SystemCoreClock = 72000000;
+
+/* in the vector table on the target */
+void DMA1_Channel1_IRQHandler( void );
+
+static uint8_t dma_claimed;
+
+void bsp_dma_claim( DMA_Channel_TypeDef *ch )
+{
+	CHECK( DMA1_Channel1 == ch && !dma_claimed );
+	dma_claimed = 1;
+}
+
+/* the inputs, different in every scan of a block */
+static uint16_t sample( uint32_t scan, uint8_t ch )
+{
+	return (uint16_t)( scan % 61U * 16U + ch * 1000U );
+}
+
+static uint32_t scans;		/* since the start */
+static uint32_t irqs;
+
+/* one scan into the buffer at the DMA position */
+static void adc_dma_scan( void )
+{
+	DMA_Channel_TypeDef *ch = DMA1_Channel1;
+	uint16_t *buf = (uint16_t *)(uintptr_t)ch->CMAR;
+	uint32_t pos = 2 * BLOCK - ch->CNDTR;
+	uint8_t i;
+
+	CHECK( ( TIM3->CR1 & TIM_CR1_CEN ) && ( ch->CCR & DMA_CCR1_EN ) && ( ch->CCR & DMA_Mode_Circular ) );
+	CHECK( ( ch->CCR & DMA_MemoryInc_Enable ) && 0 == pos % BSP_ADC_CHANNELS );
+
+	for( i = 0; i < BSP_ADC_CHANNELS; i++ )
+	{
+		buf[ pos + i ] = sample( scans, i );
+	}
+	++scans;
+
+	ch->CNDTR -= BSP_ADC_CHANNELS;
+	if( BLOCK == ch->CNDTR )
+	{
+		dma1_isr_model |= DMA1_IT_HT1;
+	}
+	else if( 0 == ch->CNDTR )
+	{
+		dma1_isr_model |= DMA1_IT_TC1;
+		ch->CNDTR = 2 * BLOCK;
+	}
+}
+
+/* the pending interrupts, the handler clears what it served */
+static void adc_dma_irq( void )
+{
+	uint8_t n;
+
+	for( n = 0; n < 2 && ( dma1_isr_model & ( DMA1_IT_HT1 | DMA1_IT_TC1 ) ); n++ )
+	{
+		++irqs;
+		vPortHostInterrupt( DMA1_Channel1_IRQHandler );
+	}
+
+	CHECK( 0 == ( dma1_isr_model & ( DMA1_IT_HT1 | DMA1_IT_TC1 ) ) );
+}
+
+/* scans while the next block is processed */
+static uint32_t lag;
+static uint8_t lag_irq;
+
+/* the reads come in pairs around the processing of a block */
+DWT_Type *test_dwt( void )
+{
+	static DWT_Type dwt;
+	static uint32_t reads;
+
+	dwt.CYCCNT = (uint32_t)bsp_dwt_get_cycles64();
+
+	if( 0 == reads++ % 2 )
+	{
+		for( ; lag != 0; lag-- )
+		{
+			adc_dma_scan();
+			if( lag_irq )
+			{
+				adc_dma_irq();
+			}
+		}
+		freertos_test_work( BLOCK_CYCLES );
+	}
+
+	return &dwt;
+}
+
+/* the newest output sample: the mean of the last scans of a block */
+static uint8_t last_is( uint32_t end )
+{
+	uint32_t sum;
+	uint8_t ch, k;
+
+	for( ch = 0; ch < BSP_ADC_CHANNELS; ch++ )
+	{
+		sum = 0;
+		for( k = 1; k <= ADC_ACQ_DECIMATE; k++ )
+		{
+			sum += sample( end - k, ch );
+		}
+
+		if( adc_acq_read( ch ) != sum / ADC_ACQ_DECIMATE )
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+typedef struct
+{
+	uint32_t lag;		/* scans while the block is processed */
+	uint8_t irq;		/* run by the interrupts in the lag */
+	uint8_t valid;
+} CASE;
+
+static CASE const cases[] =
+{
+	{ 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 }, { 0, 0, 1 },
+
+	/* the DMA reached the block, the interrupt held off, then run */
+	{ BSP_ADC_BLOCK_FRAMES, 0, 1 },
+	{ BSP_ADC_BLOCK_FRAMES, 1, 1 },
+
+	/* one scan into it */
+	{ BSP_ADC_BLOCK_FRAMES + 1, 0, 0 },
+	{ BSP_ADC_BLOCK_FRAMES + 1, 1, 0 },
+
+	{ 0, 0, 1 },
+};
+
+static unsigned step;
+static uint32_t overruns;
+
+static void freertos_test_idle( void )
+{
+	ADC_ACQ_STATS s;
+	uint32_t end;
+
+	/* the interrupts held off in the last block */
+	adc_dma_irq();
+
+	if( step != 0 )
+	{
+		adc_acq_stats( &s );
+
+		overruns += !cases[ step - 1 ].valid;
+		CHECK( overruns == s.overruns && irqs == s.blocks );
+		CHECK( QF_pool_[ 0 ].nTot == QF_pool_[ 0 ].nFree );
+	}
+
+	if( step < Q_DIM( cases ) )
+	{
+		lag = cases[ step ].lag;
+		lag_irq = cases[ step ].irq;
+		++step;
+
+		/* the rest of the half, its block is processed right away */
+		do
+		{
+			adc_dma_scan();
+		}
+		while( DMA1_Channel1->CNDTR % BLOCK != 0 );
+		end = scans;
+
+		adc_dma_irq();
+
+		if( 0 == cases[ step - 1 ].lag )
+		{
+			CHECK( last_is( end ) );
+		}
+		return;
+	}
+
+	bsp_adc_stop();
+	CHECK( 0 == ( TIM3->CR1 & TIM_CR1_CEN ) && 0 == ( DMA1_Channel1->CCR & DMA_CCR1_EN ) );
+
+	adc_acq_stats( &s );
+	CHECK( BLOCK_CYCLES == s.cycles_max );
+	adc_acq_report( 0 );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( ADC_BLOCK_EVT ) pool[ 4 ];
+	static QEvt const *queue[ 4 ];
+	static StackType_t stack[ configMINIMAL_STACK_SIZE ];
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	adc_acq_ctor();
+	QACTIVE_START( AO_AdcAcq, 1U, queue, Q_DIM( queue ), stack, sizeof( stack ), (QEvt *)0 );
+
+	/* bsp_adc_start() from the initial transition */
+	CHECK( dma_claimed && 2 * BLOCK == DMA1_Channel1->CNDTR );
+
+	freertos_test_run();
+
+	CHECK( Q_DIM( cases ) == step );
+
+	return TEST_RESULT( "adc_acq" );
+}
@@ -0,0 +1,304 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <time.h>
+
+#include "freertos_test.h"
+
+/*
+ * the broadcast channels of the FreeRTOS port against QF_publish_(): every
+ * subscriber gets each multicast once, a broadcast still pending when the
+ * next one comes is delivered once, the broadcasts go before the queued
+ * events, the higher channel first, and they take no queue entries. then
+ * the time per multicast to four subscribers from an interrupt and from a
+ * task. the dispatch is mostly the host context switches, so the post call
+ * of the interrupt is also timed alone.
+ */
+
+#define N_AO		4
+#define N_BENCH		20000U
+
+enum
+{
+	PUB_SIG = Q_USER_SIG,
+	BCAST1_SIG,
+	BCAST2_SIG,
+	WORK_SIG,
+	MAX_PUB_SIG
+};
+
+typedef struct
+{
+	QActive super;
+
+	char trace[ 16 ];
+	unsigned len;
+	uint32_t got;
+} TAO;
+
+static TAO tao[ N_AO + 1 ];		/* by priority, 0 unused */
+
+static QEvt const pub_evt = { PUB_SIG, 0U, 0U };
+static QEvt const bcast1_evt = { BCAST1_SIG, 0U, 0U };
+static QEvt const bcast2_evt = { BCAST2_SIG, 0U, 0U };
+static QEvt const work_evt = { WORK_SIG, 0U, 0U };
+
+static QState tao_active( TAO * const me, QEvt const * const e );
+
+static QState tao_initial( TAO * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &tao_active );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e )
+{
+	if( e->sig < PUB_SIG || e->sig > WORK_SIG )
+	{
+		return Q_SUPER( &QHsm_top );
+	}
+
+	if( me->len < sizeof( me->trace ) - 1 )
+	{
+		me->trace[ me->len++ ] = "pbcw"[ e->sig - PUB_SIG ];
+		me->trace[ me->len ] = '\0';
+	}
+	++me->got;
+	freertos_test_work( 100 );
+
+	return Q_HANDLED();
+}
+
+static uint64_t now_ns( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t post_ns;	/* in the post calls of the interrupts */
+
+/* the interrupts of the steps */
+static void isr_publish( void )
+{
+	BaseType_t woken = pdFALSE;
+	uint64_t t = now_ns();
+
+	QF_PUBLISH_FROM_ISR( &pub_evt, &woken, (void *)0 );
+	post_ns += now_ns() - t;
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void isr_bcast( void )
+{
+	BaseType_t woken = pdFALSE;
+	uint64_t t = now_ns();
+	uint8_t p;
+
+	QF_BCAST_FROM_ISR( 1U, &woken, (void *)0 );
+	post_ns += now_ns() - t;
+
+	/* pending, not queued */
+	for( p = 1; p <= N_AO; p++ )
+	{
+		CHECK( NULL == tao[ p ].super.eQueue.frontEvt && QPSet_hasElement( &tao[ p ].super.osObject, 1U ) );
+	}
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void isr_twice( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QF_BCAST_FROM_ISR( 1U, &woken, (void *)0 );
+	QF_BCAST_FROM_ISR( 1U, &woken, (void *)0 );
+	QF_PUBLISH_FROM_ISR( &pub_evt, &woken, (void *)0 );
+	QF_PUBLISH_FROM_ISR( &pub_evt, &woken, (void *)0 );
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void isr_order( void )
+{
+	BaseType_t woken = pdFALSE;
+	uint8_t p;
+
+	for( p = 1; p <= N_AO; p++ )
+	{
+		QACTIVE_POST_FROM_ISR( &tao[ p ].super, &work_evt, &woken, (void *)0 );
+	}
+	QF_BCAST_FROM_ISR( 1U, &woken, (void *)0 );
+	QF_BCAST_FROM_ISR( 2U, &woken, (void *)0 );
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void isr_both( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QF_PUBLISH_FROM_ISR( &pub_evt, &woken, (void *)0 );
+	QF_BCAST_FROM_ISR( 1U, &woken, (void *)0 );
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void task_both( void )
+{
+	QF_PUBLISH( &pub_evt, (void *)0 );
+	QF_BCAST( 1U, (void *)0 );
+}
+
+static void task_publish( void )
+{
+	QF_PUBLISH( &pub_evt, (void *)0 );
+}
+
+static void task_bcast( void )
+{
+	QF_BCAST( 1U, (void *)0 );
+}
+
+static void unsubscribe_2( void )
+{
+	QActive_unsubscribe( &tao[ 2 ].super, PUB_SIG );
+	QActive_bcastUnsubscribe( &tao[ 2 ].super, 1U );
+	vPortHostInterrupt( isr_both );
+}
+
+typedef struct
+{
+	void ( *run )( void );
+	uint8_t isr;
+	char const *expect[ N_AO + 1 ];		/* by priority */
+} STEP;
+
+static STEP const steps[] =
+{
+	{ isr_publish,	1, { NULL, "p", "p", "p", "p" } },
+	{ isr_bcast,	1, { NULL, "b", "b", "b", "b" } },
+	{ isr_twice,	1, { NULL, "bpp", "bpp", "bpp", "bpp" } },
+	{ isr_order,	1, { NULL, "cbw", "cbw", "cbw", "cbw" } },
+	{ task_both,	0, { NULL, "pb", "pb", "pb", "pb" } },
+	{ unsubscribe_2, 0, { NULL, "bp", "", "bp", "bp" } },
+};
+
+static unsigned step;
+
+/* ns per multicast, the dispatch to the subscribers included */
+static unsigned bench( void ( *run )( void ), uint8_t isr )
+{
+	uint32_t got = tao[ 1 ].got;
+	uint64_t t = now_ns();
+	uint32_t i;
+
+	for( i = 0; i < N_BENCH; i++ )
+	{
+		if( isr )
+		{
+			vPortHostInterrupt( run );
+		}
+		else
+		{
+			run();
+		}
+	}
+	t = now_ns() - t;
+
+	CHECK( got + N_BENCH == tao[ 1 ].got );
+
+	return (unsigned)( t / N_BENCH );
+}
+
+static void freertos_test_idle( void )
+{
+	unsigned pub_isr, bcast_isr, pub_task, bcast_task, pub_post, bcast_post;
+	uint8_t p;
+
+	if( step != 0 )
+	{
+		for( p = 1; p <= N_AO; p++ )
+		{
+			if( strcmp( tao[ p ].trace, steps[ step - 1 ].expect[ p ] ) != 0 )
+			{
+				printf( "step %u, AO %u: \"%s\", expected \"%s\"\n", step, p,
+						tao[ p ].trace, steps[ step - 1 ].expect[ p ] );
+				++test_failed;
+			}
+		}
+	}
+
+	for( p = 1; p <= N_AO; p++ )
+	{
+		tao[ p ].len = 0;
+		tao[ p ].trace[ 0 ] = '\0';
+	}
+
+	if( step < Q_DIM( steps ) )
+	{
+		if( steps[ step ].isr )
+		{
+			vPortHostInterrupt( steps[ step ].run );
+		}
+		else
+		{
+			steps[ step ].run();
+		}
+		++step;
+		return;
+	}
+
+	QActive_subscribe( &tao[ 2 ].super, PUB_SIG );
+	QActive_bcastSubscribe( &tao[ 2 ].super, 1U );
+
+	post_ns = 0;
+	pub_isr = bench( isr_publish, 1 );
+	pub_post = (unsigned)( post_ns / N_BENCH );
+	post_ns = 0;
+	bcast_isr = bench( isr_bcast, 1 );
+	bcast_post = (unsigned)( post_ns / N_BENCH );
+	pub_task = bench( task_publish, 0 );
+	bcast_task = bench( task_bcast, 0 );
+
+	printf( "bcast: ns per multicast to %u AOs, the dispatch included\n", N_AO );
+	printf( "  interrupt  publish %5u  bcast %5u\n", pub_isr, bcast_isr );
+	printf( "  task       publish %5u  bcast %5u\n", pub_task, bcast_task );
+	printf( "  the post call of the interrupt alone: publish %u bcast %u\n", pub_post, bcast_post );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QSubscrList subscr[ MAX_PUB_SIG ];
+	static QEvt const *queue[ N_AO + 1 ][ 4 ];
+	static StackType_t stack[ N_AO + 1 ][ configMINIMAL_STACK_SIZE ];
+	uint8_t p;
+
+	QF_init();
+	QF_psInit( subscr, Q_DIM( subscr ) );
+	QF_bcastInit( 1U, &bcast1_evt );
+	QF_bcastInit( 2U, &bcast2_evt );
+
+	for( p = 1; p <= N_AO; p++ )
+	{
+		QActive_ctor( &tao[ p ].super, Q_STATE_CAST( &tao_initial ) );
+		QACTIVE_START( &tao[ p ].super, p, queue[ p ], Q_DIM( queue[ p ] ),
+					   stack[ p ], sizeof( stack[ p ] ), (QEvt *)0 );
+
+		QActive_subscribe( &tao[ p ].super, PUB_SIG );
+		QActive_bcastSubscribe( &tao[ p ].super, 1U );
+		QActive_bcastSubscribe( &tao[ p ].super, 2U );
+	}
+
+	freertos_test_run();
+
+	CHECK( Q_DIM( steps ) == step );
+
+	return TEST_RESULT( "bcast" );
+}
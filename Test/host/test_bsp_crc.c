@@ -0,0 +1,168 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test.h"
+
+/* built in, for crc_hw_begin() and the unit model behind CRC */
+#include "bsp_crc.c"
+
+/*
+ * the table CRC and the cpu fed unit against a bitwise model of the CRC
+ * unit: 32 bit little endian words shifted in msb first, the tail bytes one
+ * by one msb first, no reflection and no final xor.
+ */
+
+static uint32_t model_word( uint32_t crc, uint32_t w )
+{
+	uint8_t i;
+
+	crc ^= w;
+	for( i = 0; i < 32; i++ )
+	{
+		crc = ( crc & 0x80000000U ) ? ( crc << 1 ) ^ CRC_POLY : crc << 1;
+	}
+
+	return crc;
+}
+
+static uint32_t model_byte( uint32_t crc, uint8_t b )
+{
+	uint8_t i;
+
+	crc ^= (uint32_t)b << 24;
+	for( i = 0; i < 8; i++ )
+	{
+		crc = ( crc & 0x80000000U ) ? ( crc << 1 ) ^ CRC_POLY : crc << 1;
+	}
+
+	return crc;
+}
+
+static uint32_t model( uint32_t crc, uint8_t const *p, uint32_t len )
+{
+	for( ; len >= 4; len -= 4, p += 4 )
+	{
+		crc = model_word( crc, p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 ) | ( (uint32_t)p[ 3 ] << 24 ) );
+	}
+	for( ; len != 0; len--, p++ )
+	{
+		crc = model_byte( crc, *p );
+	}
+
+	return crc;
+}
+
+/* the unit: a write to DR is seen at the next access. a word equal to the
+ * current result goes unnoticed, the random data makes that unlikely.
+ */
+static CRC_TypeDef crc_regs;
+static uint32_t crc_result = BSP_CRC_INIT;
+
+CRC_TypeDef *crc_unit_sync( void )
+{
+	if( crc_regs.CR & CRC_CR_RESET )
+	{
+		crc_regs.CR = 0;
+		crc_result = BSP_CRC_INIT;
+	}
+	else if( crc_regs.DR != crc_result )
+	{
+		crc_result = model_word( crc_result, crc_regs.DR );
+	}
+	crc_regs.DR = crc_result;
+
+	return &crc_regs;
+}
+
+DMA_Channel_TypeDef dma1_channel4_model;
+uint32_t dma1_isr_model;
+
+static DMA_Channel_TypeDef *claimed;
+
+void bsp_dma_claim( DMA_Channel_TypeDef *ch )
+{
+	claimed = ch;
+}
+
+QEvt *test_evt_new( uint32_t size, enum_t sig )
+{
+	QEvt *e = calloc( 1, size );
+
+	e->sig = (QSignal)sig;
+	return e;
+}
+
+void test_post( QActive *ao, QEvt const *e )
+{
+	free( (void *)e );
+}
+
+void test_assert( char const *module, int loc )
+{
+	printf( "assert %s:%d\n", module, loc );
+	++test_failed;
+}
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd( void )
+{
+	rnd_state = rnd_state * 1103515245U + 12345U;
+	return rnd_state >> 8;
+}
+
+int main( void )
+{
+	static uint8_t buf[ 300 + 4 ];
+	uint32_t i, off, len, crc, a;
+
+	bsp_crc_init();
+	/* not one of the SPI channels */
+	CHECK( DMA1_Channel4 == claimed );
+
+	/* the check value usually quoted for the unit */
+	CHECK( 0xDF8A8A2BU == model_word( BSP_CRC_INIT, 0x12345678U ) );
+
+	for( i = 0; i < sizeof( buf ); i++ )
+	{
+		buf[ i ] = (uint8_t)rnd();
+	}
+
+	for( i = 0; i < 2000; i++ )
+	{
+		off = i & 3;
+		len = rnd() % 300;
+		crc = ( i & 4 ) ? BSP_CRC_INIT : rnd() ^ ( rnd() << 24 );
+
+		CHECK( model( crc, buf + off, len ) == bsp_crc_sw( crc, buf + off, len ) );
+		CHECK( model( crc, buf + off, len ) == bsp_crc_calc( crc, buf + off, len ) );
+
+		/* continued after a multiple of 4 bytes */
+		a = len & ~3U & ( rnd() | 3U );
+		CHECK( bsp_crc_sw( crc, buf + off, len ) ==
+			   bsp_crc_sw( bsp_crc_sw( crc, buf + off, a ), buf + off + a, len - a ) );
+	}
+
+	/* the word that loads a start value into the reset unit */
+	for( i = 0; i < 1000; i++ )
+	{
+		crc = rnd() ^ ( rnd() << 24 );
+		if( BSP_CRC_INIT == crc )
+		{
+			continue;
+		}
+
+		crc_hw_begin( crc );
+		CHECK( crc == CRC->DR );
+	}
+
+	return TEST_RESULT( "bsp_crc" );
+}
@@ -0,0 +1,205 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+#include "app_signals.h"
+#include "can_bus.h"
+
+/*
+ * the can receive dispatcher on the FreeRTOS port, with the driver
+ * replaced by a ring of frames. a burst for a subscriber below the bus
+ * fills its queue, the frames past the margin are dropped and their events
+ * recycled once, and a frame without a subscriber is dropped too. the pool
+ * is full again after every burst.
+ */
+
+#define N_POOL		6
+#define QLEN		2
+#define QCAP		( QLEN + 1 )	/* the front event and the ring */
+
+enum
+{
+	FRAME_SIG = MAX_SIG
+};
+
+typedef struct
+{
+	QActive super;
+
+	uint32_t got;
+	uint8_t next;		/* data[ 0 ] of the next frame */
+} SUB;
+
+static SUB sub;				/* priority 1 */
+
+/* the driver: the ring of received frames and the rx event */
+static CAN_FRAME rx_ring[ 32 ];
+static uint8_t rx_head;
+static uint8_t rx_tail;
+static uint8_t rx_seq;
+
+static QActive *rx_ao;
+static QEvt rx_evt;
+
+void bsp_can_init( QActive *ao, enum_t rx_sig )
+{
+	rx_ao = ao;
+	rx_evt.sig = (QSignal)rx_sig;
+}
+
+uint8_t bsp_can_filter_set( uint32_t const *ids, uint8_t n )
+{
+	return 1 == n && 0x123 == ids[ 0 ];
+}
+
+uint8_t bsp_can_read( CAN_FRAME *frame )
+{
+	if( rx_tail == rx_head )
+	{
+		return 0;
+	}
+
+	*frame = rx_ring[ rx_tail++ % Q_DIM( rx_ring ) ];
+	return 1;
+}
+
+uint8_t bsp_can_send( CAN_FRAME const *frame )
+{
+	return 0;
+}
+
+void bsp_can_stats( BSP_CAN_STATS *stats )
+{
+	memset( stats, 0, sizeof( *stats ) );
+}
+
+static void rx_frame( uint8_t index )
+{
+	CAN_FRAME *f = &rx_ring[ rx_head++ % Q_DIM( rx_ring ) ];
+
+	f->id = 0x123;
+	f->dlc = 1;
+	f->data[ 0 ] = rx_seq++;
+	f->index = index;
+}
+
+static void isr_rx( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QACTIVE_POST_FROM_ISR( rx_ao, &rx_evt, &woken, (void *)0 );
+	portEND_SWITCHING_ISR( woken );
+}
+
+static QState sub_active( SUB * const me, QEvt const * const e );
+
+static QState sub_initial( SUB * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &sub_active );
+}
+
+static QState sub_active( SUB * const me, QEvt const * const e )
+{
+	CAN_FRAME const *f;
+
+	if( FRAME_SIG == e->sig )
+	{
+		f = &( (CAN_FRAME_EVT const *)e )->frame;
+
+		/* the first frames of the burst, in order */
+		CHECK( 0x123 == f->id && me->next == f->data[ 0 ] );
+		++me->next;
+		++me->got;
+		return Q_HANDLED();
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+typedef struct
+{
+	uint8_t frames;
+	uint8_t stranger;	/* one frame without a subscriber first */
+	uint8_t got;		/* delivered */
+} STEP;
+
+static STEP const steps[] =
+{
+	/* fits the queue */
+	{ 2, 0, 2 },
+
+	/* the queue keeps its margin of one, the rest is dropped */
+	{ 8, 0, QCAP - 1 },
+	{ 8, 1, QCAP - 1 },
+	{ N_POOL + 4, 0, QCAP - 1 },
+};
+
+static unsigned step;
+
+static void freertos_test_idle( void )
+{
+	uint8_t i;
+
+	if( step != 0 )
+	{
+		CHECK( steps[ step - 1 ].got == sub.got );
+
+		/* every event recycled, none of them twice */
+		CHECK( N_POOL == QF_pool_[ 0 ].nTot && QF_pool_[ 0 ].nTot == QF_pool_[ 0 ].nFree );
+		CHECK( rx_tail == rx_head );
+	}
+
+	if( step < Q_DIM( steps ) )
+	{
+		if( steps[ step ].stranger )
+		{
+			rx_frame( 1 );
+		}
+
+		sub.got = 0;
+		sub.next = rx_seq;
+		for( i = 0; i < steps[ step ].frames; i++ )
+		{
+			rx_frame( 0 );
+		}
+		++step;
+
+		vPortHostInterrupt( isr_rx );
+		return;
+	}
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( CAN_FRAME_EVT ) pool[ N_POOL ];
+	static QEvt const *bus_queue[ 2 ];
+	static QEvt const *sub_queue[ QLEN ];
+	static StackType_t stack[ 2 ][ configMINIMAL_STACK_SIZE ];
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	QActive_ctor( &sub.super, Q_STATE_CAST( &sub_initial ) );
+	QACTIVE_START( &sub.super, 1U, sub_queue, Q_DIM( sub_queue ),
+				   stack[ 0 ], sizeof( stack[ 0 ] ), (QEvt *)0 );
+
+	can_bus_ctor();
+	can_bus_subscribe( 0x123, &sub.super, FRAME_SIG );
+	QACTIVE_START( AO_CanBus, 2U, bus_queue, Q_DIM( bus_queue ),
+				   stack[ 1 ], sizeof( stack[ 1 ] ), (QEvt *)0 );
+
+	freertos_test_run();
+
+	CHECK( Q_DIM( steps ) == step );
+
+	return TEST_RESULT( "can_bus" );
+}
@@ -0,0 +1,340 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+/*
+ * coalesced posting on the FreeRTOS port. a pool event waiting as the
+ * front event or in the ring is replaced in place and recycled, from a
+ * task and from an interrupt, and the pool is full again after the
+ * dispatch. then an overload: every event the consumer handles lets
+ * BURST interrupts post a new value, plain posting with a margin drops
+ * and delivers old values, coalesced posting holds one entry and delivers
+ * the newest.
+ */
+
+#define QLEN		4
+#define QCAP		( QLEN + 1 )	/* the front event and the ring */
+#define BURST		3
+#define N_OVER		3000U
+
+enum
+{
+	GO_SIG = Q_USER_SIG,
+	OTHER_SIG,
+	VAL_SIG
+};
+
+typedef struct
+{
+	QEvt super;
+
+	uint32_t v;
+} VAL_EVT;
+
+typedef struct
+{
+	QActive super;
+
+	char trace[ 16 ];
+	unsigned len;
+
+	/* the overload */
+	uint8_t load;
+	uint8_t coalesce;
+	uint32_t dispatched;
+	uint32_t dropped;
+	uint32_t age;
+	uint32_t last;
+} CONS;
+
+static CONS cons;			/* priority 1 */
+static QActive prod;		/* priority 2, posts from a task */
+static uint32_t seq;		/* of the values posted */
+
+static QEvt const go_evt = { GO_SIG, 0U, 0U };
+static QEvt const other_evt = { OTHER_SIG, 0U, 0U };
+
+static uint16_t pool_used( void )
+{
+	return (uint16_t)( QF_pool_[ 0 ].nTot - QF_pool_[ 0 ].nFree );
+}
+
+static void trace_add( char c )
+{
+	if( cons.len < sizeof( cons.trace ) - 1 )
+	{
+		cons.trace[ cons.len++ ] = c;
+		cons.trace[ cons.len ] = '\0';
+	}
+}
+
+static VAL_EVT *val_new( uint32_t v )
+{
+	VAL_EVT *e = Q_NEW( VAL_EVT, VAL_SIG );
+
+	e->v = v;
+	return e;
+}
+
+static VAL_EVT *val_new_from_isr( uint32_t v )
+{
+	VAL_EVT *e = Q_NEW_FROM_ISR( VAL_EVT, VAL_SIG );
+
+	e->v = v;
+	return e;
+}
+
+/* one interrupt of the overload */
+static void isr_value( void )
+{
+	BaseType_t woken = pdFALSE;
+	bool ok;
+
+	++seq;
+	if( cons.coalesce )
+	{
+		ok = QActive_postCoalesceFromISR_( &cons.super, &val_new_from_isr( seq )->super, 0U, &woken );
+	}
+	else
+	{
+		ok = QACTIVE_POST_X_FROM_ISR( &cons.super, &val_new_from_isr( seq )->super, 0U, &woken, (void *)0 );
+	}
+
+	if( !ok )
+	{
+		++cons.dropped;
+	}
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static QState cons_active( CONS * const me, QEvt const * const e );
+
+static QState cons_initial( CONS * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &cons_active );
+}
+
+static QState cons_active( CONS * const me, QEvt const * const e )
+{
+	unsigned i;
+
+	switch( e->sig )
+	{
+		case OTHER_SIG:
+			trace_add( 'o' );
+			return Q_HANDLED();
+
+		case VAL_SIG:
+			if( !me->load )
+			{
+				trace_add( (char)( '0' + ( (VAL_EVT const *)e )->v ) );
+				return Q_HANDLED();
+			}
+
+			++me->dispatched;
+			me->age += seq - ( (VAL_EVT const *)e )->v;
+			me->last = ( (VAL_EVT const *)e )->v;
+
+			/* the values that come in while this one is handled */
+			for( i = 0; i < BURST && seq < N_OVER; i++ )
+			{
+				vPortHostInterrupt( isr_value );
+			}
+			freertos_test_work( 100 );
+			return Q_HANDLED();
+
+		default:
+			break;
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+static QState prod_active( QActive * const me, QEvt const * const e );
+
+static QState prod_initial( QActive * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &prod_active );
+}
+
+static QState prod_active( QActive * const me, QEvt const * const e )
+{
+	if( GO_SIG == e->sig )
+	{
+		/* the consumer is lower, so it waits: front, then ring */
+		QACTIVE_POST( &cons.super, &other_evt, me );
+		QACTIVE_POST_COALESCE( &cons.super, &val_new( 1 )->super, me );
+		CHECK( 1 == pool_used() );
+		QACTIVE_POST_COALESCE( &cons.super, &val_new( 2 )->super, me );
+		CHECK( 1 == pool_used() && QCAP - 2 == cons.super.eQueue.nFree );
+
+		/* replaced in the front event */
+		QACTIVE_POST_COALESCE( &cons.super, &other_evt, me );
+		CHECK( QCAP - 2 == cons.super.eQueue.nFree );
+		return Q_HANDLED();
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+static void isr_front( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QACTIVE_POST_COALESCE_FROM_ISR( &cons.super, &val_new_from_isr( 3 )->super, &woken, (void *)0 );
+	QACTIVE_POST_COALESCE_FROM_ISR( &cons.super, &val_new_from_isr( 4 )->super, &woken, (void *)0 );
+	QACTIVE_POST_FROM_ISR( &cons.super, &other_evt, &woken, (void *)0 );
+	QACTIVE_POST_COALESCE_FROM_ISR( &cons.super, &val_new_from_isr( 5 )->super, &woken, (void *)0 );
+	CHECK( 1 == pool_used() && QCAP - 2 == cons.super.eQueue.nFree );
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void isr_ring( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QACTIVE_POST_FROM_ISR( &cons.super, &other_evt, &woken, (void *)0 );
+	QACTIVE_POST_COALESCE_FROM_ISR( &cons.super, &val_new_from_isr( 6 )->super, &woken, (void *)0 );
+	QACTIVE_POST_COALESCE_FROM_ISR( &cons.super, &val_new_from_isr( 7 )->super, &woken, (void *)0 );
+	CHECK( 1 == pool_used() && QCAP - 2 == cons.super.eQueue.nFree );
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+typedef struct
+{
+	uint32_t dispatched;
+	uint32_t dropped;
+	uint16_t queue_max;
+	uint16_t pool_max;
+	uint32_t age;		/* mean, in posts */
+	uint32_t last;
+} OVERLOAD;
+
+static OVERLOAD over[ 2 ];		/* plain, coalesced */
+
+static void overload_start( uint8_t coalesce )
+{
+	cons.load = 1;
+	cons.coalesce = coalesce;
+	cons.dispatched = 0;
+	cons.dropped = 0;
+	cons.age = 0;
+	seq = 0;
+
+	cons.super.eQueue.nMin = cons.super.eQueue.nFree;
+	QF_pool_[ 0 ].nMin = QF_pool_[ 0 ].nFree;
+
+	vPortHostInterrupt( isr_value );
+}
+
+static void overload_end( OVERLOAD *o )
+{
+	o->dispatched = cons.dispatched;
+	o->dropped = cons.dropped;
+	o->queue_max = (uint16_t)( QCAP - cons.super.eQueue.nMin );
+	o->pool_max = (uint16_t)( QF_pool_[ 0 ].nTot - QF_pool_[ 0 ].nMin );
+	o->age = cons.age / cons.dispatched;
+	o->last = cons.last;
+
+	CHECK( N_OVER == seq && 0 == pool_used() );
+}
+
+static unsigned step;
+
+static void freertos_test_idle( void )
+{
+	static char const *const expect[] = { "o2", "5o", "o7" };
+
+	if( step > 0 && step <= Q_DIM( expect ) )
+	{
+		if( strcmp( cons.trace, expect[ step - 1 ] ) != 0 )
+		{
+			printf( "step %u: \"%s\", expected \"%s\"\n", step, cons.trace, expect[ step - 1 ] );
+			++test_failed;
+		}
+
+		/* the replaced events were recycled, the dispatched ones too */
+		CHECK( 0 == pool_used() );
+	}
+	cons.len = 0;
+	cons.trace[ 0 ] = '\0';
+
+	switch( step++ )
+	{
+		case 0:
+			QACTIVE_POST( &prod, &go_evt, (void *)0 );
+			return;
+
+		case 1:
+			vPortHostInterrupt( isr_front );
+			return;
+
+		case 2:
+			vPortHostInterrupt( isr_ring );
+			return;
+
+		case 3:
+			overload_start( 0 );
+			return;
+
+		case 4:
+			overload_end( &over[ 0 ] );
+			overload_start( 1 );
+			return;
+
+		default:
+			break;
+	}
+
+	overload_end( &over[ 1 ] );
+
+	/* nothing lost, one entry, the last value delivered */
+	CHECK( 0 == over[ 1 ].dropped && 1 == over[ 1 ].queue_max && N_OVER == over[ 1 ].last );
+	CHECK( over[ 0 ].dropped > 0 && QCAP == over[ 0 ].queue_max );
+	CHECK( over[ 1 ].age < over[ 0 ].age );
+
+	printf( "coalesce: %u values, %u per dispatch, queue of %u\n", N_OVER, BURST, QCAP );
+	printf( "            dispatched dropped queue pool  age  last\n" );
+	printf( "  plain     %10u %7u %5u %4u %4u %5u\n", over[ 0 ].dispatched, over[ 0 ].dropped,
+			over[ 0 ].queue_max, over[ 0 ].pool_max, over[ 0 ].age, over[ 0 ].last );
+	printf( "  coalesce  %10u %7u %5u %4u %4u %5u\n", over[ 1 ].dispatched, over[ 1 ].dropped,
+			over[ 1 ].queue_max, over[ 1 ].pool_max, over[ 1 ].age, over[ 1 ].last );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( VAL_EVT ) pool[ 8 ];
+	static QEvt const *cons_queue[ QLEN ];
+	static QEvt const *prod_queue[ 2 ];
+	static StackType_t stack[ 2 ][ configMINIMAL_STACK_SIZE ];
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	QActive_ctor( &cons.super, Q_STATE_CAST( &cons_initial ) );
+	QACTIVE_START( &cons.super, 1U, cons_queue, Q_DIM( cons_queue ),
+				   stack[ 0 ], sizeof( stack[ 0 ] ), (QEvt *)0 );
+
+	QActive_ctor( &prod, Q_STATE_CAST( &prod_initial ) );
+	QACTIVE_START( &prod, 2U, prod_queue, Q_DIM( prod_queue ),
+				   stack[ 1 ], sizeof( stack[ 1 ] ), (QEvt *)0 );
+
+	freertos_test_run();
+
+	CHECK( 6 == step );
+
+	return TEST_RESULT( "coalesce" );
+}
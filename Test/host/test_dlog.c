@@ -0,0 +1,414 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "stm32f10x.h"
+
+#include "rtt_chan.h"
+#include "dlog.h"
+
+#include "dlog_format.h"
+
+#include "test.h"
+
+/*
+ * the ring against the stream it must produce: whole records in
+ * reservation order, drops counted, nothing lost or doubled when a call
+ * site is interrupted by another one between its LDREX and STREX or while
+ * it fills its slot.
+ *
+ * the records are formatted by the host decoder with their format strings
+ * looked up in the dlog_fmt section by the header address. built without
+ * PIE, so the addresses fit the 32 bit arguments.
+ */
+
+#define REC_MAX		( 3 * DLOG_SLOTS + 16 )
+
+static char const fmt_a[] = "a";
+static char const fmt_b[] = "b %u";
+static char const fmt_irq[] = "irq %u";
+
+/* the RTT up buffer: bytes written, room left for the next writes */
+static uint32_t rtt_out[ 8 * REC_MAX ];
+static unsigned rtt_len;
+static unsigned rtt_room;
+
+unsigned rtt_chan_space( RTT_CHAN ch )
+{
+	CHECK( RTT_CHAN_DLOG == ch );
+	return rtt_room;
+}
+
+unsigned rtt_chan_write( RTT_CHAN ch, void const *p, unsigned n )
+{
+	CHECK( RTT_CHAN_DLOG == ch && n <= rtt_room && 0 == ( n & 3 ) );
+	CHECK( rtt_len + n <= sizeof( rtt_out ) );
+
+	memcpy( (uint8_t *)rtt_out + rtt_len, p, n );
+	rtt_len += n;
+	rtt_room -= n;
+
+	return n;
+}
+
+/* the interrupt to run at the next STREX or cycle counter read */
+static void ( *irq_strex )( void );
+static void ( *irq_dwt )( void );
+static uint8_t monitor;
+
+static void irq_run( void ( **irq )( void ) )
+{
+	void ( *f )( void ) = *irq;
+
+	if( f != NULL )
+	{
+		*irq = NULL;
+		f();
+		monitor = 0;
+	}
+}
+
+uint32_t test_ldrex( volatile uint32_t *addr )
+{
+	monitor = 1;
+	return *addr;
+}
+
+uint32_t test_strex( uint32_t value, volatile uint32_t *addr )
+{
+	irq_run( &irq_strex );
+
+	if( !monitor )
+	{
+		return 1;
+	}
+	monitor = 0;
+	*addr = value;
+
+	return 0;
+}
+
+void test_clrex( void )
+{
+	monitor = 0;
+}
+
+DWT_Type *test_dwt( void )
+{
+	static DWT_Type regs;
+
+	irq_run( &irq_dwt );
+	regs.CYCCNT += 7;
+
+	return &regs;
+}
+
+/* the stream cut into records */
+typedef struct
+{
+	uint32_t hdr;
+	uint32_t n;
+	uint32_t arg[ 4 ];
+} REC;
+
+static REC recs[ REC_MAX ];
+static unsigned n_recs;
+
+static void parse( void )
+{
+	unsigned i = 0, k;
+	REC *r;
+
+	n_recs = 0;
+	CHECK( 0 == ( rtt_len & 3 ) );
+
+	while( i < rtt_len / 4 && n_recs < REC_MAX )
+	{
+		r = &recs[ n_recs++ ];
+		r->hdr = rtt_out[ i ];
+		r->n = r->hdr >> 28;
+		CHECK( r->n <= 4 && i + 2 + r->n <= rtt_len / 4 );
+
+		for( k = 0; k < r->n && k < 4; k++ )
+		{
+			r->arg[ k ] = rtt_out[ i + 2 + k ];
+		}
+		i += 2 + r->n;
+	}
+}
+
+static void out_reset( unsigned room )
+{
+	rtt_len = 0;
+	rtt_room = room;
+}
+
+static uint8_t rec_is( REC const *r, char const *fmt, uint32_t n, uint32_t a )
+{
+	return r->hdr == ( ( n << 28 ) | ( (uint32_t)(uintptr_t)fmt & 0x0FFFFFFF ) ) &&
+		   ( 0 == n || r->arg[ 0 ] == a );
+}
+
+static void test_format( void )
+{
+	out_reset( sizeof( rtt_out ) );
+
+	dlog_write( fmt_a, 0, 0, 0, 0, 0 );
+	dlog_write( fmt_b, 1, 11, 0, 0, 0 );
+	DLOG4( "%u %u %u %u", 1, 2, 3, 4 );
+	dlog_flush();
+	parse();
+
+	CHECK( 3 == n_recs );
+	CHECK( rec_is( &recs[ 0 ], fmt_a, 0, 0 ) );
+	CHECK( rec_is( &recs[ 1 ], fmt_b, 1, 11 ) );
+	CHECK( 4 == recs[ 2 ].n && ( recs[ 2 ].hdr & 0x0FFFFFFF ) != 0 );
+	CHECK( 1 == recs[ 2 ].arg[ 0 ] && 2 == recs[ 2 ].arg[ 1 ] &&
+		   3 == recs[ 2 ].arg[ 2 ] && 4 == recs[ 2 ].arg[ 3 ] );
+	CHECK( 8 + 0 + 8 + 4 + 8 + 16 == rtt_len );
+}
+
+/* more records than slots: the rest is counted and reported */
+static void test_full( void )
+{
+	uint32_t i;
+
+	out_reset( sizeof( rtt_out ) );
+
+	for( i = 0; i < DLOG_SLOTS + 5; i++ )
+	{
+		dlog_write( fmt_b, 1, i, 0, 0, 0 );
+	}
+	dlog_flush();
+	parse();
+
+	CHECK( DLOG_SLOTS + 1 == n_recs );
+	CHECK( recs[ 0 ].hdr == 1U << 28 && 5 == recs[ 0 ].arg[ 0 ] );
+	for( i = 0; i < DLOG_SLOTS && i + 1 < n_recs; i++ )
+	{
+		CHECK( rec_is( &recs[ i + 1 ], fmt_b, 1, i ) );
+	}
+
+	/* room again */
+	out_reset( sizeof( rtt_out ) );
+	dlog_write( fmt_a, 0, 0, 0, 0, 0 );
+	dlog_flush();
+	parse();
+	CHECK( 1 == n_recs && rec_is( &recs[ 0 ], fmt_a, 0, 0 ) );
+}
+
+/* RTT short of room: whole records, the others stay for the next flush */
+static void test_room( void )
+{
+	out_reset( 8 + 4 + 8 + 3 );
+
+	dlog_write( fmt_b, 1, 1, 0, 0, 0 );
+	dlog_write( fmt_b, 1, 2, 0, 0, 0 );
+	dlog_flush();
+	CHECK( 12 == rtt_len );
+
+	rtt_room = 12;
+	dlog_flush();
+	parse();
+	CHECK( 2 == n_recs && rec_is( &recs[ 0 ], fmt_b, 1, 1 ) && rec_is( &recs[ 1 ], fmt_b, 1, 2 ) );
+}
+
+static void irq_log( void )
+{
+	dlog_write( fmt_irq, 1, 99, 0, 0, 0 );
+}
+
+static unsigned irq_flushed;
+
+static void irq_log_flush( void )
+{
+	unsigned len = rtt_len;
+
+	dlog_write( fmt_irq, 1, 98, 0, 0, 0 );
+	dlog_flush();
+	irq_flushed = rtt_len - len;
+}
+
+/* a nested call site between the LDREX and STREX of the head, and one
+ * while the slot is filled that also flushes
+ */
+static void test_nested( void )
+{
+	out_reset( sizeof( rtt_out ) );
+
+	irq_strex = irq_log;
+	dlog_write( fmt_a, 0, 0, 0, 0, 0 );
+	CHECK( NULL == irq_strex );
+
+	irq_dwt = irq_log_flush;
+	dlog_write( fmt_b, 1, 7, 0, 0, 0 );
+	CHECK( NULL == irq_dwt );
+
+	/* the flush saw the older records, it stopped at the one being filled */
+	CHECK( 8 + 12 == irq_flushed );
+
+	dlog_flush();
+	parse();
+
+	CHECK( 4 == n_recs );
+	CHECK( rec_is( &recs[ 0 ], fmt_irq, 1, 99 ) );
+	CHECK( rec_is( &recs[ 1 ], fmt_a, 0, 0 ) );
+	CHECK( rec_is( &recs[ 2 ], fmt_b, 1, 7 ) );
+	CHECK( rec_is( &recs[ 3 ], fmt_irq, 1, 98 ) );
+}
+
+/* the bounds of the section, from the linker */
+extern char const __start_dlog_fmt[];
+extern char const __stop_dlog_fmt[];
+
+static char const str_led[] = "led";
+
+static char const *image_str( uint32_t addr, void *ctx )
+{
+	return (char const *)(uintptr_t)addr;
+}
+
+/* the text of a record, as the decoder takes it from the .axf */
+static char const *rec_text( REC const *r )
+{
+	static char text[ 128 ];
+	char const *fmt = (char const *)( ( (uintptr_t)__start_dlog_fmt & ~(uintptr_t)0x0FFFFFFF ) |
+									  ( r->hdr & 0x0FFFFFFF ) );
+
+	CHECK( fmt >= __start_dlog_fmt && fmt < __stop_dlog_fmt );
+	dlog_format( text, sizeof( text ), fmt, r->arg, r->n, image_str, NULL );
+
+	return text;
+}
+
+static void test_decode( void )
+{
+	char text[ 8 ];
+
+	out_reset( sizeof( rtt_out ) );
+
+	/* the line of led_task */
+	DLOG2( "tick:%u,system heap:%u.\r\n", 1234, 5000 );
+	DLOG4( "%s %-4d|%08x|%c", str_led, -5, 0xBEEF, 'x' );
+	DLOG4( "%u%%|%.2s|%*u", 7, str_led, 4, 9 );
+	DLOG1( "%lu %u", 1 );
+	dlog_flush();
+	parse();
+
+	CHECK( 4 == n_recs );
+	CHECK( 0 == strcmp( rec_text( &recs[ 0 ] ), "tick:1234,system heap:5000.\r\n" ) );
+	CHECK( 0 == strcmp( rec_text( &recs[ 1 ] ), "led -5  |0000beef|x" ) );
+	CHECK( 0 == strcmp( rec_text( &recs[ 2 ] ), "7%|le|   9" ) );
+
+	/* an argument short */
+	CHECK( 0 == strcmp( rec_text( &recs[ 3 ] ), "1 <?u>" ) );
+
+	/* truncated, terminated */
+	CHECK( 4 == dlog_format( text, sizeof( text ), "%u", recs[ 0 ].arg, 1, image_str, NULL ) );
+	CHECK( 0 == strcmp( text, "1234" ) );
+	CHECK( 7 == dlog_format( text, sizeof( text ), "tick:%u", recs[ 0 ].arg, 1, image_str, NULL ) );
+	CHECK( 0 == strcmp( text, "tick:12" ) );
+}
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd( void )
+{
+	rnd_state = rnd_state * 1103515245U + 12345U;
+	return rnd_state >> 8;
+}
+
+static uint32_t stress_next;
+
+static void irq_stress( void )
+{
+	dlog_write( fmt_irq, 1, stress_next++, 0, 0, 0 );
+}
+
+/* many times round the ring: every record once, or counted as dropped */
+static void test_stress( void )
+{
+	static uint8_t seen[ 400000 ];
+	uint32_t i, k, dropped = 0, emitted = 0;
+
+	stress_next = 0;
+
+	for( i = 0; i < 5000; i++ )
+	{
+		out_reset( rnd() % 2 ? sizeof( rtt_out ) : rnd() % 200 );
+
+		for( k = rnd() % ( DLOG_SLOTS + 8 ); k != 0; k-- )
+		{
+			if( rnd() % 4 == 0 )
+			{
+				irq_strex = irq_stress;
+			}
+			else if( rnd() % 4 == 0 )
+			{
+				irq_dwt = irq_stress;
+			}
+			dlog_write( fmt_b, 1, stress_next++, 0, 0, 0 );
+			irq_strex = NULL;
+			irq_dwt = NULL;
+		}
+
+		dlog_flush();
+		parse();
+
+		for( k = 0; k < n_recs; k++ )
+		{
+			if( recs[ k ].hdr == 1U << 28 )
+			{
+				dropped += recs[ k ].arg[ 0 ];
+			}
+			else
+			{
+				CHECK( recs[ k ].arg[ 0 ] < sizeof( seen ) && !seen[ recs[ k ].arg[ 0 ] ] );
+				seen[ recs[ k ].arg[ 0 ] % sizeof( seen ) ] = 1;
+				++emitted;
+			}
+		}
+	}
+
+	/* drain */
+	for( i = 0; i < 4; i++ )
+	{
+		out_reset( sizeof( rtt_out ) );
+		dlog_flush();
+		parse();
+		for( k = 0; k < n_recs; k++ )
+		{
+			if( recs[ k ].hdr == 1U << 28 )
+			{
+				dropped += recs[ k ].arg[ 0 ];
+			}
+			else
+			{
+				++emitted;
+			}
+		}
+	}
+
+	CHECK( stress_next < sizeof( seen ) );
+	CHECK( emitted + dropped == stress_next );
+	CHECK( dropped != 0 && emitted > dropped );
+}
+
+int main( void )
+{
+	test_format();
+	test_full();
+	test_room();
+	test_nested();
+	test_decode();
+	test_stress();
+
+	return TEST_RESULT( "dlog" );
+}
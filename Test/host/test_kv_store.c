@@ -0,0 +1,414 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "test.h"
+
+/* built in, for the store object and the state handlers */
+#include "kv_store.c"
+
+/*
+ * the store over a RAM model of its flash pages, mapped at KV_FLASH_BASE so
+ * the 32 bit record addresses of the index stay valid. the model refuses
+ * to program a halfword twice and can cut the power before any halfword:
+ * the rebuilt store must then hold every committed value, the one being
+ * written either old or new.
+ */
+
+#define KV_KEYS		( KV_INDEX_SIZE - 1 )
+
+static uint8_t *flash;
+static uint8_t flash_locked = 1;
+static uint32_t flash_erases;
+static long cut_countdown = -1;		/* halfwords until the power cut */
+static jmp_buf cut_jmp;
+
+void FLASH_Unlock( void )
+{
+	flash_locked = 0;
+}
+
+void FLASH_Lock( void )
+{
+	flash_locked = 1;
+}
+
+void FLASH_ClearFlag( uint32_t flags )
+{
+}
+
+FLASH_Status FLASH_ProgramHalfWord( uint32_t addr, uint16_t data )
+{
+	uint16_t *p = (uint16_t *)(uintptr_t)addr;
+
+	CHECK( !flash_locked );
+	CHECK( 0 == ( addr & 1 ) && addr >= KV_FLASH_BASE && addr < KV_FLASH_BASE + KV_PAGES * KV_PAGE_SIZE );
+
+	if( cut_countdown >= 0 && 0 == cut_countdown-- )
+	{
+		longjmp( cut_jmp, 1 );
+	}
+
+	/* the F103 only programs an erased halfword */
+	CHECK( 0xFFFF == *p );
+	*p = data;
+
+	return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ErasePage( uint32_t addr )
+{
+	CHECK( !flash_locked );
+	CHECK( 0 == ( addr - KV_FLASH_BASE ) % KV_PAGE_SIZE );
+
+	/* the index must not lead into the page, readers run meanwhile */
+	CHECK( !kv_store.lock->held );
+
+	memset( (void *)(uintptr_t)addr, 0xFF, KV_PAGE_SIZE );
+	++flash_erases;
+
+	return FLASH_COMPLETE;
+}
+
+DWT_Type *test_dwt( void )
+{
+	static DWT_Type regs;
+
+	return &regs;
+}
+
+void test_mutex_deadlock( SemaphoreHandle_t m )
+{
+	printf( "mutex taken twice\n" );
+	++test_failed;
+}
+
+void test_assert( char const *module, int loc )
+{
+	printf( "assert %s:%d\n", module, loc );
+	++test_failed;
+}
+
+static uint32_t compact_posts;
+
+void test_post( QActive *ao, QEvt const *e )
+{
+	CHECK( AO_KvStore == ao && KV_COMPACT_SIG == e->sig );
+	++compact_posts;
+}
+
+QEvt *test_evt_new( uint32_t size, enum_t sig )
+{
+	return NULL;
+}
+
+QState QHsm_top( void const * const me, QEvt const * const e )
+{
+	return Q_HANDLED();
+}
+
+/* bsp_crc.c is linked for bsp_crc_sw(), the unit is not used */
+CRC_TypeDef *crc_unit_sync( void )
+{
+	static CRC_TypeDef regs;
+
+	return &regs;
+}
+
+DMA_Channel_TypeDef dma1_channel4_model;
+uint32_t dma1_isr_model;
+
+void bsp_dma_claim( DMA_Channel_TypeDef *ch )
+{
+}
+
+/* what the store should hold */
+static uint8_t ref_val[ KV_KEYS ][ KV_VALUE_MAX ];
+static uint16_t ref_len[ KV_KEYS ];		/* 0: not there */
+
+static uint32_t rnd_state = 1;
+
+static uint32_t rnd( void )
+{
+	rnd_state = rnd_state * 1103515245U + 12345U;
+	return rnd_state >> 8;
+}
+
+/* the compaction events, as the active object would take them */
+static void kv_run( void )
+{
+	while( compact_posts != 0 )
+	{
+		--compact_posts;
+		CHECK( Q_RET_HANDLED == kv_store_active( &kv_store, &kv_compact_evt ) );
+	}
+}
+
+/* reset: mount and start as main() does */
+static void kv_boot( void )
+{
+	memset( &kv_store, 0, sizeof( kv_store ) );
+	compact_posts = 0;
+	flash_locked = 1;
+
+	kv_store_ctor();
+	CHECK( Q_RET_TRAN == kv_store_initial( &kv_store, NULL ) );
+	kv_run();
+}
+
+static void kv_format( void )
+{
+	memset( flash, 0xFF, KV_PAGES * KV_PAGE_SIZE );
+	memset( ref_len, 0, sizeof( ref_len ) );
+	kv_boot();
+}
+
+static uint8_t kv_same( uint16_t key )
+{
+	uint8_t buf[ KV_VALUE_MAX ];
+	int16_t n = kv_get( key, buf, sizeof( buf ) );
+
+	if( 0 == ref_len[ key ] )
+	{
+		return KV_ERR_NOT_FOUND == n;
+	}
+
+	return n == ref_len[ key ] && 0 == memcmp( buf, ref_val[ key ], n );
+}
+
+static void kv_check_all( void )
+{
+	uint16_t key;
+
+	for( key = 0; key < KV_KEYS; key++ )
+	{
+		CHECK( kv_same( key ) );
+	}
+}
+
+static void test_basic( void )
+{
+	uint8_t buf[ KV_VALUE_MAX + 1 ];
+
+	kv_format();
+
+	CHECK( KV_ERR_NOT_FOUND == kv_get( 1, buf, sizeof( buf ) ) );
+	CHECK( KV_ERR_SIZE == kv_put( 1, buf, 0 ) );
+	CHECK( KV_ERR_SIZE == kv_put( 1, buf, KV_VALUE_MAX + 1 ) );
+	CHECK( KV_ERR_SIZE == kv_put( KV_KEY_FREE, buf, 1 ) );
+
+	CHECK( KV_OK == kv_put( 1, "abcde", 5 ) );
+	CHECK( 5 == kv_get( 1, buf, sizeof( buf ) ) && 0 == memcmp( buf, "abcde", 5 ) );
+	CHECK( KV_ERR_SIZE == kv_get( 1, buf, 4 ) );
+
+	CHECK( KV_OK == kv_put( 1, "xy", 2 ) );
+	CHECK( 2 == kv_get( 1, buf, sizeof( buf ) ) && 0 == memcmp( buf, "xy", 2 ) );
+
+	CHECK( KV_OK == kv_del( 1 ) );
+	CHECK( KV_ERR_NOT_FOUND == kv_get( 1, buf, sizeof( buf ) ) );
+	CHECK( KV_ERR_NOT_FOUND == kv_del( 1 ) );
+
+	/* the log survives the reset */
+	CHECK( KV_OK == kv_put( 2, "keep", 4 ) );
+	kv_boot();
+	CHECK( 4 == kv_get( 2, buf, sizeof( buf ) ) && 0 == memcmp( buf, "keep", 4 ) );
+	CHECK( KV_ERR_NOT_FOUND == kv_get( 1, buf, sizeof( buf ) ) );
+}
+
+/* one more key than the index takes, deleted keys holding their slots */
+static void test_index_full( void )
+{
+	uint32_t v;
+	uint16_t key;
+
+	kv_format();
+
+	for( key = 0; key < KV_KEYS; key++ )
+	{
+		v = key;
+		CHECK( KV_OK == kv_put( key, &v, 4 ) );
+	}
+	CHECK( KV_ERR_FULL == kv_put( KV_KEYS, &v, 4 ) );
+	CHECK( KV_OK == kv_put( 0, &v, 4 ) );
+	kv_run();
+
+	/* all of them live: nothing for the compaction */
+	CHECK( 0 == flash_erases );
+
+	for( key = 0; key < 8; key++ )
+	{
+		CHECK( KV_OK == kv_del( key ) );
+	}
+	CHECK( KV_ERR_FULL == kv_put( KV_KEYS, &v, 4 ) );
+	kv_run();
+
+	/* the compaction dropped the deletes */
+	CHECK( KV_OK == kv_put( KV_KEYS, &v, 4 ) );
+	CHECK( 4 == kv_get( KV_KEYS, &v, 4 ) );
+
+	kv_boot();
+	CHECK( 4 == kv_get( KV_KEYS, &v, 4 ) );
+	CHECK( KV_ERR_NOT_FOUND == kv_get( 0, &v, 4 ) );
+	CHECK( 4 == kv_get( 8, &v, 4 ) && 8 == v );
+}
+
+/* the operation under way: a put of op_val, op_len 0 a delete */
+static uint16_t op_key;
+static uint8_t op_val[ KV_VALUE_MAX ];
+static uint16_t op_len;
+
+/* one random put or delete, the reference follows when it succeeded */
+static void kv_random_op( uint16_t keys )
+{
+	uint8_t *val = op_val;
+	uint16_t key = rnd() % keys;
+	uint16_t len, i;
+	int16_t ret;
+
+	op_key = key;
+	op_len = 0;
+
+	if( rnd() % 8 == 0 )
+	{
+		ret = kv_del( key );
+		CHECK( ret == ( ref_len[ key ] ? KV_OK : KV_ERR_NOT_FOUND ) );
+		if( KV_OK == ret )
+		{
+			ref_len[ key ] = 0;
+		}
+		return;
+	}
+
+	len = 1 + rnd() % KV_VALUE_MAX;
+	for( i = 0; i < len; i++ )
+	{
+		val[ i ] = (uint8_t)rnd();
+	}
+	op_len = len;
+
+	ret = kv_put( key, val, len );
+	CHECK( KV_OK == ret || KV_ERR_FULL == ret );
+	if( KV_OK == ret )
+	{
+		memcpy( ref_val[ key ], val, len );
+		ref_len[ key ] = len;
+	}
+}
+
+/* many times the store of writes, the compaction running between them */
+static void test_random( void )
+{
+	uint32_t n;
+
+	kv_format();
+	flash_erases = 0;
+
+	for( n = 0; n < 20000; n++ )
+	{
+		kv_random_op( 24 );
+		if( rnd() % 4 == 0 )
+		{
+			kv_run();
+		}
+		if( n % 1000 == 999 )
+		{
+			kv_check_all();
+			kv_boot();
+			kv_check_all();
+		}
+	}
+
+	CHECK( flash_erases > KV_PAGES );
+}
+
+/* the write amplification and the wear of one boot of random writes, the
+ * cycle counter is not modelled here
+ */
+static void test_wear( void )
+{
+	uint32_t n;
+
+	kv_format();
+	flash_erases = 0;
+
+	for( n = 0; n < 4000; n++ )
+	{
+		kv_random_op( 24 );
+		kv_run();
+	}
+	kv_check_all();
+
+	CHECK( kv_store.user_bytes != 0 && kv_store.flash_bytes < 4 * kv_store.user_bytes );
+
+	printf( "kv_store: 4000 random writes of 24 keys\n" );
+	kv_store_report( 0 );
+}
+
+/* the power goes at a random halfword of a write or a compaction step */
+static void test_power_cut( void )
+{
+	uint8_t buf[ KV_VALUE_MAX ];
+	uint32_t volatile n, cuts = 0;
+	int16_t len;
+
+	kv_format();
+
+	for( n = 0; n < 4000; n++ )
+	{
+		cut_countdown = rnd() % 64;
+		if( 0 == setjmp( cut_jmp ) )
+		{
+			kv_random_op( 16 );
+			kv_run();
+			cut_countdown = -1;
+			continue;
+		}
+		cut_countdown = -1;
+		++cuts;
+
+		kv_boot();
+
+		/* the key written is old or new, every other one as it was */
+		len = kv_get( op_key, buf, sizeof( buf ) );
+		if( len < 0 )
+		{
+			len = 0;
+		}
+		if( len == op_len && 0 == memcmp( buf, op_val, len ) )
+		{
+			memcpy( ref_val[ op_key ], op_val, len );
+			ref_len[ op_key ] = len;
+		}
+		kv_check_all();
+	}
+
+	CHECK( cuts > 1000 );
+}
+
+int main( void )
+{
+	flash = mmap( (void *)(uintptr_t)KV_FLASH_BASE, KV_PAGES * KV_PAGE_SIZE, PROT_READ | PROT_WRITE,
+				  MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0 );
+	if( flash != (uint8_t *)(uintptr_t)KV_FLASH_BASE )
+	{
+		printf( "kv_store: no mapping at 0x%08X\n", (unsigned)KV_FLASH_BASE );
+		return 1;
+	}
+
+	test_basic();
+	test_index_full();
+	test_random();
+	test_power_cut();
+	test_wear();
+
+	return TEST_RESULT( "kv_store" );
+}
@@ -0,0 +1,318 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+/*
+ * the sparse subscriber table of QF_PS_SPARSE on the FreeRTOS port: the
+ * table stays sorted by signal and holds only the subscribed signals while
+ * the AOs subscribe, unsubscribe and unsubscribe from all in any order, a
+ * random run is checked against a dense reference, and QF_PUBLISH() and
+ * QF_PUBLISH_FROM_ISR() reach the subscribers of a sparse signal only.
+ */
+
+#define N_AO		3
+#define N_STO		16
+#define N_RANDOM	2000U
+
+enum
+{
+	SIG_5 = Q_USER_SIG + 5,
+	SIG_10 = Q_USER_SIG + 10,
+	SIG_20 = Q_USER_SIG + 20,
+	SIG_30 = Q_USER_SIG + 30,
+	MAX_PUB_SIG = Q_USER_SIG + 40
+};
+
+typedef struct
+{
+	QActive super;
+
+	uint32_t got[ MAX_PUB_SIG ];
+} TAO;
+
+static TAO tao[ N_AO + 1 ];		/* by priority, 0 unused */
+static QSubscrEntry sto[ N_STO ];
+
+static QState tao_active( TAO * const me, QEvt const * const e );
+
+static QState tao_initial( TAO * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &tao_active );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e )
+{
+	if( e->sig >= Q_USER_SIG && e->sig < MAX_PUB_SIG )
+	{
+		++me->got[ e->sig ];
+		freertos_test_work( 100 );
+		return Q_HANDLED();
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+/* the subscribers as bits 1..N_AO, single threaded here */
+static uint8_t subscribers( QSignal sig )
+{
+	QSubscrList set = QF_psFindSparse_( sig );
+	uint8_t mask = 0;
+	uint8_t p;
+
+	for( p = 1; p <= N_AO; p++ )
+	{
+		if( QPSet_hasElement( &set, p ) )
+		{
+			mask |= (uint8_t)( 1U << p );
+		}
+	}
+
+	return mask;
+}
+
+/* the first entries of the table are exactly these signals and sets */
+static int table_is( QSignal const *sig, uint8_t const *mask, unsigned n )
+{
+	unsigned i;
+
+	for( i = 0; i < n; i++ )
+	{
+		if( sto[ i ].sig != sig[ i ] || subscribers( sig[ i ] ) != mask[ i ] )
+		{
+			printf( "entry %u: signal %u, expected %u\n", i, (unsigned)sto[ i ].sig, (unsigned)sig[ i ] );
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+#define TABLE_IS( ... )		do { \
+	static QSignal const s_[] = { __VA_ARGS__ }; \
+	CHECK( table_is( s_, m_, Q_DIM( s_ ) ) ); \
+} while( 0 )
+
+#define B( p )	( 1U << ( p ) )
+
+static void table_order( void )
+{
+	QActive_subscribe( &tao[ 1 ].super, SIG_30 );
+	QActive_subscribe( &tao[ 1 ].super, SIG_10 );
+	QActive_subscribe( &tao[ 2 ].super, SIG_20 );
+	QActive_subscribe( &tao[ 2 ].super, SIG_10 );
+	QActive_subscribe( &tao[ 3 ].super, SIG_30 );
+	{
+		static uint8_t const m_[] = { B( 1 ) | B( 2 ), B( 2 ), B( 1 ) | B( 3 ) };
+		TABLE_IS( SIG_10, SIG_20, SIG_30 );
+	}
+
+	/* below all of them, the entries move up */
+	QActive_subscribe( &tao[ 3 ].super, SIG_5 );
+	{
+		static uint8_t const m_[] = { B( 3 ), B( 1 ) | B( 2 ), B( 2 ), B( 1 ) | B( 3 ) };
+		TABLE_IS( SIG_5, SIG_10, SIG_20, SIG_30 );
+	}
+
+	/* the last subscriber of 20 gone, the entry is dropped */
+	QActive_unsubscribe( &tao[ 2 ].super, SIG_20 );
+	{
+		static uint8_t const m_[] = { B( 3 ), B( 1 ) | B( 2 ), B( 1 ) | B( 3 ) };
+		TABLE_IS( SIG_5, SIG_10, SIG_30 );
+	}
+
+	/* not subscribed, nothing changes */
+	QActive_unsubscribe( &tao[ 2 ].super, SIG_30 );
+	QActive_unsubscribe( &tao[ 2 ].super, SIG_20 );
+	{
+		static uint8_t const m_[] = { B( 3 ), B( 1 ) | B( 2 ), B( 1 ) | B( 3 ) };
+		TABLE_IS( SIG_5, SIG_10, SIG_30 );
+	}
+
+	/* one of two */
+	QActive_unsubscribe( &tao[ 1 ].super, SIG_10 );
+	{
+		static uint8_t const m_[] = { B( 3 ), B( 2 ), B( 1 ) | B( 3 ) };
+		TABLE_IS( SIG_5, SIG_10, SIG_30 );
+	}
+
+	/* drops 5, the only one of 3, keeps 30 for 1, compacted in order */
+	QActive_unsubscribeAll( &tao[ 3 ].super );
+	{
+		static uint8_t const m_[] = { B( 2 ), B( 1 ) };
+		TABLE_IS( SIG_10, SIG_30 );
+	}
+
+	CHECK( 0 == subscribers( SIG_5 ) && 0 == subscribers( SIG_20 ) );
+	CHECK( 0 == subscribers( Q_USER_SIG ) && 0 == subscribers( MAX_PUB_SIG - 1 ) );
+
+	QActive_unsubscribeAll( &tao[ 1 ].super );
+	QActive_unsubscribeAll( &tao[ 2 ].super );
+	CHECK( 0 == subscribers( SIG_10 ) && 0 == subscribers( SIG_30 ) );
+
+	/* the first subscription goes to entry 0 again */
+	QActive_subscribe( &tao[ 2 ].super, SIG_20 );
+	{
+		static uint8_t const m_[] = { B( 2 ) };
+		TABLE_IS( SIG_20 );
+	}
+	QActive_unsubscribeAll( &tao[ 2 ].super );
+}
+
+/* random operations on N_STO signals against a dense reference */
+static void table_random( void )
+{
+	uint8_t ref[ MAX_PUB_SIG ] = { 0 };
+	uint32_t seed = 1;
+	unsigned i, n, k;
+	enum_t sig;
+
+	for( i = 0; i < N_RANDOM; i++ )
+	{
+		uint8_t p;
+
+		seed = seed * 1103515245U + 12345U;
+		p = (uint8_t)( 1U + ( seed >> 16 ) % N_AO );
+		sig = (enum_t)( Q_USER_SIG + ( seed >> 20 ) % N_STO * 2U );
+
+		switch( ( seed >> 28 ) % 8U )
+		{
+			case 0:
+				QActive_unsubscribeAll( &tao[ p ].super );
+				for( k = Q_USER_SIG; k < MAX_PUB_SIG; k++ )
+				{
+					ref[ k ] &= (uint8_t)~B( p );
+				}
+				break;
+
+			case 1:
+			case 2:
+			case 3:
+				QActive_unsubscribe( &tao[ p ].super, sig );
+				ref[ sig ] &= (uint8_t)~B( p );
+				break;
+
+			default:
+				QActive_subscribe( &tao[ p ].super, sig );
+				ref[ sig ] |= (uint8_t)B( p );
+				break;
+		}
+
+		/* the subscribed signals in order, then nothing else */
+		n = 0;
+		for( k = Q_USER_SIG; k < MAX_PUB_SIG; k++ )
+		{
+			if( subscribers( (QSignal)k ) != ref[ k ] )
+			{
+				printf( "op %u: signal %u has 0x%x, expected 0x%x\n", i, k, subscribers( (QSignal)k ), ref[ k ] );
+				++test_failed;
+				return;
+			}
+			if( ref[ k ] != 0 )
+			{
+				if( sto[ n ].sig != k )
+				{
+					printf( "op %u: entry %u holds %u, expected %u\n", i, n, (unsigned)sto[ n ].sig, k );
+					++test_failed;
+					return;
+				}
+				++n;
+			}
+		}
+	}
+
+	for( k = 1; k <= N_AO; k++ )
+	{
+		QActive_unsubscribeAll( &tao[ k ].super );
+	}
+	for( k = Q_USER_SIG; k < MAX_PUB_SIG; k++ )
+	{
+		CHECK( 0 == subscribers( (QSignal)k ) );
+	}
+}
+
+static void isr_publish( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QF_PUBLISH_FROM_ISR( Q_NEW_FROM_ISR( QEvt, SIG_20 ), &woken, (void *)0 );
+	QF_PUBLISH_FROM_ISR( Q_NEW_FROM_ISR( QEvt, SIG_30 ), &woken, (void *)0 );
+	portEND_SWITCHING_ISR( woken );
+}
+
+static unsigned step;
+
+static void freertos_test_idle( void )
+{
+	switch( step++ )
+	{
+		case 0:
+			/* 10 to 1 and 3, 30 to 2, 20 to nobody */
+			QActive_subscribe( &tao[ 3 ].super, SIG_10 );
+			QActive_subscribe( &tao[ 1 ].super, SIG_10 );
+			QActive_subscribe( &tao[ 2 ].super, SIG_30 );
+
+			QF_PUBLISH( Q_NEW( QEvt, SIG_10 ), (void *)0 );
+			QF_PUBLISH( Q_NEW( QEvt, SIG_20 ), (void *)0 );
+			QF_PUBLISH( Q_NEW( QEvt, SIG_30 ), (void *)0 );
+			return;
+
+		case 1:
+			CHECK( 1 == tao[ 1 ].got[ SIG_10 ] && 0 == tao[ 2 ].got[ SIG_10 ] && 1 == tao[ 3 ].got[ SIG_10 ] );
+			CHECK( 0 == tao[ 1 ].got[ SIG_30 ] && 1 == tao[ 2 ].got[ SIG_30 ] && 0 == tao[ 3 ].got[ SIG_30 ] );
+			CHECK( 0 == tao[ 1 ].got[ SIG_20 ] + tao[ 2 ].got[ SIG_20 ] + tao[ 3 ].got[ SIG_20 ] );
+
+			/* 20 gets a subscriber after it was published to nobody */
+			QActive_subscribe( &tao[ 1 ].super, SIG_20 );
+			QActive_unsubscribeAll( &tao[ 2 ].super );
+			vPortHostInterrupt( isr_publish );
+			return;
+
+		case 2:
+			CHECK( 1 == tao[ 1 ].got[ SIG_20 ] );
+			CHECK( 1 == tao[ 2 ].got[ SIG_30 ] );
+			break;
+
+		default:
+			break;
+	}
+
+	/* the events without subscribers were recycled too */
+	CHECK( QF_pool_[ 0 ].nTot == QF_pool_[ 0 ].nFree );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( QEvt ) pool[ 4 ];
+	static QEvt const *queue[ N_AO + 1 ][ 4 ];
+	static StackType_t stack[ N_AO + 1 ][ configMINIMAL_STACK_SIZE ];
+	uint8_t p;
+
+	QF_init();
+	QF_psInitSparse( sto, Q_DIM( sto ), MAX_PUB_SIG );
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	for( p = 1; p <= N_AO; p++ )
+	{
+		QActive_ctor( &tao[ p ].super, Q_STATE_CAST( &tao_initial ) );
+		QACTIVE_START( &tao[ p ].super, p, queue[ p ], Q_DIM( queue[ p ] ),
+					   stack[ p ], sizeof( stack[ p ] ), (QEvt *)0 );
+	}
+
+	table_order();
+	table_random();
+
+	freertos_test_run();
+
+	CHECK( 3 == step );
+
+	return TEST_RESULT( "ps_sparse" );
+}
@@ -0,0 +1,52 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+/*
+ * the QK scheduling the arm-cm/qk port relies on, with the host port in
+ * port/qk: synchronous preemption by a post from a thread, asynchronous
+ * preemption at the PendSV after an interrupt, and the ceiling lock.
+ */
+
+#define QP_HOST_ISR_EXIT()	QK_ISR_EXIT()
+
+/* the handler returns into QK_activate_() in thread mode */
+#define QP_HOST_PENDSV() do { \
+	QF_INT_DISABLE(); \
+	QK_activate_(); \
+	QF_INT_ENABLE(); \
+} while( 0 )
+
+#define QP_HOST_STK_SIZE	0U
+
+#define QP_HOST_LOCK( c_ )	QK_schedLock( c_ )
+#define QP_HOST_UNLOCK( s_ )	QK_schedUnlock( s_ )
+
+#include "qp_kernel_test.h"
+
+void QK_onIdle( void )
+{
+	qp_kernel_idle();
+}
+
+static SCENARIO const scenarios[] =
+{
+	{ 0, 1, "t3",		0, "LHhl" },		/* a thread post preempts */
+	{ 0, 3, "t1",		0, "HhLl" },		/* a lower one waits */
+	{ 0, 1, "i2",		0, "LMml" },		/* at the PendSV after the interrupt */
+	{ 0, 1, "l2t2t3u",	0, "LHhMml" },		/* up to the ceiling held back */
+	{ 0, 1, "t1t1",		0, "LlLlLl" },		/* to itself: run to completion */
+	{ 1, 2, "t3t1",		0, "MHhmLl" },		/* from an interrupt at idle */
+	{ 0, 2, NULL,		2, "MmMmMm" },
+};
+
+int main( void )
+{
+	qp_kernel_run( scenarios, Q_DIM( scenarios ) );
+
+	return TEST_RESULT( "qk" );
+}
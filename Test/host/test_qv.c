@@ -0,0 +1,57 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+/*
+ * the QV scheduling the arm-cm/qv port relies on, with the host port in
+ * port/qv: no preemption, the highest priority ready AO after every step,
+ * or after a batch of steps of one AO built with QV_DISPATCH_BATCH.
+ */
+
+/* QV has no work to do after an interrupt */
+#define QP_HOST_ISR_EXIT()	( (void)0 )
+#define QP_HOST_PENDSV()	( (void)0 )
+
+#define QP_HOST_STK_SIZE	0U
+
+#include "qp_kernel_test.h"
+
+void QV_onIdle( void )
+{
+	/* entered with the interrupts disabled */
+	CHECK( qp_host_int_off );
+	QV_CPU_SLEEP();
+
+	qp_kernel_idle();
+}
+
+static SCENARIO const scenarios[] =
+{
+	{ 0, 1, "t3",		0, "LlHh" },		/* a post does not preempt */
+	{ 0, 3, "t1",		0, "HhLl" },
+	{ 0, 1, "i2",		0, "LlMm" },		/* nor does an interrupt */
+	{ 0, 1, "t2t3",		0, "LlHhMm" },		/* the highest next */
+	{ 0, 1, "t1t1",		0, "LlLlLl" },
+	{ 1, 2, "t3t1",		0, "MmHhLl" },
+#ifndef QV_DISPATCH_BATCH
+	{ 0, 1, "i3",		2, "LlHhLlLl" },
+#else
+	/* H made ready waits for the rest of the batch */
+	{ 0, 1, "i3",		2, "LlLlHhLl" },
+#endif
+};
+
+int main( void )
+{
+	qp_kernel_run( scenarios, Q_DIM( scenarios ) );
+
+#ifndef QV_DISPATCH_BATCH
+	return TEST_RESULT( "qv" );
+#else
+	return TEST_RESULT( "qv_batch" );
+#endif
+}
@@ -0,0 +1,57 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+/*
+ * the QXK scheduling of basic threads the arm-cm/qxk port relies on, with
+ * the host port in port/qxk: the same preemption as QK, the activation
+ * after an interrupt through PendSV. extended threads run on their own
+ * stacks the host cannot switch, they are not covered.
+ */
+
+#define QP_HOST_ISR_EXIT()	QXK_ISR_EXIT()
+
+/* the handler's basic thread path, a stale PendSV does nothing */
+#define QP_HOST_PENDSV() do { \
+	QF_INT_DISABLE(); \
+	if( QXK_attr_.next != (QActive *)0 ) \
+	{ \
+		CHECK( (void *)0 == QXK_attr_.next->osObject ); \
+		QXK_activate_(); \
+	} \
+	QF_INT_ENABLE(); \
+} while( 0 )
+
+#define QP_HOST_STK_SIZE	0U
+
+#define QP_HOST_LOCK( c_ )	QXK_schedLock( c_ )
+#define QP_HOST_UNLOCK( s_ )	QXK_schedUnlock( s_ )
+
+#include "qp_kernel_test.h"
+
+void QXK_onIdle( void )
+{
+	qp_kernel_idle();
+}
+
+static SCENARIO const scenarios[] =
+{
+	{ 0, 1, "t3",		0, "LHhl" },
+	{ 0, 3, "t1",		0, "HhLl" },
+	{ 0, 1, "i2",		0, "LMml" },
+	{ 0, 1, "l2t2t3u",	0, "LHhMml" },
+	{ 0, 1, "t1t1",		0, "LlLlLl" },
+	{ 1, 2, "t3t1",		0, "MHhmLl" },
+	{ 0, 2, NULL,		2, "MmMmMm" },
+};
+
+int main( void )
+{
+	qp_kernel_run( scenarios, Q_DIM( scenarios ) );
+
+	return TEST_RESULT( "qxk" );
+}
@@ -0,0 +1,127 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+/* built in, for the per task accounting */
+#include "rt_stats.c"
+
+/*
+ * the run time statistics of a simulated run, from the trace hooks of the
+ * FreeRTOS kernel: two active objects on time events of 1 and 2 ticks
+ * spend 1000 and 3000 cycles per event, the idle task 500 per tick. the
+ * cycles and the context switches must come out exact, and the report is
+ * the one the target prints. the tasks run on host stacks, the stack
+ * column only shows the untouched target buffers.
+ */
+
+#define TICKS		100U
+
+enum
+{
+	TIMEOUT_SIG = Q_USER_SIG
+};
+
+typedef struct
+{
+	QActive super;
+
+	QTimeEvt te;
+	uint32_t period;
+	uint32_t cost;
+	uint32_t events;
+} TAO;
+
+static TAO tao_l, tao_h;
+static uint32_t ticks;
+
+static QState tao_active( TAO * const me, QEvt const * const e );
+
+static QState tao_initial( TAO * const me, QEvt const * const e )
+{
+	(void)e;
+	QTimeEvt_armX( &me->te, me->period, me->period );
+	return Q_TRAN( &tao_active );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e )
+{
+	if( TIMEOUT_SIG == e->sig )
+	{
+		freertos_test_work( me->cost );
+		++me->events;
+		return Q_HANDLED();
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+static void tao_start( TAO *me, uint8_t prio, uint32_t period, uint32_t cost )
+{
+	static QEvt const *queue[ 3 ][ 4 ];
+	static StackType_t stack[ 3 ][ configMINIMAL_STACK_SIZE ];
+
+	me->period = period;
+	me->cost = cost;
+	QActive_ctor( &me->super, Q_STATE_CAST( &tao_initial ) );
+	QTimeEvt_ctorX( &me->te, &me->super, TIMEOUT_SIG, 0U );
+	QACTIVE_START( &me->super, prio, queue[ prio ], Q_DIM( queue[ prio ] ),
+				   stack[ prio ], sizeof( stack[ prio ] ), (QEvt *)0 );
+}
+
+static RT_STATS_TASK const *tao_stats( TAO *me )
+{
+	return &rt_task[ uxTaskGetTaskNumber( (TaskHandle_t)&me->super.thread ) ];
+}
+
+static void freertos_test_idle( void )
+{
+	RT_STATS_TASK const *idle = &rt_task[ uxTaskGetTaskNumber( xTaskGetIdleTaskHandle() ) ];
+
+	if( ticks < TICKS )
+	{
+		freertos_test_work( 500 );
+		vPortHostTick();
+		++ticks;
+		return;
+	}
+
+	CHECK( TICKS == tao_l.events && TICKS / 2 == tao_h.events );
+
+	/* every task switched in once at the start */
+	CHECK( TICKS * 1000U == tao_stats( &tao_l )->cycles );
+	CHECK( TICKS / 2 * 3000U == tao_stats( &tao_h )->cycles );
+	CHECK( 1 + TICKS == tao_stats( &tao_l )->switches );
+	CHECK( 1 + TICKS / 2 == tao_stats( &tao_h )->switches );
+	CHECK( 1 + TICKS == idle->switches );
+
+	rt_stats_report( 0 );
+
+	/* the window restarts at the report */
+	CHECK( rt_prev_time == freertos_test_cycles );
+	CHECK( rt_prev[ uxTaskGetTaskNumber( (TaskHandle_t)&tao_l.super.thread ) ].cycles == TICKS * 1000U );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( QEvt ) pool[ 4 ];
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	tao_start( &tao_l, 1, 1, 1000 );
+	tao_start( &tao_h, 2, 2, 3000 );
+
+	freertos_test_run();
+
+	CHECK( freertos_test_ended );
+
+	return TEST_RESULT( "rt_stats" );
+}
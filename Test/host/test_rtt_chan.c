@@ -0,0 +1,224 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "qpc.h"
+
+#include "rtt_test.h"
+#include "kv_store.h"
+#include "rtt_chan.h"
+
+#include "test.h"
+
+/*
+ * the channels on the real SEGGER RTT, rtt_test.h plays the J-Link. the
+ * buffers of a boot without statistics, the keys of the "Cmd" down buffer,
+ * the reports on the "Report" up buffer, all or nothing writes and their
+ * counters, and the sizes of the next boot after the log ran full.
+ *
+ * then the throughput of the log channel against the up buffer size, with
+ * the probe emptying it at a fixed period.
+ */
+
+#define BENCH_REC		16		/* a DLOG2 record */
+#define BENCH_PERIOD	10		/* ms between the reads of the probe */
+#define BENCH_MS		1000
+
+void test_assert( char const *module, int loc )
+{
+	printf( "assert %s:%d\n", module, loc );
+	exit( 1 );
+}
+
+/* the kv store: one record */
+static uint8_t kv_blob[ 64 ];
+static uint16_t kv_len;
+static unsigned kv_puts;
+
+int16_t kv_get( uint16_t key, void *buf, uint16_t size )
+{
+	CHECK( RTT_CHAN_KV_KEY == key );
+
+	if( 0 == kv_len || size < kv_len )
+	{
+		return -1;
+	}
+
+	memcpy( buf, kv_blob, kv_len );
+	return (int16_t)kv_len;
+}
+
+int16_t kv_put( uint16_t key, void const *data, uint16_t len )
+{
+	CHECK( RTT_CHAN_KV_KEY == key && len <= sizeof( kv_blob ) );
+
+	memcpy( kv_blob, data, len );
+	kv_len = len;
+	++kv_puts;
+
+	return KV_OK;
+}
+
+static char text[ 4096 ];
+
+/* a boot: a new control block, the buffers from the pool */
+static void boot( RTT_CHAN_STATS *st )
+{
+	uint8_t i;
+
+	memset( &_SEGGER_RTT, 0, sizeof( _SEGGER_RTT ) );
+	rtt_chan_init();
+
+	for( i = 0; i < RTT_CHAN_NUM; i++ )
+	{
+		rtt_chan_stats( (RTT_CHAN)i, &st[ i ] );
+		CHECK( rtt_chan_up( (RTT_CHAN)i ) == i + 1 );
+		CHECK( _SEGGER_RTT.aUp[ i + 1 ].SizeOfBuffer == st[ i ].size );
+	}
+
+	CHECK( st[ RTT_CHAN_DLOG ].size + st[ RTT_CHAN_REPORT ].size + 16 <= RTT_CHAN_POOL );
+	CHECK( 0 == strcmp( _SEGGER_RTT.aUp[ 1 ].sName, "DLog" ) && 0 == strcmp( _SEGGER_RTT.aUp[ 2 ].sName, "Report" ) );
+	CHECK( rtt_chan_down( RTT_CHAN_DLOG ) < 0 && 1 == rtt_chan_down( RTT_CHAN_REPORT ) );
+	CHECK( 0 == strcmp( _SEGGER_RTT.aDown[ 1 ].sName, "Cmd" ) );
+}
+
+static void test_boot( void )
+{
+	static uint8_t rec[ 2048 ];
+	RTT_CHAN_STATS first[ RTT_CHAN_NUM ], next[ RTT_CHAN_NUM ], s;
+	unsigned n, size;
+
+	/* no statistics: the defaults with the spare shared out */
+	boot( first );
+	CHECK( 1104 == first[ RTT_CHAN_DLOG ].size && 412 == first[ RTT_CHAN_REPORT ].size );
+	size = first[ RTT_CHAN_DLOG ].size;
+
+	/* keys of the channel, not of the terminal */
+	CHECK( 2 == rtt_test_type( rtt_chan_down( RTT_CHAN_REPORT ), "sr" ) );
+	CHECK( 1 == rtt_test_type( 0, "x" ) );
+	CHECK( 's' == rtt_chan_key( RTT_CHAN_REPORT ) );
+	CHECK( RTT_CHAN_REPORT_KEY == rtt_chan_key( RTT_CHAN_REPORT ) );
+	CHECK( -1 == rtt_chan_key( RTT_CHAN_REPORT ) && -1 == rtt_chan_key( RTT_CHAN_DLOG ) );
+
+	/* all or nothing */
+	CHECK( 1000 == rtt_chan_write( RTT_CHAN_DLOG, rec, 1000 ) );
+	CHECK( 0 == rtt_chan_write( RTT_CHAN_DLOG, rec, size - 1000 ) );
+	CHECK( size - 1001 == rtt_chan_write( RTT_CHAN_DLOG, rec, size - 1001 ) );
+	CHECK( size - 1 == rtt_test_read( 1, text, sizeof( text ) ) );
+
+	rtt_chan_stats( RTT_CHAN_DLOG, &s );
+	CHECK( size - 1 == s.written && s.written == s.max_fill );
+	CHECK( size - 1000 == s.dropped );
+
+	/* the report on its channel, the fill sampled after it */
+	rtt_chan_report( rtt_chan_up( RTT_CHAN_REPORT ) );
+	rtt_chan_poll();
+	n = rtt_test_read( 2, text, sizeof( text ) );
+	fputs( text, stdout );
+	CHECK( strstr( text, " DLog\r\n" ) != NULL && strstr( text, " Report\r\n" ) != NULL );
+	CHECK( 0 == rtt_test_read( 0, text, sizeof( text ) ) );
+
+	rtt_chan_stats( RTT_CHAN_REPORT, &s );
+	CHECK( n == s.max_fill );
+
+	/* the log ran full and asks for twice its size, the report needs less */
+	rtt_chan_save();
+	CHECK( 1 == kv_puts );
+	rtt_chan_save();
+	CHECK( 1 == kv_puts );
+
+	boot( next );
+	CHECK( next[ RTT_CHAN_DLOG ].size > first[ RTT_CHAN_DLOG ].size );
+	CHECK( next[ RTT_CHAN_REPORT ].size < first[ RTT_CHAN_REPORT ].size );
+	CHECK( next[ RTT_CHAN_REPORT ].size >= n );
+}
+
+static uint64_t now_ns( void )
+{
+	struct timespec t;
+
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (uint64_t)t.tv_sec * 1000000000U + (uint64_t)t.tv_nsec;
+}
+
+/* records a ms into an up buffer of size bytes, return the bytes dropped */
+static unsigned bench( unsigned size, unsigned rate, uint64_t *ns )
+{
+	static uint8_t buf[ 4096 ];
+	uint8_t rec[ BENCH_REC ] = { 0 };
+	RTT_CHAN_STATS s0, s1;
+	uint64_t t0;
+	unsigned ms, i;
+
+	SEGGER_RTT_ConfigUpBuffer( rtt_chan_up( RTT_CHAN_DLOG ), "DLog", buf, size, SEGGER_RTT_MODE_NO_BLOCK_SKIP );
+	rtt_chan_stats( RTT_CHAN_DLOG, &s0 );
+
+	for( ms = 0; ms < BENCH_MS; ms++ )
+	{
+		t0 = now_ns();
+		for( i = 0; i < rate; i++ )
+		{
+			rtt_chan_write( RTT_CHAN_DLOG, rec, sizeof( rec ) );
+		}
+		*ns += now_ns() - t0;
+
+		if( ms % BENCH_PERIOD == BENCH_PERIOD - 1 )
+		{
+			rtt_test_read( rtt_chan_up( RTT_CHAN_DLOG ), text, sizeof( text ) );
+		}
+	}
+
+	rtt_chan_stats( RTT_CHAN_DLOG, &s1 );
+	CHECK( ( s1.written - s0.written ) + ( s1.dropped - s0.dropped ) == BENCH_MS * rate * BENCH_REC );
+
+	return s1.dropped - s0.dropped;
+}
+
+static void test_bench( void )
+{
+	static unsigned const sizes[] = { 256, 512, 1024, 2048 };
+	static unsigned const rates[] = { 1, 2, 4, 8, 16 };
+	uint64_t ns = 0;
+	unsigned i, k, drop, writes = 0;
+
+	printf( "rtt_chan: %u byte records, the probe empties the up buffer every %u ms\n", BENCH_REC, BENCH_PERIOD );
+	printf( "  size  dropped %% at records/ms:" );
+	for( k = 0; k < ( sizeof( rates ) / sizeof( rates[ 0 ] ) ); k++ )
+	{
+		printf( " %4u", rates[ k ] );
+	}
+	printf( "\n" );
+
+	for( i = 0; i < ( sizeof( sizes ) / sizeof( sizes[ 0 ] ) ); i++ )
+	{
+		printf( "  %4u %27s", sizes[ i ], "" );
+		for( k = 0; k < ( sizeof( rates ) / sizeof( rates[ 0 ] ) ); k++ )
+		{
+			drop = bench( sizes[ i ], rates[ k ], &ns );
+			writes += BENCH_MS * rates[ k ];
+			printf( " %4u", drop * 100U / ( BENCH_MS * rates[ k ] * BENCH_REC ) );
+
+			/* nothing lost while a period fits the buffer */
+			CHECK( ( rates[ k ] * BENCH_PERIOD * BENCH_REC < sizes[ i ] ) == ( 0 == drop ) );
+		}
+		printf( "\n" );
+	}
+
+	printf( "  %u ns a write on the host\n", (unsigned)( ns / writes ) );
+}
+
+int main( void )
+{
+	test_boot();
+	test_bench();
+
+	return TEST_RESULT( "rtt_chan" );
+}
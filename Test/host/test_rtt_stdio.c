@@ -0,0 +1,280 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdarg.h>
+#include <time.h>
+
+#include "freertos_test.h"
+
+#include "rtt_test.h"
+#include "rtt_stdio.h"
+
+/*
+ * the line buffered stdout on the FreeRTOS port and the real SEGGER RTT.
+ * a line takes one lock, a line too long for the buffer is cut and stays
+ * whole when a higher priority task prints in its middle, an interrupt
+ * writes straight through. the report compares one line through the line
+ * buffer, through a write per character as microlib printf() with the
+ * plain fputc() retarget does, and through SEGGER_RTT_printf().
+ *
+ * then the same three on the host clock, the cycles of the target come
+ * from the report.
+ */
+
+#define N_BENCH		2000
+
+/* the line of led_task */
+#define LINE		"tick:1234,system heap:5000.\r\n"
+
+DWT_Type *test_dwt( void )
+{
+	static DWT_Type dwt;
+
+	dwt.CYCCNT = (uint32_t)bsp_dwt_get_cycles64();
+
+	return &dwt;
+}
+
+/* printf() of the target library: formats, then every character to fputc() */
+static int out( char const *fmt, ... )
+{
+	char text[ 256 ];
+	va_list ap;
+	int n, i;
+
+	va_start( ap, fmt );
+	n = vsnprintf( text, sizeof( text ), fmt, ap );
+	va_end( ap );
+
+	for( i = 0; i < n && i < (int)sizeof( text ) - 1; i++ )
+	{
+		rtt_stdio_putc( text[ i ] );
+	}
+
+	return n;
+}
+
+/* printf() of rtt_stdio_report() on the target library while it runs */
+static uint8_t retarget;
+
+int printf( char const *fmt, ... )
+{
+	char text[ 256 ];
+	va_list ap;
+	int n;
+
+	va_start( ap, fmt );
+	n = vsnprintf( text, sizeof( text ), fmt, ap );
+	va_end( ap );
+
+	if( retarget )
+	{
+		return out( "%s", text );
+	}
+
+	return fputs( text, stdout ) < 0 ? -1 : n;
+}
+
+/* the plain retarget: fputc() writes the character */
+static void out_direct( char const *s )
+{
+	for( ; *s != '\0'; s++ )
+	{
+		SEGGER_RTT_Write( 0, s, 1 );
+	}
+}
+
+static TaskHandle_t task_b_handle;
+static unsigned b_lines;
+
+/* priority 2 */
+static void task_b( void *param )
+{
+	for( ;; )
+	{
+		ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		out( "b %u\r\n", ++b_lines );
+	}
+}
+
+static char rtt[ 2048 ];
+
+static uint32_t locks( void )
+{
+	RTT_STDIO_STATS s;
+
+	rtt_stdio_stats( &s );
+	return s.writes;
+}
+
+static uint64_t now_ns( void )
+{
+	struct timespec t;
+
+	clock_gettime( CLOCK_MONOTONIC, &t );
+	return (uint64_t)t.tv_sec * 1000000000U + (uint64_t)t.tv_nsec;
+}
+
+static uint64_t bench_ns[ 3 ];
+static uint32_t bench_locks[ 3 ];
+
+static void bench( void )
+{
+	uint64_t t0;
+	uint32_t l0, w0;
+	unsigned i;
+
+	for( i = 0; i < N_BENCH; i++ )
+	{
+		l0 = locks();
+		t0 = now_ns();
+		out( "tick:%u,system heap:%u.\r\n", 1234U, 5000U );
+		bench_ns[ 0 ] += now_ns() - t0;
+		bench_locks[ 0 ] += locks() - l0;
+		rtt_test_read( 0, rtt, sizeof( rtt ) );
+
+		w0 = rtt_test_writes;
+		t0 = now_ns();
+		out_direct( LINE );
+		bench_ns[ 1 ] += now_ns() - t0;
+		bench_locks[ 1 ] += rtt_test_writes - w0;
+		rtt_test_read( 0, rtt, sizeof( rtt ) );
+
+		w0 = rtt_test_writes;
+		t0 = now_ns();
+		SEGGER_RTT_printf( 0, "tick:%u,system heap:%u.\r\n", 1234U, 5000U );
+		bench_ns[ 2 ] += now_ns() - t0;
+		bench_locks[ 2 ] += rtt_test_writes - w0;
+		rtt_test_read( 0, rtt, sizeof( rtt ) );
+		CHECK( 0 == strcmp( rtt, LINE ) );
+	}
+}
+
+static uint8_t a_done;
+
+/* priority 1 */
+static void task_a( void *param )
+{
+	static char long_line[ 101 ];
+	RTT_STDIO_STATS s;
+	unsigned n[ 6 ], len;
+	uint32_t l0, w0;
+	char const *p;
+
+	/* one lock a line */
+	l0 = locks();
+	out( "tick:%u,system heap:%u.\r\n", 1234U, 5000U );
+	CHECK( l0 + 1 == locks() );
+	rtt_test_read( 0, rtt, sizeof( rtt ) );
+	CHECK( 0 == strcmp( rtt, LINE ) );
+
+	/* a partial line stays in the buffer until its '\n' */
+	out( "abc" );
+	CHECK( 0 == rtt_test_read( 0, rtt, sizeof( rtt ) ) );
+	out( "\n" );
+	rtt_test_read( 0, rtt, sizeof( rtt ) );
+	CHECK( 0 == strcmp( rtt, "abc\n" ) );
+
+	/* task b prints after 70 characters of a line, longer than the buffer */
+	memset( long_line, 'a', 100 );
+	long_line[ 70 ] = '\0';
+	out( "%s", long_line );
+	xTaskNotifyGive( task_b_handle );
+	out( "%s\r\n", long_line );
+
+	rtt_test_read( 0, rtt, sizeof( rtt ) );
+	len = strlen( "b 1\r\n" );
+	CHECK( 1 == b_lines && 0 == strncmp( rtt, "b 1\r\n", len ) );
+	CHECK( len + RTT_STDIO_LINE == strlen( rtt ) && '\n' == rtt[ len + RTT_STDIO_LINE - 1 ] );
+	CHECK( strspn( rtt + len, "a" ) == RTT_STDIO_LINE - 1 );
+
+	rtt_stdio_stats( &s );
+	CHECK( 140 + 1 - ( RTT_STDIO_LINE - 1 ) == s.cut );
+
+	/* SEGGER_RTT_printf() writes its buffer at a time */
+	memset( long_line, 'c', 100 );
+	long_line[ 100 ] = '\0';
+	w0 = rtt_test_writes;
+	SEGGER_RTT_printf( 0, "%s\r\n", long_line );
+	CHECK( w0 + ( 102 + SEGGER_RTT_PRINTF_BUFFER_SIZE - 1 ) / SEGGER_RTT_PRINTF_BUFFER_SIZE == rtt_test_writes );
+	rtt_test_read( 0, rtt, sizeof( rtt ) );
+	CHECK( 102 == strlen( rtt ) );
+
+	/* the comparison of the report, the line goes out in between */
+	retarget = 1;
+	rtt_stdio_report( 0 );
+	retarget = 0;
+	rtt_test_read( 0, rtt, sizeof( rtt ) );
+	fputs( rtt, stdout );
+
+	p = strstr( rtt, "one line:" );
+	CHECK( p != NULL );
+	CHECK( p != NULL && 6 == sscanf( p, "one line: printf %u cycles %u locks, microlib %u cycles %u locks, "
+									 "SEGGER_RTT_printf %u cycles %u locks", &n[ 0 ], &n[ 1 ], &n[ 2 ],
+									 &n[ 3 ], &n[ 4 ], &n[ 5 ] ) );
+
+	/* the microlib line is the second one */
+	p = strstr( rtt, "tick:" );
+	p = p != NULL ? strstr( p + 1, "tick:" ) : NULL;
+	CHECK( p != NULL && 1 == n[ 1 ] && strcspn( p, "\n" ) + 1 == n[ 3 ] && 1 == n[ 5 ] );
+
+	bench();
+
+	a_done = 1;
+	vTaskSuspend( NULL );
+}
+
+/* an interrupt writes every character */
+static void isr_print( void )
+{
+	out( "irq\n" );
+}
+
+static void freertos_test_idle( void )
+{
+	uint32_t l0;
+
+	if( !a_done )
+	{
+		return;
+	}
+
+	l0 = locks();
+	vPortHostInterrupt( isr_print );
+	CHECK( l0 + 4 == locks() );
+	rtt_test_read( 0, rtt, sizeof( rtt ) );
+	CHECK( 0 == strcmp( rtt, "irq\n" ) );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static StackType_t stack[ 2 ][ configMINIMAL_STACK_SIZE ];
+	static StaticTask_t tcb[ 2 ];
+
+	QF_init();
+
+	/* rtt_chan_init() on the target */
+	SEGGER_RTT_Init();
+
+	xTaskCreateStatic( task_a, "a", configMINIMAL_STACK_SIZE, NULL, 1, stack[ 0 ], &tcb[ 0 ] );
+	task_b_handle = xTaskCreateStatic( task_b, "b", configMINIMAL_STACK_SIZE, NULL, 2, stack[ 1 ], &tcb[ 1 ] );
+
+	freertos_test_run();
+
+	CHECK( a_done );
+
+	printf( "rtt_stdio: %u lines of %u bytes on the host clock, where the lock costs nothing\n", N_BENCH, (unsigned)strlen( LINE ) );
+	printf( "                     ns/line  locks/line\n" );
+	printf( "  line buffer       %8u  %10u\n", (unsigned)( bench_ns[ 0 ] / N_BENCH ), bench_locks[ 0 ] / N_BENCH );
+	printf( "  fputc per char    %8u  %10u\n", (unsigned)( bench_ns[ 1 ] / N_BENCH ), bench_locks[ 1 ] / N_BENCH );
+	printf( "  SEGGER_RTT_printf %8u  %10u\n", (unsigned)( bench_ns[ 2 ] / N_BENCH ), bench_locks[ 2 ] / N_BENCH );
+
+	return TEST_RESULT( "rtt_stdio" );
+}
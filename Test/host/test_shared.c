@@ -0,0 +1,268 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+/*
+ * QF_SHARED_STACK on the FreeRTOS port: three AOs run by the dispatcher
+ * task, the same three with a task each above them, and the same steps on
+ * both. a post from a shared AO to a higher one runs it nested at once, a
+ * post to a lower one waits for the step. an interrupt in the step of the
+ * low AO readies the other two: the tasks preempt it, the shared AOs wait
+ * for the end of its step. the AOs trace the start of a step in lower case
+ * and the end in upper case.
+ *
+ * then the ram of the stacks and the latency of the AOs readied by the
+ * interrupt, in virtual cycles, one task per AO against the shared stack.
+ */
+
+#define STEP		1000	/* cycles of each half of a step */
+
+enum
+{
+	LO,
+	MID,
+	HI,
+	N_AO
+};
+
+enum
+{
+	SHARED,
+	TASKS,
+	N_GROUP
+};
+
+enum
+{
+	PING_SIG = Q_USER_SIG
+};
+
+enum
+{
+	ACT_NONE,
+	ACT_IRQ,		/* interrupt to mid and hi in the step */
+	ACT_POST,		/* post to mid, then to hi */
+	ACT_DOWN		/* post to lo */
+};
+
+typedef struct
+{
+	QEvt super;
+
+	uint8_t act;
+} PING_EVT;
+
+typedef struct
+{
+	QActive super;
+
+	char c;
+	uint8_t group;
+} TAO;
+
+static TAO tao[ N_GROUP ][ N_AO ];
+
+static PING_EVT const ping_evt[] =
+{
+	{ { PING_SIG, 0U, 0U }, ACT_NONE }, { { PING_SIG, 0U, 0U }, ACT_IRQ },
+	{ { PING_SIG, 0U, 0U }, ACT_POST }, { { PING_SIG, 0U, 0U }, ACT_DOWN },
+};
+
+static char trace[ 32 ];
+static unsigned trace_len;
+
+/* the group of the interrupt, its time and the latency of the AOs it readied */
+static uint8_t irq_group;
+static uint64_t irq_at;
+static uint8_t irq_wait[ N_AO ];
+static uint32_t latency[ N_GROUP ][ N_AO ];
+
+static void trace_add( char c )
+{
+	if( trace_len < sizeof( trace ) - 1 )
+	{
+		trace[ trace_len++ ] = c;
+		trace[ trace_len ] = '\0';
+	}
+}
+
+static void isr_up( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	irq_at = bsp_dwt_get_cycles64();
+	irq_wait[ MID ] = 1;
+	irq_wait[ HI ] = 1;
+
+	QACTIVE_POST_FROM_ISR( &tao[ irq_group ][ MID ].super, &ping_evt[ ACT_NONE ].super, &woken, (void *)0 );
+	QACTIVE_POST_FROM_ISR( &tao[ irq_group ][ HI ].super, &ping_evt[ ACT_NONE ].super, &woken, (void *)0 );
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e );
+
+static QState tao_initial( TAO * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &tao_active );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e )
+{
+	TAO *g = tao[ me->group ];
+	unsigned r = (unsigned)( me - g );
+
+	if( PING_SIG != e->sig )
+	{
+		return Q_SUPER( &QHsm_top );
+	}
+
+	if( irq_wait[ r ] && me->group == irq_group )
+	{
+		latency[ me->group ][ r ] = (uint32_t)( bsp_dwt_get_cycles64() - irq_at );
+		irq_wait[ r ] = 0;
+	}
+
+	trace_add( me->c );
+	freertos_test_work( STEP );
+
+	switch( ( (PING_EVT const *)e )->act )
+	{
+		case ACT_IRQ:
+			irq_group = me->group;
+			vPortHostInterrupt( isr_up );
+			break;
+
+		case ACT_POST:
+			QACTIVE_POST( &g[ MID ].super, &ping_evt[ ACT_NONE ].super, me );
+			QACTIVE_POST( &g[ HI ].super, &ping_evt[ ACT_NONE ].super, me );
+			break;
+
+		case ACT_DOWN:
+			QACTIVE_POST( &g[ LO ].super, &ping_evt[ ACT_NONE ].super, me );
+			break;
+
+		default:
+			break;
+	}
+
+	freertos_test_work( STEP );
+	trace_add( (char)( me->c - 'a' + 'A' ) );
+
+	return Q_HANDLED();
+}
+
+typedef struct
+{
+	uint8_t act;
+	uint8_t first;				/* the AO given the event */
+	char const *expect[ N_GROUP ];
+} CASE;
+
+static CASE const steps[] =
+{
+	{ ACT_IRQ,	LO, { "lLhHmM", "lhHmML" } },
+	{ ACT_POST,	LO, { "lmMhHL", "lmMhHL" } },
+	{ ACT_DOWN,	HI, { "hHlL", "hHlL" } },
+};
+
+/* each step on the shared AOs, then on the tasks */
+static unsigned step;
+
+static void isr_start( void )
+{
+	CASE const *s = &steps[ step / N_GROUP ];
+	BaseType_t woken = pdFALSE;
+
+	QACTIVE_POST_FROM_ISR( &tao[ step % N_GROUP ][ s->first ].super, &ping_evt[ s->act ].super, &woken, (void *)0 );
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void freertos_test_idle( void )
+{
+	unsigned i;
+
+	if( step != 0 )
+	{
+		char const *expect = steps[ ( step - 1 ) / N_GROUP ].expect[ ( step - 1 ) % N_GROUP ];
+
+		if( strcmp( trace, expect ) != 0 )
+		{
+			printf( "step %u: \"%s\", expected \"%s\"\n", step, trace, expect );
+			++test_failed;
+		}
+
+		for( i = 0; i < N_AO; i++ )
+		{
+			CHECK( NULL == tao[ ( step - 1 ) % N_GROUP ][ i ].super.eQueue.frontEvt );
+		}
+	}
+	trace_len = 0;
+	trace[ 0 ] = '\0';
+
+	if( step < Q_DIM( steps ) * N_GROUP )
+	{
+		vPortHostInterrupt( isr_start );
+		++step;
+		return;
+	}
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QEvt const *queue[ N_GROUP ][ N_AO ][ 4 ];
+	static StackType_t stack[ N_AO ][ configMINIMAL_STACK_SIZE ];
+	unsigned g, r;
+	uint32_t ram[ N_GROUP ];
+
+	QF_init();
+
+	/* the shared AOs in the band 1..3, the tasks 4..6 above it */
+	for( g = 0; g < N_GROUP; g++ )
+	{
+		for( r = 0; r < N_AO; r++ )
+		{
+			tao[ g ][ r ].c = "lmh"[ r ];
+			tao[ g ][ r ].group = (uint8_t)g;
+
+			QActive_ctor( &tao[ g ][ r ].super, Q_STATE_CAST( &tao_initial ) );
+			QACTIVE_START( &tao[ g ][ r ].super, 1U + g * N_AO + r, queue[ g ][ r ], Q_DIM( queue[ g ][ r ] ),
+						   SHARED == g ? (void *)0 : (void *)stack[ r ],
+						   SHARED == g ? 0U : sizeof( stack[ r ] ), (QEvt *)0 );
+		}
+	}
+
+	freertos_test_run();
+
+	CHECK( Q_DIM( steps ) * N_GROUP == step );
+
+	/* the interrupt came in the middle of the step of lo */
+	CHECK( 0 == latency[ TASKS ][ HI ] && 2 * STEP == latency[ TASKS ][ MID ] );
+	CHECK( STEP == latency[ SHARED ][ HI ] && 3 * STEP == latency[ SHARED ][ MID ] );
+
+	/* the stacks on the target, 32 bit words. the queues and the TCBs are
+	 * the same, the shared AOs keep their QActive.thread unused and the
+	 * dispatcher adds one. its stack must hold the nested steps of the
+	 * shared AOs, not only the deepest one.
+	 */
+	ram[ TASKS ] = N_AO * configMINIMAL_STACK_SIZE * sizeof( uint32_t );
+	ram[ SHARED ] = QF_SHARED_STACK_SIZE;
+
+	printf( "shared: %u AOs, a step of %u cycles, an interrupt in the middle of it\n", N_AO, 2 * STEP );
+	printf( "                   stack ram  latency hi  latency mid [cycles]\n" );
+	printf( "  one task per AO  %9u  %10u  %11u\n", ram[ TASKS ], latency[ TASKS ][ HI ], latency[ TASKS ][ MID ] );
+	printf( "  shared stack     %9u  %10u  %11u\n", ram[ SHARED ], latency[ SHARED ][ HI ], latency[ SHARED ][ MID ] );
+	printf( "  every further shared AO saves its %u bytes of stack\n", ram[ TASKS ] / N_AO );
+
+	return TEST_RESULT( "shared" );
+}
@@ -0,0 +1,541 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+#include "app_signals.h"
+#include "spi_bus.h"
+
+/*
+ * the spi bus manager and the DMA driver on the FreeRTOS port, with a
+ * model of SPI1, its two DMA channels and the chip selects. the idle task
+ * plays the DMA: with both channels enabled it clocks the whole transfer
+ * through the device (which answers the complement of each byte) and runs
+ * the RX transfer complete interrupt. the device traces a frame as the
+ * device number when its CS goes low, the first byte sent of every
+ * transfer in it ('.' for the dummy bytes) and '|' when CS goes high.
+ *
+ * a CS_HOLD command waits for its data while the other device runs and
+ * then goes out with it in one frame, a busy device gives way to the
+ * other after SPI_BUS_BATCH_MAX transfers, and a sequence is not split at
+ * that limit. then a benchmark against a polled driver on the SPI1 model.
+ *
+ * built without PIE, so the static buffers fit in CMAR.
+ */
+
+#define SPI_BYTE_CYCLES		64		/* 8 bits at 72MHz / 8 */
+
+#define N_XFER				16
+#define N_BENCH				8
+
+enum
+{
+	DONE_SIG = MAX_SIG
+};
+
+/* one pool for the submit and the done events */
+Q_ASSERT_COMPILE( sizeof( SPI_DONE_EVT ) >= sizeof( SPI_SUBMIT_EVT ) );
+
+/* the host stand-ins of the registers */
+DMA_Channel_TypeDef dma1_channel2_model;
+DMA_Channel_TypeDef dma1_channel3_model;
+uint32_t dma1_isr_model;
+GPIO_TypeDef gpioa_model;
+GPIO_TypeDef gpiob_model;
+
+static SPI_TypeDef spi1_regs;
+
+/* the SPI unit: a byte written to DR is shifted at the next access, the
+ * cpu waits for it.
+ */
+SPI_TypeDef *spi1_unit_sync( void )
+{
+	if( spi1_regs.DR < 0x100 )
+	{
+		spi1_regs.DR = 0x100 | (uint8_t)~spi1_regs.DR;
+		freertos_test_work( SPI_BYTE_CYCLES );
+	}
+	spi1_regs.SR = SPI_I2S_FLAG_TXE | SPI_I2S_FLAG_RXNE;
+
+	return &spi1_regs;
+}
+
+static uint8_t dma_claimed;
+
+void bsp_dma_claim( DMA_Channel_TypeDef *ch )
+{
+	if( DMA1_Channel2 == ch )
+	{
+		dma_claimed |= 1;
+	}
+	else if( DMA1_Channel3 == ch )
+	{
+		dma_claimed |= 2;
+	}
+	else
+	{
+		++test_failed;
+	}
+}
+
+/* the chip selects, only one device may be selected */
+static struct
+{
+	GPIO_TypeDef *port;
+	uint16_t pin;
+} const cs[ BSP_SPI_DEVICES ] = BSP_SPI_CS_TABLE;
+
+static int cs_low = -1;
+
+static char trace[ 128 ];
+static unsigned trace_len;
+
+static void trace_add( char c )
+{
+	if( trace_len < sizeof( trace ) - 1 )
+	{
+		trace[ trace_len++ ] = c;
+		trace[ trace_len ] = '\0';
+	}
+}
+
+static int cs_dev( GPIO_TypeDef *port, uint16_t pin )
+{
+	int i;
+
+	for( i = 0; i < BSP_SPI_DEVICES; i++ )
+	{
+		if( cs[ i ].port == port && cs[ i ].pin == pin )
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void GPIO_SetBits( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin )
+{
+	GPIOx->ODR |= GPIO_Pin;
+
+	if( cs_low >= 0 && cs_low == cs_dev( GPIOx, GPIO_Pin ) )
+	{
+		cs_low = -1;
+		trace_add( '|' );
+	}
+}
+
+void GPIO_ResetBits( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin )
+{
+	int dev = cs_dev( GPIOx, GPIO_Pin );
+
+	GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+
+	/* held from the previous transfer */
+	if( dev == cs_low )
+	{
+		return;
+	}
+
+	CHECK( dev >= 0 && cs_low < 0 );
+	cs_low = dev;
+	trace_add( (char)( '0' + dev ) );
+}
+
+/* in the vector table on the target */
+void DMA1_Channel2_IRQHandler( void );
+
+static uint32_t dma_irqs;
+
+/* one transfer of the two channels, from the idle task */
+static int dma_run( void )
+{
+	DMA_Channel_TypeDef *rx = DMA1_Channel2;
+	DMA_Channel_TypeDef *tx = DMA1_Channel3;
+	uint8_t const *src = (uint8_t const *)(uintptr_t)tx->CMAR;
+	uint8_t *dst = (uint8_t *)(uintptr_t)rx->CMAR;
+	uint32_t i;
+	uint8_t b;
+
+	if( 0 == ( rx->CCR & DMA_CCR1_EN ) )
+	{
+		CHECK( 0 == ( tx->CCR & DMA_CCR1_EN ) );
+		return 0;
+	}
+
+	CHECK( ( tx->CCR & DMA_CCR1_EN ) && rx->CNDTR == tx->CNDTR && rx->CNDTR != 0 );
+	CHECK( cs_low >= 0 );
+
+	trace_add( ( tx->CCR & DMA_MemoryInc_Enable ) ? (char)*src : '.' );
+
+	for( i = 0; i < tx->CNDTR; i++ )
+	{
+		b = *src;
+		if( tx->CCR & DMA_MemoryInc_Enable )
+		{
+			src++;
+		}
+		else
+		{
+			CHECK( 0xFF == b );
+		}
+
+		*dst = (uint8_t)~b;
+		if( rx->CCR & DMA_MemoryInc_Enable )
+		{
+			dst++;
+		}
+	}
+
+	rx->CNDTR = 0;
+	tx->CNDTR = 0;
+
+	++dma_irqs;
+	vPortHostInterrupt( DMA1_Channel2_IRQHandler );
+
+	return 1;
+}
+
+/* the owner of the transfers, its done events come in the order of the
+ * transfers on the bus
+ */
+typedef struct
+{
+	QActive super;
+
+	char trace[ 64 ];
+	unsigned len;
+	uint32_t submitted;
+	uint32_t done;
+} CLIENT;
+
+static CLIENT client;
+
+static SPI_XFER xfer[ N_XFER ];
+static uint8_t tx_buf[ N_XFER ][ 256 ];
+static uint8_t rx_buf[ N_XFER ][ 256 ];
+
+static QState client_active( CLIENT * const me, QEvt const * const e );
+
+static QState client_initial( CLIENT * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &client_active );
+}
+
+static QState client_active( CLIENT * const me, QEvt const * const e )
+{
+	SPI_XFER const *x;
+	uint16_t i;
+
+	if( DONE_SIG == e->sig )
+	{
+		x = ( (SPI_DONE_EVT const *)e )->xfer;
+
+		if( me->len < sizeof( me->trace ) - 1 )
+		{
+			me->trace[ me->len++ ] = (char)x->tx[ 0 ];
+			me->trace[ me->len ] = '\0';
+		}
+		++me->done;
+
+		for( i = 0; x->tx != NULL && x->rx != NULL && i < x->len; i++ )
+		{
+			CHECK( 0xFF == x->tx[ i ] + x->rx[ i ] );
+		}
+		return Q_HANDLED();
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+static uint8_t n_xfer;
+
+static void submit( uint8_t dev, char tag, uint8_t flags, uint16_t len )
+{
+	SPI_XFER *x = &xfer[ n_xfer % N_XFER ];
+	uint8_t i = n_xfer % N_XFER;
+	uint16_t k;
+
+	++n_xfer;
+
+	for( k = 0; k < len; k++ )
+	{
+		tx_buf[ i ][ k ] = (uint8_t)( tag + k );
+	}
+
+	x->dev = dev;
+	x->flags = flags;
+	x->len = len;
+	x->tx = tx_buf[ i ];
+	x->rx = rx_buf[ i ];
+	x->ao = &client.super;
+	x->sig = DONE_SIG;
+
+	++client.submitted;
+	spi_bus_submit( x, (void *)0 );
+}
+
+static void submit_dummy( uint8_t dev, uint16_t len )
+{
+	SPI_XFER *x = &xfer[ n_xfer++ % N_XFER ];
+
+	x->dev = dev;
+	x->flags = 0;
+	x->len = len;
+	x->tx = NULL;
+	x->rx = NULL;
+	x->ao = NULL;
+
+	spi_bus_submit( x, (void *)0 );
+}
+
+static void submit_run( uint8_t dev, char first, unsigned n, uint16_t len )
+{
+	unsigned i;
+
+	for( i = 0; i < n; i++ )
+	{
+		submit( dev, (char)( first + i ), 0, len );
+	}
+}
+
+/* the steps, each one submits while the bus is idle */
+static void step_hold( void )
+{
+	submit( 0, 'a', 0, 1 );
+	submit( 0, 'c', SPI_XFER_CS_HOLD, 1 );
+	submit( 1, 'x', 0, 3 );
+}
+
+static void step_hold_end( void )
+{
+	submit( 0, 'd', 0, 4 );
+}
+
+static void step_batch( void )
+{
+	submit( 1, 'z', 0, 1 );
+	submit_run( 0, 'A', 10, 2 );
+	submit_run( 1, 'k', 2, 2 );
+}
+
+static void step_no_split( void )
+{
+	submit( 1, 'z', 0, 1 );
+	submit_run( 0, 'A', 7, 2 );
+	submit( 0, 'h', SPI_XFER_CS_HOLD, 1 );
+	submit( 0, 'i', SPI_XFER_CS_HOLD, 1 );
+	submit( 0, 'j', 0, 1 );
+	submit( 0, 'K', 0, 1 );
+}
+
+static void step_dummy( void )
+{
+	submit_dummy( 1, 5 );
+	submit( 1, 'r', 0, 1 );
+}
+
+typedef struct
+{
+	void ( *run )( void );
+	char const *expect;
+	uint8_t waiting;		/* transfers left in the bus */
+} STEP;
+
+static STEP const steps[] =
+{
+	/* c waits for d, x goes meanwhile */
+	{ step_hold,		"0a|1x|", 1 },
+	{ step_hold_end,	"0cd|", 0 },
+
+	/* eight of device 0, then device 1, then the rest of device 0 */
+	{ step_batch,		"1z|0A|0B|0C|0D|0E|0F|0G|0H|1k|1l|0I|0J|", 0 },
+
+	/* h i j is one sequence past the limit, K waits for the next chain */
+	{ step_no_split,	"1z|0A|0B|0C|0D|0E|0F|0G|0hij|0K|", 0 },
+
+	{ step_dummy,		"1.|1r|", 0 },
+};
+
+/* the benchmark: N_BENCH transfers of each length, polled and by DMA */
+static uint16_t const bench_len[] = { 1, 4, 16, 64, 256 };
+
+typedef struct
+{
+	uint32_t polled;		/* cpu cycles waiting on the bus */
+	uint32_t irqs;
+	uint32_t events;		/* submits and done events */
+} BENCH;
+
+static BENCH bench[ Q_DIM( bench_len ) ];
+
+/* the usual polled driver through the SPI1 registers */
+static void spi_polled( SPI_XFER const *x )
+{
+	uint16_t i;
+
+	GPIO_ResetBits( cs[ x->dev ].port, cs[ x->dev ].pin );
+	for( i = 0; i < x->len; i++ )
+	{
+		while( 0 == ( SPI1->SR & SPI_I2S_FLAG_TXE ) )
+		{
+		}
+		SPI1->DR = x->tx[ i ];
+		while( 0 == ( SPI1->SR & SPI_I2S_FLAG_RXNE ) )
+		{
+		}
+		x->rx[ i ] = (uint8_t)SPI1->DR;
+	}
+	GPIO_SetBits( cs[ x->dev ].port, cs[ x->dev ].pin );
+}
+
+static void bench_polled( BENCH *b, uint16_t len )
+{
+	uint64_t t0 = bsp_dwt_get_cycles64();
+	unsigned i;
+	uint16_t k;
+
+	for( i = 0; i < N_BENCH; i++ )
+	{
+		xfer[ i ].dev = 0;
+		xfer[ i ].len = len;
+		xfer[ i ].tx = tx_buf[ i ];
+		xfer[ i ].rx = rx_buf[ i ];
+		spi_polled( &xfer[ i ] );
+
+		for( k = 0; k < len; k++ )
+		{
+			CHECK( 0xFF == tx_buf[ i ][ k ] + rx_buf[ i ][ k ] );
+		}
+	}
+
+	b->polled = (uint32_t)( bsp_dwt_get_cycles64() - t0 );
+}
+
+/* the transfers with an owner in the trace of the frames */
+static char const *wire_tags( void )
+{
+	static char tags[ sizeof( trace ) ];
+	unsigned i, n = 0;
+
+	for( i = 0; i < trace_len; i++ )
+	{
+		if( trace[ i ] != '|' && trace[ i ] != '.' && i != 0 && trace[ i - 1 ] != '|' )
+		{
+			tags[ n++ ] = trace[ i ];
+		}
+	}
+	tags[ n ] = '\0';
+
+	return tags;
+}
+
+static unsigned step;
+static unsigned bench_step;
+
+static void freertos_test_idle( void )
+{
+	BENCH *b;
+
+	if( dma_run() )
+	{
+		return;
+	}
+
+	if( step != 0 && step <= Q_DIM( steps ) )
+	{
+		if( strcmp( trace, steps[ step - 1 ].expect ) != 0 )
+		{
+			printf( "step %u: \"%s\", expected \"%s\"\n", step, trace, steps[ step - 1 ].expect );
+			++test_failed;
+		}
+
+		/* the transfers reported in bus order, the bus idle */
+		CHECK( 0 == strcmp( client.trace, wire_tags() ) );
+		CHECK( client.submitted - client.done == steps[ step - 1 ].waiting );
+		CHECK( !bsp_spi_busy() && cs_low < 0 );
+	}
+	trace_len = 0;
+	trace[ 0 ] = '\0';
+	client.len = 0;
+	client.trace[ 0 ] = '\0';
+
+	if( step < Q_DIM( steps ) )
+	{
+		steps[ step++ ].run();
+		return;
+	}
+
+	if( step == Q_DIM( steps ) )
+	{
+		++step;
+		CHECK( QF_pool_[ 0 ].nTot == QF_pool_[ 0 ].nFree );
+	}
+	else
+	{
+		/* the DMA run of the previous length */
+		b = &bench[ bench_step - 1 ];
+		b->irqs = dma_irqs;
+		b->events = N_BENCH + client.done;
+	}
+
+	if( bench_step < Q_DIM( bench_len ) )
+	{
+		b = &bench[ bench_step ];
+		bench_polled( b, bench_len[ bench_step ] );
+
+		dma_irqs = 0;
+		client.submitted = 0;
+		client.done = 0;
+		n_xfer = 0;
+		submit_run( 0, 'a', N_BENCH, bench_len[ bench_step++ ] );
+		return;
+	}
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( SPI_DONE_EVT ) pool[ 2 * N_XFER ];
+	static QEvt const *bus_queue[ 2 * N_XFER ];
+	static QEvt const *client_queue[ N_XFER ];
+	static StackType_t stack[ 2 ][ configMINIMAL_STACK_SIZE ];
+	unsigned i;
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	QActive_ctor( &client.super, Q_STATE_CAST( &client_initial ) );
+	QACTIVE_START( &client.super, 1U, client_queue, Q_DIM( client_queue ),
+				   stack[ 0 ], sizeof( stack[ 0 ] ), (QEvt *)0 );
+
+	spi_bus_ctor();
+	QACTIVE_START( AO_SpiBus, 2U, bus_queue, Q_DIM( bus_queue ),
+				   stack[ 1 ], sizeof( stack[ 1 ] ), (QEvt *)0 );
+
+	/* bsp_spi_init() claimed both channels and released both selects */
+	CHECK( 3 == dma_claimed && cs_low < 0 );
+
+	freertos_test_run();
+
+	CHECK( Q_DIM( steps ) + 1 == step && Q_DIM( bench_len ) == bench_step );
+	CHECK( QF_pool_[ 0 ].nTot == QF_pool_[ 0 ].nFree );
+
+	printf( "spi_bus: %u transfers a run, SCK 9MHz (%u cycles a byte)\n", N_BENCH, SPI_BYTE_CYCLES );
+	printf( "  len  polled cpu/xfer  dma irq/xfer  events/xfer\n" );
+	for( i = 0; i < Q_DIM( bench_len ); i++ )
+	{
+		CHECK( N_BENCH == bench[ i ].irqs );
+		printf( "  %3u  %15u  %12u  %11u\n", bench_len[ i ], bench[ i ].polled / N_BENCH,
+				bench[ i ].irqs / N_BENCH, bench[ i ].events / N_BENCH );
+	}
+
+	return TEST_RESULT( "spi_bus" );
+}
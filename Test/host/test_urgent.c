@@ -0,0 +1,255 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+/*
+ * the lanes of QF_ACTIVE_URGENT on the FreeRTOS port, as QActive_get_()
+ * picks them: a pending broadcast first, then the urgent lane, but no more
+ * than the burst of urgent events in a row while normal events wait, and
+ * the run starts again when the normal lane is empty. the AO traces the
+ * urgent events as digits, the normal ones as letters, the broadcast as B.
+ */
+
+#define BURST		2
+
+enum
+{
+	BCAST_SIG = Q_USER_SIG,
+	NORMAL_SIG,
+	URGENT_SIG,
+	GO_SIG
+};
+
+typedef struct
+{
+	QEvt super;
+
+	char c;
+} TRACE_EVT;
+
+typedef struct
+{
+	QActive super;
+
+	char trace[ 32 ];
+	unsigned len;
+} TAO;
+
+static TAO tao;				/* priority 1, with the urgent lane */
+static QActive prod;		/* priority 2, posts from a task */
+
+static QEvt const bcast_evt = { BCAST_SIG, 0U, 0U };
+static QEvt const go_evt = { GO_SIG, 0U, 0U };
+
+static TRACE_EVT const normal_evt[] =
+{
+	{ { NORMAL_SIG, 0U, 0U }, 'a' }, { { NORMAL_SIG, 0U, 0U }, 'b' },
+	{ { NORMAL_SIG, 0U, 0U }, 'c' }, { { NORMAL_SIG, 0U, 0U }, 'd' },
+};
+
+static TRACE_EVT const urgent_evt[] =
+{
+	{ { URGENT_SIG, 0U, 0U }, '1' }, { { URGENT_SIG, 0U, 0U }, '2' },
+	{ { URGENT_SIG, 0U, 0U }, '3' }, { { URGENT_SIG, 0U, 0U }, '4' },
+	{ { URGENT_SIG, 0U, 0U }, '5' }, { { URGENT_SIG, 0U, 0U }, '6' },
+};
+
+static void trace_add( char c )
+{
+	if( tao.len < sizeof( tao.trace ) - 1 )
+	{
+		tao.trace[ tao.len++ ] = c;
+		tao.trace[ tao.len ] = '\0';
+	}
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e );
+
+static QState tao_initial( TAO * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &tao_active );
+}
+
+static QState tao_active( TAO * const me, QEvt const * const e )
+{
+	switch( e->sig )
+	{
+		case BCAST_SIG:
+			trace_add( 'B' );
+			return Q_HANDLED();
+
+		case NORMAL_SIG:
+		case URGENT_SIG:
+			trace_add( ( (TRACE_EVT const *)e )->c );
+			freertos_test_work( 100 );
+			return Q_HANDLED();
+
+		default:
+			break;
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+static QState prod_active( QActive * const me, QEvt const * const e );
+
+static QState prod_initial( QActive * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &prod_active );
+}
+
+/* the AO is lower, so everything waits until this step ends */
+static QState prod_active( QActive * const me, QEvt const * const e )
+{
+	unsigned i;
+
+	if( GO_SIG == e->sig )
+	{
+		for( i = 0; i < 2; i++ )
+		{
+			QACTIVE_POST( &tao.super, &normal_evt[ i ].super, me );
+		}
+		for( i = 0; i < 5; i++ )
+		{
+			QACTIVE_POST_URGENT( &tao.super, &urgent_evt[ i ].super, me );
+		}
+		return Q_HANDLED();
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+/* four normal, five urgent and the broadcast, in the worst order */
+static void isr_mixed( void )
+{
+	BaseType_t woken = pdFALSE;
+	unsigned i;
+
+	for( i = 0; i < 4; i++ )
+	{
+		QACTIVE_POST_FROM_ISR( &tao.super, &normal_evt[ i ].super, &woken, (void *)0 );
+	}
+	for( i = 0; i < 5; i++ )
+	{
+		QACTIVE_POST_URGENT_FROM_ISR( &tao.super, &urgent_evt[ i ].super, &woken, (void *)0 );
+	}
+	QF_BCAST_FROM_ISR( 1U, &woken, (void *)0 );
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+/* urgent only, no limit, the run starts again after it */
+static void isr_urgent( void )
+{
+	BaseType_t woken = pdFALSE;
+	unsigned i;
+
+	for( i = 0; i < 6; i++ )
+	{
+		QACTIVE_POST_URGENT_FROM_ISR( &tao.super, &urgent_evt[ i ].super, &woken, (void *)0 );
+	}
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void isr_then( void )
+{
+	BaseType_t woken = pdFALSE;
+
+	QACTIVE_POST_FROM_ISR( &tao.super, &normal_evt[ 0 ].super, &woken, (void *)0 );
+	QACTIVE_POST_URGENT_FROM_ISR( &tao.super, &urgent_evt[ 0 ].super, &woken, (void *)0 );
+	QACTIVE_POST_URGENT_FROM_ISR( &tao.super, &urgent_evt[ 1 ].super, &woken, (void *)0 );
+	QACTIVE_POST_URGENT_FROM_ISR( &tao.super, &urgent_evt[ 2 ].super, &woken, (void *)0 );
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+static void task_go( void )
+{
+	QACTIVE_POST( &prod, &go_evt, (void *)0 );
+}
+
+typedef struct
+{
+	void ( *run )( void );
+	uint8_t isr;
+	char const *expect;
+} STEP;
+
+static STEP const steps[] =
+{
+	{ isr_mixed,	1, "B12a34b5cd" },
+	{ isr_urgent,	1, "123456" },
+	{ isr_then,		1, "12a3" },
+	{ task_go,		0, "12a34b5" },
+};
+
+static unsigned step;
+
+static void freertos_test_idle( void )
+{
+	if( step != 0 )
+	{
+		if( strcmp( tao.trace, steps[ step - 1 ].expect ) != 0 )
+		{
+			printf( "step %u: \"%s\", expected \"%s\"\n", step, tao.trace, steps[ step - 1 ].expect );
+			++test_failed;
+		}
+
+		/* both lanes drained */
+		CHECK( NULL == tao.super.eQueue.frontEvt && NULL == tao.super.urgQueue.frontEvt );
+	}
+	tao.len = 0;
+	tao.trace[ 0 ] = '\0';
+
+	if( step < Q_DIM( steps ) )
+	{
+		if( steps[ step ].isr )
+		{
+			vPortHostInterrupt( steps[ step ].run );
+		}
+		else
+		{
+			steps[ step ].run();
+		}
+		++step;
+		return;
+	}
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QEvt const *queue[ 8 ];
+	static QEvt const *urgent[ 8 ];
+	static QEvt const *prod_queue[ 2 ];
+	static StackType_t stack[ 2 ][ configMINIMAL_STACK_SIZE ];
+
+	QF_init();
+	QF_bcastInit( 1U, &bcast_evt );
+
+	QActive_ctor( &tao.super, Q_STATE_CAST( &tao_initial ) );
+	QActive_urgentInit( &tao.super, urgent, Q_DIM( urgent ), BURST );
+	QACTIVE_START( &tao.super, 1U, queue, Q_DIM( queue ),
+				   stack[ 0 ], sizeof( stack[ 0 ] ), (QEvt *)0 );
+	QActive_bcastSubscribe( &tao.super, 1U );
+
+	QActive_ctor( &prod, Q_STATE_CAST( &prod_initial ) );
+	QACTIVE_START( &prod, 2U, prod_queue, Q_DIM( prod_queue ),
+				   stack[ 1 ], sizeof( stack[ 1 ] ), (QEvt *)0 );
+
+	freertos_test_run();
+
+	CHECK( Q_DIM( steps ) == step );
+
+	return TEST_RESULT( "urgent" );
+}
@@ -0,0 +1,626 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+#include "usb_lib.h"
+#include "usb_istr.h"
+#include "usb_ao.h"
+#include "bsp_usb_stream.h"
+
+/*
+ * the deferred control endpoint of usb_ao.c, with USB_Istr() and the
+ * capture of usb_int.c, against a model of the endpoint 0 hardware and a
+ * small control state machine in place of usb_core.c, on the FreeRTOS
+ * port.
+ *
+ * the host enumerates the device. then what the deferral must survive:
+ * a RESET flag raised while a transfer is captured, a SETUP while the AO
+ * services the one before it (the interrupt is masked, the packet memory
+ * overwritten), a SETUP that aborts an IN stage not serviced yet, and
+ * storms of SETUPs and resets before the AO gets to run, more than the
+ * ring has slots.
+ *
+ * the state machine traces the reset as R, SETUP as S, IN as I, OUT as O.
+ */
+
+#define MAXP			64U
+#define RX_ADDR			0x40U
+#define TX_ADDR			0x80U
+
+#define GET_DESCRIPTOR		6U
+#define SET_ADDRESS			5U
+#define SET_CONFIGURATION	9U
+
+uint32_t pma_model[ 512 ];
+uint16_t usb_ep_model[ 8 ];
+uint16_t usb_ep_rx_addr_model[ 8 ];
+uint16_t usb_ep_rx_count_model[ 8 ];
+
+static uint16_t istr_model;
+static unsigned reset_at_read;		/* RESET rises at this ISTR read */
+static uint16_t ep0_tx_len;
+static uint32_t naks;
+
+/* the USB interrupt: masked by the AO, or already running */
+static uint8_t usb_masked, usb_pending, usb_in_isr;
+
+/* the control state machine */
+enum { IDLE, DATA_IN, STATUS_OUT, STATUS_IN };
+
+static struct
+{
+	uint8_t stage;
+	uint8_t const *data;
+	uint16_t left;
+	uint8_t request;		/* of the last SETUP */
+	uint16_t value;
+	uint8_t address;
+	uint8_t config;
+
+	char trace[ 32 ];
+	unsigned len;
+} core;
+
+static void ( *setup_hook )( void );	/* the host, while a SETUP is serviced */
+
+static uint8_t const dev_desc[ 18 ] =
+{
+	18, 1, 0x00, 0x02, 0x02, 0, 0, MAXP, 0x83, 0x04, 0x40, 0x57, 0x00, 0x02, 1, 2, 3, 1
+};
+
+static uint8_t conf_desc[ 67 ];
+
+static void trace_add( char c )
+{
+	if( core.len < sizeof( core.trace ) - 1 )
+	{
+		core.trace[ core.len++ ] = c;
+		core.trace[ core.len ] = '\0';
+	}
+}
+
+static int trace_is( char const *expect )
+{
+	int ok = ( 0 == strcmp( core.trace, expect ) );
+
+	if( !ok )
+	{
+		printf( "trace \"%s\", expected \"%s\"\n", core.trace, expect );
+	}
+	core.len = 0;
+	core.trace[ 0 ] = '\0';
+
+	return ok;
+}
+
+/* the endpoint 0 hardware */
+
+uint16_t usb_istr_get( void )
+{
+	uint8_t ep;
+
+	if( reset_at_read != 0 && 0 == --reset_at_read )
+	{
+		istr_model |= ISTR_RESET;
+	}
+
+	istr_model &= (uint16_t)~( ISTR_CTR | ISTR_DIR | ISTR_EP_ID );
+	for( ep = 0; ep < 8; ep++ )
+	{
+		if( usb_ep_model[ ep ] & ( EP_CTR_RX | EP_CTR_TX ) )
+		{
+			istr_model |= (uint16_t)( ISTR_CTR | ep | ( usb_ep_model[ ep ] & EP_CTR_RX ? ISTR_DIR : 0 ) );
+			break;
+		}
+	}
+
+	return istr_model;
+}
+
+void usb_istr_set( uint16_t wRegValue )
+{
+	istr_model &= wRegValue;
+}
+
+static void usb_irq( void )
+{
+	if( usb_in_isr )
+	{
+		USB_Istr();
+	}
+	else if( usb_masked )
+	{
+		usb_pending = 1;
+	}
+	else
+	{
+		vPortHostInterrupt( USB_Istr );
+	}
+}
+
+void usb_hw_init( void )
+{
+}
+
+void usb_hw_irq_mask( void )
+{
+	CHECK( !usb_masked );
+	usb_masked = 1;
+}
+
+void usb_hw_irq_unmask( void )
+{
+	usb_masked = 0;
+	if( usb_pending )
+	{
+		usb_pending = 0;
+		vPortHostInterrupt( USB_Istr );
+	}
+}
+
+/* the host */
+
+static uint16_t ep0_stat( uint16_t mask )
+{
+	return usb_ep_model[ ENDP0 ] & mask;
+}
+
+static void ep0_set_stat( uint16_t mask, uint16_t stat )
+{
+	usb_ep_model[ ENDP0 ] = (uint16_t)( ( usb_ep_model[ ENDP0 ] & ~mask ) | stat );
+}
+
+/* ACKed whatever the status, unless the endpoint is disabled */
+static void host_setup( uint8_t request, uint16_t value, uint16_t length )
+{
+	static uint32_t pkt[ 2 ];
+	uint8_t *b = (uint8_t *)pkt;
+
+	if( EP_RX_DIS == ep0_stat( EPRX_STAT ) )
+	{
+		++naks;
+		return;
+	}
+
+	b[ 0 ] = GET_DESCRIPTOR == request ? 0x80 : 0x00;
+	b[ 1 ] = request;
+	b[ 2 ] = (uint8_t)value;
+	b[ 3 ] = (uint8_t)( value >> 8 );
+	b[ 4 ] = b[ 5 ] = 0;
+	b[ 6 ] = (uint8_t)length;
+	b[ 7 ] = (uint8_t)( length >> 8 );
+
+	UserToPMABufferCopy( b, RX_ADDR, 8 );
+	usb_ep_rx_count_model[ ENDP0 ] = 8;
+	usb_ep_model[ ENDP0 ] |= EP_CTR_RX | EP_SETUP;
+	ep0_set_stat( EPRX_STAT | EPTX_STAT, EP_RX_NAK | EP_TX_NAK );
+
+	usb_irq();
+}
+
+/* bytes received, -1 for a NAK */
+static int host_in( uint8_t *dst )
+{
+	uint16_t n = ep0_tx_len;
+
+	if( ep0_stat( EPTX_STAT ) != EP_TX_VALID )
+	{
+		++naks;
+		return -1;
+	}
+
+	PMAToUserBufferCopy( dst, TX_ADDR, n );
+	usb_ep_model[ ENDP0 ] |= EP_CTR_TX;
+	ep0_set_stat( EPTX_STAT, EP_TX_NAK );
+
+	usb_irq();
+
+	return n;
+}
+
+/* the status stage of an IN transfer */
+static int host_out( void )
+{
+	if( ep0_stat( EPRX_STAT ) != EP_RX_VALID )
+	{
+		++naks;
+		return 0;
+	}
+
+	usb_ep_model[ ENDP0 ] &= (uint16_t)~EP_SETUP;
+	usb_ep_model[ ENDP0 ] |= EP_CTR_RX;
+	usb_ep_rx_count_model[ ENDP0 ] = 0;
+	ep0_set_stat( EPRX_STAT, EP_RX_NAK );
+
+	usb_irq();
+
+	return 1;
+}
+
+/* the endpoints are disabled until Reset() sets them up */
+static void host_reset( void )
+{
+	memset( usb_ep_model, 0, sizeof( usb_ep_model ) );
+	istr_model |= ISTR_RESET;
+
+	usb_irq();
+}
+
+/* a whole control transfer, the bytes of the data stage or -1 */
+static int host_control( uint8_t request, uint16_t value, uint16_t length, uint8_t *buf )
+{
+	int got = 0;
+	int n;
+
+	host_setup( request, value, length );
+
+	if( GET_DESCRIPTOR != request )
+	{
+		return host_in( buf ) == 0 ? 0 : -1;
+	}
+
+	do
+	{
+		n = host_in( buf + got );
+		if( n < 0 )
+		{
+			return -1;
+		}
+		got += n;
+	} while( MAXP == (unsigned)n && got < length );
+
+	return host_out() ? got : -1;
+}
+
+/* the control state machine, in place of usb_core.c and usb_prop.c */
+
+static void core_reset( void )
+{
+	trace_add( 'R' );
+
+	core.stage = IDLE;
+	core.address = 0;
+	core.config = 0;
+	usb_ep_rx_addr_model[ ENDP0 ] = RX_ADDR;
+	usb_ep_model[ ENDP0 ] = EP_RX_VALID | EP_TX_NAK;
+}
+
+static DEVICE_PROP device_prop = { core_reset };
+
+DEVICE_PROP *pProperty = &device_prop;
+uint16_t wInterrupt_Mask = ISTR_CTR | ISTR_RESET;
+uint8_t EPindex;
+
+static void core_send( void )
+{
+	static uint32_t pkt[ MAXP / 4 ];
+	uint16_t n = core.left < MAXP ? core.left : MAXP;
+
+	memcpy( pkt, core.data, n );
+	UserToPMABufferCopy( (uint8_t *)pkt, TX_ADDR, n );
+	ep0_tx_len = n;
+
+	core.data += n;
+	core.left = (uint16_t)( core.left - n );
+	SaveTState = EP_TX_VALID;
+	SaveRState = EP_RX_NAK;
+}
+
+uint8_t Setup0_Process( void )
+{
+	uint8_t const *p = pCtrRxData;
+	uint16_t length;
+
+	trace_add( 'S' );
+
+	/* serviced from the copy of the interrupt, not from the PMA */
+	CHECK( p != NULL );
+	CHECK( usb_masked );
+
+	if( setup_hook != NULL )
+	{
+		void ( *hook )( void ) = setup_hook;
+
+		setup_hook = NULL;
+		hook();
+	}
+
+	core.request = p[ 1 ];
+	core.value = (uint16_t)( p[ 2 ] | p[ 3 ] << 8 );
+	length = (uint16_t)( p[ 6 ] | p[ 7 ] << 8 );
+
+	if( GET_DESCRIPTOR == core.request )
+	{
+		core.data = 1 == ( core.value >> 8 ) ? dev_desc : conf_desc;
+		core.left = 1 == ( core.value >> 8 ) ? sizeof( dev_desc ) : sizeof( conf_desc );
+		if( core.left > length )
+		{
+			core.left = length;
+		}
+		core.stage = DATA_IN;
+		core_send();
+	}
+	else
+	{
+		core.stage = STATUS_IN;
+		ep0_tx_len = 0;
+		SaveTState = EP_TX_VALID;
+		SaveRState = EP_RX_NAK;
+	}
+
+	return 0;
+}
+
+uint8_t In0_Process( void )
+{
+	trace_add( 'I' );
+
+	if( DATA_IN == core.stage )
+	{
+		if( core.left != 0 )
+		{
+			core_send();
+		}
+		else
+		{
+			core.stage = STATUS_OUT;
+			SaveTState = EP_TX_NAK;
+			SaveRState = EP_RX_VALID;
+		}
+	}
+	else if( STATUS_IN == core.stage )
+	{
+		if( SET_ADDRESS == core.request )
+		{
+			core.address = (uint8_t)core.value;
+		}
+		else if( SET_CONFIGURATION == core.request )
+		{
+			core.config = (uint8_t)core.value;
+		}
+		core.stage = IDLE;
+		SaveRState = EP_RX_VALID;
+	}
+
+	return 0;
+}
+
+uint8_t Out0_Process( void )
+{
+	trace_add( 'O' );
+
+	CHECK( STATUS_OUT == core.stage );
+	core.stage = IDLE;
+	SaveRState = EP_RX_VALID;
+
+	return 0;
+}
+
+void NOP_Process( void )
+{
+}
+
+/* the stream of the AO is not used here */
+
+void bsp_usb_stream_init( QActive *ao, enum_t tx_done_sig, enum_t rx_done_sig )
+{
+}
+
+void bsp_usb_stream_read( uint8_t *buf, uint16_t size )
+{
+}
+
+uint16_t bsp_usb_stream_write( uint8_t const *buf, uint16_t len )
+{
+	return len;
+}
+
+void bsp_usb_stream_in_callback( void )
+{
+}
+
+void bsp_usb_stream_out_callback( void )
+{
+}
+
+DWT_Type *test_dwt( void )
+{
+	static DWT_Type dwt;
+
+	dwt.CYCCNT = (uint32_t)bsp_dwt_get_cycles64();
+	return &dwt;
+}
+
+/* the scenarios */
+
+static void enumerate( void )
+{
+	static uint8_t buf[ 128 ];
+
+	host_reset();
+	CHECK( trace_is( "R" ) );
+
+	/* the first 64 bytes of the device descriptor, then a reset */
+	CHECK( sizeof( dev_desc ) == host_control( GET_DESCRIPTOR, 0x0100, 64, buf ) );
+	CHECK( 0 == memcmp( buf, dev_desc, sizeof( dev_desc ) ) );
+	CHECK( trace_is( "SIO" ) );
+	host_reset();
+
+	CHECK( 0 == host_control( SET_ADDRESS, 5, 0, buf ) );
+	CHECK( 5 == core.address );
+
+	CHECK( sizeof( dev_desc ) == host_control( GET_DESCRIPTOR, 0x0100, sizeof( dev_desc ), buf ) );
+	CHECK( 9 == host_control( GET_DESCRIPTOR, 0x0200, 9, buf ) );
+	CHECK( sizeof( conf_desc ) == host_control( GET_DESCRIPTOR, 0x0200, sizeof( conf_desc ), buf ) );
+	CHECK( 0 == memcmp( buf, conf_desc, sizeof( conf_desc ) ) );
+	CHECK( 0 == host_control( SET_CONFIGURATION, 1, 0, buf ) );
+	CHECK( 1 == core.config );
+
+	CHECK( trace_is( "RSISIOSIOSIIOSI" ) );
+
+	/* the AO serviced every transfer before the next token */
+	CHECK( 0 == naks );
+}
+
+/* the RESET flag rises while the transfer is captured */
+static void reset_in_capture( void )
+{
+	static uint8_t buf[ MAXP ];
+	CTR_EVENT evt;
+
+	host_setup( GET_DESCRIPTOR, 0x0100, sizeof( dev_desc ) );
+	CHECK( sizeof( dev_desc ) == host_in( buf ) );
+	CHECK( trace_is( "SI" ) );
+
+	/* the status OUT, taken straight by the capture */
+	usb_ep_model[ ENDP0 ] &= (uint16_t)~EP_SETUP;
+	usb_ep_model[ ENDP0 ] |= EP_CTR_RX;
+	usb_ep_rx_count_model[ ENDP0 ] = 0;
+	reset_at_read = 1;
+
+	CHECK( 1 == CTR_LP_Capture( &evt ) );
+	CHECK( ( ISTR_CTR | ISTR_DIR ) == evt.wIstr );
+	CHECK( istr_model & ISTR_RESET );
+
+	/* the reset itself comes with the interrupt */
+	vPortHostInterrupt( USB_Istr );
+	CHECK( trace_is( "R" ) );
+	CHECK( EP_RX_VALID == ep0_stat( EPRX_STAT ) );
+}
+
+static void setup_again( void )
+{
+	host_setup( SET_ADDRESS, 3, 0 );
+	CHECK( usb_pending );
+}
+
+/* the next SETUP lands while the AO services the first one */
+static void setup_in_service( void )
+{
+	uint8_t buf[ 4 ];
+
+	setup_hook = setup_again;
+	host_setup( GET_DESCRIPTOR, 0x0100, 18 );
+
+	/* the first one read its copy, the second aborted it */
+	CHECK( trace_is( "SS" ) );
+	CHECK( SET_ADDRESS == core.request && STATUS_IN == core.stage );
+
+	CHECK( 0 == host_in( buf ) );
+	CHECK( trace_is( "I" ) && 3 == core.address );
+}
+
+static void isr_abort_in( void )
+{
+	static uint8_t buf[ MAXP ];
+
+	usb_in_isr = 1;
+	CHECK( MAXP == host_in( buf ) );
+	host_setup( SET_ADDRESS, 9, 0 );
+	usb_in_isr = 0;
+}
+
+/* a SETUP replaces an IN completion the AO did not see yet */
+static void setup_aborts_in( void )
+{
+	uint8_t buf[ 4 ];
+
+	host_setup( GET_DESCRIPTOR, 0x0200, sizeof( conf_desc ) );
+	CHECK( trace_is( "S" ) );
+
+	vPortHostInterrupt( isr_abort_in );
+	CHECK( trace_is( "S" ) && SET_ADDRESS == core.request );
+
+	CHECK( 0 == host_in( buf ) );
+	CHECK( trace_is( "I" ) && 9 == core.address );
+}
+
+/* two rings worth of SETUPs, the last one is serviced */
+static void isr_setup_storm( void )
+{
+	uint16_t i;
+
+	usb_in_isr = 1;
+	for( i = 1; i <= 2 * USB_AO_RING_SIZE; i++ )
+	{
+		host_setup( SET_ADDRESS, i, 0 );
+	}
+	usb_in_isr = 0;
+}
+
+/* SETUPs, then resets, the endpoint disabled from the first reset on */
+static void isr_reset_storm( void )
+{
+	unsigned i;
+
+	usb_in_isr = 1;
+	host_setup( SET_ADDRESS, 1, 0 );
+	for( i = 0; i < 2 * USB_AO_RING_SIZE; i++ )
+	{
+		host_reset();
+		host_setup( SET_ADDRESS, 2, 0 );
+	}
+	usb_in_isr = 0;
+}
+
+static void storms( void )
+{
+	uint8_t buf[ 4 ];
+
+	vPortHostInterrupt( isr_setup_storm );
+	CHECK( trace_is( "S" ) && 2 * USB_AO_RING_SIZE == core.value );
+	CHECK( 0 == host_in( buf ) );
+	CHECK( trace_is( "I" ) && 2 * USB_AO_RING_SIZE == core.address );
+
+	naks = 0;
+	vPortHostInterrupt( isr_reset_storm );
+	CHECK( trace_is( "R" ) && 0 == core.address );
+	CHECK( 2 * USB_AO_RING_SIZE == naks );
+
+	/* and enumerates again */
+	CHECK( 0 == host_control( SET_ADDRESS, 4, 0, buf ) );
+	CHECK( trace_is( "SI" ) && 4 == core.address );
+}
+
+static void freertos_test_idle( void )
+{
+	enumerate();
+	reset_in_capture();
+	setup_in_service();
+	setup_aborts_in();
+	storms();
+
+	CHECK( !usb_masked && !usb_pending );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QEvt const *queue[ 4 ];
+	static StackType_t stack[ configMINIMAL_STACK_SIZE ];
+	unsigned i;
+
+	for( i = 0; i < sizeof( conf_desc ); i++ )
+	{
+		conf_desc[ i ] = (uint8_t)( 0x40 + i );
+	}
+	conf_desc[ 0 ] = 9;
+	conf_desc[ 1 ] = 2;
+	conf_desc[ 2 ] = sizeof( conf_desc );
+
+	QF_init();
+
+	usb_ao_ctor();
+	QACTIVE_START( AO_Usb, 1U, queue, Q_DIM( queue ), stack, sizeof( stack ), (QEvt *)0 );
+
+	freertos_test_run();
+
+	return TEST_RESULT( "usb_ao" );
+}
@@ -0,0 +1,150 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "usb_lib.h"
+
+#include "test.h"
+
+/*
+ * the unrolled PMA copies against the original halfword loops of the
+ * library, for every user buffer alignment, PMA offset and length up to
+ * two 64 byte packets.
+ */
+
+uint32_t pma_model[ 512 ];
+
+/* the original V4.0.0 routines, the reference */
+static void ref_user_to_pma( uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes )
+{
+	uint32_t n = ( wNBytes + 1 ) >> 1;
+	uint16_t *pdwVal = (uint16_t *)( wPMABufAddr * 2 + PMAAddr );
+
+	for( ; n != 0; n-- )
+	{
+		*pdwVal = (uint16_t)( pbUsrBuf[ 0 ] | ( pbUsrBuf[ 1 ] << 8 ) );
+		pdwVal += 2;
+		pbUsrBuf += 2;
+	}
+}
+
+static void ref_pma_to_user( uint8_t *pbUsrBuf, uint16_t wPMABufAddr, uint16_t wNBytes )
+{
+	uint32_t n = ( wNBytes + 1 ) >> 1;
+	uint32_t *pdwVal = (uint32_t *)( wPMABufAddr * 2 + PMAAddr );
+
+	for( ; n != 0; n-- )
+	{
+		uint32_t v = *pdwVal++;
+
+		pbUsrBuf[ 0 ] = (uint8_t)v;
+		pbUsrBuf[ 1 ] = (uint8_t)( v >> 8 );
+		pbUsrBuf += 2;
+	}
+}
+
+/* the hardware returns 0 in the upper half of every PMA word */
+static void pma_fill( uint32_t seed )
+{
+	uint32_t i;
+
+	for( i = 0; i < 512; i++ )
+	{
+		seed = seed * 1103515245U + 12345U;
+		pma_model[ i ] = ( seed >> 8 ) & 0xFFFF;
+	}
+}
+
+/* byte i of the PMA buffer at addr */
+static uint8_t pma_byte( uint16_t addr, uint32_t i )
+{
+	return (uint8_t)( pma_model[ addr / 2 + i / 2 ] >> ( 8 * ( i & 1 ) ) );
+}
+
+static void test_user_to_pma( void )
+{
+	static uint8_t src[ 8 + 128 + 8 ];
+	static uint8_t expect[ 128 ];
+	uint32_t i, align, addr, len;
+
+	for( i = 0; i < sizeof( src ); i++ )
+	{
+		src[ i ] = (uint8_t)rand();
+	}
+
+	for( align = 0; align < 4; align++ )
+	{
+		for( addr = 0; addr <= 8; addr += 2 )
+		{
+			for( len = 0; len <= 128; len++ )
+			{
+				pma_fill( len );
+				ref_user_to_pma( &src[ 4 + align ], (uint16_t)addr, (uint16_t)len );
+				for( i = 0; i < len; i++ )
+				{
+					expect[ i ] = pma_byte( (uint16_t)addr, i );
+				}
+
+				pma_fill( len );
+				UserToPMABufferCopy( &src[ 4 + align ], (uint16_t)addr, (uint16_t)len );
+				for( i = 0; i < len; i++ )
+				{
+					CHECK( pma_byte( (uint16_t)addr, i ) == expect[ i ] );
+				}
+
+				/* the halfword after the buffer is not touched */
+				pma_fill( len );
+				i = pma_model[ addr / 2 + ( len + 1 ) / 2 ];
+				UserToPMABufferCopy( &src[ 4 + align ], (uint16_t)addr, (uint16_t)len );
+				CHECK( pma_model[ addr / 2 + ( len + 1 ) / 2 ] == i );
+			}
+		}
+	}
+}
+
+static void test_pma_to_user( void )
+{
+	static uint8_t dst[ 8 + 128 + 8 ];
+	static uint8_t ref[ 8 + 128 + 8 ];
+	uint32_t align, addr, len;
+
+	for( align = 0; align < 4; align++ )
+	{
+		for( addr = 0; addr <= 8; addr += 2 )
+		{
+			for( len = 0; len <= 128; len++ )
+			{
+				pma_fill( len + addr );
+
+				memset( ref, 0xA5, sizeof( ref ) );
+				ref_pma_to_user( &ref[ 4 + align ], (uint16_t)addr, (uint16_t)len );
+
+				memset( dst, 0xA5, sizeof( dst ) );
+				PMAToUserBufferCopy( &dst[ 4 + align ], (uint16_t)addr, (uint16_t)len );
+
+				CHECK( memcmp( &dst[ 4 + align ], &ref[ 4 + align ], len ) == 0 );
+
+				/* exactly len bytes, the original wrote one more for odd len */
+				CHECK( dst[ 3 + align ] == 0xA5 );
+				CHECK( dst[ 4 + align + len ] == 0xA5 );
+			}
+		}
+	}
+}
+
+int main( void )
+{
+	srand( 1 );
+
+	test_user_to_pma();
+	test_pma_to_user();
+
+	return TEST_RESULT( "usb_mem" );
+}
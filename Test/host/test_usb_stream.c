@@ -0,0 +1,504 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "freertos_test.h"
+
+#include "usb_lib.h"
+#include "bsp_usb_stream.h"
+
+/*
+ * the double buffered bulk endpoints of bsp_usb_stream.c against a model
+ * of the endpoint hardware, on the FreeRTOS port.
+ *
+ * the model keeps who owns each packet buffer: an IN buffer belongs to the
+ * hardware from FreeUserBuffer() until it was sent, an OUT buffer from
+ * FreeUserBuffer() until a packet was received into it. the hardware uses
+ * the buffer of DTOG and NAKs when that one is not its own; software may
+ * only touch the buffer of SW_BUF, and only while it owns it. the host
+ * side plays IN and OUT tokens, the USB interrupt runs the callbacks of
+ * all the transfers completed since the last one, so completions merge.
+ *
+ * then the throughput of a bulk stream at 19 packets per frame, when the
+ * interrupt is serviced after every n tokens.
+ */
+
+#define IN_EP		USB_STREAM_IN_EP
+#define OUT_EP		USB_STREAM_OUT_EP
+#define MAXP		USB_STREAM_MAX_PACKET
+
+#define N_STREAM	( 64U * 1000U + 17U )
+#define RX_SIZE		1024U
+
+enum
+{
+	TX_DONE_SIG = Q_USER_SIG,
+	RX_DONE_SIG
+};
+
+uint32_t pma_model[ 512 ];
+uint16_t usb_ep_model[ 8 ];
+
+static uint16_t ep_addr[ 8 ][ 2 ];
+static uint16_t ep_count[ 8 ][ 2 ];
+static uint8_t ep_hw[ 8 ][ 2 ];		/* the buffer belongs to the hardware */
+static uint8_t ctr_in, ctr_out;		/* completed, interrupt pending */
+static uint32_t nak_in, nak_out;
+
+static uint8_t sw_buf( uint8_t ep, uint16_t bit )
+{
+	return ( usb_ep_model[ ep ] & bit ) != 0;
+}
+
+/* IN: SW_BUF is DTOG_RX, OUT: SW_BUF is DTOG_TX */
+static uint16_t sw_bit( uint8_t ep )
+{
+	return IN_EP == ep ? EP_DTOG_RX : EP_DTOG_TX;
+}
+
+void usb_ep_set_count( uint8_t bEpNum, uint8_t buf, uint16_t wCount )
+{
+	CHECK( buf == sw_buf( bEpNum, sw_bit( bEpNum ) ) && !ep_hw[ bEpNum ][ buf ] );
+	ep_count[ bEpNum ][ buf ] = wCount;
+}
+
+uint16_t usb_ep_get_count( uint8_t bEpNum, uint8_t buf )
+{
+	CHECK( buf == sw_buf( bEpNum, sw_bit( bEpNum ) ) && !ep_hw[ bEpNum ][ buf ] );
+	return ep_count[ bEpNum ][ buf ];
+}
+
+void SetEPType( uint8_t bEpNum, uint16_t wType )
+{
+	(void)bEpNum;
+	(void)wType;
+}
+
+/* IN: both buffers empty, owned by software */
+void SetEPTxStatus( uint8_t bEpNum, uint16_t wState )
+{
+	if( EP_TX_VALID == wState )
+	{
+		ep_hw[ bEpNum ][ 0 ] = 0;
+		ep_hw[ bEpNum ][ 1 ] = 0;
+	}
+}
+
+/* OUT: both buffers free, owned by the hardware */
+void SetEPRxStatus( uint8_t bEpNum, uint16_t wState )
+{
+	if( EP_RX_VALID == wState )
+	{
+		ep_hw[ bEpNum ][ 0 ] = 1;
+		ep_hw[ bEpNum ][ 1 ] = 1;
+	}
+}
+
+void SetEPDoubleBuff( uint8_t bEpNum )
+{
+	(void)bEpNum;
+}
+
+void SetEPDblBuffAddr( uint8_t bEpNum, uint16_t wBuf0Addr, uint16_t wBuf1Addr )
+{
+	ep_addr[ bEpNum ][ 0 ] = wBuf0Addr;
+	ep_addr[ bEpNum ][ 1 ] = wBuf1Addr;
+}
+
+void SetEPDblBuffCount( uint8_t bEpNum, uint8_t bDir, uint16_t wCount )
+{
+	(void)bDir;
+	ep_count[ bEpNum ][ 0 ] = wCount;
+	ep_count[ bEpNum ][ 1 ] = wCount;
+}
+
+void ClearDTOG_RX( uint8_t bEpNum )
+{
+	usb_ep_model[ bEpNum ] &= (uint16_t)~EP_DTOG_RX;
+}
+
+void ClearDTOG_TX( uint8_t bEpNum )
+{
+	usb_ep_model[ bEpNum ] &= (uint16_t)~EP_DTOG_TX;
+}
+
+/* hand the buffer of SW_BUF to the hardware */
+void FreeUserBuffer( uint8_t bEpNum, uint8_t bDir )
+{
+	uint16_t bit = EP_DBUF_IN == bDir ? EP_DTOG_RX : EP_DTOG_TX;
+	uint8_t buf = sw_buf( bEpNum, bit );
+
+	CHECK( !ep_hw[ bEpNum ][ buf ] );
+	ep_hw[ bEpNum ][ buf ] = 1;
+	usb_ep_model[ bEpNum ] ^= bit;
+}
+
+/* an IN token: the bytes sent, -1 for a NAK */
+static int host_in( uint8_t *dst )
+{
+	uint8_t buf = sw_buf( IN_EP, EP_DTOG_TX );
+	uint16_t i, n;
+
+	if( !ep_hw[ IN_EP ][ buf ] )
+	{
+		++nak_in;
+		return -1;
+	}
+
+	n = ep_count[ IN_EP ][ buf ];
+	for( i = 0; i < n; i++ )
+	{
+		dst[ i ] = (uint8_t)( pma_model[ ep_addr[ IN_EP ][ buf ] / 2 + i / 2 ] >> ( 8 * ( i & 1 ) ) );
+	}
+
+	ep_hw[ IN_EP ][ buf ] = 0;
+	usb_ep_model[ IN_EP ] ^= EP_DTOG_TX;
+	ctr_in = 1;
+
+	return n;
+}
+
+/* an OUT token: 1 for an ACK, 0 for a NAK */
+static int host_out( uint8_t const *src, uint16_t n )
+{
+	uint8_t buf = sw_buf( OUT_EP, EP_DTOG_RX );
+	uint32_t *pma;
+	uint16_t i;
+
+	CHECK( n <= MAXP );
+
+	if( !ep_hw[ OUT_EP ][ buf ] )
+	{
+		++nak_out;
+		return 0;
+	}
+
+	pma = &pma_model[ ep_addr[ OUT_EP ][ buf ] / 2 ];
+	for( i = 0; i < n; i += 2 )
+	{
+		pma[ i / 2 ] = src[ i ] | ( i + 1 < n ? src[ i + 1 ] << 8 : 0 );
+	}
+
+	ep_count[ OUT_EP ][ buf ] = n;
+	ep_hw[ OUT_EP ][ buf ] = 0;
+	usb_ep_model[ OUT_EP ] ^= EP_DTOG_RX;
+	ctr_out = 1;
+
+	return 1;
+}
+
+/* the USB interrupt, for all the transfers completed so far */
+static void usb_isr( void )
+{
+	if( ctr_in )
+	{
+		ctr_in = 0;
+		bsp_usb_stream_in_callback();
+	}
+	if( ctr_out )
+	{
+		ctr_out = 0;
+		bsp_usb_stream_out_callback();
+	}
+}
+
+typedef struct
+{
+	QActive super;
+
+	uint32_t tx_done;
+	uint32_t tx_len;
+
+	uint32_t rx_done;
+	uint32_t rx_len;		/* of the last transfer */
+	uint8_t *rx_buf;
+
+	/* streaming: check against stream_data and read again */
+	uint8_t rx_stream;
+	uint32_t rx_total;
+} STREAM;
+
+static STREAM stream;
+static uint8_t stream_data[ N_STREAM ];
+static uint8_t rx_bufs[ 2 ][ RX_SIZE ];
+
+static QState stream_active( STREAM * const me, QEvt const * const e );
+
+static QState stream_initial( STREAM * const me, QEvt const * const e )
+{
+	(void)e;
+	return Q_TRAN( &stream_active );
+}
+
+static QState stream_active( STREAM * const me, QEvt const * const e )
+{
+	USB_STREAM_EVT const *se = (USB_STREAM_EVT const *)e;
+
+	switch( e->sig )
+	{
+		case TX_DONE_SIG:
+			++me->tx_done;
+			me->tx_len += se->len;
+			return Q_HANDLED();
+
+		case RX_DONE_SIG:
+			++me->rx_done;
+			me->rx_len = se->len;
+			me->rx_buf = se->buf;
+
+			if( me->rx_stream )
+			{
+				CHECK( 0 == memcmp( se->buf, &stream_data[ me->rx_total ], se->len ) );
+				me->rx_total += se->len;
+				bsp_usb_stream_read( rx_bufs[ me->rx_done & 1 ], RX_SIZE );
+			}
+			return Q_HANDLED();
+
+		default:
+			break;
+	}
+
+	return Q_SUPER( &QHsm_top );
+}
+
+static void usb_reset_isr( void )
+{
+	bsp_usb_stream_reset();
+}
+
+static void test_in( void )
+{
+	static uint8_t got[ 1024 ];
+	uint32_t len, at;
+	int n;
+
+	/* one full and one short packet, both buffers loaded at once */
+	CHECK( 100 == bsp_usb_stream_write( stream_data, 100 ) );
+	CHECK( ep_hw[ IN_EP ][ 0 ] && ep_hw[ IN_EP ][ 1 ] );
+
+	CHECK( MAXP == host_in( got ) && 0 == memcmp( got, stream_data, MAXP ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 0 == stream.tx_done );
+
+	CHECK( 36 == host_in( got ) && 0 == memcmp( got, &stream_data[ MAXP ], 36 ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 1 == stream.tx_done && 100 == stream.tx_len );
+	CHECK( -1 == host_in( got ) );
+
+	/* two full packets sent before the interrupt, then the ZLP */
+	CHECK( 2 * MAXP == bsp_usb_stream_write( stream_data, 2 * MAXP ) );
+	CHECK( MAXP == host_in( got ) && MAXP == host_in( got ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 1 == stream.tx_done );
+	CHECK( 0 == host_in( got ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 2 == stream.tx_done && 100 + 2 * MAXP == stream.tx_len );
+	CHECK( -1 == host_in( got ) );
+
+	/* a transfer across the end of the ring */
+	CHECK( 400 == bsp_usb_stream_write( stream_data, 400 ) );
+	for( at = 0; at < 400; at += len )
+	{
+		n = host_in( &got[ at ] );
+		CHECK( n > 0 );
+		len = n > 0 ? (uint32_t)n : 400;
+		vPortHostInterrupt( usb_isr );
+	}
+	CHECK( 0 == memcmp( got, stream_data, 400 ) );
+	CHECK( 3 == stream.tx_done && 100 + 2 * MAXP + 400 == stream.tx_len );
+}
+
+static void test_out( void )
+{
+	static uint8_t buf[ 256 ];
+
+	/* two full packets and a short one, an interrupt each */
+	bsp_usb_stream_read( buf, sizeof( buf ) );
+	CHECK( host_out( stream_data, MAXP ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( host_out( &stream_data[ MAXP ], MAXP ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 0 == stream.rx_done );
+	CHECK( host_out( &stream_data[ 2 * MAXP ], 10 ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 1 == stream.rx_done && 2 * MAXP + 10 == stream.rx_len && buf == stream.rx_buf );
+	CHECK( 0 == memcmp( buf, stream_data, 2 * MAXP + 10 ) );
+
+	/* no buffer given: both packet buffers fill, the host is NAKed,
+	 * one interrupt for both
+	 */
+	CHECK( host_out( stream_data, MAXP ) && host_out( &stream_data[ MAXP ], MAXP ) );
+	CHECK( !host_out( stream_data, MAXP ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( !host_out( stream_data, MAXP ) );
+
+	/* the read takes both and completes at once */
+	bsp_usb_stream_read( buf, 2 * MAXP );
+	CHECK( 2 == stream.rx_done && 2 * MAXP == stream.rx_len );
+	CHECK( 0 == memcmp( buf, stream_data, 2 * MAXP ) );
+
+	/* a short packet that waited for the buffer */
+	CHECK( host_out( stream_data, 5 ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 2 == stream.rx_done );
+	bsp_usb_stream_read( buf, sizeof( buf ) );
+	CHECK( 3 == stream.rx_done && 5 == stream.rx_len );
+
+	/* a ZLP ends a transfer of full packets */
+	bsp_usb_stream_read( buf, sizeof( buf ) );
+	CHECK( host_out( stream_data, MAXP ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( host_out( stream_data, 0 ) );
+	vPortHostInterrupt( usb_isr );
+	CHECK( 4 == stream.rx_done && MAXP == stream.rx_len );
+}
+
+/* kB/s of the IN stream, the NAKs in *naks */
+static uint32_t throughput_in( unsigned every, uint32_t *naks )
+{
+	static uint8_t got[ MAXP ];
+	uint32_t produced = 0, received = 0, tokens = 0, tx_len = stream.tx_len;
+	uint32_t nak = nak_in;
+	unsigned since = 0;
+	int n;
+
+	/* a stream that stalls ends at the token limit */
+	while( received < N_STREAM && tokens < N_STREAM )
+	{
+		/* the producer keeps the ring full */
+		if( produced < N_STREAM )
+		{
+			uint32_t len = N_STREAM - produced;
+
+			produced += bsp_usb_stream_write( &stream_data[ produced ], (uint16_t)( len > 512 ? 512 : len ) );
+		}
+
+		n = host_in( got );
+		++tokens;
+		if( n > 0 )
+		{
+			CHECK( 0 == memcmp( got, &stream_data[ received ], (size_t)n ) );
+			received += (uint32_t)n;
+		}
+
+		if( ++since == every )
+		{
+			since = 0;
+			vPortHostInterrupt( usb_isr );
+		}
+	}
+	vPortHostInterrupt( usb_isr );
+
+	CHECK( N_STREAM == received && N_STREAM == stream.tx_len - tx_len );
+
+	*naks = nak_in - nak;
+	return received * 19U / tokens;
+}
+
+static uint32_t throughput_out( unsigned every, uint32_t *naks )
+{
+	uint32_t sent = 0, tokens = 0, nak = nak_out;
+	unsigned since = 0;
+
+	stream.rx_stream = 1;
+	stream.rx_total = 0;
+	bsp_usb_stream_read( rx_bufs[ 0 ], RX_SIZE );
+
+	while( sent < N_STREAM && tokens < N_STREAM )
+	{
+		uint32_t len = N_STREAM - sent;
+
+		if( len > MAXP )
+		{
+			len = MAXP;
+		}
+
+		++tokens;
+		if( host_out( &stream_data[ sent ], (uint16_t)len ) )
+		{
+			sent += len;
+		}
+
+		if( ++since == every )
+		{
+			since = 0;
+			vPortHostInterrupt( usb_isr );
+		}
+	}
+	vPortHostInterrupt( usb_isr );
+
+	CHECK( N_STREAM == sent && N_STREAM == stream.rx_total );
+	stream.rx_stream = 0;
+
+	/* the read given after the last transfer */
+	CHECK( host_out( stream_data, 0 ) );
+	vPortHostInterrupt( usb_isr );
+
+	*naks = nak_out - nak;
+	return sent * 19U / tokens;
+}
+
+static void freertos_test_idle( void )
+{
+	uint32_t in_kbs, out_kbs, in_nak, out_nak;
+	unsigned every;
+
+	vPortHostInterrupt( usb_reset_isr );
+
+	test_in();
+	test_out();
+
+	printf( "usb_stream: %u bytes at 19 packets per frame, the interrupt after every n tokens\n", N_STREAM );
+	printf( "  n   IN kB/s    NAK  OUT kB/s    NAK\n" );
+	for( every = 1; every <= 4; every++ )
+	{
+		in_kbs = throughput_in( every, &in_nak );
+		out_kbs = throughput_out( every, &out_nak );
+		printf( "  %u  %8u %6u  %8u %6u\n", every, in_kbs, in_nak, out_kbs, out_nak );
+
+		/* both packet buffers cover one interrupt latency of a token */
+		if( every <= 2 )
+		{
+			CHECK( 0 == in_nak && 0 == out_nak );
+		}
+	}
+
+	/* every transfer done, the packet buffers back where they started */
+	CHECK( !ep_hw[ IN_EP ][ 0 ] && !ep_hw[ IN_EP ][ 1 ] );
+	CHECK( ep_hw[ OUT_EP ][ 0 ] && ep_hw[ OUT_EP ][ 1 ] );
+	CHECK( QF_pool_[ 0 ].nTot == QF_pool_[ 0 ].nFree );
+
+	freertos_test_end();
+}
+
+int main( void )
+{
+	static QF_MPOOL_EL( USB_STREAM_EVT ) pool[ 4 ];
+	static QEvt const *queue[ 4 ];
+	static StackType_t stack[ configMINIMAL_STACK_SIZE ];
+	uint32_t i;
+
+	for( i = 0; i < N_STREAM; i++ )
+	{
+		stream_data[ i ] = (uint8_t)( i * 7U + i / 251U );
+	}
+
+	QF_init();
+	QF_poolInit( pool, sizeof( pool ), sizeof( pool[ 0 ] ) );
+
+	QActive_ctor( &stream.super, Q_STATE_CAST( &stream_initial ) );
+	QACTIVE_START( &stream.super, 1U, queue, Q_DIM( queue ),
+				   stack, sizeof( stack ), (QEvt *)0 );
+
+	bsp_usb_stream_init( &stream.super, TX_DONE_SIG, RX_DONE_SIG );
+
+	freertos_test_run();
+
+	CHECK( freertos_test_ended );
+
+	return TEST_RESULT( "usb_stream" );
+}
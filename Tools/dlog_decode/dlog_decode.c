@@ -0,0 +1,268 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlog_format.h"
+
+/*
+ * dlog_decode project.axf dlog.bin [cpu hz]
+ *
+ * prints the records of the RTT "DLog" up buffer as text, e.g. from
+ *
+ *   JLinkRTTLogger -Device STM32F103C8 -If SWD -Speed 4000 -RTTChannel 1 dlog.bin
+ *
+ * the format strings and the %s arguments are read from the allocated
+ * sections of the .axf at their address. armlink merges the dlog_fmt
+ * section into the flash region, when the image still has a section of
+ * that name (gcc) the headers must point into it. the time is the DWT
+ * cycle count since the first record, the wraps between records are
+ * followed as long as they are less than 2^32 cycles apart.
+ */
+
+#define DLOG_ADDR_MASK		0x0FFFFFFFU
+
+typedef struct
+{
+	uint32_t addr;
+	uint32_t size;
+	uint8_t const *data;
+} SECTION;
+
+typedef struct
+{
+	uint8_t *file;
+	long file_size;
+
+	SECTION sec[ 64 ];
+	unsigned n_sec;
+
+	SECTION fmt;		/* the dlog_fmt section, size 0: merged */
+	uint32_t fmt_high;	/* the address bits the headers drop */
+} IMAGE;
+
+static uint32_t rd16( uint8_t const *p )
+{
+	return p[ 0 ] | (uint32_t)p[ 1 ] << 8;
+}
+
+static uint32_t rd32( uint8_t const *p )
+{
+	return p[ 0 ] | (uint32_t)p[ 1 ] << 8 | (uint32_t)p[ 2 ] << 16 | (uint32_t)p[ 3 ] << 24;
+}
+
+static uint8_t *load( char const *name, long *size )
+{
+	FILE *f = fopen( name, "rb" );
+	uint8_t *p = NULL;
+
+	if( NULL == f )
+	{
+		return NULL;
+	}
+
+	if( 0 == fseek( f, 0, SEEK_END ) && ( *size = ftell( f ) ) >= 0 && 0 == fseek( f, 0, SEEK_SET ) )
+	{
+		p = malloc( *size + 1 );
+		if( p != NULL && fread( p, 1, *size, f ) != (size_t)*size )
+		{
+			free( p );
+			p = NULL;
+		}
+	}
+
+	fclose( f );
+	return p;
+}
+
+/* the allocated sections of an ELF32 little endian image */
+static int image_open( IMAGE *im, char const *name )
+{
+	uint8_t const *sh, *strtab;
+	uint32_t shoff, shentsize, shnum, shstrndx, type, flags, off, size;
+	unsigned i;
+
+	memset( im, 0, sizeof( *im ) );
+
+	im->file = load( name, &im->file_size );
+	if( NULL == im->file || im->file_size < 52 || memcmp( im->file, "\177ELF\1\1", 6 ) != 0 )
+	{
+		fprintf( stderr, "%s: not an ELF32 little endian image\n", name );
+		return -1;
+	}
+
+	shoff = rd32( im->file + 32 );
+	shentsize = rd16( im->file + 46 );
+	shnum = rd16( im->file + 48 );
+	shstrndx = rd16( im->file + 50 );
+
+	if( shentsize < 40 || shstrndx >= shnum || shoff + (uint64_t)shnum * shentsize > (uint64_t)im->file_size )
+	{
+		fprintf( stderr, "%s: bad section headers\n", name );
+		return -1;
+	}
+
+	strtab = im->file + rd32( im->file + shoff + shstrndx * shentsize + 16 );
+
+	for( i = 0; i < shnum; i++ )
+	{
+		sh = im->file + shoff + i * shentsize;
+		type = rd32( sh + 4 );
+		flags = rd32( sh + 8 );
+		off = rd32( sh + 16 );
+		size = rd32( sh + 20 );
+
+		/* SHF_ALLOC, not SHT_NOBITS */
+		if( 0 == ( flags & 2 ) || 8 == type || (uint64_t)off + size > (uint64_t)im->file_size )
+		{
+			continue;
+		}
+
+		if( im->n_sec < sizeof( im->sec ) / sizeof( im->sec[ 0 ] ) )
+		{
+			im->sec[ im->n_sec ].addr = rd32( sh + 12 );
+			im->sec[ im->n_sec ].size = size;
+			im->sec[ im->n_sec ].data = im->file + off;
+
+			if( 0 == strcmp( (char const *)strtab + rd32( sh ), "dlog_fmt" ) )
+			{
+				im->fmt = im->sec[ im->n_sec ];
+			}
+			++im->n_sec;
+		}
+	}
+
+	/* the flash */
+	im->fmt_high = im->fmt.size != 0 ? im->fmt.addr & ~DLOG_ADDR_MASK : 0x08000000U & ~DLOG_ADDR_MASK;
+
+	return 0;
+}
+
+/* the string at a target address, NULL when it runs out of its section */
+static char const *image_str( uint32_t addr, void *ctx )
+{
+	IMAGE const *im = ctx;
+	SECTION const *s;
+	unsigned i;
+
+	for( i = 0; i < im->n_sec; i++ )
+	{
+		s = &im->sec[ i ];
+		if( addr >= s->addr && addr - s->addr < s->size &&
+			memchr( s->data + ( addr - s->addr ), '\0', s->size - ( addr - s->addr ) ) != NULL )
+		{
+			return (char const *)s->data + ( addr - s->addr );
+		}
+	}
+
+	return NULL;
+}
+
+/* the format string of a record header */
+static char const *image_fmt( IMAGE const *im, uint32_t hdr )
+{
+	uint32_t addr = im->fmt_high | ( hdr & DLOG_ADDR_MASK );
+
+	if( im->fmt.size != 0 && ( addr < im->fmt.addr || addr - im->fmt.addr >= im->fmt.size ) )
+	{
+		return NULL;
+	}
+
+	return image_str( addr, (void *)im );
+}
+
+int main( int argc, char **argv )
+{
+	IMAGE im;
+	uint8_t *stream;
+	long size, pos = 0;
+	uint32_t hdr, time, prev = 0, arg[ 4 ];
+	uint64_t cycles = 0;
+	double hz = 72e6;
+	char text[ 512 ];
+	char const *fmt;
+	unsigned n, k, len, first = 1;
+
+	if( argc < 3 )
+	{
+		fprintf( stderr, "usage: %s project.axf dlog.bin [cpu hz]\n", argv[ 0 ] );
+		return 2;
+	}
+
+	if( image_open( &im, argv[ 1 ] ) != 0 )
+	{
+		return 1;
+	}
+
+	if( argc > 3 )
+	{
+		hz = atof( argv[ 3 ] );
+	}
+
+	stream = load( argv[ 2 ], &size );
+	if( NULL == stream )
+	{
+		fprintf( stderr, "%s: cannot read\n", argv[ 2 ] );
+		return 1;
+	}
+
+	while( pos + 8 <= size )
+	{
+		hdr = rd32( stream + pos );
+		time = rd32( stream + pos + 4 );
+		n = hdr >> 28;
+
+		if( n > 4 || pos + 8 + 4 * (long)n > size )
+		{
+			fprintf( stderr, "offset %ld: bad record 0x%08X\n", pos, (unsigned)hdr );
+			return 1;
+		}
+
+		for( k = 0; k < n; k++ )
+		{
+			arg[ k ] = rd32( stream + pos + 8 + 4 * k );
+		}
+		pos += 8 + 4 * (long)n;
+
+		cycles += first ? 0 : (uint32_t)( time - prev );
+		prev = time;
+		first = 0;
+
+		if( 0 == ( hdr & DLOG_ADDR_MASK ) )
+		{
+			printf( "%12.6f  %u records lost\n", cycles / hz, n != 0 ? (unsigned)arg[ 0 ] : 0U );
+			continue;
+		}
+
+		fmt = image_fmt( &im, hdr );
+		if( NULL == fmt )
+		{
+			printf( "%12.6f  <format 0x%08X not in the image>\n", cycles / hz,
+					(unsigned)( im.fmt_high | ( hdr & DLOG_ADDR_MASK ) ) );
+			continue;
+		}
+
+		len = dlog_format( text, sizeof( text ), fmt, arg, n, image_str, &im );
+
+		/* one line a record */
+		while( len != 0 && ( '\n' == text[ len - 1 ] || '\r' == text[ len - 1 ] ) )
+		{
+			text[ --len ] = '\0';
+		}
+		printf( "%12.6f  %s\n", cycles / hz, text );
+	}
+
+	if( pos != size )
+	{
+		fprintf( stderr, "%ld bytes of a record at the end\n", size - pos );
+	}
+
+	return 0;
+}
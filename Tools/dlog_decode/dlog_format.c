@@ -0,0 +1,146 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dlog_format.h"
+
+/* append to out, truncated at size - 1 */
+static void dlog_append( char *out, unsigned size, unsigned *len, char const *spec, uint32_t arg, char const *s )
+{
+	int n;
+
+	if( *len + 1 >= size )
+	{
+		return;
+	}
+
+	if( s != NULL )
+	{
+		n = snprintf( out + *len, size - *len, spec, s );
+	}
+	else if( 'd' == spec[ strlen( spec ) - 1 ] || 'i' == spec[ strlen( spec ) - 1 ] )
+	{
+		n = snprintf( out + *len, size - *len, spec, (int)(int32_t)arg );
+	}
+	else if( 'c' == spec[ strlen( spec ) - 1 ] )
+	{
+		n = snprintf( out + *len, size - *len, spec, (int)arg );
+	}
+	else
+	{
+		n = snprintf( out + *len, size - *len, spec, (unsigned)arg );
+	}
+
+	if( n > 0 )
+	{
+		*len = *len + (unsigned)n < size ? *len + (unsigned)n : size - 1;
+	}
+}
+
+/**
+ * format one record.
+ *
+ * @param out, size	text buffer, always terminated
+ * @param fmt		format string of the call site
+ * @param arg, n	the arguments of the record
+ * @param str, ctx	strings of the %s arguments
+ *
+ * @return length of the text
+ */
+unsigned dlog_format( char *out, unsigned size, char const *fmt,
+					  uint32_t const *arg, unsigned n, DLOG_STR_FN str, void *ctx )
+{
+	char spec[ 32 ];
+	char lit[ 2 ] = { 0, 0 };
+	char const *s;
+	unsigned len = 0, used = 0, k;
+	char c;
+
+	if( 0 == size )
+	{
+		return 0;
+	}
+	out[ 0 ] = '\0';
+
+	while( *fmt != '\0' )
+	{
+		if( *fmt != '%' )
+		{
+			lit[ 0 ] = *fmt++;
+			dlog_append( out, size, &len, "%s", 0, lit );
+			continue;
+		}
+
+		/* flags, width, precision, the stars take an argument each */
+		spec[ 0 ] = *fmt++;
+		k = 1;
+		while( *fmt != '\0' && strchr( "-+ #0123456789.*", *fmt ) != NULL && k < sizeof( spec ) - 2 )
+		{
+			if( '*' == *fmt )
+			{
+				k += (unsigned)snprintf( spec + k, sizeof( spec ) - 2 - k, "%d",
+										 used < n ? (int)(int32_t)arg[ used ] : 0 );
+				++used;
+				++fmt;
+				k = k < sizeof( spec ) - 2 ? k : sizeof( spec ) - 2;
+				continue;
+			}
+			spec[ k++ ] = *fmt++;
+		}
+
+		while( *fmt != '\0' && strchr( "hljztL", *fmt ) != NULL )
+		{
+			++fmt;
+		}
+
+		c = *fmt;
+		if( '\0' == c )
+		{
+			break;
+		}
+		++fmt;
+
+		if( '%' == c )
+		{
+			dlog_append( out, size, &len, "%s", 0, "%" );
+			continue;
+		}
+
+		if( strchr( "diuxXocs", c ) == NULL || used >= n )
+		{
+			/* not a 32 bit conversion, or an argument short */
+			dlog_append( out, size, &len, "<?%c>", (uint32_t)c, NULL );
+			continue;
+		}
+
+		spec[ k++ ] = c;
+		spec[ k ] = '\0';
+
+		if( 's' == c )
+		{
+			s = str != NULL ? str( arg[ used ], ctx ) : NULL;
+			if( NULL == s )
+			{
+				dlog_append( out, size, &len, "<0x%08X>", arg[ used ], NULL );
+			}
+			else
+			{
+				dlog_append( out, size, &len, spec, 0, s );
+			}
+		}
+		else
+		{
+			dlog_append( out, size, &len, spec, arg[ used ], NULL );
+		}
+		++used;
+	}
+
+	return len;
+}
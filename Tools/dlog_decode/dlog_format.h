@@ -0,0 +1,30 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _DLOG_FORMAT_H
+#define _DLOG_FORMAT_H
+
+#include <stdint.h>
+
+/*
+ * host side of dlog: the text of one record from its format string and
+ * raw 32 bit arguments, see the stream in User/app/inc/dlog.h.
+ *
+ * d i u x X o c s and % with flags, width and precision, length modifiers
+ * are skipped since every argument is 32 bit. %s takes the string at the
+ * target address in the argument through the callback.
+ */
+
+/* string at a target address, NULL: not in the image */
+typedef char const *( *DLOG_STR_FN )( uint32_t addr, void *ctx );
+
+unsigned dlog_format( char *out, unsigned size, char const *fmt,
+					  uint32_t const *arg, unsigned n, DLOG_STR_FN str, void *ctx );
+
+#endif /* _DLOG_FORMAT_H */
@@ -42,14 +42,14 @@
 
 #define configUSE_PREEMPTION		1
 #define configUSE_IDLE_HOOK			0
-#define configUSE_TICK_HOOK			0
+#define configUSE_TICK_HOOK			1
 #define configCPU_CLOCK_HZ			( ( unsigned long ) 72000000 )	
 #define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES		( 32 )
 #define configMINIMAL_STACK_SIZE	( ( unsigned short ) 128 )
 #define configTOTAL_HEAP_SIZE		( ( size_t ) ( 10 * 1024 ) )
 #define configMAX_TASK_NAME_LEN		( 16 )
-#define configUSE_TRACE_FACILITY	0
+#define configUSE_TRACE_FACILITY	1
 #define configUSE_16_BIT_TICKS		0
 #define configIDLE_SHOULD_YIELD		1
 
@@ -75,6 +75,9 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil			1
 #define INCLUDE_vTaskDelay				1
 #define INCLUDE_xTaskGetCurrentTaskHandle 1
+#define INCLUDE_xTaskGetIdleTaskHandle	1
+#define INCLUDE_uxTaskGetStackHighWaterMark 1
+#define INCLUDE_xTaskGetSchedulerState	1
 
 /* This is the raw value as per the Cortex-M3 NVIC.  Values can be 255
 (lowest) to 0 (1?) (highest). */
@@ -90,6 +93,17 @@ configKERNEL_INTERRUPT_PRIORITY setting.  Here 15 corresponds to the lowest
 NVIC value of 255. */
 #define configLIBRARY_KERNEL_INTERRUPT_PRIORITY	15
 
+/* Run time statistics, DWT cycle counter based, see rt_stats.c. */
+#include "rt_stats.h"
+
+#define configGENERATE_RUN_TIME_STATS	1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	rt_stats_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()			rt_stats_get_counter()
+
+#define traceTASK_CREATE( pxNewTCB )			( pxNewTCB )->uxTaskNumber = rt_stats_task_create( pxNewTCB )
+#define traceTASK_SWITCHED_IN()					rt_stats_task_switched_in( pxCurrentTCB->uxTaskNumber )
+#define traceTASK_INCREMENT_TICK( xTickCount )	rt_stats_tick()
+
 #define configASSERT( x )         if( x == 0 ) { taskDISABLE_INTERRUPTS(); for(;;); }
 
 #endif /* FREERTOS_CONFIG_H */
@@ -109,6 +109,11 @@ Revision: $Rev: 9599 $
 //#if ((defined __SES_ARM) || (defined __CROSSWORKS_ARM) || (defined __GNUC__)) && (defined (__ARM_ARCH_7A__))  
 //  #define SEGGER_RTT_MEMCPY(pDest, pSrc, NumBytes)      SEGGER_memcpy((pDest), (pSrc), (NumBytes))
 //#endif
+//
+// Cortex-M3: inline copy with single stores for small records and word blocks, see bsp_memcpy.h
+//
+#include "bsp_memcpy.h"
+#define SEGGER_RTT_MEMCPY(pDest, pSrc, NumBytes)        bsp_memcpy((pDest), (pSrc), (NumBytes))
 
 //
 // Target is not allowed to perform other RTT operations while string still has not been stored completely.
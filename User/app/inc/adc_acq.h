@@ -0,0 +1,44 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _ADC_ACQ_H
+#define _ADC_ACQ_H
+
+#include "qpc.h"
+
+#include "bsp_adc.h"
+
+/* scans averaged into one output sample, 1: no decimation.
+ * must divide BSP_ADC_BLOCK_FRAMES.
+ */
+#ifndef ADC_ACQ_DECIMATE
+#define ADC_ACQ_DECIMATE	8
+#endif
+
+#define ADC_ACQ_OUT_FRAMES	( BSP_ADC_BLOCK_FRAMES / ADC_ACQ_DECIMATE )
+
+/* RTT key requesting adc_acq_report(), see rtt_chan_key(). */
+#define ADC_ACQ_REPORT_KEY	'a'
+
+typedef struct
+{
+	uint32_t blocks;
+	uint32_t overruns;		/* blocks overwritten while processed */
+	uint32_t cycles_max;	/* processing of one block */
+} ADC_ACQ_STATS;
+
+extern QActive * const AO_AdcAcq;
+
+void adc_acq_ctor( void );
+
+uint16_t adc_acq_read( uint8_t ch );
+void adc_acq_stats( ADC_ACQ_STATS *stats );
+void adc_acq_report( unsigned buffer_index );
+
+#endif /* _ADC_ACQ_H */
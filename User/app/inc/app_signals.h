@@ -0,0 +1,39 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _APP_SIGNALS_H
+#define _APP_SIGNALS_H
+
+#include "qpc.h"
+
+/* QP signals of the application active objects. */
+enum app_signals
+{
+	/* published signals */
+	MAX_PUB_SIG = Q_USER_SIG,		/* the last published signal */
+
+	/* direct posted signals */
+	USB_CTR_SIG,					/* usb control transfer captured */
+	USB_STREAM_TX_SIG,				/* usb stream sent the tx ring */
+	USB_STREAM_RX_SIG,				/* usb stream filled the read buffer */
+	SPI_SUBMIT_SIG,					/* spi transfer for the bus */
+	SPI_IDLE_SIG,					/* spi chain done */
+	I2C_SUBMIT_SIG,					/* i2c transfer for the bus */
+	I2C_DONE_SIG,					/* i2c transfer state machine done */
+	I2C_TIMEOUT_SIG,				/* i2c transfer took too long */
+	ADC_BLOCK_SIG,					/* adc block of scans filled */
+	CAN_RX_SIG,						/* can frames in the rx ring */
+	KV_COMPACT_SIG,					/* kv store compaction step */
+	PC_BENCH_TICK_SIG,				/* pc bench producer period */
+	PC_BENCH_DATA_SIG,				/* pc bench event to the consumer */
+
+	MAX_SIG							/* the last signal */
+};
+
+#endif /* _APP_SIGNALS_H */
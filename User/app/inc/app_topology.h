@@ -0,0 +1,158 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _APP_TOPOLOGY_H
+#define _APP_TOPOLOGY_H
+
+#include "qpc.h"
+
+#include "app_signals.h"
+#include "kv_store.h"
+#include "i2c_bus.h"
+#include "spi_bus.h"
+#include "can_bus.h"
+#include "adc_acq.h"
+#include "usb_ao.h"
+#include "pc_bench.h"
+#include "bsp_spi.h"
+#include "bsp_crc.h"
+#include "bsp_usb_stream.h"
+
+/*
+ * the active objects, their events and the expected load in one place.
+ * app_topology.c generates the queues, stacks, event pools and subscriber
+ * lists from the tables below and checks the sizes at compile time, the
+ * depths follow from the rates instead of being guessed per QACTIVE_START.
+ *
+ * a queue (or pool) must hold what arrives while the AO cannot run:
+ * depth = burst + rate * latency, rounded up.
+ */
+#define APP_DEPTH( rate, latency_ms, burst ) \
+	( (burst) + ( (rate) * (latency_ms) + 999U ) / 1000U )
+
+/*
+ * APP_AO( ao, prio, threshold, stack, rate, latency_ms, burst )
+ *
+ * prio			QF priority, unique
+ * threshold	preemption threshold (TASK_THRESHOLD_ATTR), 0: none
+ * stack		words, 0: runs in the dispatcher of QF_SHARED_STACK
+ * rate			events per second posted to the AO, worst case
+ * latency_ms	longest wait to run: its longest RTC step plus the higher
+ *				priority load
+ * burst		events arriving at once (a publish, a self post)
+ *
+ * the constructors are called by main() before app_topology_start().
+ * the adc block is overwritten one block time after its event, waiting
+ * longer is an overrun anyway. the spi clients submit up to a batch at
+ * once, the can driver only posts to an empty queue.
+ */
+#define APP_ADC_BLOCK_MS	( 1000U * BSP_ADC_BLOCK_FRAMES / BSP_ADC_SAMPLE_RATE )
+
+/*
+ * with QF_SHARED_STACK the bus servers, short steps that never block, run
+ * in the dispatcher, band 2..3 (NOTE8 in qf_port.h). the kv store waits on
+ * its flash lock and keeps its task, so do the AOs with tight deadlines
+ * above the band. the led task moves below it.
+ */
+#ifdef QF_SHARED_STACK
+#define APP_SHARED( stack )		0
+#define APP_LED_TASK_PRIO		1
+#else
+#define APP_SHARED( stack )		( stack )
+#define APP_LED_TASK_PRIO		3
+#endif
+
+#define APP_TOPOLOGY_AOS( APP_AO ) \
+	APP_AO( AO_KvStore, 1, 0, 128, 100, 20, 2 ) \
+	APP_AO( AO_I2cBus, 2, 0, APP_SHARED( 128 ), 1000, 5, 4 ) \
+	APP_AO( AO_SpiBus, 3, 0, APP_SHARED( 128 ), 1000, 5, SPI_BUS_BATCH_MAX ) \
+	APP_TOPOLOGY_USB_CAN_AOS( APP_AO ) \
+	APP_AO( AO_AdcAcq, 5, 0, 128, BSP_ADC_SAMPLE_RATE / BSP_ADC_BLOCK_FRAMES, APP_ADC_BLOCK_MS, 1 ) \
+	APP_TOPOLOGY_BENCH_AOS( APP_AO )
+
+/*
+ * APP_POOL( pool, evt_type, rate, hold_ms, burst ), by ascending event size
+ *
+ * evt_type		the largest event of the pool, gives the block size. QF
+ *				needs the sizes strictly ascending, so events of the same
+ *				size share a pool.
+ * rate			allocations per second of all its events, worst case
+ * hold_ms		longest time an event stays allocated, queued and processed
+ *
+ * APP_EVT( evt_type, pool ), every event allocated with Q_NEW(). QF takes
+ * the first pool its event fits, checked at compile time.
+ */
+#define APP_TOPOLOGY_POOLS( APP_POOL ) \
+	APP_POOL( small, SPI_DONE_EVT, 2000, 5, 8 ) \
+	APP_POOL( medium, ADC_BLOCK_EVT, 1000 + BSP_ADC_SAMPLE_RATE / BSP_ADC_BLOCK_FRAMES, 5, 4 ) \
+	APP_TOPOLOGY_CAN_POOLS( APP_POOL )
+
+#define APP_TOPOLOGY_EVTS( APP_EVT ) \
+	APP_EVT( SPI_SUBMIT_EVT, small ) \
+	APP_EVT( SPI_DONE_EVT, small ) \
+	APP_EVT( I2C_SUBMIT_EVT, small ) \
+	APP_EVT( I2C_DONE_EVT, small ) \
+	APP_EVT( CRC_DONE_EVT, small ) \
+	APP_EVT( ADC_BLOCK_EVT, medium ) \
+	APP_TOPOLOGY_USB_EVTS( APP_EVT ) \
+	APP_TOPOLOGY_CAN_EVTS( APP_EVT )
+
+/* USB or CAN, see BSP_USB_DEVICE. the usb AO must answer a bus reset
+ * within 10ms, the stream events are serialized by its loopback. the can
+ * frames are taken with a margin, a flood drops them instead of asserting.
+ */
+#if BSP_USB_DEVICE
+#define APP_TOPOLOGY_USB_CAN_AOS( APP_AO ) \
+	APP_AO( AO_Usb, 4, 0, 160, 1000, 5, 3 )
+#define APP_TOPOLOGY_USB_EVTS( APP_EVT ) \
+	APP_EVT( USB_STREAM_EVT, medium )
+#define APP_TOPOLOGY_CAN_POOLS( APP_POOL )
+#define APP_TOPOLOGY_CAN_EVTS( APP_EVT )
+#else
+#define APP_TOPOLOGY_USB_CAN_AOS( APP_AO ) \
+	APP_AO( AO_CanBus, 4, 0, 128, 1000, 2, 1 )
+#define APP_TOPOLOGY_USB_EVTS( APP_EVT )
+#define APP_TOPOLOGY_CAN_POOLS( APP_POOL ) \
+	APP_POOL( large, CAN_FRAME_EVT, 2000, 5, 8 )
+#define APP_TOPOLOGY_CAN_EVTS( APP_EVT ) \
+	APP_EVT( CAN_FRAME_EVT, large )
+#endif
+
+/* the producer/consumer bench, see pc_bench.h. a burst every period, the
+ * consumer waits for the whole burst under the threshold.
+ */
+#if PC_BENCH
+#define PC_BENCH_THRE	( PC_BENCH_THRESHOLD ? PC_BENCH_CONSUMER_PRIO : 0 )
+#define APP_TOPOLOGY_BENCH_AOS( APP_AO ) \
+	APP_AO( AO_PcProducer, PC_BENCH_PRODUCER_PRIO, PC_BENCH_THRE, 128, 1000 / PC_BENCH_PERIOD, 1, 1 ) \
+	APP_AO( AO_PcConsumer, PC_BENCH_CONSUMER_PRIO, 0, 128, \
+			PC_BENCH_BURST * 1000 / PC_BENCH_PERIOD, 1, PC_BENCH_BURST )
+#else
+#define APP_TOPOLOGY_BENCH_AOS( APP_AO )
+#endif
+
+/*
+ * APP_PUB( ao, sig ) and APP_SUB( ao, sig ), published signals only.
+ * the subscriptions are made by app_topology_start().
+ */
+#define APP_TOPOLOGY_PUBS( APP_PUB )
+#define APP_TOPOLOGY_SUBS( APP_SUB )
+
+/* queues, stacks and pools together, checked at compile time. */
+#ifndef APP_TOPOLOGY_RAM_MAX
+#define APP_TOPOLOGY_RAM_MAX	( 6 * 1024 )
+#endif
+
+/* RTT key requesting app_topology_report(), see rtt_chan_key(). */
+#define APP_TOPOLOGY_REPORT_KEY	't'
+
+void app_topology_start( void );
+void app_topology_report( unsigned buffer_index );
+
+#endif /* _APP_TOPOLOGY_H */
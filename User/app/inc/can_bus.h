@@ -0,0 +1,34 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _CAN_BUS_H
+#define _CAN_BUS_H
+
+#include "qpc.h"
+
+#include "bsp_can.h"
+
+/* subscribed ids, at most 56 standard or 28 extended ones fit the filters. */
+#define CAN_BUS_SUBS_MAX	16
+
+typedef struct
+{
+	QEvt super;
+
+	CAN_FRAME frame;
+} CAN_FRAME_EVT;
+
+extern QActive * const AO_CanBus;
+
+void can_bus_ctor( void );
+void can_bus_subscribe( uint32_t id, QActive *ao, enum_t sig );
+
+void can_bus_report( unsigned buffer_index );
+
+#endif /* _CAN_BUS_H */
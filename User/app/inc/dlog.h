@@ -0,0 +1,73 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _DLOG_H
+#define _DLOG_H
+
+#include <stdint.h>
+
+/*
+ * deferred binary log. a call site stores the address of its format string
+ * and up to 4 raw 32 bit arguments, the string is formatted on the host.
+ *
+ * the format strings are collected in the section DLOG_SECTION_NAME, the
+ * host takes them from the .axf by address. stream on the RTT up buffer
+ * of RTT_CHAN_DLOG, little endian words per record:
+ *
+ *   header	( n << 28 ) | ( format address & 0x0FFFFFFF ), n = argument count
+ *   time	DWT CYCCNT at the call
+ *   n arguments
+ *
+ * header address 0: records lost because the ring was full, the argument
+ * is their count. %s arguments must point to constant strings in flash.
+ */
+
+/* records between the call sites and dlog_flush(), must be a power of 2. */
+#ifndef DLOG_SLOTS
+#define DLOG_SLOTS			64
+#endif
+
+#define DLOG_SECTION_NAME	"dlog_fmt"
+
+/* RTT key of dlog_bench() */
+#define DLOG_BENCH_KEY		'd'
+
+#define DLOG_FMT_( fmt_ )	\
+	static char const dlog_fmt_[] __attribute__( ( section( DLOG_SECTION_NAME ), used ) ) = fmt_
+
+#define DLOG0( fmt_ ) do { \
+	DLOG_FMT_( fmt_ ); \
+	dlog_write( dlog_fmt_, 0, 0, 0, 0, 0 ); \
+} while( 0 )
+
+#define DLOG1( fmt_, a_ ) do { \
+	DLOG_FMT_( fmt_ ); \
+	dlog_write( dlog_fmt_, 1, (uint32_t)( a_ ), 0, 0, 0 ); \
+} while( 0 )
+
+#define DLOG2( fmt_, a_, b_ ) do { \
+	DLOG_FMT_( fmt_ ); \
+	dlog_write( dlog_fmt_, 2, (uint32_t)( a_ ), (uint32_t)( b_ ), 0, 0 ); \
+} while( 0 )
+
+#define DLOG3( fmt_, a_, b_, c_ ) do { \
+	DLOG_FMT_( fmt_ ); \
+	dlog_write( dlog_fmt_, 3, (uint32_t)( a_ ), (uint32_t)( b_ ), (uint32_t)( c_ ), 0 ); \
+} while( 0 )
+
+#define DLOG4( fmt_, a_, b_, c_, d_ ) do { \
+	DLOG_FMT_( fmt_ ); \
+	dlog_write( dlog_fmt_, 4, (uint32_t)( a_ ), (uint32_t)( b_ ), (uint32_t)( c_ ), (uint32_t)( d_ ) ); \
+} while( 0 )
+
+void dlog_write( char const *fmt, uint32_t n, uint32_t a, uint32_t b, uint32_t c, uint32_t d );
+void dlog_flush( void );
+void dlog_bench( unsigned buffer_index );
+
+#endif /* _DLOG_H */
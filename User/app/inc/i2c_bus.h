@@ -0,0 +1,76 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _I2C_BUS_H
+#define _I2C_BUS_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/* I2C1, SCL PB6, SDA PB7, DMA1 channel 6 (TX) and 7 (RX). */
+#define RCC_I2C_GPIO			( RCC_APB2Periph_GPIOB )
+#define GPIO_PORT_I2C			GPIOB
+#define GPIO_PIN_I2C_SCL		GPIO_Pin_6
+#define GPIO_PIN_I2C_SDA		GPIO_Pin_7
+
+#define I2C_BUS_SPEED			400000
+
+/* must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY (5). */
+#define I2C_BUS_IRQ_PRIO		6
+
+/* QF ticks a transfer may take before the bus is reset, the application
+ * must call QF_TICK_X() for QF tick rate 0.
+ */
+#define I2C_BUS_TIMEOUT_TICKS	10
+
+/* I2C_XFER status */
+#define I2C_XFER_OK				0
+#define I2C_XFER_NACK			1	/* address or data not acknowledged */
+#define I2C_XFER_BUS_ERR		2	/* bus error, arbitration lost, overrun */
+#define I2C_XFER_TIMEOUT		3
+
+/* transfer descriptor, owned by the caller until the done event.
+ * writes tx (if any), then reads rx (if any) after a repeated start.
+ */
+typedef struct I2C_XFER
+{
+	struct I2C_XFER *next;	/* used by the bus queue */
+
+	uint8_t addr;			/* 7 bit slave address */
+	uint8_t status;			/* I2C_XFER_xxx, set when done */
+	uint16_t tx_len;
+	uint16_t rx_len;
+	uint8_t const *tx;
+	uint8_t *rx;
+
+	QActive *ao;			/* gets sig with I2C_DONE_EVT, NULL: none */
+	enum_t sig;
+} I2C_XFER;
+
+typedef struct
+{
+	QEvt super;
+
+	I2C_XFER *xfer;
+} I2C_DONE_EVT;
+
+typedef struct
+{
+	QEvt super;
+
+	I2C_XFER *xfer;
+} I2C_SUBMIT_EVT;
+
+extern QActive * const AO_I2cBus;
+
+void i2c_bus_ctor( void );
+void i2c_bus_submit( I2C_XFER *xfer, void const *sender );
+
+#endif /* _I2C_BUS_H */
@@ -0,0 +1,47 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _KV_STORE_H
+#define _KV_STORE_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/* the last 4 pages of the STM32F103CB, excluded from IROM1 of the target. */
+#define KV_FLASH_BASE		0x0801F000U
+#define KV_PAGE_SIZE		1024
+#define KV_PAGES			4
+
+/* keys live in the RAM index, must be a power of 2 above the key count. */
+#define KV_INDEX_SIZE		64
+
+#define KV_VALUE_MAX		64
+
+/* RTT key requesting kv_store_report(), see rtt_chan_key(). */
+#define KV_STORE_REPORT_KEY	'k'
+
+/* kv_get() / kv_put() / kv_del() */
+#define KV_OK				0
+#define KV_ERR_NOT_FOUND	( -1 )
+#define KV_ERR_FULL			( -2 )	/* no page or no index slot, retry after the compaction */
+#define KV_ERR_SIZE			( -3 )
+
+/* the compaction, start it at a low priority. */
+extern QActive * const AO_KvStore;
+
+void kv_store_ctor( void );
+
+int16_t kv_get( uint16_t key, void *buf, uint16_t size );
+int16_t kv_put( uint16_t key, void const *data, uint16_t len );
+int16_t kv_del( uint16_t key );
+
+void kv_store_report( unsigned buffer_index );
+
+#endif /* _KV_STORE_H */
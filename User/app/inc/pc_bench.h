@@ -0,0 +1,42 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _PC_BENCH_H
+#define _PC_BENCH_H
+
+#include "qpc.h"
+
+/* 1: run the producer/consumer pair that counts the context switches a
+ * preemption threshold saves (NOTE9 in qf_port.h), 0: not built in.
+ */
+#ifndef PC_BENCH
+#define PC_BENCH			0
+#endif
+
+/* 1: the producer gets the consumer priority as its threshold. */
+#ifndef PC_BENCH_THRESHOLD
+#define PC_BENCH_THRESHOLD	1
+#endif
+
+#define PC_BENCH_PRODUCER_PRIO	10
+#define PC_BENCH_CONSUMER_PRIO	11
+
+/* events posted back to back every PC_BENCH_PERIOD ticks */
+#define PC_BENCH_BURST		8
+#define PC_BENCH_PERIOD		10
+
+/* bursts per report */
+#define PC_BENCH_ROUNDS		100
+
+extern QActive * const AO_PcProducer;
+extern QActive * const AO_PcConsumer;
+
+void pc_bench_ctor( void );
+
+#endif /* _PC_BENCH_H */
@@ -0,0 +1,41 @@
+
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _RT_STATS_H
+#define _RT_STATS_H
+
+#include <stdint.h>
+
+/* this header is included by FreeRTOSConfig.h, so it must not include
+ * any FreeRTOS header itself.
+ */
+
+/* number of tasks tracked, task created beyond that are counted in slot 0. */
+#define RT_STATS_MAX_TASKS		16
+
+/* tasks listed by the report, tracked or not. */
+#define RT_STATS_MAX_STATUS		24
+
+/* FreeRTOS run time counter = cycles >> shift, 72MHz >> 6 wraps after ~63min. */
+#define RT_STATS_COUNTER_SHIFT	6
+
+/* RTT key requesting rt_stats_report(), see rtt_chan_key(). */
+#define RT_STATS_REPORT_KEY		's'
+
+/* FreeRTOS hooks, see FreeRTOSConfig.h */
+void rt_stats_init( void );
+uint32_t rt_stats_get_counter( void );
+uint32_t rt_stats_task_create( void const *task );
+void rt_stats_task_switched_in( uint32_t slot );
+void rt_stats_tick( void );
+
+void rt_stats_report( unsigned buffer_index );
+
+#endif /* _RT_STATS_H */
@@ -0,0 +1,59 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _RTT_CHAN_H
+#define _RTT_CHAN_H
+
+#include <stdint.h>
+
+/* RAM shared by the up and down buffers of the channels below. buffer 0
+ * keeps its own static buffers of SEGGER_RTT_Conf.h.
+ */
+#ifndef RTT_CHAN_POOL
+#define RTT_CHAN_POOL		1536
+#endif
+
+/* kv store key of the statistics of the last boot. */
+#define RTT_CHAN_KV_KEY		0x0100
+
+/* RTT key requesting rtt_chan_report(), see rtt_chan_key(). */
+#define RTT_CHAN_REPORT_KEY	'r'
+
+/* channels, each needs one of SEGGER_RTT_MAX_NUM_UP_BUFFERS. */
+typedef enum
+{
+	RTT_CHAN_DLOG,		/* deferred binary log */
+	RTT_CHAN_REPORT,	/* xxx_report() output, "Cmd" down buffer */
+
+	RTT_CHAN_NUM
+} RTT_CHAN;
+
+typedef struct
+{
+	uint32_t written;	/* bytes */
+	uint32_t dropped;	/* bytes */
+	uint16_t max_fill;	/* bytes */
+	uint16_t size;		/* up buffer */
+} RTT_CHAN_STATS;
+
+void rtt_chan_init( void );
+
+int rtt_chan_up( RTT_CHAN ch );
+int rtt_chan_down( RTT_CHAN ch );
+
+unsigned rtt_chan_space( RTT_CHAN ch );
+unsigned rtt_chan_write( RTT_CHAN ch, void const *p, unsigned n );
+int rtt_chan_key( RTT_CHAN ch );
+void rtt_chan_poll( void );
+
+void rtt_chan_stats( RTT_CHAN ch, RTT_CHAN_STATS *stats );
+void rtt_chan_save( void );
+void rtt_chan_report( unsigned buffer_index );
+
+#endif /* _RTT_CHAN_H */
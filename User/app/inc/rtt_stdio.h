@@ -0,0 +1,53 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _RTT_STDIO_H
+#define _RTT_STDIO_H
+
+#include <stdint.h>
+
+#include "SEGGER_RTT.h"
+
+/* staging buffer per task. a line goes out whole at its '\n', the
+ * characters past RTT_STDIO_LINE - 1 are cut and counted.
+ */
+#ifndef RTT_STDIO_LINE
+#define RTT_STDIO_LINE		64
+#endif
+
+/* RTT up buffer of stdout */
+#define RTT_STDIO_CHANNEL	0
+
+/* RTT key of rtt_stdio_report() */
+#define RTT_STDIO_REPORT_KEY	'p'
+
+/* when a line does not fit: SEGGER_RTT_MODE_NO_BLOCK_SKIP drops it,
+ * SEGGER_RTT_MODE_NO_BLOCK_TRIM writes what fits, and
+ * SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL waits a tick at a time (tasks only).
+ */
+#ifndef RTT_STDIO_MODE
+#define RTT_STDIO_MODE		SEGGER_RTT_MODE_NO_BLOCK_SKIP
+#endif
+
+typedef struct
+{
+	uint32_t chars;
+	uint32_t writes;	/* RTT lock taken */
+	uint32_t dropped;	/* bytes */
+	uint32_t cut;		/* characters of too long lines */
+	uint32_t cycles;	/* in rtt_stdio_putc() and the writes */
+} RTT_STDIO_STATS;
+
+void rtt_stdio_putc( char ch );
+void rtt_stdio_flush( void );
+
+void rtt_stdio_stats( RTT_STDIO_STATS *stats );
+void rtt_stdio_report( unsigned buffer_index );
+
+#endif /* _RTT_STDIO_H */
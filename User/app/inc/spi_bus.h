@@ -0,0 +1,32 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _SPI_BUS_H
+#define _SPI_BUS_H
+
+#include "qpc.h"
+
+#include "bsp_spi.h"
+
+/* transfers of one device taken into a chain before the next device. */
+#define SPI_BUS_BATCH_MAX	8
+
+typedef struct
+{
+	QEvt super;
+
+	SPI_XFER *xfer;
+} SPI_SUBMIT_EVT;
+
+extern QActive * const AO_SpiBus;
+
+void spi_bus_ctor( void );
+void spi_bus_submit( SPI_XFER *xfer, void const *sender );
+
+#endif /* _SPI_BUS_H */
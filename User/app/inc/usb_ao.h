@@ -0,0 +1,43 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _USB_AO_H
+#define _USB_AO_H
+
+#include "qpc.h"
+
+/* 1: control transfers run in the usb active object,
+ * 0: they run in the interrupt as before (to compare the ISR time).
+ */
+#ifndef USB_AO_DEFERRED
+#define USB_AO_DEFERRED		1
+#endif
+
+/* captured transfers not serviced yet, a power of 2 of at least 3: a
+ * reset, the control transfer behind it and the slot being captured. each
+ * one holds a copy of the received packet, 74 bytes.
+ */
+#define USB_AO_RING_SIZE	4
+
+/* stream loopback block, at least USB_STREAM_MAX_PACKET. */
+#define USB_AO_LOOP_SIZE	256
+
+extern QActive * const AO_Usb;
+
+void usb_ao_ctor( void );
+
+/* from USB_Istr() (usb_istr.c): instead of CTR_LP() and of
+ * Device_Property.Reset().
+ */
+void usb_ao_ctr_isr( void );
+void usb_ao_reset_isr( void );
+
+uint32_t usb_ao_isr_cycles_max( void );
+
+#endif /* _USB_AO_H */
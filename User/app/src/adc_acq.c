@@ -0,0 +1,182 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "SEGGER_RTT.h"
+
+#include "bsp_dwt.h"
+
+#include "app_signals.h"
+#include "adc_acq.h"
+
+Q_DEFINE_THIS_MODULE("adc_acq")
+
+/*
+ * processing side of the adc pipeline. each ADC_BLOCK_SIG carries one half
+ * of the driver's ping-pong buffer, it is averaged down by ADC_ACQ_DECIMATE
+ * while the DMA fills the other half. a block the DMA started to overwrite
+ * before it was done is counted and dropped.
+ *
+ * the cycles spent on a block give the scan rate the processing could keep
+ * up with, see adc_acq_report().
+ */
+
+typedef struct
+{
+	QActive super;
+
+	uint16_t out[ ADC_ACQ_OUT_FRAMES ][ BSP_ADC_CHANNELS ];
+	uint16_t last[ BSP_ADC_CHANNELS ];	/* newest output sample */
+
+	ADC_ACQ_STATS st;
+} ADC_ACQ;
+
+static ADC_ACQ adc_acq;
+QActive * const AO_AdcAcq = &adc_acq.super;
+
+static QState adc_acq_initial( ADC_ACQ * const me, QEvt const * const e );
+static QState adc_acq_active( ADC_ACQ * const me, QEvt const * const e );
+
+void adc_acq_ctor( void )
+{
+	Q_ASSERT_ID( 100, BSP_ADC_BLOCK_FRAMES % ADC_ACQ_DECIMATE == 0 );
+
+	QActive_ctor( &adc_acq.super, Q_STATE_CAST( &adc_acq_initial ) );
+}
+
+/**
+ * newest averaged sample of a channel, raw 12 bit.
+ */
+uint16_t adc_acq_read( uint8_t ch )
+{
+	Q_REQUIRE_ID( 200, ch < BSP_ADC_CHANNELS );
+
+	return adc_acq.last[ ch ];
+}
+
+/**
+ * the block statistics, from any task.
+ */
+void adc_acq_stats( ADC_ACQ_STATS *stats )
+{
+	taskENTER_CRITICAL();
+	*stats = adc_acq.st;
+	taskEXIT_CRITICAL();
+}
+
+/**
+ * print the block statistics.
+ *
+ * max rate: scans a second the processing alone could take, from the worst
+ * block seen.
+ *
+ * @param RTT up buffer index
+ */
+void adc_acq_report( unsigned buffer_index )
+{
+	ADC_ACQ_STATS s;
+	uint32_t rate = 0;
+
+	adc_acq_stats( &s );
+
+	if( s.cycles_max != 0 )
+	{
+		rate = (uint32_t)( (uint64_t)SystemCoreClock * BSP_ADC_BLOCK_FRAMES / s.cycles_max );
+	}
+
+	SEGGER_RTT_printf( buffer_index, "adc blocks %u, overruns %u, block %u cycles, rate %u/%u scans/s\r\n",
+					   (unsigned)s.blocks, (unsigned)s.overruns,
+					   (unsigned)s.cycles_max, (unsigned)BSP_ADC_SAMPLE_RATE, (unsigned)rate );
+}
+
+/* average ADC_ACQ_DECIMATE scans into each output scan. */
+static void adc_acq_decimate( ADC_ACQ * const me, uint16_t const *in )
+{
+	uint32_t sum[ BSP_ADC_CHANNELS ];
+	uint16_t f, k;
+	uint8_t ch;
+
+	for( f = 0; f < ADC_ACQ_OUT_FRAMES; f++ )
+	{
+		for( ch = 0; ch < BSP_ADC_CHANNELS; ch++ )
+		{
+			sum[ ch ] = *in++;
+		}
+
+		for( k = 1; k < ADC_ACQ_DECIMATE; k++ )
+		{
+			for( ch = 0; ch < BSP_ADC_CHANNELS; ch++ )
+			{
+				sum[ ch ] += *in++;
+			}
+		}
+
+		for( ch = 0; ch < BSP_ADC_CHANNELS; ch++ )
+		{
+			me->out[ f ][ ch ] = (uint16_t)( sum[ ch ] / ADC_ACQ_DECIMATE );
+		}
+	}
+}
+
+static QState adc_acq_initial( ADC_ACQ * const me, QEvt const * const e )
+{
+	(void)e;
+
+	me->st.blocks = 0;
+	me->st.overruns = 0;
+	me->st.cycles_max = 0;
+
+	bsp_adc_init( &me->super, ADC_BLOCK_SIG );
+	bsp_adc_start();
+
+	return Q_TRAN( &adc_acq_active );
+}
+
+static QState adc_acq_active( ADC_ACQ * const me, QEvt const * const e )
+{
+	QState status;
+	ADC_BLOCK_EVT const *b;
+	uint32_t t0, cycles;
+	uint8_t ch;
+
+	switch( e->sig )
+	{
+		case ADC_BLOCK_SIG:
+			b = (ADC_BLOCK_EVT const *)e;
+
+			t0 = bsp_dwt_get_cycles();
+			adc_acq_decimate( me, b->data );
+			cycles = bsp_dwt_get_cycles() - t0;
+
+			if( cycles > me->st.cycles_max )
+			{
+				me->st.cycles_max = cycles;
+			}
+
+			++me->st.blocks;
+
+			if( bsp_adc_block_valid( b ) )
+			{
+				for( ch = 0; ch < BSP_ADC_CHANNELS; ch++ )
+				{
+					me->last[ ch ] = me->out[ ADC_ACQ_OUT_FRAMES - 1 ][ ch ];
+				}
+			}
+			else
+			{
+				++me->st.overruns;
+			}
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
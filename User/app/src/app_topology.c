@@ -0,0 +1,196 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "SEGGER_RTT.h"
+
+#include "qpc.h"
+
+#include "app_topology.h"
+
+Q_DEFINE_THIS_MODULE("app_topology")
+
+/*
+ * everything below is generated from the tables in app_topology.h.
+ * the checks use Q_ASSERT_COMPILE(), armcc 5 has no _Static_assert.
+ */
+
+#ifdef QF_SHARED_STACK
+#define APP_SHARED_STACK	1
+#else
+#define APP_SHARED_STACK	0
+#endif
+
+#define APP_EQUEUE_MAX		( (QEQueueCtr)~(QEQueueCtr)0 )
+#define APP_MPOOL_MAX		( (QMPoolCtr)~(QMPoolCtr)0 )
+
+/* storage --------------------------------------------------------------- */
+#define APP_AO_STORAGE( ao, prio, thre, stack, rate, latency_ms, burst ) \
+	static QEvt const *app_queue_##ao[ APP_DEPTH( rate, latency_ms, burst ) ];
+
+/* the stacks in one block, the offset of each from its enumerator. an AO
+ * of the dispatcher (stack 0) takes nothing of it.
+ */
+#define APP_AO_STACK_AT( ao, prio, thre, stack, rate, latency_ms, burst ) \
+	app_stack_at_##ao, app_stack_last_##ao = app_stack_at_##ao + ( stack ) - 1,
+
+enum app_stack_at
+{
+	APP_TOPOLOGY_AOS( APP_AO_STACK_AT )
+	app_stack_words
+};
+
+#define APP_POOL_STORAGE( pool, evt_type, rate, hold_ms, burst ) \
+	static QF_MPOOL_EL( evt_type ) app_pool_##pool[ APP_DEPTH( rate, hold_ms, burst ) ];
+
+APP_TOPOLOGY_AOS( APP_AO_STORAGE )
+APP_TOPOLOGY_POOLS( APP_POOL_STORAGE )
+
+/* a word when every AO runs in the dispatcher, C has no empty array */
+static StackType_t app_stack[ app_stack_words ? app_stack_words : 1 ];
+
+#ifdef QF_PS_SPARSE
+#define APP_SUB_ENTRY( ao, sig )	+ 1
+/* one entry per subscription is enough, +1 for an empty table */
+static QSubscrEntry app_subscr[ 1 APP_TOPOLOGY_SUBS( APP_SUB_ENTRY ) ];
+#else
+static QSubscrList app_subscr[ MAX_PUB_SIG ];
+#endif
+
+/* compile-time checks --------------------------------------------------- */
+#define APP_AO_CHECK( ao, prio, thre, stack, rate, latency_ms, burst ) \
+	Q_ASSERT_COMPILE( ( prio ) >= 1 && ( prio ) <= QF_MAX_ACTIVE ); \
+	Q_ASSERT_COMPILE( ( thre ) == 0 || ( ( thre ) >= ( prio ) && ( thre ) <= QF_MAX_ACTIVE ) ); \
+	Q_ASSERT_COMPILE( ( stack ) >= configMINIMAL_STACK_SIZE || ( ( stack ) == 0 && APP_SHARED_STACK ) ); \
+	Q_ASSERT_COMPILE( APP_DEPTH( rate, latency_ms, burst ) >= 1 ); \
+	Q_ASSERT_COMPILE( APP_DEPTH( rate, latency_ms, burst ) <= APP_EQUEUE_MAX );
+
+#define APP_POOL_CHECK( pool, evt_type, rate, hold_ms, burst ) \
+	Q_ASSERT_COMPILE( sizeof( evt_type ) >= sizeof( QEvt ) ); \
+	Q_ASSERT_COMPILE( APP_DEPTH( rate, hold_ms, burst ) >= 1 ); \
+	Q_ASSERT_COMPILE( APP_DEPTH( rate, hold_ms, burst ) <= APP_MPOOL_MAX );
+
+#define APP_SIG_CHECK( ao, sig ) \
+	Q_ASSERT_COMPILE( ( sig ) >= Q_USER_SIG && ( sig ) < MAX_PUB_SIG );
+
+/* the block of the event is the one of its pool: it does not fit a smaller
+ * pool, QF_poolInit() asserts that the pools ascend.
+ */
+#define APP_EVT_CHECK( evt_type, pool ) \
+	Q_ASSERT_COMPILE( sizeof( QF_MPOOL_EL( evt_type ) ) == sizeof( app_pool_##pool[ 0 ] ) );
+
+APP_TOPOLOGY_AOS( APP_AO_CHECK )
+APP_TOPOLOGY_POOLS( APP_POOL_CHECK )
+APP_TOPOLOGY_EVTS( APP_EVT_CHECK )
+APP_TOPOLOGY_PUBS( APP_SIG_CHECK )
+APP_TOPOLOGY_SUBS( APP_SIG_CHECK )
+
+/* a priority used twice defines the same enumerator twice */
+#define APP_AO_PRIO( ao, prio, thre, stack, rate, latency_ms, burst )	app_prio_##prio,
+enum app_prio
+{
+	APP_TOPOLOGY_AOS( APP_AO_PRIO )
+	app_prio_end
+};
+
+#define APP_AO_RAM( ao, prio, thre, stack, rate, latency_ms, burst ) \
+	+ sizeof( app_queue_##ao ) + ( stack ) * sizeof( StackType_t )
+#define APP_POOL_RAM( pool, evt_type, rate, hold_ms, burst ) \
+	+ sizeof( app_pool_##pool )
+
+#define APP_RAM	( sizeof( app_subscr ) \
+				  APP_TOPOLOGY_AOS( APP_AO_RAM ) APP_TOPOLOGY_POOLS( APP_POOL_RAM ) )
+
+Q_ASSERT_COMPILE( APP_RAM <= APP_TOPOLOGY_RAM_MAX );
+
+#define APP_AO_STACK( ao, prio, thre, stack, rate, latency_ms, burst )	+ ( stack )
+Q_ASSERT_COMPILE( app_stack_words == 0 APP_TOPOLOGY_AOS( APP_AO_STACK ) );
+
+/* start ----------------------------------------------------------------- */
+#define APP_POOL_INIT( pool, evt_type, rate, hold_ms, burst ) \
+	QF_poolInit( app_pool_##pool, sizeof( app_pool_##pool ), sizeof( app_pool_##pool[ 0 ] ) );
+
+#define APP_AO_START( ao, prio, thre, stack, rate, latency_ms, burst ) \
+	if( ( thre ) != 0 ) \
+	{ \
+		QActive_setAttr( ao, TASK_THRESHOLD_ATTR, (void const *)( thre ) ); \
+	} \
+	QACTIVE_START( ao, prio, app_queue_##ao, Q_DIM( app_queue_##ao ), \
+				   ( stack ) ? (void *)&app_stack[ app_stack_at_##ao ] : (void *)0, ( stack ) * sizeof( StackType_t ), (QEvt *)0 );
+
+#define APP_AO_SUBSCRIBE( ao, sig ) \
+	QActive_subscribe( ao, sig );
+
+/**
+ * init the event pools and the subscriber lists, start the active objects
+ * and make their subscriptions. the constructors must have been called.
+ */
+void app_topology_start( void )
+{
+#ifdef QF_PS_SPARSE
+	QF_psInitSparse( app_subscr, Q_DIM( app_subscr ), MAX_PUB_SIG );
+#else
+	QF_psInit( app_subscr, Q_DIM( app_subscr ) );
+#endif
+
+	APP_TOPOLOGY_POOLS( APP_POOL_INIT )
+	APP_TOPOLOGY_AOS( APP_AO_START )
+	APP_TOPOLOGY_SUBS( APP_AO_SUBSCRIBE )
+}
+
+/* report ---------------------------------------------------------------- */
+#define APP_AO_REPORT( ao, prio, thre, stack, rate, latency_ms, burst ) \
+	app_topology_report_ao( buffer_index, #ao, ao, stack );
+
+/* the pools are numbered in the order of QF_poolInit() */
+#define APP_POOL_REPORT( pool, evt_type, rate, hold_ms, burst ) \
+	++pool_id; \
+	SEGGER_RTT_printf( buffer_index, " pool %u: %u/%u blocks of %u bytes  %s\r\n", \
+					   (unsigned)pool_id, \
+					   (unsigned)( Q_DIM( app_pool_##pool ) - QF_getPoolMin( pool_id ) ), \
+					   (unsigned)Q_DIM( app_pool_##pool ), \
+					   (unsigned)sizeof( app_pool_##pool[ 0 ] ), #pool );
+
+static void app_topology_report_ao( unsigned buffer_index, char const *name, QActive *ao, uint32_t stack )
+{
+	uint32_t len = (uint32_t)ao->eQueue.end + 1;	/* the ring plus the front event */
+	uint32_t used = len - (uint32_t)ao->eQueue.nMin;
+	uint32_t water;
+
+	if( 0 == stack )
+	{
+		/* no task of its own, the dispatcher of QF_SHARED_STACK runs it */
+		SEGGER_RTT_printf( buffer_index, " %2u %5u/%-5u      shared  %s\r\n",
+						   (unsigned)ao->prio, (unsigned)used, (unsigned)len, name );
+		return;
+	}
+
+	water = (uint32_t)uxTaskGetStackHighWaterMark( (TaskHandle_t)&ao->thread );
+
+	SEGGER_RTT_printf( buffer_index, " %2u %5u/%-5u %5u/%-5u  %s\r\n",
+					   (unsigned)ao->prio, (unsigned)used, (unsigned)len,
+					   (unsigned)( stack - water ), (unsigned)stack, name );
+}
+
+/**
+ * print the deepest queue, the stack and the pool use so far against the
+ * sizes from the tables, to tune the rates and latencies with.
+ *
+ * @param RTT up buffer index
+ */
+void app_topology_report( unsigned buffer_index )
+{
+	uint_fast8_t pool_id = 0;
+
+	SEGGER_RTT_printf( buffer_index, "\r\n qf  queue used  stack used  name\r\n" );
+
+	APP_TOPOLOGY_AOS( APP_AO_REPORT )
+	APP_TOPOLOGY_POOLS( APP_POOL_REPORT )
+
+	SEGGER_RTT_printf( buffer_index, "topology ram %u of %u bytes\r\n",
+					   (unsigned)APP_RAM, (unsigned)APP_TOPOLOGY_RAM_MAX );
+}
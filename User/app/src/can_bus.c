@@ -0,0 +1,150 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "SEGGER_RTT.h"
+
+#include "app_signals.h"
+#include "can_bus.h"
+
+Q_DEFINE_THIS_MODULE("can_bus")
+
+/*
+ * can receive dispatcher. the subscribed ids are the hardware filter list,
+ * so a frame arrives with the index of its subscription and is posted to
+ * that subscriber without a search. one subscriber per id, frames are sent
+ * with bsp_can_send() directly.
+ */
+
+typedef struct
+{
+	QActive *ao;
+	enum_t sig;
+} CAN_SUB;
+
+typedef struct
+{
+	QActive super;
+
+	uint32_t ids[ CAN_BUS_SUBS_MAX ];
+	CAN_SUB subs[ CAN_BUS_SUBS_MAX ];
+	uint8_t n_subs;
+
+	uint32_t dropped;	/* no subscriber, no event or a full queue */
+} CAN_BUS;
+
+static CAN_BUS can_bus;
+QActive * const AO_CanBus = &can_bus.super;
+
+static QState can_bus_initial( CAN_BUS * const me, QEvt const * const e );
+static QState can_bus_active( CAN_BUS * const me, QEvt const * const e );
+
+void can_bus_ctor( void )
+{
+	QActive_ctor( &can_bus.super, Q_STATE_CAST( &can_bus_initial ) );
+	can_bus.n_subs = 0;
+}
+
+/**
+ * deliver frames of id to ao as CAN_FRAME_EVT, call before the bus starts.
+ *
+ * @param id 11 bit, or 29 bit | CAN_ID_EXT_FLAG
+ */
+void can_bus_subscribe( uint32_t id, QActive *ao, enum_t sig )
+{
+	CAN_BUS *me = &can_bus;
+
+	Q_REQUIRE_ID( 100, me->n_subs < CAN_BUS_SUBS_MAX );
+
+	me->ids[ me->n_subs ] = id;
+	me->subs[ me->n_subs ].ao = ao;
+	me->subs[ me->n_subs ].sig = sig;
+	++me->n_subs;
+}
+
+/**
+ * print the driver statistics, cycles per frame of the receive interrupt.
+ *
+ * @param RTT up buffer index
+ */
+void can_bus_report( unsigned buffer_index )
+{
+	BSP_CAN_STATS s;
+
+	bsp_can_stats( &s );
+
+	SEGGER_RTT_printf( buffer_index, "can rx %u, overruns %u, dropped %u, isr %u cycles/frame\r\n",
+					   (unsigned)s.rx_frames, (unsigned)s.rx_overruns, (unsigned)can_bus.dropped,
+					   (unsigned)( s.rx_frames ? s.rx_cycles / s.rx_frames : 0 ) );
+	SEGGER_RTT_printf( buffer_index, "can tx %u, preempts %u\r\n",
+					   (unsigned)s.tx_frames, (unsigned)s.tx_preempts );
+}
+
+static QState can_bus_initial( CAN_BUS * const me, QEvt const * const e )
+{
+	uint8_t ok;
+
+	(void)e;
+
+	me->dropped = 0;
+
+	bsp_can_init( &me->super, CAN_RX_SIG );
+	ok = bsp_can_filter_set( me->ids, me->n_subs );
+
+	Q_ASSERT_ID( 200, ok );
+
+	return Q_TRAN( &can_bus_active );
+}
+
+static QState can_bus_active( CAN_BUS * const me, QEvt const * const e )
+{
+	QState status;
+	CAN_FRAME_EVT *f;
+	CAN_SUB const *sub;
+	CAN_FRAME frame;
+
+	switch( e->sig )
+	{
+		case CAN_RX_SIG:
+			while( bsp_can_read( &frame ) )
+			{
+				if( frame.index >= me->n_subs )
+				{
+					++me->dropped;
+					continue;
+				}
+
+				sub = &me->subs[ frame.index ];
+
+				/* a flood must not assert on an empty pool */
+				Q_NEW_X( f, CAN_FRAME_EVT, 1U, sub->sig );
+				if( NULL == f )
+				{
+					++me->dropped;
+					continue;
+				}
+
+				f->frame = frame;
+
+				/* nor on the full queue of a slow subscriber, the post
+				 * recycles the event it could not queue
+				 */
+				if( !QACTIVE_POST_X( sub->ao, &f->super, 1U, me ) )
+				{
+					++me->dropped;
+				}
+			}
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
@@ -0,0 +1,146 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdio.h>
+
+#include "stm32f10x.h"
+
+#include "SEGGER_RTT.h"
+
+#include "bsp_dwt.h"
+
+#include "rtt_chan.h"
+#include "dlog.h"
+
+/*
+ * the call sites reserve a slot with LDREX/STREX on the head, fill it and
+ * commit it by writing its sequence number last. no lock and no interrupt
+ * masking, so any task or interrupt may log, a nested one simply takes the
+ * next slot. dlog_flush() copies the committed slots in order to RTT, it
+ * stops at a slot still being filled by a preempted caller.
+ *
+ * a full ring drops the record and counts it, the count goes out as a
+ * record of its own once there is room again.
+ */
+
+#define DLOG_MASK		( DLOG_SLOTS - 1 )
+
+typedef struct
+{
+	volatile uint32_t seq;	/* reservation number + 1 when committed */
+	uint32_t hdr;
+	uint32_t time;
+	uint32_t arg[ 4 ];
+} DLOG_SLOT;
+
+static DLOG_SLOT dlog_slots[ DLOG_SLOTS ];
+static volatile uint32_t dlog_head;		/* next reservation */
+static volatile uint32_t dlog_tail;		/* next slot to flush */
+static volatile uint32_t dlog_dropped;
+
+/**
+ * log a record, use the DLOGn() macros.
+ */
+void dlog_write( char const *fmt, uint32_t n, uint32_t a, uint32_t b, uint32_t c, uint32_t d )
+{
+	DLOG_SLOT *s;
+	uint32_t h, v;
+
+	do
+	{
+		h = __LDREXW( &dlog_head );
+
+		if( h - dlog_tail >= DLOG_SLOTS )
+		{
+			__CLREX();
+			do
+			{
+				v = __LDREXW( &dlog_dropped );
+			} while( __STREXW( v + 1, &dlog_dropped ) );
+			return;
+		}
+	} while( __STREXW( h + 1, &dlog_head ) );
+
+	s = &dlog_slots[ h & DLOG_MASK ];
+	s->hdr = ( n << 28 ) | ( (uint32_t)fmt & 0x0FFFFFFF );
+	s->time = bsp_dwt_get_cycles();
+	s->arg[ 0 ] = a;
+	s->arg[ 1 ] = b;
+	s->arg[ 2 ] = c;
+	s->arg[ 3 ] = d;
+
+	__DMB();
+	s->seq = h + 1;
+}
+
+/**
+ * move the committed records to RTT, call from a low priority task.
+ */
+void dlog_flush( void )
+{
+	DLOG_SLOT *s;
+	uint32_t rec[ 3 ];
+	uint32_t tail = dlog_tail;
+	uint32_t n, v, dropped;
+
+	for( ;; )
+	{
+		dropped = dlog_dropped;
+		if( dropped != 0 && rtt_chan_space( RTT_CHAN_DLOG ) >= 12 )
+		{
+			rec[ 0 ] = 1U << 28;
+			rec[ 1 ] = bsp_dwt_get_cycles();
+			rec[ 2 ] = dropped;
+			rtt_chan_write( RTT_CHAN_DLOG, rec, 12 );
+
+			do
+			{
+				v = __LDREXW( &dlog_dropped );
+			} while( __STREXW( v - dropped, &dlog_dropped ) );
+		}
+
+		s = &dlog_slots[ tail & DLOG_MASK ];
+		if( s->seq != tail + 1 )
+		{
+			break;
+		}
+
+		/* whole records only */
+		n = s->hdr >> 28;
+		if( rtt_chan_space( RTT_CHAN_DLOG ) < 8 + 4 * n )
+		{
+			break;
+		}
+
+		rtt_chan_write( RTT_CHAN_DLOG, &s->hdr, 8 + 4 * n );
+
+		dlog_tail = ++tail;
+	}
+}
+
+/**
+ * time the line of led_task through dlog and through printf(), i.e. the
+ * fputc() retarget and the RTT write, and print the cycles. the printf()
+ * line goes out on stdout as well, the record with the next flush.
+ *
+ * @param RTT up buffer index
+ */
+void dlog_bench( unsigned buffer_index )
+{
+	uint32_t t0, t1, t2;
+	uint32_t a = bsp_dwt_get_cycles();
+
+	t0 = bsp_dwt_get_cycles();
+	DLOG2( "tick:%u,system heap:%u.\r\n", a, a >> 16 );
+	t1 = bsp_dwt_get_cycles();
+	printf( "tick:%u,system heap:%u.\r\n", (unsigned)a, (unsigned)( a >> 16 ) );
+	t2 = bsp_dwt_get_cycles();
+
+	SEGGER_RTT_printf( buffer_index, "dlog %u cycles, printf %u cycles\r\n",
+					   (unsigned)( t1 - t0 ), (unsigned)( t2 - t1 ) );
+}
@@ -0,0 +1,594 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "app_signals.h"
+#include "bsp_dma.h"
+#include "i2c_bus.h"
+
+Q_DEFINE_THIS_MODULE("i2c_bus")
+
+/*
+ * event driven I2C master, no busy wait on the EVx events.
+ *
+ * the transfer itself is a QHsm dispatched straight from the I2C event,
+ * I2C error and DMA interrupts, so each EVx is answered within the
+ * interrupt latency. payloads of 2 bytes and more go by DMA (with LAST for
+ * the automatic NACK on reads), a single byte by the BTF/RXNE interrupt.
+ *
+ * the active object around it queues the requests, starts the next one
+ * when the state machine reports I2C_DONE_SIG, and guards each transfer
+ * with a QTimeEvt: on timeout the peripheral is reset and the transfer
+ * fails. the active object dispatches into the state machine only with the
+ * I2C and DMA interrupts masked in the NVIC, the rest of the system keeps
+ * running.
+ */
+
+/* signals of the transfer state machine, dispatched synchronously only */
+enum i2c_hsm_signals
+{
+	I2C_GO_SIG = Q_USER_SIG,	/* start cur */
+	I2C_SB_SIG,					/* EV5: start sent */
+	I2C_ADDR_SIG,				/* EV6: address acknowledged */
+	I2C_BTF_SIG,				/* EV8_2: last byte sent */
+	I2C_RXNE_SIG,				/* EV7: byte received */
+	I2C_DMA_SIG,				/* DMA transfer complete */
+	I2C_ERR_SIG,				/* error interrupt, see err */
+	I2C_ABORT_SIG				/* timeout */
+};
+
+typedef struct
+{
+	QHsm super;
+
+	I2C_XFER *cur;
+	uint16_t err;			/* SR1 error flags */
+	BaseType_t *woken;		/* set while dispatched from an interrupt */
+} I2C_HSM;
+
+typedef struct
+{
+	QActive super;
+
+	QTimeEvt timeout;
+	I2C_XFER *head;
+	I2C_XFER *tail;
+	uint8_t stale_timeout;	/* timeout fired just before the disarm */
+	uint8_t timed_out;		/* the timeout of cur has been handled */
+
+	I2C_HSM hsm;
+} I2C_BUS;
+
+static I2C_BUS i2c_bus;
+QActive * const AO_I2cBus = &i2c_bus.super;
+
+static QEvt const i2c_evt_go    = { (QSignal)I2C_GO_SIG, 0U, 0U };
+static QEvt const i2c_evt_sb    = { (QSignal)I2C_SB_SIG, 0U, 0U };
+static QEvt const i2c_evt_addr  = { (QSignal)I2C_ADDR_SIG, 0U, 0U };
+static QEvt const i2c_evt_btf   = { (QSignal)I2C_BTF_SIG, 0U, 0U };
+static QEvt const i2c_evt_rxne  = { (QSignal)I2C_RXNE_SIG, 0U, 0U };
+static QEvt const i2c_evt_dma   = { (QSignal)I2C_DMA_SIG, 0U, 0U };
+static QEvt const i2c_evt_err   = { (QSignal)I2C_ERR_SIG, 0U, 0U };
+static QEvt const i2c_evt_abort = { (QSignal)I2C_ABORT_SIG, 0U, 0U };
+static QEvt const i2c_evt_done  = { (QSignal)I2C_DONE_SIG, 0U, 0U };
+
+static QState i2c_bus_initial( I2C_BUS * const me, QEvt const * const e );
+static QState i2c_bus_active( I2C_BUS * const me, QEvt const * const e );
+
+static QState i2c_hsm_initial( I2C_HSM * const me, QEvt const * const e );
+static QState i2c_hsm_idle( I2C_HSM * const me, QEvt const * const e );
+static QState i2c_hsm_busy( I2C_HSM * const me, QEvt const * const e );
+static QState i2c_hsm_writing( I2C_HSM * const me, QEvt const * const e );
+static QState i2c_hsm_reading( I2C_HSM * const me, QEvt const * const e );
+
+/*..........................................................................*/
+static void i2c_hw_init( void )
+{
+	I2C_InitTypeDef I2C_InitStructure;
+
+	I2C_DeInit( I2C1 );
+
+	I2C_InitStructure.I2C_Mode = I2C_Mode_I2C;
+	I2C_InitStructure.I2C_DutyCycle = I2C_DutyCycle_2;
+	I2C_InitStructure.I2C_OwnAddress1 = 0;
+	I2C_InitStructure.I2C_Ack = I2C_Ack_Enable;
+	I2C_InitStructure.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+	I2C_InitStructure.I2C_ClockSpeed = I2C_BUS_SPEED;
+	I2C_Init( I2C1, &I2C_InitStructure );
+
+	I2C1->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN;
+	I2C_Cmd( I2C1, ENABLE );
+}
+
+static void i2c_init( void )
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	RCC_APB2PeriphClockCmd( RCC_I2C_GPIO, ENABLE );
+	RCC_APB1PeriphClockCmd( RCC_APB1Periph_I2C1, ENABLE );
+	RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
+
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_OD;
+	GPIO_InitStructure.GPIO_Pin = GPIO_PIN_I2C_SCL | GPIO_PIN_I2C_SDA;
+	GPIO_Init( GPIO_PORT_I2C, &GPIO_InitStructure );
+
+	/* addresses and lengths are set per transfer */
+	bsp_dma_claim( DMA1_Channel6 );
+	DMA_DeInit( DMA1_Channel6 );
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&I2C1->DR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = 0;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_Medium;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init( DMA1_Channel6, &DMA_InitStructure );
+	DMA_ITConfig( DMA1_Channel6, DMA_IT_TC, ENABLE );
+
+	bsp_dma_claim( DMA1_Channel7 );
+	DMA_DeInit( DMA1_Channel7 );
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+	DMA_Init( DMA1_Channel7, &DMA_InitStructure );
+	DMA_ITConfig( DMA1_Channel7, DMA_IT_TC, ENABLE );
+
+	/* same priority: the state machine is never dispatched reentrantly */
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = I2C_BUS_IRQ_PRIO;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_InitStructure.NVIC_IRQChannel = I2C1_EV_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+	NVIC_InitStructure.NVIC_IRQChannel = I2C1_ER_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel6_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel7_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+
+	i2c_hw_init();
+}
+
+/* the interrupts that dispatch into the state machine. */
+static const IRQn_Type i2c_irqs[] =
+{
+	I2C1_EV_IRQn, I2C1_ER_IRQn, DMA1_Channel6_IRQn, DMA1_Channel7_IRQn
+};
+
+static void i2c_irq_mask( void )
+{
+	uint8_t i;
+
+	for( i = 0; i < Q_DIM( i2c_irqs ); i++ )
+	{
+		NVIC_DisableIRQ( i2c_irqs[ i ] );
+	}
+	__DSB();
+	__ISB();
+}
+
+static void i2c_irq_unmask( void )
+{
+	uint8_t i;
+
+	for( i = 0; i < Q_DIM( i2c_irqs ); i++ )
+	{
+		NVIC_EnableIRQ( i2c_irqs[ i ] );
+	}
+}
+
+static void i2c_dma_start( DMA_Channel_TypeDef *ch, uint8_t const *buf, uint16_t len )
+{
+	ch->CMAR  = (uint32_t)buf;
+	ch->CNDTR = len;
+	DMA_Cmd( ch, ENABLE );
+}
+
+/*..........................................................................*/
+void i2c_bus_ctor( void )
+{
+	I2C_BUS *me = &i2c_bus;
+
+	QActive_ctor( &me->super, Q_STATE_CAST( &i2c_bus_initial ) );
+	QTimeEvt_ctorX( &me->timeout, &me->super, I2C_TIMEOUT_SIG, 0U );
+	QHsm_ctor( &me->hsm.super, Q_STATE_CAST( &i2c_hsm_initial ) );
+}
+
+/**
+ * queue a transfer, the owner gets xfer->sig when it is done.
+ */
+void i2c_bus_submit( I2C_XFER *xfer, void const *sender )
+{
+	I2C_SUBMIT_EVT *e = Q_NEW( I2C_SUBMIT_EVT, I2C_SUBMIT_SIG );
+
+	e->xfer = xfer;
+	QACTIVE_POST( AO_I2cBus, &e->super, sender );
+}
+
+/* dispatch into the state machine from task level. */
+static void i2c_hsm_dispatch( I2C_BUS * const me, QEvt const *e )
+{
+	i2c_irq_mask();
+	QHSM_DISPATCH( &me->hsm.super, e );
+	i2c_irq_unmask();
+}
+
+static void i2c_bus_next( I2C_BUS * const me )
+{
+	I2C_XFER *x = me->head;
+
+	if( NULL == x || me->hsm.cur != NULL )
+	{
+		return;
+	}
+
+	me->head = x->next;
+	x->next = NULL;
+
+	me->hsm.cur = x;
+	QTimeEvt_armX( &me->timeout, I2C_BUS_TIMEOUT_TICKS, 0U );
+	i2c_hsm_dispatch( me, &i2c_evt_go );
+}
+
+static QState i2c_bus_initial( I2C_BUS * const me, QEvt const * const e )
+{
+	(void)e;
+
+	me->head = NULL;
+	me->tail = NULL;
+	me->stale_timeout = 0;
+	me->timed_out = 0;
+	me->hsm.cur = NULL;
+	me->hsm.woken = NULL;
+
+	i2c_init();
+	QHSM_INIT( &me->hsm.super, (QEvt *)0 );
+
+	return Q_TRAN( &i2c_bus_active );
+}
+
+static QState i2c_bus_active( I2C_BUS * const me, QEvt const * const e )
+{
+	QState status;
+	I2C_XFER *x;
+	I2C_DONE_EVT *d;
+
+	switch( e->sig )
+	{
+		case I2C_SUBMIT_SIG:
+			x = ( (I2C_SUBMIT_EVT const *)e )->xfer;
+
+			Q_ASSERT_ID( 100, x->tx_len != 0 || x->rx_len != 0 );
+
+			x->next = NULL;
+			if( NULL == me->head )
+			{
+				me->head = x;
+			}
+			else
+			{
+				me->tail->next = x;
+			}
+			me->tail = x;
+
+			i2c_bus_next( me );
+			status = Q_HANDLED();
+			break;
+
+		case I2C_DONE_SIG:
+			/* the timer is not armed anymore: either its timeout aborted
+			 * this transfer, or it is still in the queue and belongs to it
+			 */
+			if( me->timed_out )
+			{
+				me->timed_out = 0;
+			}
+			else if( !QTimeEvt_disarm( &me->timeout ) )
+			{
+				me->stale_timeout = 1;
+			}
+
+			x = me->hsm.cur;
+			me->hsm.cur = NULL;
+
+			if( x->ao != NULL )
+			{
+				d = Q_NEW( I2C_DONE_EVT, x->sig );
+				d->xfer = x;
+				QACTIVE_POST( x->ao, &d->super, me );
+			}
+
+			i2c_bus_next( me );
+			status = Q_HANDLED();
+			break;
+
+		case I2C_TIMEOUT_SIG:
+			if( me->stale_timeout )
+			{
+				me->stale_timeout = 0;
+			}
+			else
+			{
+				/* the state machine reports I2C_DONE_SIG */
+				me->timed_out = 1;
+				i2c_hsm_dispatch( me, &i2c_evt_abort );
+			}
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
+
+/*..........................................................................*/
+/* end the transfer, report to the active object. */
+static void i2c_hsm_done( I2C_HSM * const me, uint8_t status )
+{
+	me->cur->status = status;
+
+	if( me->woken != NULL )
+	{
+		QACTIVE_POST_FROM_ISR( AO_I2cBus, &i2c_evt_done, me->woken, me );
+	}
+	else
+	{
+		QACTIVE_POST( AO_I2cBus, &i2c_evt_done, me );
+	}
+}
+
+static QState i2c_hsm_initial( I2C_HSM * const me, QEvt const * const e )
+{
+	(void)me;
+	(void)e;
+
+	return Q_TRAN( &i2c_hsm_idle );
+}
+
+static QState i2c_hsm_idle( I2C_HSM * const me, QEvt const * const e )
+{
+	QState status;
+
+	switch( e->sig )
+	{
+		case I2C_GO_SIG:
+			if( me->cur->tx_len != 0 )
+			{
+				status = Q_TRAN( &i2c_hsm_writing );
+			}
+			else
+			{
+				status = Q_TRAN( &i2c_hsm_reading );
+			}
+			break;
+
+		default:
+			/* late interrupts of an aborted transfer */
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
+
+static QState i2c_hsm_busy( I2C_HSM * const me, QEvt const * const e )
+{
+	QState status;
+
+	switch( e->sig )
+	{
+		case Q_EXIT_SIG:
+			DMA_Cmd( DMA1_Channel6, DISABLE );
+			DMA_Cmd( DMA1_Channel7, DISABLE );
+			I2C1->CR2 &= ~( I2C_CR2_DMAEN | I2C_CR2_LAST | I2C_CR2_ITBUFEN );
+			status = Q_HANDLED();
+			break;
+
+		case I2C_ERR_SIG:
+			I2C1->CR1 |= I2C_CR1_STOP;
+			i2c_hsm_done( me, ( me->err & I2C_SR1_AF ) ? I2C_XFER_NACK : I2C_XFER_BUS_ERR );
+			status = Q_TRAN( &i2c_hsm_idle );
+			break;
+
+		case I2C_ABORT_SIG:
+			/* stuck bus or lost interrupt: start over */
+			I2C1->CR1 |= I2C_CR1_SWRST;
+			I2C1->CR1 &= ~I2C_CR1_SWRST;
+			i2c_hw_init();
+			i2c_hsm_done( me, I2C_XFER_TIMEOUT );
+			status = Q_TRAN( &i2c_hsm_idle );
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
+
+static QState i2c_hsm_writing( I2C_HSM * const me, QEvt const * const e )
+{
+	QState status;
+
+	switch( e->sig )
+	{
+		case Q_ENTRY_SIG:
+			I2C1->CR1 |= I2C_CR1_START;
+			status = Q_HANDLED();
+			break;
+
+		case I2C_SB_SIG:
+			I2C1->DR = (uint8_t)( me->cur->addr << 1 );
+			status = Q_HANDLED();
+			break;
+
+		case I2C_ADDR_SIG:
+			if( me->cur->tx_len >= 2 )
+			{
+				i2c_dma_start( DMA1_Channel6, me->cur->tx, me->cur->tx_len );
+				I2C1->CR2 |= I2C_CR2_DMAEN;
+				(void)I2C1->SR2;	/* clears ADDR */
+			}
+			else
+			{
+				(void)I2C1->SR2;
+				I2C1->DR = me->cur->tx[ 0 ];
+			}
+			status = Q_HANDLED();
+			break;
+
+		case I2C_DMA_SIG:
+			/* all bytes in DR, BTF follows when they are on the bus */
+			I2C1->CR2 &= ~I2C_CR2_DMAEN;
+			status = Q_HANDLED();
+			break;
+
+		case I2C_BTF_SIG:
+			if( me->cur->rx_len != 0 )
+			{
+				/* repeated start, clears BTF */
+				status = Q_TRAN( &i2c_hsm_reading );
+			}
+			else
+			{
+				I2C1->CR1 |= I2C_CR1_STOP;
+				i2c_hsm_done( me, I2C_XFER_OK );
+				status = Q_TRAN( &i2c_hsm_idle );
+			}
+			break;
+
+		default:
+			status = Q_SUPER( &i2c_hsm_busy );
+			break;
+	}
+
+	return status;
+}
+
+static QState i2c_hsm_reading( I2C_HSM * const me, QEvt const * const e )
+{
+	QState status;
+
+	switch( e->sig )
+	{
+		case Q_ENTRY_SIG:
+			I2C1->CR1 |= I2C_CR1_START | I2C_CR1_ACK;
+			status = Q_HANDLED();
+			break;
+
+		case I2C_SB_SIG:
+			I2C1->DR = (uint8_t)( ( me->cur->addr << 1 ) | 1 );
+			status = Q_HANDLED();
+			break;
+
+		case I2C_ADDR_SIG:
+			if( me->cur->rx_len >= 2 )
+			{
+				/* LAST: the DMA end NACKs the last byte by itself */
+				i2c_dma_start( DMA1_Channel7, me->cur->rx, me->cur->rx_len );
+				I2C1->CR2 |= I2C_CR2_DMAEN | I2C_CR2_LAST;
+				(void)I2C1->SR2;
+			}
+			else
+			{
+				/* single byte: NACK and STOP right after ADDR */
+				I2C1->CR1 &= ~I2C_CR1_ACK;
+				(void)I2C1->SR2;
+				I2C1->CR1 |= I2C_CR1_STOP;
+				I2C1->CR2 |= I2C_CR2_ITBUFEN;
+			}
+			status = Q_HANDLED();
+			break;
+
+		case I2C_RXNE_SIG:
+			me->cur->rx[ 0 ] = (uint8_t)I2C1->DR;
+			i2c_hsm_done( me, I2C_XFER_OK );
+			status = Q_TRAN( &i2c_hsm_idle );
+			break;
+
+		case I2C_DMA_SIG:
+			I2C1->CR1 |= I2C_CR1_STOP;
+			i2c_hsm_done( me, I2C_XFER_OK );
+			status = Q_TRAN( &i2c_hsm_idle );
+			break;
+
+		default:
+			status = Q_SUPER( &i2c_hsm_busy );
+			break;
+	}
+
+	return status;
+}
+
+/*..........................................................................*/
+static void i2c_isr_dispatch( QEvt const *e )
+{
+	BaseType_t woken = pdFALSE;
+
+	i2c_bus.hsm.woken = &woken;
+	QHSM_DISPATCH( &i2c_bus.hsm.super, e );
+	i2c_bus.hsm.woken = NULL;
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+void I2C1_EV_IRQHandler( void )
+{
+	uint16_t sr1 = I2C1->SR1;
+
+	if( sr1 & I2C_SR1_SB )
+	{
+		i2c_isr_dispatch( &i2c_evt_sb );
+	}
+	else if( sr1 & I2C_SR1_ADDR )
+	{
+		i2c_isr_dispatch( &i2c_evt_addr );
+	}
+	else if( ( sr1 & I2C_SR1_RXNE ) && ( I2C1->CR2 & I2C_CR2_ITBUFEN ) )
+	{
+		i2c_isr_dispatch( &i2c_evt_rxne );
+	}
+	else if( sr1 & I2C_SR1_BTF )
+	{
+		i2c_isr_dispatch( &i2c_evt_btf );
+	}
+}
+
+void I2C1_ER_IRQHandler( void )
+{
+	uint16_t err = I2C1->SR1 & ( I2C_SR1_BERR | I2C_SR1_ARLO | I2C_SR1_AF | I2C_SR1_OVR );
+
+	I2C1->SR1 = (uint16_t)~err;	/* rc_w0 */
+
+	i2c_bus.hsm.err = err;
+	i2c_isr_dispatch( &i2c_evt_err );
+}
+
+void DMA1_Channel6_IRQHandler( void )
+{
+	DMA_ClearITPendingBit( DMA1_IT_TC6 );
+	DMA_Cmd( DMA1_Channel6, DISABLE );
+
+	i2c_isr_dispatch( &i2c_evt_dma );
+}
+
+void DMA1_Channel7_IRQHandler( void )
+{
+	DMA_ClearITPendingBit( DMA1_IT_TC7 );
+	DMA_Cmd( DMA1_Channel7, DISABLE );
+
+	i2c_isr_dispatch( &i2c_evt_dma );
+}
@@ -0,0 +1,771 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+#include "SEGGER_RTT.h"
+
+#include "bsp_crc.h"
+#include "bsp_dwt.h"
+
+#include "app_signals.h"
+#include "kv_store.h"
+
+Q_DEFINE_THIS_MODULE("kv_store")
+
+/*
+ * log structured key value store in internal flash.
+ *
+ * records are only appended, a new value of a key simply comes later in
+ * the log. the RAM index maps each key to its newest record and is rebuilt
+ * from the pages at boot, in page sequence order. a record is committed by
+ * writing its key last, so one cut by a reset is skipped.
+ *
+ * a page that fills up is closed and the erased page with the fewest
+ * erases is opened. the compaction active object copies the live records
+ * of the oldest page to the head of the log and erases it, one record or
+ * one erase per event, so anything of higher priority runs in between.
+ * one erased page is kept for the compaction, writers get KV_ERR_FULL
+ * rather than taking it. a new key also gets KV_ERR_FULL when the index is
+ * full, a deleted key keeps its slot until the compaction drops the delete.
+ *
+ * lock guards the index, flash_lock the programming: writers and the
+ * compaction take flash_lock first. the compaction erases with flash_lock
+ * only, nothing in the index points into the victim by then, so kv_get()
+ * is not queued behind the erase.
+ *
+ * the F103 fetches code from the flash being programmed, so the cpu stalls
+ * for each halfword (~50us) and erase (~20ms) whatever the priority: the
+ * store only bounds them to one per step of the low priority compaction.
+ */
+
+#define KV_MAGIC		0x4B56
+#define KV_SEQ_FREE		0xFFFFFFFFU
+#define KV_KEY_FREE		0xFFFF			/* not written, not a valid key */
+#define KV_NONE			0xFF
+
+#define KV_INDEX_MASK	( KV_INDEX_SIZE - 1 )
+
+/* at the start of each page, magic and erases are written right after the
+ * erase, seq when the page is opened.
+ */
+typedef struct
+{
+	uint16_t magic;
+	uint16_t erases;
+	uint32_t seq;
+} KV_PAGE_HDR;
+
+/* followed by len bytes, padded to a word. len 0: key deleted. */
+typedef struct
+{
+	uint16_t key;		/* written last */
+	uint16_t len;
+	uint32_t crc;		/* bsp_crc over key, len and the data */
+} KV_REC_HDR;
+
+#define KV_REC_SIZE( len )	( sizeof( KV_REC_HDR ) + ( ( ( len ) + 3 ) & ~3U ) )
+
+typedef struct
+{
+	QActive super;
+
+	SemaphoreHandle_t lock;
+	StaticSemaphore_t lock_buf;
+	SemaphoreHandle_t flash_lock;
+	StaticSemaphore_t flash_lock_buf;
+
+	uint16_t keys[ KV_INDEX_SIZE ];
+	uint32_t addrs[ KV_INDEX_SIZE ];	/* newest record of keys[] */
+	uint16_t n_keys;					/* deleted ones included */
+
+	uint8_t head;				/* page written, KV_NONE: none open */
+	uint16_t head_off;
+	uint32_t seq;				/* of the head page */
+
+	uint8_t victim;				/* page compacted, KV_NONE: none */
+	uint16_t victim_off;
+	uint8_t compacting;			/* KV_COMPACT_SIG posted */
+	uint8_t erases;				/* by this compaction */
+	uint8_t full;				/* compaction gained nothing */
+
+	uint32_t user_bytes;		/* kv_put() data */
+	uint32_t flash_bytes;		/* programmed, headers and copies included */
+	uint32_t rebuild_cycles;
+} KV_STORE;
+
+static KV_STORE kv_store;
+QActive * const AO_KvStore = &kv_store.super;
+
+static QEvt const kv_compact_evt = { (QSignal)KV_COMPACT_SIG, 0U, 0U };
+
+static QState kv_store_initial( KV_STORE * const me, QEvt const * const e );
+static QState kv_store_active( KV_STORE * const me, QEvt const * const e );
+
+/*..........................................................................*/
+static KV_PAGE_HDR const *kv_page( uint8_t page )
+{
+	return (KV_PAGE_HDR const *)( KV_FLASH_BASE + page * KV_PAGE_SIZE );
+}
+
+static KV_REC_HDR const *kv_rec( uint8_t page, uint16_t off )
+{
+	return (KV_REC_HDR const *)( KV_FLASH_BASE + page * KV_PAGE_SIZE + off );
+}
+
+static uint8_t kv_page_free( uint8_t page )
+{
+	KV_PAGE_HDR const *h = kv_page( page );
+
+	return KV_SEQ_FREE == h->seq && ( KV_MAGIC == h->magic || 0xFFFF == h->magic );
+}
+
+/* seq of a used page, 0 for a page of unknown content: compacted first */
+static uint32_t kv_page_seq( uint8_t page )
+{
+	KV_PAGE_HDR const *h = kv_page( page );
+
+	return KV_MAGIC == h->magic ? h->seq : 0;
+}
+
+static uint16_t kv_page_erases( uint8_t page )
+{
+	KV_PAGE_HDR const *h = kv_page( page );
+
+	return KV_MAGIC == h->magic ? h->erases : 0;
+}
+
+static uint8_t kv_free_pages( void )
+{
+	uint8_t p, n = 0;
+
+	for( p = 0; p < KV_PAGES; p++ )
+	{
+		n += kv_page_free( p );
+	}
+
+	return n;
+}
+
+static uint32_t kv_rec_crc( uint16_t key, uint16_t len, void const *data )
+{
+	uint16_t kl[ 2 ];
+
+	kl[ 0 ] = key;
+	kl[ 1 ] = len;
+
+	return bsp_crc_sw( bsp_crc_sw( BSP_CRC_INIT, kl, 4 ), data, len );
+}
+
+/* a record that is committed and intact */
+static uint8_t kv_rec_valid( KV_REC_HDR const *r )
+{
+	return r->key != KV_KEY_FREE && r->len <= KV_VALUE_MAX &&
+		   r->crc == kv_rec_crc( r->key, r->len, r + 1 );
+}
+
+static void kv_flash_write( uint32_t addr, void const *src, uint16_t len )
+{
+	uint8_t const *p = (uint8_t const *)src;
+	uint16_t hw;
+
+	FLASH_Unlock();
+	FLASH_ClearFlag( FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR );
+
+	for( ; len != 0; addr += 2, p += 2 )
+	{
+		hw = p[ 0 ];
+		if( len >= 2 )
+		{
+			hw |= p[ 1 ] << 8;
+			len -= 2;
+		}
+		else
+		{
+			hw |= 0xFF00;
+			len = 0;
+		}
+
+		FLASH_ProgramHalfWord( addr, hw );
+	}
+
+	FLASH_Lock();
+}
+
+static void kv_flash_write16( uint32_t addr, uint16_t hw )
+{
+	kv_flash_write( addr, &hw, 2 );
+	kv_store.flash_bytes += 2;
+}
+
+/*..........................................................................*/
+/* slot of key, or the empty slot it goes into. */
+static uint16_t kv_index_find( KV_STORE * const me, uint16_t key )
+{
+	uint16_t i = (uint16_t)( key * 0x9E37U ) & KV_INDEX_MASK;
+
+	while( me->keys[ i ] != KV_KEY_FREE && me->keys[ i ] != key )
+	{
+		i = ( i + 1 ) & KV_INDEX_MASK;
+	}
+
+	return i;
+}
+
+/* an empty slot is always left */
+static uint8_t kv_index_full( KV_STORE * const me )
+{
+	return me->n_keys >= KV_INDEX_SIZE - 1;
+}
+
+static void kv_index_put( KV_STORE * const me, uint16_t key, uint32_t addr )
+{
+	uint16_t i = kv_index_find( me, key );
+
+	if( KV_KEY_FREE == me->keys[ i ] )
+	{
+		/* kv_put() checked kv_index_room(), find() ends */
+		Q_ASSERT_ID( 100, !kv_index_full( me ) );
+		me->keys[ i ] = key;
+		++me->n_keys;
+	}
+	me->addrs[ i ] = addr;
+}
+
+/* key has a slot or may take one */
+static uint8_t kv_index_room( KV_STORE * const me, uint16_t key )
+{
+	return me->keys[ kv_index_find( me, key ) ] == key || !kv_index_full( me );
+}
+
+/* keys with a value, the others are deleted */
+static uint16_t kv_index_live( KV_STORE * const me )
+{
+	uint16_t i, n = 0;
+
+	for( i = 0; i < KV_INDEX_SIZE; i++ )
+	{
+		if( me->keys[ i ] != KV_KEY_FREE && ( (KV_REC_HDR const *)me->addrs[ i ] )->len != 0 )
+		{
+			++n;
+		}
+	}
+
+	return n;
+}
+
+/* backward shift delete, keeps the probe sequences unbroken */
+static void kv_index_remove( KV_STORE * const me, uint16_t key )
+{
+	uint16_t i = kv_index_find( me, key );
+	uint16_t j = i;
+	uint16_t home;
+
+	if( KV_KEY_FREE == me->keys[ i ] )
+	{
+		return;
+	}
+	--me->n_keys;
+
+	for( ;; )
+	{
+		me->keys[ i ] = KV_KEY_FREE;
+
+		for( ;; )
+		{
+			j = ( j + 1 ) & KV_INDEX_MASK;
+			if( KV_KEY_FREE == me->keys[ j ] )
+			{
+				return;
+			}
+
+			/* j may move to i when its home is not within ( i, j ] */
+			home = (uint16_t)( me->keys[ j ] * 0x9E37U ) & KV_INDEX_MASK;
+			if( ( ( j - home ) & KV_INDEX_MASK ) >= ( ( j - i ) & KV_INDEX_MASK ) )
+			{
+				break;
+			}
+		}
+
+		me->keys[ i ] = me->keys[ j ];
+		me->addrs[ i ] = me->addrs[ j ];
+		i = j;
+	}
+}
+
+/* scan a page into the index, returns the offset after the last record. */
+static uint16_t kv_page_scan( KV_STORE * const me, uint8_t page )
+{
+	uint16_t off = sizeof( KV_PAGE_HDR );
+	KV_REC_HDR const *r;
+
+	while( off + sizeof( KV_REC_HDR ) <= KV_PAGE_SIZE )
+	{
+		r = kv_rec( page, off );
+
+		if( KV_KEY_FREE == r->key && 0xFFFF == r->len )
+		{
+			return off;
+		}
+
+		/* garbage length: nothing after it can be trusted */
+		if( r->len > KV_VALUE_MAX )
+		{
+			return KV_PAGE_SIZE;
+		}
+
+		if( kv_rec_valid( r ) )
+		{
+			kv_index_put( me, r->key, (uint32_t)r );
+		}
+
+		off += KV_REC_SIZE( r->len );
+	}
+
+	return KV_PAGE_SIZE;
+}
+
+static void kv_rebuild( KV_STORE * const me )
+{
+	uint32_t t0 = bsp_dwt_get_cycles();
+	uint8_t order[ KV_PAGES ];
+	uint8_t n = 0;
+	uint8_t p, i;
+
+	memset( me->keys, 0xFF, sizeof( me->keys ) );
+	memset( me->addrs, 0, sizeof( me->addrs ) );
+	me->n_keys = 0;
+
+	/* used pages in sequence order, later records override earlier ones */
+	for( p = 0; p < KV_PAGES; p++ )
+	{
+		if( kv_page_free( p ) )
+		{
+			continue;
+		}
+
+		for( i = n++; i > 0 && kv_page_seq( order[ i - 1 ] ) > kv_page_seq( p ); i-- )
+		{
+			order[ i ] = order[ i - 1 ];
+		}
+		order[ i ] = p;
+	}
+
+	me->head = KV_NONE;
+	me->head_off = KV_PAGE_SIZE;
+	me->seq = 0;
+
+	for( i = 0; i < n; i++ )
+	{
+		/* unknown content is left to the compaction */
+		if( kv_page_seq( order[ i ] ) != 0 )
+		{
+			me->head = order[ i ];
+			me->head_off = kv_page_scan( me, order[ i ] );
+			me->seq = kv_page_seq( order[ i ] );
+		}
+	}
+
+	me->rebuild_cycles = bsp_dwt_get_cycles() - t0;
+}
+
+/* open the erased page with the fewest erases. */
+static uint8_t kv_page_open( KV_STORE * const me )
+{
+	uint8_t p, best = KV_NONE;
+	uint16_t erases = 0xFFFF;
+	KV_PAGE_HDR h;
+
+	for( p = 0; p < KV_PAGES; p++ )
+	{
+		if( kv_page_free( p ) && kv_page_erases( p ) <= erases )
+		{
+			best = p;
+			erases = kv_page_erases( p );
+		}
+	}
+
+	if( KV_NONE == best )
+	{
+		return 0;
+	}
+
+	/* magic and erases are there unless the page was never used */
+	h.magic = KV_MAGIC;
+	h.erases = 0;
+	h.seq = me->seq + 1;
+	if( 0xFFFF == kv_page( best )->magic )
+	{
+		kv_flash_write( (uint32_t)kv_page( best ), &h, 4 );
+		me->flash_bytes += 4;
+	}
+	kv_flash_write( (uint32_t)&kv_page( best )->seq, &h.seq, 4 );
+	me->flash_bytes += 4;
+
+	me->head = best;
+	me->head_off = sizeof( KV_PAGE_HDR );
+	me->seq = h.seq;
+
+	return 1;
+}
+
+/* append a record, the lock held. reserve: may take the last erased page. */
+static int16_t kv_append( KV_STORE * const me, uint16_t key, void const *data, uint16_t len, uint8_t reserve )
+{
+	uint16_t size = KV_REC_SIZE( len );
+	uint32_t addr;
+	uint32_t crc;
+
+	if( KV_NONE == me->head || me->head_off + size > KV_PAGE_SIZE )
+	{
+		if( kv_free_pages() < ( reserve ? 1 : 2 ) || !kv_page_open( me ) )
+		{
+			return KV_ERR_FULL;
+		}
+	}
+
+	addr = (uint32_t)kv_rec( me->head, me->head_off );
+	crc = kv_rec_crc( key, len, data );
+
+	/* len, crc, data, then the key commits it */
+	kv_flash_write( addr + 2, &len, 2 );
+	kv_flash_write( addr + 4, &crc, 4 );
+	kv_flash_write( addr + sizeof( KV_REC_HDR ), data, len );
+	kv_flash_write16( addr, key );
+	me->flash_bytes += size - 2;
+
+	me->head_off += size;
+	kv_index_put( me, key, addr );
+
+	return KV_OK;
+}
+
+/* the compaction has work: pages run short, or deletes hold index slots. */
+static uint8_t kv_compact_needed( KV_STORE * const me )
+{
+	return kv_free_pages() < 2 || ( kv_index_full( me ) && kv_index_live( me ) < me->n_keys );
+}
+
+/* start the compaction when a writer may soon run out of pages or slots. */
+static void kv_compact_request( KV_STORE * const me )
+{
+	if( !me->compacting && !me->full && kv_compact_needed( me ) )
+	{
+		me->compacting = 1;
+		me->erases = 0;
+		QACTIVE_POST( &me->super, &kv_compact_evt, me );
+	}
+}
+
+/*..........................................................................*/
+/**
+ * mount the store: rebuild the index from flash, call before the tasks
+ * using it start.
+ */
+void kv_store_ctor( void )
+{
+	KV_STORE *me = &kv_store;
+
+	QActive_ctor( &me->super, Q_STATE_CAST( &kv_store_initial ) );
+
+	me->lock = xSemaphoreCreateMutexStatic( &me->lock_buf );
+	me->flash_lock = xSemaphoreCreateMutexStatic( &me->flash_lock_buf );
+	me->victim = KV_NONE;
+	me->compacting = 0;
+	me->full = 0;
+	me->user_bytes = 0;
+	me->flash_bytes = 0;
+
+	kv_rebuild( me );
+}
+
+/**
+ * @return length of the value, or KV_ERR_xxx
+ */
+int16_t kv_get( uint16_t key, void *buf, uint16_t size )
+{
+	KV_STORE *me = &kv_store;
+	KV_REC_HDR const *r;
+	uint16_t i;
+	int16_t ret = KV_ERR_NOT_FOUND;
+
+	xSemaphoreTake( me->lock, portMAX_DELAY );
+
+	i = kv_index_find( me, key );
+	if( me->keys[ i ] == key && key != KV_KEY_FREE )
+	{
+		r = (KV_REC_HDR const *)me->addrs[ i ];
+
+		if( 0 == r->len )
+		{
+			ret = KV_ERR_NOT_FOUND;
+		}
+		else if( r->len > size )
+		{
+			ret = KV_ERR_SIZE;
+		}
+		else
+		{
+			memcpy( buf, r + 1, r->len );
+			ret = r->len;
+		}
+	}
+
+	xSemaphoreGive( me->lock );
+
+	return ret;
+}
+
+int16_t kv_put( uint16_t key, void const *data, uint16_t len )
+{
+	KV_STORE *me = &kv_store;
+	int16_t ret;
+
+	if( KV_KEY_FREE == key || 0 == len || len > KV_VALUE_MAX )
+	{
+		return KV_ERR_SIZE;
+	}
+
+	xSemaphoreTake( me->flash_lock, portMAX_DELAY );
+	xSemaphoreTake( me->lock, portMAX_DELAY );
+
+	if( !kv_index_room( me, key ) )
+	{
+		ret = KV_ERR_FULL;
+	}
+	else
+	{
+		ret = kv_append( me, key, data, len, 0 );
+	}
+	if( KV_OK == ret )
+	{
+		me->user_bytes += len;
+	}
+	kv_compact_request( me );
+
+	xSemaphoreGive( me->lock );
+	xSemaphoreGive( me->flash_lock );
+
+	return ret;
+}
+
+int16_t kv_del( uint16_t key )
+{
+	KV_STORE *me = &kv_store;
+	int16_t ret;
+	uint16_t i;
+
+	xSemaphoreTake( me->flash_lock, portMAX_DELAY );
+	xSemaphoreTake( me->lock, portMAX_DELAY );
+
+	i = kv_index_find( me, key );
+	if( me->keys[ i ] != key || 0 == ( (KV_REC_HDR const *)me->addrs[ i ] )->len )
+	{
+		ret = KV_ERR_NOT_FOUND;
+	}
+	else
+	{
+		ret = kv_append( me, key, NULL, 0, 0 );
+		me->full = 0;
+		kv_compact_request( me );
+	}
+
+	xSemaphoreGive( me->lock );
+	xSemaphoreGive( me->flash_lock );
+
+	return ret;
+}
+
+/**
+ * print keys, write amplification, erases per page and the boot rebuild.
+ *
+ * @param RTT up buffer index
+ */
+void kv_store_report( unsigned buffer_index )
+{
+	KV_STORE *me = &kv_store;
+	uint32_t amp = 0;
+	uint16_t keys;
+	uint8_t p;
+
+	xSemaphoreTake( me->lock, portMAX_DELAY );
+
+	keys = kv_index_live( me );
+
+	if( me->user_bytes != 0 )
+	{
+		amp = me->flash_bytes * 100 / me->user_bytes;
+	}
+
+	SEGGER_RTT_printf( buffer_index, "kv keys %u, free pages %u, written %u/%u bytes, amplification %u.%02u\r\n",
+					   (unsigned)keys, (unsigned)kv_free_pages(),
+					   (unsigned)me->flash_bytes, (unsigned)me->user_bytes,
+					   (unsigned)( amp / 100 ), (unsigned)( amp % 100 ) );
+
+	SEGGER_RTT_printf( buffer_index, "kv rebuild %u cycles, erases", (unsigned)me->rebuild_cycles );
+	for( p = 0; p < KV_PAGES; p++ )
+	{
+		SEGGER_RTT_printf( buffer_index, " %u", (unsigned)kv_page_erases( p ) );
+	}
+	SEGGER_RTT_printf( buffer_index, "\r\n" );
+
+	xSemaphoreGive( me->lock );
+}
+
+/*..........................................................................*/
+/* one step: copy one record of the victim, or erase it. returns 1 when the
+ * compaction is done. both locks held, lock is let go during the erase.
+ */
+static uint8_t kv_compact_step( KV_STORE * const me )
+{
+	KV_REC_HDR const *r;
+	KV_PAGE_HDR h;
+	uint32_t seq, best = KV_SEQ_FREE;
+	uint16_t i;
+	int16_t ret;
+	uint8_t p;
+
+	if( KV_NONE == me->victim )
+	{
+		if( !kv_compact_needed( me ) )
+		{
+			return 1;
+		}
+
+		/* the oldest page, never the open one */
+		for( p = 0; p < KV_PAGES; p++ )
+		{
+			seq = kv_page_seq( p );
+			if( !kv_page_free( p ) && p != me->head && seq < best )
+			{
+				me->victim = p;
+				best = seq;
+			}
+		}
+
+		/* the deletes holding the index are all in the open page: close it,
+		 * it is the victim of the next step.
+		 */
+		if( KV_NONE == me->victim && kv_free_pages() >= 2 && kv_page_open( me ) )
+		{
+			return 0;
+		}
+
+		/* every page went round once: the live data fills the store */
+		if( KV_NONE == me->victim || me->erases >= KV_PAGES )
+		{
+			me->victim = KV_NONE;
+			me->full = ( me->erases >= KV_PAGES );
+			return 1;
+		}
+
+		me->victim_off = KV_MAGIC == kv_page( me->victim )->magic ? sizeof( KV_PAGE_HDR ) : KV_PAGE_SIZE;
+	}
+
+	/* next live record */
+	while( me->victim_off + sizeof( KV_REC_HDR ) <= KV_PAGE_SIZE )
+	{
+		r = kv_rec( me->victim, me->victim_off );
+
+		if( ( KV_KEY_FREE == r->key && 0xFFFF == r->len ) || r->len > KV_VALUE_MAX )
+		{
+			break;
+		}
+
+		me->victim_off += KV_REC_SIZE( r->len );
+
+		i = kv_index_find( me, r->key );
+		if( r->key != KV_KEY_FREE && me->keys[ i ] == r->key && me->addrs[ i ] == (uint32_t)r )
+		{
+			if( 0 == r->len )
+			{
+				/* nothing older than the oldest page: the delete is done */
+				kv_index_remove( me, r->key );
+			}
+			else
+			{
+				/* fits: the victim is at most one page of live data */
+				ret = kv_append( me, r->key, r + 1, r->len, 1 );
+				Q_ASSERT_ID( 200, KV_OK == ret );
+			}
+			return 0;
+		}
+	}
+
+	/* no live record left */
+	h.magic = KV_MAGIC;
+	h.erases = kv_page_erases( me->victim ) + 1;
+
+	xSemaphoreGive( me->lock );
+
+	FLASH_Unlock();
+	FLASH_ClearFlag( FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR );
+	FLASH_ErasePage( (uint32_t)kv_page( me->victim ) );
+	FLASH_Lock();
+
+	xSemaphoreTake( me->lock, portMAX_DELAY );
+
+	kv_flash_write( (uint32_t)kv_page( me->victim ), &h, 4 );
+	me->flash_bytes += 4;
+
+	me->victim = KV_NONE;
+	++me->erases;
+
+	return 0;
+}
+
+static QState kv_store_initial( KV_STORE * const me, QEvt const * const e )
+{
+	(void)e;
+
+	/* pages may have run short before the reset */
+	xSemaphoreTake( me->lock, portMAX_DELAY );
+	kv_compact_request( me );
+	xSemaphoreGive( me->lock );
+
+	return Q_TRAN( &kv_store_active );
+}
+
+static QState kv_store_active( KV_STORE * const me, QEvt const * const e )
+{
+	QState status;
+	uint8_t done;
+
+	switch( e->sig )
+	{
+		case KV_COMPACT_SIG:
+			xSemaphoreTake( me->flash_lock, portMAX_DELAY );
+			xSemaphoreTake( me->lock, portMAX_DELAY );
+
+			done = kv_compact_step( me );
+			if( done )
+			{
+				me->compacting = 0;
+			}
+
+			xSemaphoreGive( me->lock );
+			xSemaphoreGive( me->flash_lock );
+
+			/* back through the queue, other events get their turn */
+			if( !done )
+			{
+				QACTIVE_POST( &me->super, &kv_compact_evt, me );
+			}
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
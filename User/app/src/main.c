@@ -18,9 +18,23 @@
 #include "stdio.h"
 
 #include "bsp_led.h"
+#include "bsp_memcpy.h"
 
 #include "qpc.h"
 
+#include "rt_stats.h"
+#include "dlog.h"
+#include "rtt_stdio.h"
+#include "rtt_chan.h"
+#include "kv_store.h"
+#include "i2c_bus.h"
+#include "spi_bus.h"
+#include "can_bus.h"
+#include "adc_acq.h"
+#include "usb_ao.h"
+#include "pc_bench.h"
+#include "app_topology.h"
+
 /**
  * ضfputc
  *
@@ -32,7 +46,7 @@
 int fputc(int ch, FILE *f)
 {
 
-	SEGGER_RTT_Write( 0, &ch, 1 );
+	rtt_stdio_putc( (char)ch );
 	
 	return ch;
 
@@ -104,6 +118,24 @@ void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
     *pulIdleTaskStackSize = Q_DIM(uxIdleTaskStack);
 }
 
+/*..........................................................................*/
+/* configUSE_TICK_HOOK is set to 1, the FreeRTOS tick drives the QF time
+* events of tick rate 0, one QF tick per configTICK_RATE_HZ tick.
+*/
+#ifdef Q_SPY
+static uint8_t const l_tickHook = 0U;
+#endif
+
+void vApplicationTickHook( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+    QF_TICK_X_FROM_ISR( 0U, &xHigherPriorityTaskWoken, &l_tickHook );
+
+    /* notify FreeRTOS to perform context switch from ISR, if needed */
+    portEND_SWITCHING_ISR( xHigherPriorityTaskWoken );
+}
+
 void led_task( void *pvParameters );
 
 TaskHandle_t led_task_handle = NULL;
@@ -114,10 +146,33 @@ int main(void)
 	/* ȼΪ4 */
 	NVIC_PriorityGroupConfig( NVIC_PriorityGroup_4 );
 
-	xTaskCreate( led_task, "led", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY+3, &led_task_handle );
+	QF_init();
+
+	/* rtt channel sizes come from the kv store */
+	kv_store_ctor();
+	rtt_chan_init();
 
-	/* Start the scheduler. */
-	vTaskStartScheduler();
+	i2c_bus_ctor();
+	spi_bus_ctor();
+	adc_acq_ctor();
+
+#if BSP_USB_DEVICE
+	usb_ao_ctor();
+#else
+	can_bus_ctor();
+#endif
+
+#if PC_BENCH
+	pc_bench_ctor();
+#endif
+
+	/* queues, stacks and pools sized in app_topology.h */
+	app_topology_start();
+
+	xTaskCreate( led_task, "led", configMINIMAL_STACK_SIZE, NULL, tskIDLE_PRIORITY+APP_LED_TASK_PRIO, &led_task_handle );
+
+	/* Start the scheduler, QF_run() creates the dispatcher of the shared AOs first. */
+	QF_run();
 	
 	while(1);
 	
@@ -126,6 +181,8 @@ int main(void)
 
 void led_task( void *pvParameters )
 {
+	uint32_t n = 0;
+	unsigned report;
 	
 	bsp_led_init();
 
@@ -134,7 +191,57 @@ void led_task( void *pvParameters )
 	
 		bsp_led_toggle( e_led_red_system_status );
 		
-		printf( "tick:%u,system heap:%u.\r\n", xTaskGetTickCount(), xPortGetFreeHeapSize() );
+		DLOG2( "tick:%u,system heap:%u.\r\n", xTaskGetTickCount(), xPortGetFreeHeapSize() );
+		
+		/* keys of the "Cmd" down buffer, the reports on the "Report" up buffer */
+		report = rtt_chan_up( RTT_CHAN_REPORT );
+		
+		switch( rtt_chan_key( RTT_CHAN_REPORT ) )
+		{
+			case RT_STATS_REPORT_KEY:
+				rt_stats_report( report );
+				break;
+			
+			case RTT_CHAN_REPORT_KEY:
+				rtt_chan_report( report );
+				break;
+			
+			case ADC_ACQ_REPORT_KEY:
+				adc_acq_report( report );
+				break;
+			
+			case KV_STORE_REPORT_KEY:
+				kv_store_report( report );
+				break;
+			
+			case DLOG_BENCH_KEY:
+				dlog_bench( report );
+				break;
+			
+			case RTT_STDIO_REPORT_KEY:
+				rtt_stdio_report( report );
+				break;
+			
+			case BSP_MEMCPY_BENCH_KEY:
+				bsp_memcpy_bench( report );
+				break;
+			
+			case APP_TOPOLOGY_REPORT_KEY:
+				app_topology_report( report );
+				break;
+			
+			default:
+				break;
+		}
+		
+		dlog_flush();
+		rtt_chan_poll();
+		
+		/* at most a kv write a minute, usually none */
+		if( ++n % 60 == 0 )
+		{
+			rtt_chan_save();
+		}
 		
 		vTaskDelay(1000 / portTICK_PERIOD_MS);
 		
@@ -0,0 +1,139 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "SEGGER_RTT.h"
+
+#include "app_signals.h"
+#include "pc_bench.h"
+
+Q_DEFINE_THIS_MODULE("pc_bench")
+
+/*
+ * a producer posts PC_BENCH_BURST events in one RTC step to a consumer of
+ * a higher priority. without a threshold every post switches to the
+ * consumer and back, two context switches an event. with the consumer
+ * priority as the producer's threshold the burst is posted first and the
+ * consumer takes it in one go, one switch a burst.
+ *
+ * the consumer counts the events it took while the producer was in the
+ * middle of its burst, each of them cost the two switches. every
+ * PC_BENCH_ROUNDS bursts it prints the count, rt_stats shows the switches
+ * of both tasks for the same window.
+ */
+
+typedef struct
+{
+	QActive super;
+
+	QTimeEvt tick;
+	uint8_t volatile in_burst;		/* the consumer may look at it */
+} PC_PRODUCER;
+
+typedef struct
+{
+	QActive super;
+
+	uint32_t events;
+	uint32_t preempted;				/* events taken inside a burst */
+} PC_CONSUMER;
+
+static PC_PRODUCER pc_producer;
+static PC_CONSUMER pc_consumer;
+
+QActive * const AO_PcProducer = &pc_producer.super;
+QActive * const AO_PcConsumer = &pc_consumer.super;
+
+static QEvt const pc_data_evt = { (QSignal)PC_BENCH_DATA_SIG, 0U, 0U };
+
+static QState pc_producer_initial( PC_PRODUCER * const me, QEvt const * const e );
+static QState pc_producer_active( PC_PRODUCER * const me, QEvt const * const e );
+static QState pc_consumer_initial( PC_CONSUMER * const me, QEvt const * const e );
+static QState pc_consumer_active( PC_CONSUMER * const me, QEvt const * const e );
+
+void pc_bench_ctor( void )
+{
+	QActive_ctor( &pc_producer.super, Q_STATE_CAST( &pc_producer_initial ) );
+	QTimeEvt_ctorX( &pc_producer.tick, &pc_producer.super, PC_BENCH_TICK_SIG, 0U );
+
+	QActive_ctor( &pc_consumer.super, Q_STATE_CAST( &pc_consumer_initial ) );
+}
+
+static QState pc_producer_initial( PC_PRODUCER * const me, QEvt const * const e )
+{
+	(void)e;
+
+	QTimeEvt_armX( &me->tick, PC_BENCH_PERIOD, PC_BENCH_PERIOD );
+
+	return Q_TRAN( &pc_producer_active );
+}
+
+static QState pc_producer_active( PC_PRODUCER * const me, QEvt const * const e )
+{
+	QState status;
+	uint8_t i;
+
+	switch( e->sig )
+	{
+		case PC_BENCH_TICK_SIG:
+			me->in_burst = 1;
+			for( i = 0; i < PC_BENCH_BURST; i++ )
+			{
+				QACTIVE_POST( AO_PcConsumer, &pc_data_evt, me );
+			}
+			me->in_burst = 0;
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
+
+static QState pc_consumer_initial( PC_CONSUMER * const me, QEvt const * const e )
+{
+	(void)e;
+
+	me->events = 0;
+	me->preempted = 0;
+
+	return Q_TRAN( &pc_consumer_active );
+}
+
+static QState pc_consumer_active( PC_CONSUMER * const me, QEvt const * const e )
+{
+	QState status;
+
+	switch( e->sig )
+	{
+		case PC_BENCH_DATA_SIG:
+			if( pc_producer.in_burst )
+			{
+				++me->preempted;
+			}
+
+			if( ++me->events == PC_BENCH_ROUNDS * PC_BENCH_BURST )
+			{
+				SEGGER_RTT_printf( 0, "pc bench: %u events, %u inside the burst, threshold %u\r\n",
+								   (unsigned)me->events, (unsigned)me->preempted,
+								   (unsigned)PC_BENCH_THRESHOLD );
+				me->events = 0;
+				me->preempted = 0;
+			}
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
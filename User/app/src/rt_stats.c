@@ -0,0 +1,235 @@
+
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "SEGGER_RTT.h"
+
+#include "bsp_dwt.h"
+
+#include "qpc.h"
+
+#include "rt_stats.h"
+
+/* per task accounting, indexed by the TCB uxTaskNumber (see traceTASK_CREATE). */
+typedef struct
+{
+	void const *task;
+	uint64_t cycles;	/* cycles spent running */
+	uint32_t switches;	/* times switched in */
+} RT_STATS_TASK;
+
+static RT_STATS_TASK rt_task[RT_STATS_MAX_TASKS + 1];
+static uint32_t rt_task_used;
+
+static uint32_t rt_current;		/* slot of the running task */
+static uint64_t rt_switch_time;	/* cycles when rt_current was switched in */
+
+/* snapshot of the previous report, results are per report window. */
+static RT_STATS_TASK rt_prev[RT_STATS_MAX_TASKS + 1];
+static uint64_t rt_prev_time;
+
+static TaskStatus_t rt_status[RT_STATS_MAX_STATUS];
+
+/**
+ * portCONFIGURE_TIMER_FOR_RUN_TIME_STATS(), called from vTaskStartScheduler().
+ */
+void rt_stats_init( void )
+{
+	bsp_dwt_init();
+
+	rt_current     = 0;
+	rt_switch_time = 0;
+	rt_prev_time   = 0;
+}
+
+/**
+ * portGET_RUN_TIME_COUNTER_VALUE(), FreeRTOS keeps only 32 bit counters,
+ * the 64 bit values of this module are used for the report.
+ */
+uint32_t rt_stats_get_counter( void )
+{
+	return (uint32_t)( bsp_dwt_get_cycles64() >> RT_STATS_COUNTER_SHIFT );
+}
+
+/**
+ * traceTASK_CREATE(), called inside a critical section.
+ *
+ * @return slot to be stored in the TCB, 0 when the table is full
+ */
+uint32_t rt_stats_task_create( void const *task )
+{
+	if( rt_task_used >= RT_STATS_MAX_TASKS )
+	{
+		return 0;
+	}
+
+	++rt_task_used;
+	rt_task[rt_task_used].task = task;
+
+	return rt_task_used;
+}
+
+/**
+ * traceTASK_SWITCHED_IN(), called from the scheduler with interrupts masked.
+ */
+void rt_stats_task_switched_in( uint32_t slot )
+{
+	uint64_t now = bsp_dwt_get_cycles64();
+
+	if( slot > RT_STATS_MAX_TASKS )
+	{
+		slot = 0;
+	}
+
+	rt_task[rt_current].cycles += now - rt_switch_time;
+	rt_switch_time = now;
+
+	if( slot != rt_current )
+	{
+		++rt_task[slot].switches;
+		rt_current = slot;
+	}
+}
+
+/**
+ * traceTASK_INCREMENT_TICK(), keeps the 64 bit cycle counter extension alive
+ * even when no context switch happens for a whole CYCCNT wrap period.
+ */
+void rt_stats_tick( void )
+{
+	(void)bsp_dwt_get_cycles64();
+}
+
+static uint_fast8_t rt_stats_qf_prio( TaskHandle_t task )
+{
+	uint_fast8_t p;
+
+	for( p = 1; p <= QF_MAX_ACTIVE; ++p )
+	{
+		if( ( QF_active_[p] != (QActive *)0 )
+			&& ( (TaskHandle_t)&QF_active_[p]->thread == task ) )
+		{
+			return p;
+		}
+	}
+
+	return 0;
+}
+
+/* cycles -> tenth of percent of the window */
+static uint32_t rt_stats_permille( uint64_t cycles, uint64_t window )
+{
+	if( window == 0 )
+	{
+		return 0;
+	}
+
+	return (uint32_t)( ( cycles * 1000U ) / window );
+}
+
+/**
+ * print the cpu usage since the previous report.
+ *
+ * columns: QF priority of the active object ('-' for plain tasks), FreeRTOS
+ * priority, cpu usage, context switches, stack high water mark in words.
+ *
+ * @param RTT up buffer index
+ */
+void rt_stats_report( unsigned buffer_index )
+{
+	static RT_STATS_TASK snap[RT_STATS_MAX_TASKS + 1];
+	TaskHandle_t idle = xTaskGetIdleTaskHandle();
+	uint64_t now;
+	uint64_t window;
+	uint32_t idle_permille = 0;
+	uint32_t switches = 0;
+	UBaseType_t n;
+	UBaseType_t i;
+
+	/* 0 when the tasks do not fit, only the switch total is right then */
+	n = uxTaskGetSystemState( rt_status, RT_STATS_MAX_STATUS, NULL );
+
+	/* charge the running task up to now and take a consistent snapshot */
+	taskENTER_CRITICAL();
+	now = bsp_dwt_get_cycles64();
+	rt_task[rt_current].cycles += now - rt_switch_time;
+	rt_switch_time = now;
+	for( i = 0; i <= RT_STATS_MAX_TASKS; ++i )
+	{
+		snap[i] = rt_task[i];
+	}
+	taskEXIT_CRITICAL();
+
+	window = now - rt_prev_time;
+
+	/* all context switches of the window, including the untracked tasks */
+	for( i = 0; i <= RT_STATS_MAX_TASKS; ++i )
+	{
+		switches += snap[i].switches - rt_prev[i].switches;
+	}
+
+	SEGGER_RTT_printf( buffer_index, "\r\n qf pri   cpu%%  switches  stack  name\r\n" );
+
+	if( n == 0 )
+	{
+		SEGGER_RTT_printf( buffer_index, " %u tasks, the list holds %u (RT_STATS_MAX_STATUS)\r\n",
+						   (unsigned)uxTaskGetNumberOfTasks(), (unsigned)RT_STATS_MAX_STATUS );
+	}
+
+	for( i = 0; i < n; ++i )
+	{
+		TaskStatus_t const *s = &rt_status[i];
+		uint32_t slot = (uint32_t)uxTaskGetTaskNumber( s->xHandle );
+		uint_fast8_t qf_prio = rt_stats_qf_prio( s->xHandle );
+		uint32_t permille;
+
+		if( slot > RT_STATS_MAX_TASKS )
+		{
+			slot = 0;
+		}
+
+		permille = rt_stats_permille( snap[slot].cycles - rt_prev[slot].cycles, window );
+
+		if( s->xHandle == idle )
+		{
+			idle_permille = permille;
+		}
+
+		if( qf_prio != 0 )
+		{
+			SEGGER_RTT_printf( buffer_index, " %2u", (unsigned)qf_prio );
+		}
+		else
+		{
+			SEGGER_RTT_printf( buffer_index, "  -" );
+		}
+
+		SEGGER_RTT_printf( buffer_index, " %3u %3u.%u%% %9u %6u  %s%s\r\n",
+						   (unsigned)s->uxCurrentPriority,
+						   (unsigned)( permille / 10 ), (unsigned)( permille % 10 ),
+						   (unsigned)( snap[slot].switches - rt_prev[slot].switches ),
+						   (unsigned)s->usStackHighWaterMark,
+						   s->pcTaskName,
+						   ( slot == 0 ) ? " (untracked)" : "" );
+	}
+
+	SEGGER_RTT_printf( buffer_index, "window %u ms, load %u.%u%%, idle %u.%u%%, switches %u\r\n",
+					   (unsigned)( window / ( configCPU_CLOCK_HZ / 1000 ) ),
+					   (unsigned)( ( 1000 - idle_permille ) / 10 ), (unsigned)( ( 1000 - idle_permille ) % 10 ),
+					   (unsigned)( idle_permille / 10 ), (unsigned)( idle_permille % 10 ),
+					   (unsigned)switches );
+
+	for( i = 0; i <= RT_STATS_MAX_TASKS; ++i )
+	{
+		rt_prev[i] = snap[i];
+	}
+	rt_prev_time = now;
+}
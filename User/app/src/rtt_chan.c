@@ -0,0 +1,297 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <string.h>
+
+#include "SEGGER_RTT.h"
+
+#include "qpc.h"
+
+#include "kv_store.h"
+#include "rtt_chan.h"
+
+Q_DEFINE_THIS_MODULE("rtt_chan")
+
+/*
+ * the channels get their RTT buffers from one pool at boot. the up buffer
+ * sizes follow what the channels needed during the last boot: the byte
+ * counters and the highest fill are stored in the kv store, a channel that
+ * dropped or ran nearly full asks for twice its size, the others for their
+ * highest fill plus a quarter. the pool is shared in proportion to that.
+ */
+
+typedef struct
+{
+	char const *name;
+	char const *down_name;
+	uint16_t min;		/* up buffer */
+	uint16_t def;		/* up buffer without statistics */
+	uint16_t down;		/* down buffer, 0: none */
+} RTT_CHAN_DESC;
+
+static RTT_CHAN_DESC const rtt_chan_desc[ RTT_CHAN_NUM ] =
+{
+	{ "DLog",   NULL,  256, 1024,  0 },
+	{ "Report", "Cmd", 128,  384, 16 },
+};
+
+static uint32_t rtt_chan_pool[ RTT_CHAN_POOL / 4 ];
+
+static int rtt_chan_up_idx[ RTT_CHAN_NUM ];
+static int rtt_chan_down_idx[ RTT_CHAN_NUM ];
+
+static RTT_CHAN_STATS rtt_chan_st[ RTT_CHAN_NUM ];
+static RTT_CHAN_STATS rtt_chan_saved[ RTT_CHAN_NUM ];	/* as in the kv store */
+
+/* up buffer the channel asks for after a boot with the statistics s. */
+static uint32_t rtt_chan_demand( RTT_CHAN_DESC const *d, RTT_CHAN_STATS const *s )
+{
+	uint32_t n;
+
+	if( 0 == s->size )
+	{
+		return d->def;
+	}
+
+	if( s->dropped != 0 || s->max_fill >= s->size - s->size / 8 )
+	{
+		/* saturated, the fill does not tell the need */
+		n = 2U * s->size;
+	}
+	else
+	{
+		n = s->max_fill + s->max_fill / 4;
+	}
+
+	return n < d->min ? d->min : n;
+}
+
+/**
+ * allocate the channel buffers, call after kv_store_ctor() and before
+ * the channels are used.
+ */
+void rtt_chan_init( void )
+{
+	uint32_t demand[ RTT_CHAN_NUM ];
+	uint32_t avail = RTT_CHAN_POOL;
+	uint32_t total = 0, mins = 0, size;
+	uint8_t *p = (uint8_t *)rtt_chan_pool;
+	uint8_t i;
+
+	if( kv_get( RTT_CHAN_KV_KEY, rtt_chan_saved, sizeof( rtt_chan_saved ) ) != sizeof( rtt_chan_saved ) )
+	{
+		memset( rtt_chan_saved, 0, sizeof( rtt_chan_saved ) );
+	}
+
+	for( i = 0; i < RTT_CHAN_NUM; i++ )
+	{
+		avail -= ( rtt_chan_desc[ i ].down + 3U ) & ~3U;
+		demand[ i ] = rtt_chan_demand( &rtt_chan_desc[ i ], &rtt_chan_saved[ i ] );
+		total += demand[ i ];
+		mins += rtt_chan_desc[ i ].min;
+	}
+
+	Q_REQUIRE_ID( 100, mins <= avail );
+
+	for( i = 0; i < RTT_CHAN_NUM; i++ )
+	{
+		if( total > avail )
+		{
+			/* short: the minimum plus a share of the rest */
+			size = rtt_chan_desc[ i ].min
+				   + ( avail - mins ) * ( demand[ i ] - rtt_chan_desc[ i ].min ) / ( total - mins );
+		}
+		else
+		{
+			/* spare: a share of it on top */
+			size = demand[ i ] + ( avail - total ) * demand[ i ] / total;
+		}
+		size &= ~3U;
+
+		rtt_chan_up_idx[ i ] = SEGGER_RTT_AllocUpBuffer( rtt_chan_desc[ i ].name, p, size,
+														 SEGGER_RTT_MODE_NO_BLOCK_SKIP );
+		Q_ASSERT_ID( 110, rtt_chan_up_idx[ i ] > 0 );
+		p += size;
+
+		rtt_chan_st[ i ].size = (uint16_t)size;
+
+		rtt_chan_down_idx[ i ] = -1;
+		if( rtt_chan_desc[ i ].down != 0 )
+		{
+			rtt_chan_down_idx[ i ] = SEGGER_RTT_AllocDownBuffer( rtt_chan_desc[ i ].down_name, p,
+																 rtt_chan_desc[ i ].down,
+																 SEGGER_RTT_MODE_NO_BLOCK_SKIP );
+			Q_ASSERT_ID( 120, rtt_chan_down_idx[ i ] > 0 );
+			p += ( rtt_chan_desc[ i ].down + 3U ) & ~3U;
+		}
+	}
+}
+
+/**
+ * @return RTT up buffer index of the channel
+ */
+int rtt_chan_up( RTT_CHAN ch )
+{
+	return rtt_chan_up_idx[ ch ];
+}
+
+/**
+ * @return RTT down buffer index of the channel, -1: none
+ */
+int rtt_chan_down( RTT_CHAN ch )
+{
+	return rtt_chan_down_idx[ ch ];
+}
+
+/**
+ * @return bytes the up buffer of the channel takes
+ */
+unsigned rtt_chan_space( RTT_CHAN ch )
+{
+	SEGGER_RTT_BUFFER_UP const *up = &_SEGGER_RTT.aUp[ rtt_chan_up_idx[ ch ] ];
+	unsigned rd = up->RdOff;
+	unsigned wr = up->WrOff;
+
+	return rd > wr ? rd - wr - 1 : up->SizeOfBuffer - ( wr - rd ) - 1;
+}
+
+/* track the fill, RTT lock held. */
+static void rtt_chan_fill( RTT_CHAN ch, unsigned space )
+{
+	unsigned fill = rtt_chan_st[ ch ].size - 1U - space;
+
+	if( fill > rtt_chan_st[ ch ].max_fill )
+	{
+		rtt_chan_st[ ch ].max_fill = (uint16_t)fill;
+	}
+}
+
+/**
+ * write all or nothing to the up buffer of the channel.
+ *
+ * @return bytes written
+ */
+unsigned rtt_chan_write( RTT_CHAN ch, void const *p, unsigned n )
+{
+	unsigned space;
+
+	SEGGER_RTT_LOCK();
+
+	space = rtt_chan_space( ch );
+
+	if( n <= space )
+	{
+		SEGGER_RTT_WriteNoLock( rtt_chan_up_idx[ ch ], p, n );
+		rtt_chan_st[ ch ].written += n;
+		rtt_chan_fill( ch, space - n );
+	}
+	else
+	{
+		rtt_chan_st[ ch ].dropped += n;
+		rtt_chan_fill( ch, space );
+		n = 0;
+	}
+
+	SEGGER_RTT_UNLOCK();
+
+	return n;
+}
+
+/**
+ * a key typed into the down buffer of the channel, one at a time so the
+ * rest waits in the buffer.
+ *
+ * @return the key, -1: none
+ */
+int rtt_chan_key( RTT_CHAN ch )
+{
+	uint8_t c;
+
+	if( rtt_chan_down_idx[ ch ] < 0 || 0 == SEGGER_RTT_Read( rtt_chan_down_idx[ ch ], &c, 1 ) )
+	{
+		return -1;
+	}
+
+	return c;
+}
+
+/**
+ * sample the fill of the channels written by SEGGER_RTT_printf() and
+ * friends, call periodically.
+ */
+void rtt_chan_poll( void )
+{
+	uint8_t i;
+
+	for( i = 0; i < RTT_CHAN_NUM; i++ )
+	{
+		SEGGER_RTT_LOCK();
+		rtt_chan_fill( (RTT_CHAN)i, rtt_chan_space( (RTT_CHAN)i ) );
+		SEGGER_RTT_UNLOCK();
+	}
+}
+
+void rtt_chan_stats( RTT_CHAN ch, RTT_CHAN_STATS *stats )
+{
+	SEGGER_RTT_LOCK();
+	*stats = rtt_chan_st[ ch ];
+	SEGGER_RTT_UNLOCK();
+}
+
+/**
+ * store the statistics for the sizing at the next boot. writes the kv
+ * store only when a channel would get a noticeably different size, so it
+ * may be called often from a low priority task.
+ */
+void rtt_chan_save( void )
+{
+	RTT_CHAN_STATS st[ RTT_CHAN_NUM ];
+	uint32_t now, was;
+	uint8_t i, changed = 0;
+
+	for( i = 0; i < RTT_CHAN_NUM; i++ )
+	{
+		rtt_chan_stats( (RTT_CHAN)i, &st[ i ] );
+
+		now = rtt_chan_demand( &rtt_chan_desc[ i ], &st[ i ] );
+		was = rtt_chan_demand( &rtt_chan_desc[ i ], &rtt_chan_saved[ i ] );
+		if( now > was + was / 8 || now + now / 8 < was )
+		{
+			changed = 1;
+		}
+	}
+
+	if( changed && kv_put( RTT_CHAN_KV_KEY, st, sizeof( st ) ) == KV_OK )
+	{
+		memcpy( rtt_chan_saved, st, sizeof( st ) );
+	}
+}
+
+/**
+ * print the byte counters and the up buffer sizes of this and the next boot.
+ *
+ * @param RTT up buffer index
+ */
+void rtt_chan_report( unsigned buffer_index )
+{
+	RTT_CHAN_STATS s;
+	uint8_t i;
+
+	SEGGER_RTT_printf( buffer_index, "\r\n up name       size  next   written   dropped  max fill\r\n" );
+
+	for( i = 0; i < RTT_CHAN_NUM; i++ )
+	{
+		rtt_chan_stats( (RTT_CHAN)i, &s );
+
+		SEGGER_RTT_printf( buffer_index, " %2d %6u %5u %9u %9u %9u  %s\r\n",
+						   rtt_chan_up_idx[ i ], (unsigned)s.size,
+						   (unsigned)rtt_chan_demand( &rtt_chan_desc[ i ], &s ),
+						   (unsigned)s.written, (unsigned)s.dropped, (unsigned)s.max_fill,
+						   rtt_chan_desc[ i ].name );
+	}
+}
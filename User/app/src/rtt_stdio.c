@@ -0,0 +1,213 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "stm32f10x.h"
+
+#include "bsp_dwt.h"
+
+#include "rt_stats.h"
+#include "rtt_stdio.h"
+
+/*
+ * line buffered stdout on RTT. each task collects its characters in its
+ * own staging buffer, found by the rt_stats slot in the TCB, and writes a
+ * whole line with a single locked RTT write, so the lock is taken once per
+ * line and lines of different tasks never mix. a line longer than the
+ * buffer is cut rather than written in parts, a part would let the line of
+ * a preempting task in between.
+ *
+ * interrupts, tasks beyond RT_STATS_MAX_TASKS and code running before the
+ * scheduler write each character straight through, as before.
+ */
+
+typedef struct
+{
+	uint8_t len;
+	char buf[ RTT_STDIO_LINE ];
+} RTT_STDIO_LINE_BUF;
+
+static RTT_STDIO_LINE_BUF rtt_stdio_lines[ RT_STATS_MAX_TASKS + 1 ];
+
+static RTT_STDIO_STATS rtt_stdio_st;
+
+/* 1: every character straight through, for the comparison of the report */
+static volatile uint8_t rtt_stdio_direct;
+
+/* the line of the comparison, as led_task prints it */
+#define RTT_STDIO_BENCH_FMT		"tick:%u,system heap:%u.\r\n"
+
+/* bytes the up buffer takes, RTT lock held. */
+static unsigned rtt_stdio_space( void )
+{
+	SEGGER_RTT_BUFFER_UP const *up = &_SEGGER_RTT.aUp[ RTT_STDIO_CHANNEL ];
+	unsigned rd = up->RdOff;
+	unsigned wr = up->WrOff;
+
+	return rd > wr ? rd - wr - 1 : up->SizeOfBuffer - ( wr - rd ) - 1;
+}
+
+static void rtt_stdio_write( char const *p, unsigned n, uint8_t can_block )
+{
+	unsigned space;
+	uint8_t done = 0;
+
+	while( !done )
+	{
+		SEGGER_RTT_LOCK();
+
+		++rtt_stdio_st.writes;
+		space = rtt_stdio_space();
+
+		if( n <= space )
+		{
+			SEGGER_RTT_WriteNoLock( RTT_STDIO_CHANNEL, p, n );
+			done = 1;
+		}
+		else if( RTT_STDIO_MODE != SEGGER_RTT_MODE_BLOCK_IF_FIFO_FULL || !can_block )
+		{
+			if( RTT_STDIO_MODE == SEGGER_RTT_MODE_NO_BLOCK_TRIM )
+			{
+				SEGGER_RTT_WriteNoLock( RTT_STDIO_CHANNEL, p, space );
+				n -= space;
+			}
+			rtt_stdio_st.dropped += n;
+			done = 1;
+		}
+
+		SEGGER_RTT_UNLOCK();
+
+		if( !done )
+		{
+			vTaskDelay( 1 );
+		}
+	}
+}
+
+/* staging buffer of the running task, NULL: write through. */
+static RTT_STDIO_LINE_BUF *rtt_stdio_line( void )
+{
+	UBaseType_t slot;
+
+	if( __get_IPSR() != 0 || xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED )
+	{
+		return NULL;
+	}
+
+	slot = uxTaskGetTaskNumber( xTaskGetCurrentTaskHandle() );
+	if( 0 == slot || slot > RT_STATS_MAX_TASKS )
+	{
+		return NULL;
+	}
+
+	return &rtt_stdio_lines[ slot ];
+}
+
+/**
+ * stdout character, called by fputc().
+ */
+void rtt_stdio_putc( char ch )
+{
+	uint32_t t0 = bsp_dwt_get_cycles();
+	RTT_STDIO_LINE_BUF *line = rtt_stdio_line();
+
+	if( NULL == line || rtt_stdio_direct )
+	{
+		rtt_stdio_write( &ch, 1, 0 );
+	}
+	else
+	{
+		/* the last place is kept for the '\n' */
+		if( '\n' == ch || line->len < RTT_STDIO_LINE - 1 )
+		{
+			line->buf[ line->len++ ] = ch;
+		}
+		else
+		{
+			++rtt_stdio_st.cut;
+		}
+
+		if( '\n' == ch )
+		{
+			rtt_stdio_write( line->buf, line->len, 1 );
+			line->len = 0;
+		}
+	}
+
+	/* counters of several tasks, lost updates are acceptable */
+	++rtt_stdio_st.chars;
+	rtt_stdio_st.cycles += bsp_dwt_get_cycles() - t0;
+}
+
+/**
+ * write the unfinished line of the running task, e.g. a prompt.
+ */
+void rtt_stdio_flush( void )
+{
+	RTT_STDIO_LINE_BUF *line = rtt_stdio_line();
+
+	if( line != NULL && line->len != 0 )
+	{
+		rtt_stdio_write( line->buf, line->len, 1 );
+		line->len = 0;
+	}
+}
+
+void rtt_stdio_stats( RTT_STDIO_STATS *stats )
+{
+	*stats = rtt_stdio_st;
+}
+
+/**
+ * print lock acquisitions and cycles per character, then time one line
+ * through printf() with the line buffer, through printf() writing every
+ * character as the plain fputc() retarget did (microlib), and through
+ * SEGGER_RTT_printf(), which writes its 64 byte buffer at a time. the line
+ * goes out on stdout three times.
+ *
+ * @param RTT up buffer index
+ */
+void rtt_stdio_report( unsigned buffer_index )
+{
+	RTT_STDIO_STATS s = rtt_stdio_st;
+	uint32_t t0, cycles[ 3 ], locks[ 3 ];
+	uint8_t i;
+	int n;
+
+	SEGGER_RTT_printf( buffer_index, "stdio chars %u, locks %u, dropped %u, cut %u, %u cycles/char\r\n",
+					   (unsigned)s.chars, (unsigned)s.writes, (unsigned)s.dropped, (unsigned)s.cut,
+					   (unsigned)( s.chars ? s.cycles / s.chars : 0 ) );
+
+	rtt_stdio_flush();
+
+	for( i = 0; i < 2; i++ )
+	{
+		rtt_stdio_direct = i;
+
+		locks[ i ] = rtt_stdio_st.writes;
+		t0 = bsp_dwt_get_cycles();
+		printf( RTT_STDIO_BENCH_FMT, (unsigned)t0, (unsigned)( t0 >> 16 ) );
+		cycles[ i ] = bsp_dwt_get_cycles() - t0;
+		locks[ i ] = rtt_stdio_st.writes - locks[ i ];
+	}
+	rtt_stdio_direct = 0;
+
+	t0 = bsp_dwt_get_cycles();
+	n = SEGGER_RTT_printf( RTT_STDIO_CHANNEL, RTT_STDIO_BENCH_FMT, (unsigned)t0, (unsigned)( t0 >> 16 ) );
+	cycles[ 2 ] = bsp_dwt_get_cycles() - t0;
+	locks[ 2 ] = n > 0 ? ( (uint32_t)n + SEGGER_RTT_PRINTF_BUFFER_SIZE - 1 ) / SEGGER_RTT_PRINTF_BUFFER_SIZE : 0;
+
+	SEGGER_RTT_printf( buffer_index, "one line: printf %u cycles %u locks, microlib %u cycles %u locks, "
+					   "SEGGER_RTT_printf %u cycles %u locks\r\n",
+					   (unsigned)cycles[ 0 ], (unsigned)locks[ 0 ], (unsigned)cycles[ 1 ], (unsigned)locks[ 1 ],
+					   (unsigned)cycles[ 2 ], (unsigned)locks[ 2 ] );
+}
@@ -0,0 +1,183 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "app_signals.h"
+#include "spi_bus.h"
+
+Q_DEFINE_THIS_MODULE("spi_bus")
+
+/*
+ * spi bus manager. transfers are queued per device in the order they were
+ * submitted. while the bus is idle the queued transfers are linked into one
+ * chain, the devices taken round robin, up to SPI_BUS_BATCH_MAX transfers
+ * of a device at a time, so a busy device can not starve the others. the
+ * driver runs the chain from its interrupt, each transfer reports to its
+ * own owner, and SPI_IDLE_SIG comes back here when the chain is done.
+ *
+ * a CS_HOLD sequence is only linked once its last transfer (the one
+ * without CS_HOLD) is queued too. the driver releases CS at the end of a
+ * chain, so a command and its data submitted one after the other would
+ * otherwise end up under two CS assertions.
+ */
+
+typedef struct
+{
+	QActive super;
+
+	SPI_XFER *head[ BSP_SPI_DEVICES ];
+	SPI_XFER *tail[ BSP_SPI_DEVICES ];
+	SPI_XFER *open[ BSP_SPI_DEVICES ];	/* CS_HOLD sequence without its end yet */
+	uint8_t rr;		/* device served first in the next chain */
+} SPI_BUS;
+
+static SPI_BUS spi_bus;
+QActive * const AO_SpiBus = &spi_bus.super;
+
+static QState spi_bus_initial( SPI_BUS * const me, QEvt const * const e );
+static QState spi_bus_active( SPI_BUS * const me, QEvt const * const e );
+
+void spi_bus_ctor( void )
+{
+	QActive_ctor( &spi_bus.super, Q_STATE_CAST( &spi_bus_initial ) );
+}
+
+/**
+ * queue a transfer, the owner gets xfer->sig when it is done.
+ */
+void spi_bus_submit( SPI_XFER *xfer, void const *sender )
+{
+	SPI_SUBMIT_EVT *e = Q_NEW( SPI_SUBMIT_EVT, SPI_SUBMIT_SIG );
+
+	e->xfer = xfer;
+	QACTIVE_POST( AO_SpiBus, &e->super, sender );
+}
+
+/* link the queued transfers into a chain and start it. */
+static void spi_bus_run( SPI_BUS * const me )
+{
+	SPI_XFER *chain = NULL;
+	SPI_XFER *last = NULL;
+	SPI_XFER *x;
+	uint8_t i, dev, n;
+
+	/* the driver may have gone idle before SPI_IDLE_SIG got here */
+	if( bsp_spi_busy() )
+	{
+		return;
+	}
+
+	for( i = 0; i < BSP_SPI_DEVICES; i++ )
+	{
+		dev = ( me->rr + i ) % BSP_SPI_DEVICES;
+
+		for( n = 0; me->head[ dev ] != NULL; n++ )
+		{
+			x = me->head[ dev ];
+
+			/* the rest waits for the end of its CS_HOLD sequence */
+			if( x == me->open[ dev ] )
+			{
+				break;
+			}
+
+			/* never split a CS_HOLD sequence over two chains */
+			if( n >= SPI_BUS_BATCH_MAX && 0 == ( last->flags & SPI_XFER_CS_HOLD ) )
+			{
+				break;
+			}
+
+			me->head[ dev ] = x->next;
+			x->next = NULL;
+
+			if( NULL == chain )
+			{
+				chain = x;
+			}
+			else
+			{
+				last->next = x;
+			}
+			last = x;
+		}
+	}
+
+	me->rr = ( me->rr + 1 ) % BSP_SPI_DEVICES;
+
+	if( chain != NULL )
+	{
+		bsp_spi_start( chain );
+	}
+}
+
+static QState spi_bus_initial( SPI_BUS * const me, QEvt const * const e )
+{
+	uint8_t i;
+
+	(void)e;
+
+	for( i = 0; i < BSP_SPI_DEVICES; i++ )
+	{
+		me->head[ i ] = NULL;
+		me->tail[ i ] = NULL;
+		me->open[ i ] = NULL;
+	}
+	me->rr = 0;
+
+	bsp_spi_init( &me->super, SPI_IDLE_SIG );
+
+	return Q_TRAN( &spi_bus_active );
+}
+
+static QState spi_bus_active( SPI_BUS * const me, QEvt const * const e )
+{
+	QState status;
+	SPI_XFER *x;
+
+	switch( e->sig )
+	{
+		case SPI_SUBMIT_SIG:
+			x = ( (SPI_SUBMIT_EVT const *)e )->xfer;
+
+			Q_ASSERT_ID( 100, x->dev < BSP_SPI_DEVICES );
+
+			x->next = NULL;
+			if( NULL == me->head[ x->dev ] )
+			{
+				me->head[ x->dev ] = x;
+			}
+			else
+			{
+				me->tail[ x->dev ]->next = x;
+			}
+			me->tail[ x->dev ] = x;
+
+			if( 0 == ( x->flags & SPI_XFER_CS_HOLD ) )
+			{
+				me->open[ x->dev ] = NULL;
+			}
+			else if( NULL == me->open[ x->dev ] )
+			{
+				me->open[ x->dev ] = x;
+			}
+
+			spi_bus_run( me );
+			status = Q_HANDLED();
+			break;
+
+		case SPI_IDLE_SIG:
+			spi_bus_run( me );
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
@@ -0,0 +1,260 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "usb_lib.h"
+#include "usb_hw.h"
+
+#include "bsp_dwt.h"
+#include "bsp_usb_stream.h"
+
+#include "app_signals.h"
+#include "usb_ao.h"
+
+/*
+ * the control endpoint state machine (Setup0_Process() and the descriptor
+ * requests behind it) runs here at task level instead of in the USB
+ * interrupt. the interrupt only captures the transfer into a ring, with a
+ * copy of the received packet, NAKs endpoint 0 until it is serviced, and
+ * posts USB_CTR_SIG when the ring was empty. the AO reads a slot and moves
+ * the tail with the USB interrupt masked, so the ISR always finds the
+ * entries from the tail on unserviced and may drop them.
+ *
+ * a bus reset goes through the same ring, so it never runs while a
+ * control transfer is half serviced. it flushes the ring, the transfers
+ * before it belong to the old session. a SETUP is ACKed even while
+ * endpoint 0 is NAKed and aborts the transfer in progress, so it replaces
+ * the control transfer waiting behind the reset. the ring holds at most a
+ * reset and one transfer, plus the slot the ISR captures into.
+ *
+ * data endpoints are still serviced in the interrupt, their callbacks are
+ * short and latency bound.
+ *
+ * the AO also owns the stream (bsp_usb_stream.c) and sends back what the
+ * host writes, so the throughput can be measured from the host side.
+ */
+
+#define USB_AO_RING_MASK	( USB_AO_RING_SIZE - 1 )
+
+typedef struct
+{
+	QActive super;
+
+	uint8_t loop_buf[ USB_AO_LOOP_SIZE ];
+	uint16_t loop_len;		/* bytes received */
+	uint16_t loop_sent;		/* bytes of them taken by the tx ring */
+} USB_AO;
+
+static USB_AO usb_ao;
+QActive * const AO_Usb = &usb_ao.super;
+
+static CTR_EVENT usb_ao_ring[ USB_AO_RING_SIZE ];
+static volatile uint8_t usb_ao_head;	/* written by the ISR */
+static volatile uint8_t usb_ao_tail;	/* written by the AO */
+
+static QEvt const usb_ctr_evt = { (QSignal)USB_CTR_SIG, 0U, 0U };
+
+static uint32_t usb_ao_cycles_max;
+
+static QState usb_ao_initial( USB_AO * const me, QEvt const * const e );
+static QState usb_ao_active( USB_AO * const me, QEvt const * const e );
+
+void usb_ao_ctor( void )
+{
+	QActive_ctor( &usb_ao.super, Q_STATE_CAST( &usb_ao_initial ) );
+
+	usb_ao_head = 0;
+	usb_ao_tail = 0;
+}
+
+static QState usb_ao_initial( USB_AO * const me, QEvt const * const e )
+{
+	(void)e;
+
+	bsp_usb_stream_init( &me->super, USB_STREAM_TX_SIG, USB_STREAM_RX_SIG );
+	bsp_usb_stream_read( me->loop_buf, sizeof( me->loop_buf ) );
+
+	usb_hw_init();
+
+	return Q_TRAN( &usb_ao_active );
+}
+
+/* send the rest of the received block, read the next one when it is out. */
+static void usb_ao_loop( USB_AO * const me )
+{
+	me->loop_sent += bsp_usb_stream_write( me->loop_buf + me->loop_sent,
+										   me->loop_len - me->loop_sent );
+
+	if( me->loop_sent == me->loop_len )
+	{
+		bsp_usb_stream_read( me->loop_buf, sizeof( me->loop_buf ) );
+	}
+}
+
+static QState usb_ao_active( USB_AO * const me, QEvt const * const e )
+{
+	QState status;
+	CTR_EVENT const *evt;
+
+	switch( e->sig )
+	{
+		case USB_CTR_SIG:
+			while( usb_ao_tail != usb_ao_head )
+			{
+				/* both sides read-modify-write the endpoint registers,
+				 * only the USB interrupt waits for one transfer step.
+				 */
+				usb_hw_irq_mask();
+
+				/* tail moves after servicing, so the ISR sees a busy ring */
+				evt = &usb_ao_ring[ usb_ao_tail & USB_AO_RING_MASK ];
+
+				if( evt->wIstr & ISTR_RESET )
+				{
+					pProperty->Reset();
+				}
+				else
+				{
+					CTR_LP_Service( evt );
+				}
+
+				++usb_ao_tail;
+
+				usb_hw_irq_unmask();
+			}
+			status = Q_HANDLED();
+			break;
+
+		case USB_STREAM_RX_SIG:
+			me->loop_len  = (uint16_t)Q_EVT_CAST( USB_STREAM_EVT )->len;
+			me->loop_sent = 0;
+			usb_ao_loop( me );
+			status = Q_HANDLED();
+			break;
+
+		case USB_STREAM_TX_SIG:
+			/* the ring ran empty, it was full when data is left */
+			if( me->loop_sent != me->loop_len )
+			{
+				usb_ao_loop( me );
+			}
+			status = Q_HANDLED();
+			break;
+
+		default:
+			status = Q_SUPER( &QHsm_top );
+			break;
+	}
+
+	return status;
+}
+
+#if USB_AO_DEFERRED
+
+/* a reset, the transfer behind it and the slot being captured */
+Q_ASSERT_COMPILE( USB_AO_RING_SIZE >= 3 );
+
+/* the slot after the last entry, always free: endpoint 0 stays NAKed
+ * until its transfer is serviced, a SETUP replaces it, a reset flushes.
+ */
+static CTR_EVENT *usb_ao_slot( void )
+{
+	return &usb_ao_ring[ usb_ao_head & USB_AO_RING_MASK ];
+}
+
+/* the entry at pos is the last one now, those behind it are dropped. wake
+ * the AO when the ring was empty.
+ */
+static void usb_ao_push( uint8_t pos, BaseType_t *woken )
+{
+	uint8_t empty = ( usb_ao_head == usb_ao_tail );
+
+	usb_ao_head = (uint8_t)( pos + 1U );
+
+	if( empty )
+	{
+		QACTIVE_POST_FROM_ISR( AO_Usb, &usb_ctr_evt, woken, &usb_ao_ring );
+	}
+}
+
+/* publish the transfer just captured into usb_ao_slot(). */
+static void usb_ao_push_ctr( BaseType_t *woken )
+{
+	CTR_EVENT const *evt = usb_ao_slot();
+	uint8_t pos = usb_ao_head;
+
+	if( ( evt->wIstr & ISTR_DIR ) && ( evt->wEPVal & EP_SETUP ) )
+	{
+		/* the transfer still waiting was aborted, a reset stays */
+		pos = usb_ao_tail;
+		if( pos != usb_ao_head && ( usb_ao_ring[ pos & USB_AO_RING_MASK ].wIstr & ISTR_RESET ) )
+		{
+			++pos;
+		}
+
+		if( pos != usb_ao_head )
+		{
+			usb_ao_ring[ pos & USB_AO_RING_MASK ] = *evt;
+		}
+	}
+
+	usb_ao_push( pos, woken );
+}
+
+#endif /* USB_AO_DEFERRED */
+
+void usb_ao_ctr_isr( void )
+{
+	uint32_t cycles = bsp_dwt_get_cycles();
+
+#if USB_AO_DEFERRED
+	BaseType_t woken = pdFALSE;
+
+	while( CTR_LP_Capture( usb_ao_slot() ) )
+	{
+		usb_ao_push_ctr( &woken );
+	}
+#else
+	CTR_LP();
+#endif
+
+	cycles = bsp_dwt_get_cycles() - cycles;
+	if( cycles > usb_ao_cycles_max )
+	{
+		usb_ao_cycles_max = cycles;
+	}
+
+#if USB_AO_DEFERRED
+	portEND_SWITCHING_ISR( woken );
+#endif
+}
+
+void usb_ao_reset_isr( void )
+{
+#if USB_AO_DEFERRED
+	BaseType_t woken = pdFALSE;
+
+	/* the unserviced entries go, the reset takes the first one */
+	usb_ao_ring[ usb_ao_tail & USB_AO_RING_MASK ].wIstr = ISTR_RESET;
+	usb_ao_push( usb_ao_tail, &woken );
+
+	portEND_SWITCHING_ISR( woken );
+#else
+	pProperty->Reset();
+#endif
+}
+
+/**
+ * longest time spent in usb_ao_ctr_isr(), set USB_AO_DEFERRED to 0 to
+ * measure the control transfers serviced in the interrupt.
+ *
+ * @return DWT cycles, needs bsp_dwt_init()
+ */
+uint32_t usb_ao_isr_cycles_max( void )
+{
+	return usb_ao_cycles_max;
+}
@@ -0,0 +1,184 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "bsp_dma.h"
+#include "bsp_adc.h"
+
+Q_DEFINE_THIS_MODULE("bsp_adc")
+
+/*
+ * TIM3 triggers one scan of the regular group, the DMA stores it into a
+ * circular ping-pong buffer of two blocks. the half transfer and transfer
+ * complete interrupts post the block just filled, so the cpu sees one
+ * interrupt per BSP_ADC_BLOCK_FRAMES scans instead of one per conversion.
+ */
+
+#define ADC_BLOCK_SIZE	( BSP_ADC_BLOCK_FRAMES * BSP_ADC_CHANNELS )
+
+static uint8_t const adc_channels[ BSP_ADC_CHANNELS ] = BSP_ADC_CHANNEL_TABLE;
+
+static uint16_t adc_buf[ 2 * ADC_BLOCK_SIZE ];
+
+static QActive *adc_ao;
+static enum_t adc_block_sig;
+static volatile uint32_t adc_seq;
+
+void bsp_adc_init( QActive *ao, enum_t block_sig )
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	ADC_InitTypeDef ADC_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+	uint8_t i;
+
+	adc_ao = ao;
+	adc_block_sig = block_sig;
+
+	RCC_APB2PeriphClockCmd( RCC_ADC_GPIO | RCC_APB2Periph_ADC1, ENABLE );
+	RCC_APB1PeriphClockCmd( RCC_APB1Periph_TIM3, ENABLE );
+	RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
+	RCC_ADCCLKConfig( RCC_PCLK2_Div6 );
+
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AIN;
+	GPIO_InitStructure.GPIO_Pin = GPIO_PIN_ADC;
+	GPIO_Init( GPIO_PORT_ADC, &GPIO_InitStructure );
+
+	/* TIM3 clock 72MHz, counts at 1MHz, TRGO on update */
+	TIM_TimeBaseStructure.TIM_Prescaler = 72 - 1;
+	TIM_TimeBaseStructure.TIM_Period = 1000000 / BSP_ADC_SAMPLE_RATE - 1;
+	TIM_TimeBaseStructure.TIM_ClockDivision = TIM_CKD_DIV1;
+	TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+	TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+	TIM_TimeBaseInit( TIM3, &TIM_TimeBaseStructure );
+	TIM_SelectOutputTrigger( TIM3, TIM_TRGOSource_Update );
+
+	bsp_dma_claim( DMA1_Channel1 );
+	DMA_DeInit( DMA1_Channel1 );
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&ADC1->DR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)adc_buf;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+	DMA_InitStructure.DMA_BufferSize = 2 * ADC_BLOCK_SIZE;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Circular;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init( DMA1_Channel1, &DMA_InitStructure );
+	DMA_ITConfig( DMA1_Channel1, DMA_IT_HT | DMA_IT_TC, ENABLE );
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel1_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = BSP_ADC_IRQ_PRIO;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init( &NVIC_InitStructure );
+
+	ADC_DeInit( ADC1 );
+	ADC_InitStructure.ADC_Mode = ADC_Mode_Independent;
+	ADC_InitStructure.ADC_ScanConvMode = ENABLE;
+	ADC_InitStructure.ADC_ContinuousConvMode = DISABLE;
+	ADC_InitStructure.ADC_ExternalTrigConv = ADC_ExternalTrigConv_T3_TRGO;
+	ADC_InitStructure.ADC_DataAlign = ADC_DataAlign_Right;
+	ADC_InitStructure.ADC_NbrOfChannel = BSP_ADC_CHANNELS;
+	ADC_Init( ADC1, &ADC_InitStructure );
+
+	for( i = 0; i < BSP_ADC_CHANNELS; i++ )
+	{
+		ADC_RegularChannelConfig( ADC1, adc_channels[ i ], i + 1, BSP_ADC_SAMPLE_TIME );
+	}
+
+	ADC_DMACmd( ADC1, ENABLE );
+	ADC_Cmd( ADC1, ENABLE );
+
+	ADC_ResetCalibration( ADC1 );
+	while( ADC_GetResetCalibrationStatus( ADC1 ) );
+	ADC_StartCalibration( ADC1 );
+	while( ADC_GetCalibrationStatus( ADC1 ) );
+
+	ADC_ExternalTrigConvCmd( ADC1, ENABLE );
+}
+
+/**
+ * start the acquisition at the first half of the buffer.
+ */
+void bsp_adc_start( void )
+{
+	Q_REQUIRE_ID( 100, 1000000 / BSP_ADC_SAMPLE_RATE > 1 );
+
+	adc_seq = 0;
+
+	DMA_Cmd( DMA1_Channel1, DISABLE );
+	DMA1_Channel1->CNDTR = 2 * ADC_BLOCK_SIZE;
+	DMA_Cmd( DMA1_Channel1, ENABLE );
+
+	TIM_SetCounter( TIM3, 0 );
+	TIM_Cmd( TIM3, ENABLE );
+}
+
+void bsp_adc_stop( void )
+{
+	TIM_Cmd( TIM3, DISABLE );
+	DMA_Cmd( DMA1_Channel1, DISABLE );
+}
+
+/**
+ * still unchanged by the DMA? call after the block has been used.
+ *
+ * the DMA moves into the block of event n when it posts event n + 1, but
+ * the interrupt may be held off while the DMA goes on, so its position
+ * decides: the block is intact while the DMA is in the other half, or at
+ * the very start of this one and has not lapped it. an interrupt held off
+ * for a whole block time is not seen.
+ */
+uint8_t bsp_adc_block_valid( ADC_BLOCK_EVT const *e )
+{
+	uint32_t start = (uint32_t)( e->data - adc_buf );
+	uint32_t primask, posted, pos;
+
+	/* both at the same instant, the DMA does not wait for the cpu */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	posted = adc_seq - e->seq;		/* events since, this one included */
+	pos = 2 * ADC_BLOCK_SIZE - DMA1_Channel1->CNDTR;
+	__set_PRIMASK( primask );
+
+	if( pos == start )
+	{
+		return posted <= 2;
+	}
+
+	return 1 == posted && ( pos < start || pos >= start + ADC_BLOCK_SIZE );
+}
+
+void DMA1_Channel1_IRQHandler( void )
+{
+	BaseType_t woken = pdFALSE;
+	ADC_BLOCK_EVT *e;
+	uint16_t const *data;
+
+	if( DMA_GetITStatus( DMA1_IT_HT1 ) )
+	{
+		DMA_ClearITPendingBit( DMA1_IT_HT1 );
+		data = &adc_buf[ 0 ];
+	}
+	else
+	{
+		DMA_ClearITPendingBit( DMA1_IT_TC1 );
+		data = &adc_buf[ ADC_BLOCK_SIZE ];
+	}
+
+	e = Q_NEW_FROM_ISR( ADC_BLOCK_EVT, adc_block_sig );
+	e->data = data;
+	e->seq = adc_seq++;
+	QACTIVE_POST_FROM_ISR( adc_ao, &e->super, &woken, &adc_seq );
+
+	portEND_SWITCHING_ISR( woken );
+}
@@ -0,0 +1,58 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_ADC_H
+#define _BSP_ADC_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/* ADC1 regular group, scanned in table order, inputs PA0..PA3. */
+#define RCC_ADC_GPIO			( RCC_APB2Periph_GPIOA )
+#define GPIO_PORT_ADC			GPIOA
+#define GPIO_PIN_ADC			( GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 )
+
+#define BSP_ADC_CHANNEL_TABLE	{ ADC_Channel_0, ADC_Channel_1, ADC_Channel_2, ADC_Channel_3 }
+#define BSP_ADC_CHANNELS		4
+
+/* ADCCLK = 72MHz / 6 = 12MHz, (55.5 + 12.5) cycles = 5.67us a conversion. */
+#define BSP_ADC_SAMPLE_TIME		ADC_SampleTime_55Cycles5
+
+/* scans a second, TIM3 update is the trigger. */
+#ifndef BSP_ADC_SAMPLE_RATE
+#define BSP_ADC_SAMPLE_RATE		1000
+#endif
+
+/* scans in one block, one DMA interrupt per block. */
+#ifndef BSP_ADC_BLOCK_FRAMES
+#define BSP_ADC_BLOCK_FRAMES	32
+#endif
+
+/* must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY (5). */
+#define BSP_ADC_IRQ_PRIO		7
+
+/* posted for each filled half of the DMA buffer. the block is overwritten
+ * one block time after the event, see bsp_adc_block_valid().
+ */
+typedef struct
+{
+	QEvt super;
+
+	uint16_t const *data;	/* BSP_ADC_BLOCK_FRAMES x BSP_ADC_CHANNELS */
+	uint32_t seq;			/* block number since bsp_adc_start() */
+} ADC_BLOCK_EVT;
+
+void bsp_adc_init( QActive *ao, enum_t block_sig );
+void bsp_adc_start( void );
+void bsp_adc_stop( void );
+
+uint8_t bsp_adc_block_valid( ADC_BLOCK_EVT const *e );
+
+#endif /* _BSP_ADC_H */
@@ -0,0 +1,528 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <string.h>
+
+#include "bsp_dwt.h"
+
+#include "bsp_can.h"
+
+Q_DEFINE_THIS_MODULE("bsp_can")
+
+/*
+ * receive: the hardware filters run in identifier list mode, so only the
+ * subscribed ids are accepted and the filter match index (FMI) of a frame
+ * tells which one it is, a table lookup instead of a search by id. each RX
+ * interrupt empties both FIFOs into a single producer / single consumer
+ * ring, the owner gets rx_sig only when the ring was empty before, so a
+ * burst of frames costs one event.
+ *
+ * transmit: frames wait in a queue sorted by arbitration priority, the
+ * mailboxes are refilled from the TX interrupt. when all three are busy and
+ * a more urgent frame is queued, the least urgent mailbox is aborted and
+ * its frame goes back into the queue, so a low priority frame can not hold
+ * a mailbox the bus would give to the urgent one.
+ */
+
+#define RX_RING_MASK	( BSP_CAN_RX_RING - 1 )
+
+/* filter numbers per FIFO, all banks in 16 bit list mode */
+#define CAN_FMI_MAX		( BSP_CAN_FILTER_BANKS * 4 )
+
+/* CAN_TxMailBox_TypeDef.TIR / CAN_FIFOMailBox_TypeDef.RIR */
+#define CAN_IR_TXRQ		0x00000001U
+#define CAN_IR_RTR		0x00000002U
+#define CAN_IR_IDE		0x00000004U
+
+#define CAN_TSR_RQCP( mb )	( CAN_TSR_RQCP0 << ( 8 * ( mb ) ) )
+#define CAN_TSR_TXOK( mb )	( CAN_TSR_TXOK0 << ( 8 * ( mb ) ) )
+#define CAN_TSR_ABRQ( mb )	( CAN_TSR_ABRQ0 << ( 8 * ( mb ) ) )
+#define CAN_TSR_TME_ALL		( CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2 )
+
+static QActive *can_ao;
+static QEvt can_rx_evt;
+
+static uint8_t can_fmi_map[ 2 ][ CAN_FMI_MAX ];
+
+static CAN_FRAME can_rx_ring[ BSP_CAN_RX_RING ];
+static volatile uint16_t can_rx_head;	/* written by the RX interrupts */
+static volatile uint16_t can_rx_tail;	/* written by the owner */
+
+/* sorted by can_tx_key(), descending: the most urgent frame is last */
+static CAN_FRAME can_tx_queue[ BSP_CAN_TX_QUEUE ];
+static uint8_t can_tx_count;
+static CAN_FRAME can_tx_mailbox[ 3 ];	/* copies for a requeue after abort */
+static uint8_t can_tx_aborting;			/* mailbox bit mask */
+
+static BSP_CAN_STATS can_stats;
+
+/* arbitration order, lower wins. a standard frame wins over an extended
+ * one of the same base id (IDE is recessive).
+ */
+static uint32_t can_tx_key( uint32_t id )
+{
+	if( id & CAN_ID_EXT_FLAG )
+	{
+		return ( ( id & CAN_ID_MASK ) << 1 ) | 1;
+	}
+
+	return ( id & 0x7FF ) << 19;
+}
+
+void bsp_can_init( QActive *ao, enum_t rx_sig )
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	CAN_InitTypeDef CAN_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	can_ao = ao;
+	can_rx_evt.sig = (QSignal)rx_sig;
+	can_rx_evt.poolId_ = 0;
+	can_rx_evt.refCtr_ = 0;
+
+	can_rx_head = 0;
+	can_rx_tail = 0;
+	can_tx_count = 0;
+	can_tx_aborting = 0;
+	memset( &can_stats, 0, sizeof( can_stats ) );
+	memset( can_fmi_map, CAN_INDEX_NONE, sizeof( can_fmi_map ) );
+
+	RCC_APB2PeriphClockCmd( RCC_CAN_GPIO, ENABLE );
+	RCC_APB1PeriphClockCmd( RCC_APB1Periph_CAN1, ENABLE );
+
+	GPIO_PinRemapConfig( GPIO_Remap1_CAN1, ENABLE );
+
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IPU;
+	GPIO_InitStructure.GPIO_Pin = GPIO_PIN_CAN_RX;
+	GPIO_Init( GPIO_PORT_CAN, &GPIO_InitStructure );
+
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+	GPIO_InitStructure.GPIO_Pin = GPIO_PIN_CAN_TX;
+	GPIO_Init( GPIO_PORT_CAN, &GPIO_InitStructure );
+
+	/* automatic bus off recovery and retransmission, TX order by id */
+	CAN_DeInit( CAN1 );
+	CAN_StructInit( &CAN_InitStructure );
+	CAN_InitStructure.CAN_TTCM = DISABLE;
+	CAN_InitStructure.CAN_ABOM = ENABLE;
+	CAN_InitStructure.CAN_AWUM = DISABLE;
+	CAN_InitStructure.CAN_NART = DISABLE;
+	CAN_InitStructure.CAN_RFLM = DISABLE;
+	CAN_InitStructure.CAN_TXFP = DISABLE;
+	CAN_InitStructure.CAN_Mode = CAN_Mode_Normal;
+	CAN_InitStructure.CAN_SJW = CAN_SJW_1tq;
+	CAN_InitStructure.CAN_BS1 = BSP_CAN_BS1;
+	CAN_InitStructure.CAN_BS2 = BSP_CAN_BS2;
+	CAN_InitStructure.CAN_Prescaler = BSP_CAN_PRESCALER;
+	CAN_Init( CAN1, &CAN_InitStructure );
+
+	/* same priority for all three, the ring and queue are not reentrant */
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = BSP_CAN_IRQ_PRIO;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_InitStructure.NVIC_IRQChannel = USB_LP_CAN1_RX0_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+	NVIC_InitStructure.NVIC_IRQChannel = CAN1_RX1_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+	NVIC_InitStructure.NVIC_IRQChannel = USB_HP_CAN1_TX_IRQn;
+	NVIC_Init( &NVIC_InitStructure );
+
+	CAN_ITConfig( CAN1, CAN_IT_FMP0 | CAN_IT_FOV0 | CAN_IT_FMP1 | CAN_IT_FOV1 | CAN_IT_TME, ENABLE );
+}
+
+/**
+ * accept exactly the given ids (data frames), nothing before the first call.
+ *
+ * standard ids take a quarter, extended ids half a filter bank. the banks
+ * alternate between the two FIFOs, so a burst is spread over both.
+ *
+ * @param ids 11 bit, or 29 bit | CAN_ID_EXT_FLAG
+ * @return 0 when they do not fit into BSP_CAN_FILTER_BANKS, nothing changed
+ */
+uint8_t bsp_can_filter_set( uint32_t const *ids, uint8_t n )
+{
+	uint16_t n_std = 0;
+	uint16_t n_ext;
+	uint32_t reg[ 4 ];
+	uint8_t idx[ 4 ];
+	uint8_t fmi[ 2 ] = { 0, 0 };
+	uint8_t bank = 0;
+	uint8_t ext, per_bank, k, i, j, fifo;
+
+	Q_REQUIRE_ID( 100, n < CAN_INDEX_NONE );
+
+	for( i = 0; i < n; i++ )
+	{
+		n_std += ( 0 == ( ids[ i ] & CAN_ID_EXT_FLAG ) );
+	}
+	n_ext = n - n_std;
+
+	if( ( n_std + 3 ) / 4 + ( n_ext + 1 ) / 2 > BSP_CAN_FILTER_BANKS )
+	{
+		return 0;
+	}
+
+	CAN1->FMR |= CAN_FMR_FINIT;
+	CAN1->FA1R = 0;
+	memset( can_fmi_map, CAN_INDEX_NONE, sizeof( can_fmi_map ) );
+
+	for( ext = 0; ext < 2; ext++ )
+	{
+		per_bank = ext ? 2 : 4;
+		i = 0;
+
+		while( i < n )
+		{
+			/* collect the ids of one bank */
+			for( k = 0; k < per_bank && i < n; i++ )
+			{
+				if( ( 0 != ( ids[ i ] & CAN_ID_EXT_FLAG ) ) != ext )
+				{
+					continue;
+				}
+
+				if( ext )
+				{
+					reg[ k ] = ( ( ids[ i ] & CAN_ID_MASK ) << 3 ) | CAN_IR_IDE;
+				}
+				else
+				{
+					reg[ k ] = ( ids[ i ] & 0x7FF ) << 5;
+				}
+				idx[ k++ ] = i;
+			}
+
+			if( 0 == k )
+			{
+				break;
+			}
+
+			/* a partly used bank repeats its last id */
+			for( j = k; j < per_bank; j++ )
+			{
+				reg[ j ] = reg[ k - 1 ];
+				idx[ j ] = idx[ k - 1 ];
+			}
+
+			fifo = bank & 1;
+
+			CAN1->FM1R |= 1U << bank;	/* list mode */
+			if( ext )
+			{
+				CAN1->FS1R |= 1U << bank;
+				CAN1->sFilterRegister[ bank ].FR1 = reg[ 0 ];
+				CAN1->sFilterRegister[ bank ].FR2 = reg[ 1 ];
+			}
+			else
+			{
+				CAN1->FS1R &= ~( 1U << bank );
+				CAN1->sFilterRegister[ bank ].FR1 = reg[ 0 ] | ( reg[ 1 ] << 16 );
+				CAN1->sFilterRegister[ bank ].FR2 = reg[ 2 ] | ( reg[ 3 ] << 16 );
+			}
+
+			if( fifo )
+			{
+				CAN1->FFA1R |= 1U << bank;
+			}
+			else
+			{
+				CAN1->FFA1R &= ~( 1U << bank );
+			}
+
+			/* filter numbers count up per FIFO in bank order */
+			for( j = 0; j < per_bank; j++ )
+			{
+				can_fmi_map[ fifo ][ fmi[ fifo ]++ ] = idx[ j ];
+			}
+
+			CAN1->FA1R |= 1U << bank;
+			++bank;
+		}
+	}
+
+	CAN1->FMR &= ~CAN_FMR_FINIT;
+
+	return 1;
+}
+
+/**
+ * take the oldest received frame, called by the owner only.
+ *
+ * @return 0 when the ring is empty
+ */
+uint8_t bsp_can_read( CAN_FRAME *frame )
+{
+	uint16_t tail = can_rx_tail;
+
+	if( tail == can_rx_head )
+	{
+		return 0;
+	}
+
+	*frame = can_rx_ring[ tail & RX_RING_MASK ];
+	can_rx_tail = tail + 1;
+
+	return 1;
+}
+
+static void can_tx_write( uint8_t mb, CAN_FRAME const *frame )
+{
+	CAN_TxMailBox_TypeDef *box = &CAN1->sTxMailBox[ mb ];
+	uint32_t tir;
+
+	if( frame->id & CAN_ID_EXT_FLAG )
+	{
+		tir = ( ( frame->id & CAN_ID_MASK ) << 3 ) | CAN_IR_IDE;
+	}
+	else
+	{
+		tir = ( frame->id & 0x7FF ) << 21;
+	}
+
+	if( frame->id & CAN_ID_RTR_FLAG )
+	{
+		tir |= CAN_IR_RTR;
+	}
+
+	can_tx_mailbox[ mb ] = *frame;
+
+	box->TIR = tir;
+	box->TDTR = frame->dlc & 0x0F;
+	box->TDLR = *(uint32_t const *)&frame->data[ 0 ];
+	box->TDHR = *(uint32_t const *)&frame->data[ 4 ];
+	box->TIR = tir | CAN_IR_TXRQ;
+}
+
+/* mailboxes whose frame may still come back into the queue: the busy
+ * ones, can_tx_load() may abort them, and the aborted ones the TX
+ * interrupt has not seen yet.
+ */
+static uint8_t can_tx_returning( void )
+{
+	uint32_t m = ( ( ~CAN1->TSR & CAN_TSR_TME_ALL ) / CAN_TSR_TME0 ) | can_tx_aborting;
+
+	return (uint8_t)( ( m & 1 ) + ( ( m >> 1 ) & 1 ) + ( ( m >> 2 ) & 1 ) );
+}
+
+/* insert by priority, interrupts masked. */
+static void can_tx_insert( CAN_FRAME const *frame )
+{
+	uint32_t key = can_tx_key( frame->id );
+	uint8_t i = can_tx_count;
+
+	Q_ASSERT_ID( 200, can_tx_count < BSP_CAN_TX_QUEUE );
+
+	/* behind the frames of equal priority, they go first */
+	while( i > 0 && can_tx_key( can_tx_queue[ i - 1 ].id ) <= key )
+	{
+		can_tx_queue[ i ] = can_tx_queue[ i - 1 ];
+		--i;
+	}
+
+	can_tx_queue[ i ] = *frame;
+	++can_tx_count;
+}
+
+/* move queued frames into the mailboxes, interrupts masked. */
+static void can_tx_load( void )
+{
+	uint32_t tsr;
+	uint32_t key, worst_key;
+	uint8_t mb, worst;
+
+	while( can_tx_count != 0 )
+	{
+		tsr = CAN1->TSR;
+
+		if( tsr & CAN_TSR_TME_ALL )
+		{
+			mb = ( tsr & CAN_TSR_CODE ) >> 24;	/* next empty mailbox */
+			can_tx_write( mb, &can_tx_queue[ --can_tx_count ] );
+			continue;
+		}
+
+		/* all busy: preempt the least urgent one if the queue beats it */
+		worst = 3;
+		worst_key = 0;
+		for( mb = 0; mb < 3; mb++ )
+		{
+			key = can_tx_key( can_tx_mailbox[ mb ].id );
+			if( 0 == ( can_tx_aborting & ( 1 << mb ) ) && ( 3 == worst || key > worst_key ) )
+			{
+				worst = mb;
+				worst_key = key;
+			}
+		}
+
+		if( worst < 3 && can_tx_key( can_tx_queue[ can_tx_count - 1 ].id ) < worst_key )
+		{
+			can_tx_aborting |= 1 << worst;
+			CAN1->TSR = CAN_TSR_ABRQ( worst );
+			++can_stats.tx_preempts;
+		}
+		break;
+	}
+}
+
+/**
+ * queue a frame for transmission, called from tasks.
+ *
+ * @return 0 when the queue is full
+ */
+uint8_t bsp_can_send( CAN_FRAME const *frame )
+{
+	uint32_t primask;
+	uint8_t ok = 0;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	/* room is kept for every mailbox frame that may be aborted later */
+	if( can_tx_count + can_tx_returning() < BSP_CAN_TX_QUEUE )
+	{
+		can_tx_insert( frame );
+		can_tx_load();
+		ok = 1;
+	}
+
+	__set_PRIMASK( primask );
+
+	return ok;
+}
+
+void bsp_can_stats( BSP_CAN_STATS *stats )
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	*stats = can_stats;
+
+	__set_PRIMASK( primask );
+}
+
+/* empty both FIFOs into the ring. */
+static void can_rx_drain( void )
+{
+	BaseType_t woken = pdFALSE;
+	uint32_t t0 = bsp_dwt_get_cycles();
+	uint16_t head = can_rx_head;
+	uint16_t first = head;
+	CAN_FIFOMailBox_TypeDef *box;
+	CAN_FRAME *frame;
+	volatile uint32_t *rfr;
+	uint32_t rir, rdtr, fmi;
+	uint8_t fifo;
+
+	for( fifo = 0; fifo < 2; fifo++ )
+	{
+		rfr = fifo ? &CAN1->RF1R : &CAN1->RF0R;
+		box = &CAN1->sFIFOMailBox[ fifo ];
+
+		while( *rfr & CAN_RF0R_FMP0 )
+		{
+			if( (uint16_t)( head - can_rx_tail ) < BSP_CAN_RX_RING )
+			{
+				frame = &can_rx_ring[ head & RX_RING_MASK ];
+
+				rir = box->RIR;
+				if( rir & CAN_IR_IDE )
+				{
+					frame->id = ( rir >> 3 ) | CAN_ID_EXT_FLAG;
+				}
+				else
+				{
+					frame->id = rir >> 21;
+				}
+				if( rir & CAN_IR_RTR )
+				{
+					frame->id |= CAN_ID_RTR_FLAG;
+				}
+
+				rdtr = box->RDTR;
+				fmi = ( rdtr >> 8 ) & 0xFF;
+				frame->dlc = rdtr & 0x0F;
+				frame->index = fmi < CAN_FMI_MAX ? can_fmi_map[ fifo ][ fmi ] : CAN_INDEX_NONE;
+				*(uint32_t *)&frame->data[ 0 ] = box->RDLR;
+				*(uint32_t *)&frame->data[ 4 ] = box->RDHR;
+
+				++head;
+			}
+			else
+			{
+				++can_stats.rx_overruns;
+			}
+
+			*rfr = CAN_RF0R_RFOM0;
+		}
+
+		if( *rfr & CAN_RF0R_FOVR0 )
+		{
+			*rfr = CAN_RF0R_FOVR0;
+			++can_stats.rx_overruns;
+		}
+	}
+
+	can_rx_head = head;
+	can_stats.rx_frames += (uint16_t)( head - first );
+
+	/* the owner reads until empty, it only needs waking when it was */
+	if( head != first && first == can_rx_tail )
+	{
+		QACTIVE_POST_FROM_ISR( can_ao, &can_rx_evt, &woken, &can_rx_head );
+	}
+
+	can_stats.rx_cycles += bsp_dwt_get_cycles() - t0;
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+#if !BSP_USB_DEVICE
+
+void USB_LP_CAN1_RX0_IRQHandler( void )
+{
+	can_rx_drain();
+}
+
+#endif /* !BSP_USB_DEVICE */
+
+void CAN1_RX1_IRQHandler( void )
+{
+	can_rx_drain();
+}
+
+void USB_HP_CAN1_TX_IRQHandler( void )
+{
+	uint32_t tsr = CAN1->TSR;
+	uint8_t mb;
+
+	for( mb = 0; mb < 3; mb++ )
+	{
+		if( 0 == ( tsr & CAN_TSR_RQCP( mb ) ) )
+		{
+			continue;
+		}
+
+		CAN1->TSR = CAN_TSR_RQCP( mb );
+
+		if( tsr & CAN_TSR_TXOK( mb ) )
+		{
+			++can_stats.tx_frames;
+		}
+		else if( can_tx_aborting & ( 1 << mb ) )
+		{
+			can_tx_insert( &can_tx_mailbox[ mb ] );
+		}
+
+		can_tx_aborting &= ~( 1 << mb );
+	}
+
+	can_tx_load();
+}
@@ -0,0 +1,81 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_CAN_H
+#define _BSP_CAN_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/* CAN1 remapped to RX PB8, TX PB9.
+ * CAN and USB share their SRAM and the RX0/TX interrupt vectors on the
+ * F103, this driver owns USB_LP_CAN1_RX0 and USB_HP_CAN1_TX. with
+ * BSP_USB_DEVICE (stm32f10x_conf.h) the USB device takes USB_LP_CAN1_RX0
+ * and CAN is not used.
+ */
+#define RCC_CAN_GPIO			( RCC_APB2Periph_GPIOB | RCC_APB2Periph_AFIO )
+#define GPIO_PORT_CAN			GPIOB
+#define GPIO_PIN_CAN_RX			GPIO_Pin_8
+#define GPIO_PIN_CAN_TX			GPIO_Pin_9
+
+/* 36MHz / 4 / ( 1 + 6 + 2 ) tq = 1Mbit, sample point 78% */
+#define BSP_CAN_PRESCALER		4
+#define BSP_CAN_BS1				CAN_BS1_6tq
+#define BSP_CAN_BS2				CAN_BS2_2tq
+
+/* must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY (5). */
+#define BSP_CAN_IRQ_PRIO		6
+
+/* received frames between ISR and the owner, must be a power of 2. */
+#ifndef BSP_CAN_RX_RING
+#define BSP_CAN_RX_RING			64
+#endif
+
+/* frames waiting for a TX mailbox. */
+#ifndef BSP_CAN_TX_QUEUE
+#define BSP_CAN_TX_QUEUE		16
+#endif
+
+/* filter banks: 4 standard or 2 extended ids each. */
+#define BSP_CAN_FILTER_BANKS	14
+
+/* CAN_FRAME id flags */
+#define CAN_ID_EXT_FLAG			0x80000000U
+#define CAN_ID_RTR_FLAG			0x40000000U
+#define CAN_ID_MASK				0x1FFFFFFFU
+
+#define CAN_INDEX_NONE			0xFF
+
+typedef struct
+{
+	uint32_t id;		/* 11 or 29 bit id | CAN_ID_xxx_FLAG */
+	uint8_t data[ 8 ];
+	uint8_t dlc;
+	uint8_t index;		/* rx: position of id in bsp_can_filter_set() */
+} CAN_FRAME;
+
+typedef struct
+{
+	uint32_t rx_frames;
+	uint32_t rx_overruns;	/* ring or hardware FIFO full */
+	uint32_t rx_cycles;		/* spent in the RX interrupts */
+	uint32_t tx_frames;
+	uint32_t tx_preempts;	/* mailboxes aborted for a higher priority frame */
+} BSP_CAN_STATS;
+
+void bsp_can_init( QActive *ao, enum_t rx_sig );
+uint8_t bsp_can_filter_set( uint32_t const *ids, uint8_t n );
+
+uint8_t bsp_can_read( CAN_FRAME *frame );
+uint8_t bsp_can_send( CAN_FRAME const *frame );
+
+void bsp_can_stats( BSP_CAN_STATS *stats );
+
+#endif /* _BSP_CAN_H */
@@ -0,0 +1,67 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_CRC_H
+#define _BSP_CRC_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/*
+ * CRC-32 as computed by the CRC unit: polynomial 0x04C11DB7, not reflected,
+ * no final xor, fed with 32 bit little endian words. bytes after the last
+ * whole word are taken one by one, msb first. start with BSP_CRC_INIT.
+ *
+ * a CRC may be continued with the result of a previous call as long as
+ * that call had a multiple of 4 bytes.
+ */
+#define BSP_CRC_INIT			0xFFFFFFFFU
+
+/* memory to memory DMA channel, any one no other driver claims. channel 4
+ * is free (1 ADC, 2 and 3 SPI, 6 and 7 I2C), a board using it defines all
+ * four.
+ */
+#ifndef BSP_CRC_DMA_CH
+#define BSP_CRC_DMA_CH			DMA1_Channel4
+#define BSP_CRC_DMA_IRQn		DMA1_Channel4_IRQn
+#define BSP_CRC_DMA_IT_TC		DMA1_IT_TC4
+#define BSP_CRC_DMA_IRQHandler	DMA1_Channel4_IRQHandler
+#endif
+
+/* must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY (5). */
+#define BSP_CRC_IRQ_PRIO		7
+
+/* request descriptor, owned by the caller until the done event. */
+typedef struct CRC_REQ
+{
+	struct CRC_REQ *next;	/* used by the request queue */
+
+	void const *buf;		/* word aligned for DMA, else fed by the cpu */
+	uint32_t len;			/* bytes */
+	uint32_t crc;			/* in: start value, out: result */
+
+	QActive *ao;			/* gets sig with CRC_DONE_EVT */
+	enum_t sig;
+} CRC_REQ;
+
+typedef struct
+{
+	QEvt super;
+
+	CRC_REQ *req;
+} CRC_DONE_EVT;
+
+void bsp_crc_init( void );
+
+uint32_t bsp_crc_sw( uint32_t crc, void const *buf, uint32_t len );
+uint32_t bsp_crc_calc( uint32_t crc, void const *buf, uint32_t len );
+void bsp_crc_submit( CRC_REQ *req );
+
+#endif /* _BSP_CRC_H */
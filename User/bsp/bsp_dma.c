@@ -0,0 +1,39 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "bsp_dma.h"
+
+Q_DEFINE_THIS_MODULE("bsp_dma")
+
+/* the channel registers are 0x14 bytes apart */
+#define DMA_CH_STRIDE	( DMA1_Channel2_BASE - DMA1_Channel1_BASE )
+#define DMA_CH_NUM		7
+
+static uint8_t dma_claimed;		/* bit n: DMA1 channel n + 1 */
+
+/**
+ * take ch for the calling driver, asserts if it already has an owner.
+ */
+void bsp_dma_claim( DMA_Channel_TypeDef *ch )
+{
+	uint32_t n = ( (uint32_t)ch - DMA1_Channel1_BASE ) / DMA_CH_STRIDE;
+	uint32_t primask;
+	uint8_t taken;
+
+	Q_REQUIRE_ID( 100, n < DMA_CH_NUM );
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	taken = dma_claimed & ( 1U << n );
+	dma_claimed |= 1U << n;
+
+	__set_PRIMASK( primask );
+
+	Q_ASSERT_ID( 110, 0 == taken );
+}
@@ -0,0 +1,26 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_DMA_H
+#define _BSP_DMA_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/*
+ * DMA1 has one request line per channel and the drivers keep a channel
+ * for good (registers, interrupt handler). a driver claims its channels
+ * in its init, a second claim of the same channel asserts there instead of
+ * two drivers silently taking turns at the registers.
+ */
+
+void bsp_dma_claim( DMA_Channel_TypeDef *ch );
+
+#endif /* _BSP_DMA_H */
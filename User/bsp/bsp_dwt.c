@@ -0,0 +1,57 @@
+
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "bsp_dwt.h"
+
+/* 64 bit cycle counter, high word is extended in software. */
+static uint32_t dwt_cycles_hi;
+static uint32_t dwt_cycles_last;
+
+void bsp_dwt_init( void )
+{
+	/* enable the trace block, otherwise DWT is not clocked */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	dwt_cycles_hi   = 0;
+	dwt_cycles_last = 0;
+}
+
+/**
+ * read the 64 bit cycle counter.
+ *
+ * a wraparound of CYCCNT is detected by comparing with the previous read,
+ * so this must be called at least once per wrap period (~59.6s at 72MHz),
+ * e.g. from the system tick. callable from tasks and interrupts.
+ *
+ * @return cycles since bsp_dwt_init()
+ */
+uint64_t bsp_dwt_get_cycles64( void )
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now;
+	uint64_t cycles;
+
+	__disable_irq();
+
+	now = DWT->CYCCNT;
+	if( now < dwt_cycles_last )
+	{
+		++dwt_cycles_hi;
+	}
+	dwt_cycles_last = now;
+
+	cycles = ( (uint64_t)dwt_cycles_hi << 32 ) | now;
+
+	__set_PRIMASK( primask );
+
+	return cycles;
+}
@@ -0,0 +1,22 @@
+
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_DWT_H
+#define _BSP_DWT_H
+
+#include "stm32f10x.h"
+
+/* DWT CYCCNT, 72MHz, 32 bit wraps every ~59.6s. */
+#define bsp_dwt_get_cycles()	( DWT->CYCCNT )
+
+void bsp_dwt_init( void );
+uint64_t bsp_dwt_get_cycles64( void );
+
+#endif /* _BSP_DWT_H */
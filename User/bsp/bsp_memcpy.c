@@ -0,0 +1,64 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <string.h>
+
+#include "SEGGER_RTT.h"
+
+#include "bsp_dwt.h"
+#include "bsp_memcpy.h"
+
+typedef void ( *BSP_MEMCPY_FN )( void *dst, void const *src, unsigned n );
+
+static void bsp_memcpy_inline( void *dst, void const *src, unsigned n )
+{
+	bsp_memcpy( dst, src, n );
+}
+
+static void bsp_memcpy_lib( void *dst, void const *src, unsigned n )
+{
+	memcpy( dst, src, n );
+}
+
+/* both called the same way, so the call is in both counts */
+static BSP_MEMCPY_FN volatile const bsp_memcpy_fn[ 2 ] = { bsp_memcpy_inline, bsp_memcpy_lib };
+
+/**
+ * print the cycles of bsp_memcpy() and of microlib memcpy() for the sizes
+ * of RTT records, with both sides aligned, the destination or the source
+ * one byte off, and both one byte off.
+ *
+ * @param RTT up buffer index
+ */
+void bsp_memcpy_bench( unsigned buffer_index )
+{
+	static uint32_t dst[ 20 ], src[ 20 ];
+	static uint8_t const lens[] = { 2, 4, 8, 16, 29, 64 };
+	static uint8_t const offs[][ 2 ] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+	uint32_t t0, cycles[ 2 ];
+	uint8_t i, k, f;
+
+	SEGGER_RTT_printf( buffer_index, "\r\n len  d s  bsp_memcpy  memcpy  cycles\r\n" );
+
+	for( i = 0; i < sizeof( lens ); i++ )
+	{
+		for( k = 0; k < sizeof( offs ) / sizeof( offs[ 0 ] ); k++ )
+		{
+			for( f = 0; f < 2; f++ )
+			{
+				t0 = bsp_dwt_get_cycles();
+				bsp_memcpy_fn[ f ]( (uint8_t *)dst + offs[ k ][ 0 ], (uint8_t const *)src + offs[ k ][ 1 ], lens[ i ] );
+				cycles[ f ] = bsp_dwt_get_cycles() - t0;
+			}
+
+			SEGGER_RTT_printf( buffer_index, " %3u  %u %u  %10u  %6u\r\n", (unsigned)lens[ i ],
+							   (unsigned)offs[ k ][ 0 ], (unsigned)offs[ k ][ 1 ],
+							   (unsigned)cycles[ 0 ], (unsigned)cycles[ 1 ] );
+		}
+	}
+}
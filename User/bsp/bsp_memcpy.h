@@ -0,0 +1,125 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_MEMCPY_H
+#define _BSP_MEMCPY_H
+
+#include <stdint.h>
+
+/*
+ * inline copy for the RTT ring writes, see SEGGER_RTT_MEMCPY in
+ * SEGGER_RTT_Conf.h. microlib memcpy() is a call and a byte loop, most RTT
+ * records are a few bytes of binary log or trace.
+ *
+ * 1, 2, 4 and 8 bytes are single stores when aligned. aligned blocks go in
+ * groups of 4 words, which the compiler turns into LDM/STM. otherwise from
+ * BSP_MEMCPY_UNALIGNED bytes on the destination is aligned byte by byte
+ * and the words are read with single LDR from the misaligned source: the
+ * Cortex-M3 splits an unaligned LDR/STR on the bus itself (CCR UNALIGN_TRP
+ * stays 0), only LDM/STM/LDRD fault. the tail goes byte by byte.
+ */
+
+/* misaligned copies shorter than this go byte by byte */
+#ifndef BSP_MEMCPY_UNALIGNED
+#define BSP_MEMCPY_UNALIGNED	8
+#endif
+
+/* RTT key of bsp_memcpy_bench() */
+#define BSP_MEMCPY_BENCH_KEY	'm'
+
+/* a word at any address, a single LDR */
+#if defined( __CC_ARM )
+#define BSP_MEMCPY_LDR( p_ )	( *(__packed uint32_t const *)( p_ ) )
+#else
+typedef struct
+{
+	uint32_t w;
+} __attribute__( ( packed ) ) BSP_MEMCPY_WORD;
+#define BSP_MEMCPY_LDR( p_ )	( ( (BSP_MEMCPY_WORD const *)( p_ ) )->w )
+#endif
+
+static __inline void bsp_memcpy( void *dst, void const *src, unsigned n )
+{
+	uint8_t *d = (uint8_t *)dst;
+	uint8_t const *s = (uint8_t const *)src;
+	uintptr_t align = (uintptr_t)d | (uintptr_t)s;
+
+	/* before the word path, which would take 2 bytes one by one */
+	if( 2 == n && 0 == ( align & 1U ) )
+	{
+		*(uint16_t *)d = *(uint16_t const *)s;
+		return;
+	}
+
+	if( 0 == ( align & 3U ) )
+	{
+		uint32_t *dw = (uint32_t *)d;
+		uint32_t const *sw = (uint32_t const *)s;
+
+		if( 4 == n )
+		{
+			dw[ 0 ] = sw[ 0 ];
+			return;
+		}
+
+		if( 8 == n )
+		{
+			dw[ 0 ] = sw[ 0 ];
+			dw[ 1 ] = sw[ 1 ];
+			return;
+		}
+
+		for( ; n >= 16; n -= 16 )
+		{
+			uint32_t w0 = sw[ 0 ], w1 = sw[ 1 ], w2 = sw[ 2 ], w3 = sw[ 3 ];
+
+			dw[ 0 ] = w0;
+			dw[ 1 ] = w1;
+			dw[ 2 ] = w2;
+			dw[ 3 ] = w3;
+			dw += 4;
+			sw += 4;
+		}
+
+		for( ; n >= 4; n -= 4 )
+		{
+			*dw++ = *sw++;
+		}
+
+		d = (uint8_t *)dw;
+		s = (uint8_t const *)sw;
+	}
+	else if( n >= BSP_MEMCPY_UNALIGNED )
+	{
+		uint32_t *dw;
+
+		for( ; ( (uintptr_t)d & 3U ) != 0; n-- )
+		{
+			*d++ = *s++;
+		}
+
+		dw = (uint32_t *)d;
+		for( ; n >= 4; n -= 4 )
+		{
+			*dw++ = BSP_MEMCPY_LDR( s );
+			s += 4;
+		}
+
+		d = (uint8_t *)dw;
+	}
+
+	while( n-- )
+	{
+		*d++ = *s++;
+	}
+}
+
+void bsp_memcpy_bench( unsigned buffer_index );
+
+#endif /* _BSP_MEMCPY_H */
@@ -0,0 +1,205 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "bsp_dma.h"
+#include "bsp_spi.h"
+
+Q_DEFINE_THIS_MODULE("bsp_spi")
+
+/*
+ * runs a chain of transfers back to back. the RX DMA transfer complete
+ * interrupt ends a transfer (all bytes clocked in), releases its chip
+ * select, reports it and programs the DMA for the next one, so there is
+ * no task round trip between transfers. when the chain is done the bus
+ * owner gets idle_sig and may start the next chain.
+ */
+
+static struct
+{
+	GPIO_TypeDef *port;
+	uint16_t pin;
+} const spi_cs[ BSP_SPI_DEVICES ] = BSP_SPI_CS_TABLE;
+
+static QActive *spi_ao;
+static QEvt spi_idle_evt;
+
+static SPI_XFER *volatile spi_cur;
+
+static uint8_t const spi_dummy_tx = 0xFF;
+static uint8_t spi_dummy_rx;
+
+static void spi_xfer_start( SPI_XFER *x )
+{
+	Q_ASSERT_ID( 100, x->dev < BSP_SPI_DEVICES && x->len != 0 );
+
+	GPIO_ResetBits( spi_cs[ x->dev ].port, spi_cs[ x->dev ].pin );
+
+	/* a missing buffer is replaced by one byte, not incremented */
+	if( x->rx != NULL )
+	{
+		DMA1_Channel2->CMAR = (uint32_t)x->rx;
+		DMA1_Channel2->CCR |= DMA_MemoryInc_Enable;
+	}
+	else
+	{
+		DMA1_Channel2->CMAR = (uint32_t)&spi_dummy_rx;
+		DMA1_Channel2->CCR &= ~DMA_MemoryInc_Enable;
+	}
+
+	if( x->tx != NULL )
+	{
+		DMA1_Channel3->CMAR = (uint32_t)x->tx;
+		DMA1_Channel3->CCR |= DMA_MemoryInc_Enable;
+	}
+	else
+	{
+		DMA1_Channel3->CMAR = (uint32_t)&spi_dummy_tx;
+		DMA1_Channel3->CCR &= ~DMA_MemoryInc_Enable;
+	}
+
+	DMA1_Channel2->CNDTR = x->len;
+	DMA1_Channel3->CNDTR = x->len;
+
+	/* RX first, so no received byte is missed */
+	DMA_Cmd( DMA1_Channel2, ENABLE );
+	DMA_Cmd( DMA1_Channel3, ENABLE );
+}
+
+void bsp_spi_init( QActive *ao, enum_t idle_sig )
+{
+	GPIO_InitTypeDef GPIO_InitStructure;
+	SPI_InitTypeDef SPI_InitStructure;
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+	uint8_t i;
+
+	spi_ao = ao;
+	spi_idle_evt.sig = (QSignal)idle_sig;
+	spi_idle_evt.poolId_ = 0;
+	spi_idle_evt.refCtr_ = 0;
+	spi_cur = NULL;
+
+	RCC_APB2PeriphClockCmd( RCC_SPI_GPIO | RCC_APB2Periph_SPI1, ENABLE );
+	RCC_AHBPeriphClockCmd( RCC_AHBPeriph_DMA1, ENABLE );
+
+	GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF_PP;
+	GPIO_InitStructure.GPIO_Pin = GPIO_PIN_SPI_SCK | GPIO_PIN_SPI_MOSI;
+	GPIO_Init( GPIO_PORT_SPI, &GPIO_InitStructure );
+
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_IN_FLOATING;
+	GPIO_InitStructure.GPIO_Pin = GPIO_PIN_SPI_MISO;
+	GPIO_Init( GPIO_PORT_SPI, &GPIO_InitStructure );
+
+	GPIO_InitStructure.GPIO_Mode = GPIO_Mode_Out_PP;
+	for( i = 0; i < BSP_SPI_DEVICES; i++ )
+	{
+		GPIO_SetBits( spi_cs[ i ].port, spi_cs[ i ].pin );
+		GPIO_InitStructure.GPIO_Pin = spi_cs[ i ].pin;
+		GPIO_Init( spi_cs[ i ].port, &GPIO_InitStructure );
+	}
+
+	/* mode 0, 8 bit, MSB first */
+	SPI_InitStructure.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
+	SPI_InitStructure.SPI_Mode = SPI_Mode_Master;
+	SPI_InitStructure.SPI_DataSize = SPI_DataSize_8b;
+	SPI_InitStructure.SPI_CPOL = SPI_CPOL_Low;
+	SPI_InitStructure.SPI_CPHA = SPI_CPHA_1Edge;
+	SPI_InitStructure.SPI_NSS = SPI_NSS_Soft;
+	SPI_InitStructure.SPI_BaudRatePrescaler = BSP_SPI_PRESCALER;
+	SPI_InitStructure.SPI_FirstBit = SPI_FirstBit_MSB;
+	SPI_InitStructure.SPI_CRCPolynomial = 7;
+	SPI_Init( SPI1, &SPI_InitStructure );
+
+	/* addresses and lengths are set per transfer */
+	bsp_dma_claim( DMA1_Channel2 );
+	DMA_DeInit( DMA1_Channel2 );
+	DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&SPI1->DR;
+	DMA_InitStructure.DMA_MemoryBaseAddr = (uint32_t)&spi_dummy_rx;
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralSRC;
+	DMA_InitStructure.DMA_BufferSize = 1;
+	DMA_InitStructure.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+	DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+	DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+	DMA_InitStructure.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+	DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+	DMA_InitStructure.DMA_M2M = DMA_M2M_Disable;
+	DMA_Init( DMA1_Channel2, &DMA_InitStructure );
+	DMA_ITConfig( DMA1_Channel2, DMA_IT_TC, ENABLE );
+
+	bsp_dma_claim( DMA1_Channel3 );
+	DMA_DeInit( DMA1_Channel3 );
+	DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralDST;
+	DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+	DMA_Init( DMA1_Channel3, &DMA_InitStructure );
+
+	NVIC_InitStructure.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = BSP_SPI_IRQ_PRIO;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init( &NVIC_InitStructure );
+
+	SPI_I2S_DMACmd( SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE );
+	SPI_Cmd( SPI1, ENABLE );
+}
+
+/**
+ * run a chain of transfers, called by the bus owner while the bus is idle.
+ */
+void bsp_spi_start( SPI_XFER *chain )
+{
+	Q_REQUIRE_ID( 200, spi_cur == NULL && chain != NULL );
+
+	spi_cur = chain;
+	spi_xfer_start( chain );
+}
+
+uint8_t bsp_spi_busy( void )
+{
+	return spi_cur != NULL;
+}
+
+void DMA1_Channel2_IRQHandler( void )
+{
+	BaseType_t woken = pdFALSE;
+	SPI_XFER *x = spi_cur;
+	SPI_XFER *next = x->next;
+	SPI_DONE_EVT *e;
+
+	DMA_ClearITPendingBit( DMA1_IT_TC2 );
+	DMA_Cmd( DMA1_Channel2, DISABLE );
+	DMA_Cmd( DMA1_Channel3, DISABLE );
+
+	if( next == NULL || next->dev != x->dev || 0 == ( x->flags & SPI_XFER_CS_HOLD ) )
+	{
+		GPIO_SetBits( spi_cs[ x->dev ].port, spi_cs[ x->dev ].pin );
+	}
+
+	/* next one first, the bus keeps running while the event is posted */
+	spi_cur = next;
+	if( next != NULL )
+	{
+		spi_xfer_start( next );
+	}
+
+	/* x belongs to its owner again after this post */
+	if( x->ao != NULL )
+	{
+		e = Q_NEW_FROM_ISR( SPI_DONE_EVT, x->sig );
+		e->xfer = x;
+		QACTIVE_POST_FROM_ISR( x->ao, &e->super, &woken, &spi_cur );
+	}
+
+	if( NULL == next )
+	{
+		QACTIVE_POST_FROM_ISR( spi_ao, &spi_idle_evt, &woken, &spi_cur );
+	}
+
+	portEND_SWITCHING_ISR( woken );
+}
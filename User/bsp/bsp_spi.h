@@ -0,0 +1,66 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_SPI_H
+#define _BSP_SPI_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/* SPI1, SCK PA5, MISO PA6, MOSI PA7, DMA1 channel 2 (RX) and 3 (TX). */
+#define RCC_SPI_GPIO			( RCC_APB2Periph_GPIOA | RCC_APB2Periph_GPIOB )
+#define GPIO_PORT_SPI			GPIOA
+#define GPIO_PIN_SPI_SCK		GPIO_Pin_5
+#define GPIO_PIN_SPI_MISO		GPIO_Pin_6
+#define GPIO_PIN_SPI_MOSI		GPIO_Pin_7
+
+/* SCK = 72MHz / 8 = 9MHz */
+#define BSP_SPI_PRESCALER		SPI_BaudRatePrescaler_8
+
+/* chip selects, active low, one per device on the bus. */
+#define BSP_SPI_CS_TABLE		{ { GPIOA, GPIO_Pin_4 }, { GPIOB, GPIO_Pin_0 } }
+#define BSP_SPI_DEVICES			2
+
+/* must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY (5). */
+#define BSP_SPI_IRQ_PRIO		6
+
+/* keep CS asserted after the transfer when the next one in the chain is for
+ * the same device, e.g. a command followed by its data. the last transfer
+ * of the sequence has no CS_HOLD, spi_bus starts the sequence with it.
+ */
+#define SPI_XFER_CS_HOLD		0x01
+
+/* transaction descriptor, owned by the caller until the done event. */
+typedef struct SPI_XFER
+{
+	struct SPI_XFER *next;	/* used by the bus, chain of transfers */
+
+	uint8_t dev;			/* index into BSP_SPI_CS_TABLE */
+	uint8_t flags;			/* SPI_XFER_xxx */
+	uint16_t len;			/* bytes, > 0 */
+	uint8_t const *tx;		/* NULL: send 0xFF */
+	uint8_t *rx;			/* NULL: discard */
+
+	QActive *ao;			/* gets sig with SPI_DONE_EVT, NULL: none */
+	enum_t sig;
+} SPI_XFER;
+
+typedef struct
+{
+	QEvt super;
+
+	SPI_XFER *xfer;
+} SPI_DONE_EVT;
+
+void bsp_spi_init( QActive *ao, enum_t idle_sig );
+void bsp_spi_start( SPI_XFER *chain );
+uint8_t bsp_spi_busy( void );
+
+#endif /* _BSP_SPI_H */
@@ -0,0 +1,334 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include <string.h>
+
+#include "usb_lib.h"
+
+#include "bsp_usb_stream.h"
+
+Q_DEFINE_THIS_MODULE("bsp_usb_stream")
+
+/*
+ * streaming over two double buffered bulk endpoints.
+ *
+ * in double buffer mode the hardware uses one PMA buffer while software
+ * fills (IN) or drains (OUT) the other, so the host sees no NAK between
+ * packets as long as the ISR keeps up. the buffer used by the hardware is
+ * DTOG, the one used by software is SW_BUF (the DTOG bit of the opposite
+ * direction, toggled by FreeUserBuffer()).
+ *
+ * the ISR refills the IN endpoint from a ring buffer and fills the OUT
+ * data into the buffer given by the application. the active object gets
+ * one event per transfer, not one per packet: IN when the ring ran empty,
+ * OUT when a short packet arrived or the buffer is full.
+ */
+
+#define TX_RING_MASK	( USB_STREAM_TX_RING_SIZE - 1 )
+
+static QActive *usb_stream_ao;
+static enum_t usb_stream_tx_sig;
+static enum_t usb_stream_rx_sig;
+static uint8_t usb_stream_ready;
+
+/* device to host, head written by tasks, tail by the USB ISR. */
+static uint32_t tx_ring[ USB_STREAM_TX_RING_SIZE / 4 ];
+static volatile uint16_t tx_head;
+static volatile uint16_t tx_tail;
+static uint8_t tx_loaded;	/* PMA buffers handed to the hardware, 0..2 */
+static uint8_t tx_zlp;		/* last packet was full size */
+static uint32_t tx_count;	/* bytes of the current transfer */
+
+/* host to device, buffer given by bsp_usb_stream_read(). */
+static uint8_t *rx_buf;
+static uint16_t rx_size;
+static uint16_t rx_len;
+static uint8_t rx_held;		/* PMA buffers filled by the hardware, 0..2 */
+
+static void usb_stream_post( enum_t sig, uint8_t *buf, uint32_t len,
+							 BaseType_t *woken )
+{
+	USB_STREAM_EVT *e;
+
+	if( woken != NULL )
+	{
+		e = Q_NEW_FROM_ISR( USB_STREAM_EVT, sig );
+		e->buf = buf;
+		e->len = len;
+		QACTIVE_POST_FROM_ISR( usb_stream_ao, &e->super, woken, &usb_stream_ao );
+	}
+	else
+	{
+		e = Q_NEW( USB_STREAM_EVT, sig );
+		e->buf = buf;
+		e->len = len;
+		QACTIVE_POST( usb_stream_ao, &e->super, &usb_stream_ao );
+	}
+}
+
+/* fill free IN buffers from the ring, USB interrupt must be masked. */
+static void usb_stream_tx_load( void )
+{
+	uint8_t const *ring = (uint8_t const *)tx_ring;
+	uint32_t stage[ USB_STREAM_MAX_PACKET / 4 ];
+	uint16_t avail, len, first, addr;
+
+	while( tx_loaded < 2 )
+	{
+		avail = (uint16_t)( tx_head - tx_tail );
+
+		if( 0 == avail && 0 == tx_zlp )
+		{
+			break;
+		}
+
+		/* 0 == avail: zero length packet ends a transfer of full packets */
+		len = avail > USB_STREAM_MAX_PACKET ? USB_STREAM_MAX_PACKET : avail;
+
+		addr = ( _GetENDPOINT( USB_STREAM_IN_EP ) & EP_DTOG_RX ) ?
+			   USB_STREAM_IN_BUF1 : USB_STREAM_IN_BUF0;
+
+		first = USB_STREAM_TX_RING_SIZE - ( tx_tail & TX_RING_MASK );
+		if( len <= first )
+		{
+			UserToPMABufferCopy( (uint8_t *)&ring[ tx_tail & TX_RING_MASK ], addr, len );
+		}
+		else
+		{
+			/* packet wraps the ring, the PMA takes whole halfwords only */
+			memcpy( stage, &ring[ tx_tail & TX_RING_MASK ], first );
+			memcpy( (uint8_t *)stage + first, ring, len - first );
+			UserToPMABufferCopy( (uint8_t *)stage, addr, len );
+		}
+
+		if( USB_STREAM_IN_BUF1 == addr )
+		{
+			_SetEPDblBuf1Count( USB_STREAM_IN_EP, EP_DBUF_IN, len );
+		}
+		else
+		{
+			_SetEPDblBuf0Count( USB_STREAM_IN_EP, EP_DBUF_IN, len );
+		}
+
+		tx_tail += len;
+		tx_count += len;
+		tx_zlp = ( USB_STREAM_MAX_PACKET == len );
+
+		FreeUserBuffer( USB_STREAM_IN_EP, EP_DBUF_IN );
+		++tx_loaded;
+	}
+}
+
+/* copy filled OUT buffers to the user buffer, USB interrupt must be masked.
+ * returns 1 when the transfer is complete.
+ */
+static uint8_t usb_stream_rx_drain( void )
+{
+	uint16_t count;
+
+	while( rx_held != 0 && rx_buf != NULL )
+	{
+		if( _GetENDPOINT( USB_STREAM_OUT_EP ) & EP_DTOG_TX )
+		{
+			count = _GetEPDblBuf1Count( USB_STREAM_OUT_EP );
+			PMAToUserBufferCopy( rx_buf + rx_len, USB_STREAM_OUT_BUF1, count );
+		}
+		else
+		{
+			count = _GetEPDblBuf0Count( USB_STREAM_OUT_EP );
+			PMAToUserBufferCopy( rx_buf + rx_len, USB_STREAM_OUT_BUF0, count );
+		}
+
+		/* hand the buffer back, the hardware ACKs into it again */
+		FreeUserBuffer( USB_STREAM_OUT_EP, EP_DBUF_OUT );
+		--rx_held;
+		rx_len += count;
+
+		if( count < USB_STREAM_MAX_PACKET || rx_size - rx_len < USB_STREAM_MAX_PACKET )
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+void bsp_usb_stream_init( QActive *ao, enum_t tx_done_sig, enum_t rx_done_sig )
+{
+	usb_stream_ao     = ao;
+	usb_stream_tx_sig = tx_done_sig;
+	usb_stream_rx_sig = rx_done_sig;
+	usb_stream_ready  = 0;
+
+	tx_head = 0;
+	tx_tail = 0;
+	rx_buf  = NULL;
+}
+
+/**
+ * set up the stream endpoints, called from the USB reset handler.
+ *
+ * pending data of the device to host ring is dropped, a read in progress
+ * is continued after the host configured the device again.
+ */
+void bsp_usb_stream_reset( void )
+{
+	/* IN: both buffers transmit */
+	SetEPType( USB_STREAM_IN_EP, EP_BULK );
+	SetEPDoubleBuff( USB_STREAM_IN_EP );
+	SetEPDblBuffAddr( USB_STREAM_IN_EP, USB_STREAM_IN_BUF0, USB_STREAM_IN_BUF1 );
+	SetEPDblBuffCount( USB_STREAM_IN_EP, EP_DBUF_IN, 0 );
+	ClearDTOG_RX( USB_STREAM_IN_EP );
+	ClearDTOG_TX( USB_STREAM_IN_EP );
+	SetEPRxStatus( USB_STREAM_IN_EP, EP_RX_DIS );
+	SetEPTxStatus( USB_STREAM_IN_EP, EP_TX_VALID );
+
+	/* OUT: both buffers receive */
+	SetEPType( USB_STREAM_OUT_EP, EP_BULK );
+	SetEPDoubleBuff( USB_STREAM_OUT_EP );
+	SetEPDblBuffAddr( USB_STREAM_OUT_EP, USB_STREAM_OUT_BUF0, USB_STREAM_OUT_BUF1 );
+	SetEPDblBuffCount( USB_STREAM_OUT_EP, EP_DBUF_OUT, USB_STREAM_MAX_PACKET );
+	ClearDTOG_RX( USB_STREAM_OUT_EP );
+	ClearDTOG_TX( USB_STREAM_OUT_EP );
+	SetEPTxStatus( USB_STREAM_OUT_EP, EP_TX_DIS );
+	SetEPRxStatus( USB_STREAM_OUT_EP, EP_RX_VALID );
+
+	tx_tail   = tx_head;
+	tx_loaded = 0;
+	tx_zlp    = 0;
+	tx_count  = 0;
+
+	rx_held = 0;
+
+	usb_stream_ready = 1;
+}
+
+/**
+ * queue data for the host, called from tasks.
+ *
+ * @return bytes taken, less than len when the ring is full. the stream
+ *         active object gets tx_done_sig when the ring has been sent.
+ */
+uint16_t bsp_usb_stream_write( uint8_t const *buf, uint16_t len )
+{
+	uint8_t *ring = (uint8_t *)tx_ring;
+	uint16_t space = USB_STREAM_TX_RING_SIZE - (uint16_t)( tx_head - tx_tail );
+	uint16_t head = tx_head & TX_RING_MASK;
+	uint16_t first;
+	uint32_t primask;
+
+	if( len > space )
+	{
+		len = space;
+	}
+
+	first = USB_STREAM_TX_RING_SIZE - head;
+	if( len <= first )
+	{
+		memcpy( &ring[ head ], buf, len );
+	}
+	else
+	{
+		memcpy( &ring[ head ], buf, first );
+		memcpy( ring, buf + first, len - first );
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	tx_head += len;
+	if( usb_stream_ready )
+	{
+		usb_stream_tx_load();
+	}
+
+	__set_PRIMASK( primask );
+
+	return len;
+}
+
+/**
+ * give the buffer for the next host to device transfer, called from tasks.
+ *
+ * the stream active object gets rx_done_sig with the buffer when a short
+ * packet arrived or less than a packet is left. until then the host is
+ * NAKed as soon as both PMA buffers are full.
+ *
+ * @param size at least USB_STREAM_MAX_PACKET
+ */
+void bsp_usb_stream_read( uint8_t *buf, uint16_t size )
+{
+	uint8_t done;
+	uint16_t len;
+	uint32_t primask;
+
+	Q_ASSERT_ID( 100, size >= USB_STREAM_MAX_PACKET );
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	rx_buf  = buf;
+	rx_size = size;
+	rx_len  = 0;
+
+	/* packets that waited for a buffer */
+	done = usb_stream_rx_drain();
+	len  = rx_len;
+	if( done )
+	{
+		rx_buf = NULL;
+	}
+
+	__set_PRIMASK( primask );
+
+	if( done )
+	{
+		usb_stream_post( usb_stream_rx_sig, buf, len, NULL );
+	}
+}
+
+void bsp_usb_stream_in_callback( void )
+{
+	BaseType_t woken = pdFALSE;
+	uint16_t ep = _GetENDPOINT( USB_STREAM_IN_EP );
+
+	/* completions may merge into one interrupt, so ask the hardware:
+	 * a packet is still queued when its buffer (DTOG_TX) is not ours.
+	 */
+	tx_loaded = ( ( ep & EP_DTOG_TX ) != 0 ) != ( ( ep & EP_DTOG_RX ) != 0 );
+
+	usb_stream_tx_load();
+
+	if( 0 == tx_loaded && tx_count != 0 )
+	{
+		usb_stream_post( usb_stream_tx_sig, NULL, tx_count, &woken );
+		tx_count = 0;
+	}
+
+	portEND_SWITCHING_ISR( woken );
+}
+
+void bsp_usb_stream_out_callback( void )
+{
+	BaseType_t woken = pdFALSE;
+	uint16_t ep = _GetENDPOINT( USB_STREAM_OUT_EP );
+	uint8_t *buf = rx_buf;
+
+	/* one buffer filled when the hardware moved on to the other one,
+	 * both when it is back on ours.
+	 */
+	rx_held = ( ( ep & EP_DTOG_RX ) != 0 ) != ( ( ep & EP_DTOG_TX ) != 0 ) ? 1 : 2;
+
+	if( usb_stream_rx_drain() )
+	{
+		rx_buf = NULL;
+		usb_stream_post( usb_stream_rx_sig, buf, rx_len, &woken );
+	}
+
+	portEND_SWITCHING_ISR( woken );
+}
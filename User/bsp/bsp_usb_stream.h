@@ -0,0 +1,61 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _BSP_USB_STREAM_H
+#define _BSP_USB_STREAM_H
+
+#include "stm32f10x.h"
+
+#include "qpc.h"
+
+/* bulk endpoints of the stream, both double buffered. */
+#ifndef USB_STREAM_IN_EP
+#define USB_STREAM_IN_EP		1	/* device to host */
+#endif
+#ifndef USB_STREAM_OUT_EP
+#define USB_STREAM_OUT_EP		2	/* host to device */
+#endif
+
+#define USB_STREAM_MAX_PACKET	64
+
+/* PMA addresses of the four packet buffers, 64 bytes each. */
+#ifndef USB_STREAM_IN_BUF0
+#define USB_STREAM_IN_BUF0		0x100
+#define USB_STREAM_IN_BUF1		0x140
+#define USB_STREAM_OUT_BUF0		0x180
+#define USB_STREAM_OUT_BUF1		0x1C0
+#endif
+
+/* device to host ring buffer, must be a power of 2. */
+#ifndef USB_STREAM_TX_RING_SIZE
+#define USB_STREAM_TX_RING_SIZE	512
+#endif
+
+/* posted to the stream active object when a transfer completed. */
+typedef struct
+{
+	QEvt super;
+
+	uint8_t *buf;	/* rx: buffer given to bsp_usb_stream_read(), tx: NULL */
+	uint32_t len;	/* bytes transferred */
+} USB_STREAM_EVT;
+
+void bsp_usb_stream_init( QActive *ao, enum_t tx_done_sig, enum_t rx_done_sig );
+
+/* call from the Reset property callback, after endpoint 0 is set up. */
+void bsp_usb_stream_reset( void );
+
+uint16_t bsp_usb_stream_write( uint8_t const *buf, uint16_t len );
+void bsp_usb_stream_read( uint8_t *buf, uint16_t size );
+
+/* install as EPx_IN_Callback / EPx_OUT_Callback of the stream endpoints. */
+void bsp_usb_stream_in_callback( void );
+void bsp_usb_stream_out_callback( void );
+
+#endif /* _BSP_USB_STREAM_H */
@@ -47,6 +47,14 @@
 #include "stm32f10x_wwdg.h"
 #include "misc.h"   /* NVICSysTickĸ߼(CMSIS) */
 
+/* USB and CAN share their SRAM and the USB_LP_CAN1_RX0 / USB_HP_CAN1_TX
+ * vectors on the F103, only one of them is built in.
+ * 1: the USB CDC stream (User/usb), 0: CAN (bsp_can.c)
+ */
+#ifndef BSP_USB_DEVICE
+#define BSP_USB_DEVICE	0
+#endif
+
 /*
 	ûѡǷʹST̼ĶԹܡʹܶԵķ֣
 	(1) CԤѡжUSE_FULL_ASSERT
@@ -156,6 +156,17 @@ typedef struct QActive {
     /*! QF priority (1..#QF_MAX_ACTIVE) of this active object. */
     uint8_t prio;
 
+#ifdef QF_ACTIVE_URGENT
+    /*! urgent lane of the event queue, see QActive_urgentInit() */
+    QEQueue urgQueue;
+
+    /*! max. urgent events dispatched in a row while normal ones wait */
+    uint8_t urgBurst;
+
+    /*! urgent events dispatched in a row so far */
+    uint8_t urgRun;
+#endif
+
 #ifdef qxk_h  /* QXK kernel used? */
     /*! QF start priority (1..#QF_MAX_ACTIVE) of this active object. */
     uint8_t startPrio;
@@ -306,6 +317,91 @@ typedef struct {
 #define QACTIVE_POST_LIFO(me_, e_) \
     ((*((QActiveVtbl const *)((me_)->super.vptr))->postLIFO)((me_), (e_)))
 
+#ifdef Q_SPY
+    /*! Posts an event to an active object replacing the event with the
+    * same signal that still waits in the queue (last value wins). */
+    /**
+    * @description
+    * Intended for high-rate "sample" signals (ADC, encoders), whose older
+    * values are useless once a newer one arrives. A signal posted only this
+    * way takes at most one entry in the queue of the active object, so the
+    * queue can be sized for the number of distinct signals rather than for
+    * the peak burst. When no event with the same signal is waiting, the
+    * event is posted as with QACTIVE_POST() (FIFO, asserts on overflow).
+    *
+    * @param[in,out] me_     pointer (see @ref oop)
+    * @param[in]     e_      pointer to the event to post
+    * @param[in]     sender_ pointer to the sender object.
+    *
+    * @sa QActive_postCoalesce_()
+    */
+    #define QACTIVE_POST_COALESCE(me_, e_, sender_) \
+        ((void)QActive_postCoalesce_((me_), (e_), QF_NO_MARGIN, (sender_)))
+
+    /*! Coalescing post without delivery guarantee, see QACTIVE_POST_X() */
+    #define QACTIVE_POST_COALESCE_X(me_, e_, margin_, sender_) \
+        (QActive_postCoalesce_((me_), (e_), (margin_), (sender_)))
+
+    bool QActive_postCoalesce_(QActive * const me, QEvt const * const e,
+                               uint_fast16_t const margin,
+                               void const * const sender);
+#else
+
+    #define QACTIVE_POST_COALESCE(me_, e_, sender_) \
+        ((void)QActive_postCoalesce_((me_), (e_), QF_NO_MARGIN))
+
+    #define QACTIVE_POST_COALESCE_X(me_, e_, margin_, sender_) \
+        (QActive_postCoalesce_((me_), (e_), (margin_)))
+
+    bool QActive_postCoalesce_(QActive * const me, QEvt const * const e,
+                               uint_fast16_t const margin);
+#endif
+
+#ifdef QF_ACTIVE_URGENT
+#ifdef Q_SPY
+    /*! Posts an event to the urgent lane of an active object (FIFO). */
+    /**
+    * @description
+    * Urgent events (faults, emergency stops) are dispatched ahead of the
+    * events already waiting in the normal lane, so their latency does not
+    * depend on the depth of the normal backlog. At most the burst limit
+    * given to QActive_urgentInit() urgent events are dispatched in a row
+    * while normal events wait.
+    *
+    * @param[in,out] me_     pointer (see @ref oop)
+    * @param[in]     e_      pointer to the event to post
+    * @param[in]     sender_ pointer to the sender object.
+    *
+    * @sa QActive_postUrgent_(), QActive_urgentInit()
+    */
+    #define QACTIVE_POST_URGENT(me_, e_, sender_) \
+        ((void)QActive_postUrgent_((me_), (e_), QF_NO_MARGIN, (sender_)))
+
+    /*! Urgent post without delivery guarantee, see QACTIVE_POST_X() */
+    #define QACTIVE_POST_URGENT_X(me_, e_, margin_, sender_) \
+        (QActive_postUrgent_((me_), (e_), (margin_), (sender_)))
+
+    bool QActive_postUrgent_(QActive * const me, QEvt const * const e,
+                             uint_fast16_t const margin,
+                             void const * const sender);
+#else
+
+    #define QACTIVE_POST_URGENT(me_, e_, sender_) \
+        ((void)QActive_postUrgent_((me_), (e_), QF_NO_MARGIN))
+
+    #define QACTIVE_POST_URGENT_X(me_, e_, margin_, sender_) \
+        (QActive_postUrgent_((me_), (e_), (margin_)))
+
+    bool QActive_postUrgent_(QActive * const me, QEvt const * const e,
+                             uint_fast16_t const margin);
+#endif
+
+/*! Adds the urgent lane to the event queue of an active object. */
+void QActive_urgentInit(QActive * const me, QEvt const *qSto[],
+                        uint_fast16_t const qLen,
+                        uint8_t const maxBurst);
+#endif /* QF_ACTIVE_URGENT */
+
 /* protected functions for ::QActive ...*/
 
 #ifdef QF_ACTIVE_STOP
@@ -504,13 +600,38 @@ QTimeEvtCtr QTimeEvt_currCtr(QTimeEvt const * const me);
 */
 typedef QPSet QSubscrList;
 
+#ifdef QF_PS_SPARSE
+
+/*! Sparse Subscriber-List entry */
+/**
+* @description
+* When the macro #QF_PS_SPARSE is defined in qf_port.h, the subscriber
+* lists are kept in a compact table sorted by signal, which holds only the
+* signals that currently have subscribers. This saves RAM for applications
+* with large, sparsely subscribed signal spaces.
+*
+* @sa QF_psInitSparse()
+*/
+typedef struct {
+    QSubscrList set; /*!< the subscribers of the signal */
+    QSignal     sig; /*!< the signal (the sorting key of the table) */
+} QSubscrEntry;
+
+#endif /* QF_PS_SPARSE */
+
 /* public functions */
 
 /*! QF initialization. */
 void QF_init(void);
 
+#ifndef QF_PS_SPARSE
 /*! Publish-subscribe initialization. */
 void QF_psInit(QSubscrList * const subscrSto, enum_t const maxSignal);
+#else
+/*! Publish-subscribe initialization with the sparse subscriber table. */
+void QF_psInitSparse(QSubscrEntry * const subscrSto,
+                     uint_fast16_t const stoLen, enum_t const maxSignal);
+#endif
 
 /*! Event pool initialization for dynamic allocation of events. */
 void QF_poolInit(void * const poolSto, uint_fast32_t const poolSize,
@@ -0,0 +1,217 @@
+/**
+* @file
+* @brief QK/C port to ARM Cortex-M3, ARM-KEIL toolset
+* @ingroup ports
+* @cond
+******************************************************************************
+* Last Updated for Version: 6.4.0
+* Date of the Last Update:  2019-02-10
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, LLC. state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* https://www.state-machine.com
+* mailto:info@state-machine.com
+******************************************************************************
+* @endcond
+*/
+#include "qf_port.h"
+
+#define SCB_SYSPRI  ((uint32_t volatile *)0xE000ED18U)
+#define NVIC_IP     ((uint32_t volatile *)0xE000E400U)
+#define SCnSCB_ICTR ((uint32_t volatile *)0xE000E004U)
+
+/* prototypes --------------------------------------------------------------*/
+void PendSV_Handler(void);
+void NMI_Handler(void);
+
+/*
+* Initialize the exception priorities and IRQ priorities to safe values.
+*
+* Description:
+* On Cortex-M3, this QK port disables interrupts by means of the BASEPRI
+* register. However, this method cannot disable interrupt priority zero,
+* which is the default for all interrupts out of reset. The following code
+* changes the SysTick priority and all IRQ priorities to the safe value
+* QF_BASEPRI, which the QF critical section can disable. This avoids
+* breaching of the QF critical sections in case the application programmer
+* forgets to explicitly set priorities of all "kernel aware" interrupts.
+*
+* The interrupt priorities established in QK_init() can be later
+* changed by the application-level code.
+*/
+void QK_init(void) {
+    uint32_t n;
+
+    /* set exception priorities to QF_BASEPRI...
+    * SCB_SYSPRI1: Usage-fault, Bus-fault, Memory-fault
+    */
+    SCB_SYSPRI[1] |= (QF_BASEPRI << 24) | (QF_BASEPRI << 16) | (QF_BASEPRI << 8);
+
+    /* SCB_SYSPRI2: SVCall */
+    SCB_SYSPRI[2] |= (QF_BASEPRI << 24);
+
+    /* SCB_SYSPRI3:  SysTick, PendSV, Debug */
+    SCB_SYSPRI[3] |= (QF_BASEPRI << 24) | (QF_BASEPRI << 16) | QF_BASEPRI;
+
+    /* set all implemented IRQ priories to QF_BASEPRI... */
+    n = 8U + ((*SCnSCB_ICTR & 0x7U) << 3); /* (# NVIC_PRIO registers)/4 */
+    do {
+        --n;
+        NVIC_IP[n] = (QF_BASEPRI << 24) | (QF_BASEPRI << 16)
+                     | (QF_BASEPRI << 8) | QF_BASEPRI;
+    } while (n != 0U);
+
+    /* set PendSV priority to the lowest level 0xFF */
+    SCB_SYSPRI[3] |= (0xFFU << 16);
+}
+
+/*****************************************************************************
+* The PendSV_Handler exception handler is used for handling context switch
+* and asynchronous preemption in QK. The use of the PendSV exception is
+* the recommended and most efficient method for performing context switches
+* with ARM Cortex-M.
+*
+* The PendSV exception should have the lowest priority in the whole system
+* (0xFF, see QK_init). All other exceptions and interrupts should have higher
+* priority. For example, for NVIC with 2 priority bits all interrupts and
+* exceptions must have numerical value of priority lower than 0xC0. In this
+* case the interrupt priority levels available to your applications are (in
+* the order from the lowest urgency to the highest urgency): 0x80, 0x40, 0x00.
+*
+* Also, *all* "kernel aware" ISRs in the QK application must call the
+* QK_ISR_EXIT() macro, which triggers PendSV when it detects a need for
+* a context switch or asynchronous preemption.
+*
+* Due to tail-chaining and its lowest priority, the PendSV exception will be
+* entered immediately after the exit from the *last* nested interrupt (or
+* exception). In QK, this is exactly the time when the QK activator needs to
+* handle the asynchronous preemption. See also NOTE1 for the stack usage.
+*/
+__asm void PendSV_Handler(void) {
+    IMPORT  QK_activate_    /* external reference */
+
+    /* Prepare constants in registers before entering critical section */
+    LDR     r3,=0xE000ED04  /* Interrupt Control and State Register */
+    MOVS    r1,#1
+    LSLS    r1,r1,#27       /* r1 := (1 << 27) (UNPENDSVSET bit) */
+
+    /* <<<<<<<<<<<<<<<<<<<<<<< CRITICAL SECTION BEGIN <<<<<<<<<<<<<<<<<<<<< */
+    CPSID   i               /* disable interrupts with PRIMASK, see NOTE2 */
+    MOVS    r0,#QF_BASEPRI
+    MSR     BASEPRI,r0      /* disable interrupts at processor level */
+    CPSIE   i               /* enable interrupts with PRIMASK */
+
+    /* The PendSV exception handler can be preempted by an interrupt,
+    * which might pend PendSV exception again. The following write to
+    * ICSR[27] un-pends any such spurious instance of PendSV.
+    */
+    STR     r1,[r3]         /* ICSR[27] := 1 (unpend PendSV) */
+
+    /* The QK activator must be called in a Thread mode, while this code
+    * executes in the Handler mode of the PendSV exception. The switch
+    * to the Thread mode is accomplished by returning from PendSV using
+    * a fabricated exception stack frame, where the return address is
+    * QK_activate_().
+    *
+    * NOTE: the QK activator is called with interrupts DISABLED and also
+    * returns with interrupts DISABLED.
+    */
+    LSRS    r3,r1,#3        /* r3 := (r1 >> 3), set the T bit (new xpsr) */
+    LDR     r2,=QK_activate_ /* address of QK_activate_ */
+    SUBS    r2,r2,#1        /* align Thumb-address at halfword (new pc) */
+    LDR     r1,=QK_thread_ret /* return address after the call   (new lr) */
+
+    SUB     sp,sp,#(8*4)    /* reserve space for exception stack frame */
+    ADD     r0,sp,#(5*4)    /* r0 := 5 registers below the top of stack */
+    STM     r0!,{r1-r3}     /* save xpsr,pc,lr */
+
+    MOVS    r0,#6
+    MVNS    r0,r0           /* r0 := ~6 == 0xFFFFFFF9 */
+    DSB                     /* ARM Erratum 838869 */
+    BX      r0              /* exception-return to the QK activator */
+    ALIGN                   /* make sure the END is aligned */
+}
+
+/*****************************************************************************
+* QK_thread_ret is a helper function executed when the QK activator returns.
+*
+* NOTE: QK_thread_ret does not execute in the PendSV context!
+* NOTE: QK_thread_ret executes entirely with interrupts DISABLED.
+*/
+__asm void QK_thread_ret(void) {
+    /* After the QK activator returns, we need to resume the preempted
+    * thread. However, this must be accomplished by a return-from-exception,
+    * while we are still in the thread context. The switch to the exception
+    * contex is accomplished by triggering the NMI exception.
+    */
+    LDR     r0,=0xE000ED04  /* Interrupt Control and State Register */
+    MOVS    r1,#1
+    LSLS    r1,r1,#31       /* r1 := (1 << 31) (NMI bit) */
+    STR     r1,[r0]         /* ICSR[31] := 1 (pend NMI) */
+
+    /* NOTE! interrupts are still disabled when NMI is used */
+    B       .               /* wait for preemption by NMI */
+    ALIGN                   /* make sure the END is aligned */
+}
+
+/*****************************************************************************
+* The NMI_Handler exception handler is used for returning back to the
+* interrupted task. The NMI exception simply removes its own interrupt
+* stack frame from the stack and returns to the preempted task using the
+* interrupt stack frame that must be at the top of the stack.
+*
+* NOTE: The NMI exception is entered with interrupts DISABLED, so it needs
+* to re-enable interrupts before it returns to the preempted task.
+*/
+__asm void NMI_Handler(void) {
+    ADD     sp,sp,#(8*4)    /* remove one 8-register exception frame */
+
+    MOVS    r0,#0
+    MSR     BASEPRI,r0      /* enable interrupts (clear BASEPRI) */
+    DSB                     /* ARM Erratum 838869 */
+    BX      lr              /* return to the preempted task */
+    ALIGN                   /* make sure the END is aligned */
+}
+
+/*****************************************************************************
+* NOTE1:
+* All active objects share the main stack (MSP). A preemption adds one
+* hardware exception frame (8 words) plus the frame of the activator and
+* of the dispatched state handler to the stack of the preempted object, so
+* the stack must hold the deepest preemption chain, which is bounded by the
+* number of distinct AO priorities, not by the number of AOs.
+*
+* NOTE2:
+* The sequence CPSID i, MSR BASEPRI, CPSIE i is the workaround of the
+* Cortex-M7 r0p1 erratum 837070, it is harmless on Cortex-M3.
+*
+* NOTE3:
+* This port owns the PendSV_Handler and NMI_Handler exceptions, so it
+* cannot be linked together with the FreeRTOS port (port.c of
+* portable/RVDS/ARM_CM3), which owns PendSV_Handler, SVC_Handler and
+* SysTick_Handler. The application provides SysTick_Handler for the QF
+* clock tick and QK_onIdle() when it is built with QK.
+*/
@@ -0,0 +1,85 @@
+/**
+* @file
+* @brief QK/C port to ARM Cortex-M3, ARM-KEIL toolset
+* @ingroup ports
+* @cond
+******************************************************************************
+* Last Updated for Version: 6.4.0
+* Date of the Last Update:  2019-02-10
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, LLC. state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* https://www.state-machine.com
+* mailto:info@state-machine.com
+******************************************************************************
+* @endcond
+*/
+#ifndef qk_port_h
+#define qk_port_h
+
+/* determination if the code executes in the ISR context, see NOTE1 */
+#define QK_ISR_CONTEXT_() (QK_get_IPSR() != (uint32_t)0)
+
+/* inline function for getting the IPSR register */
+static __inline uint32_t QK_get_IPSR(void) {
+    register uint32_t volatile __regIPSR __asm("ipsr");
+    return __regIPSR;
+}
+
+/* QK interrupt entry and exit, see NOTE2 */
+#define QK_ISR_ENTRY() ((void)0)
+
+#define QK_ISR_EXIT()  do { \
+    QF_INT_DISABLE(); \
+    if (QK_sched_() != (uint_fast8_t)0) { \
+        *Q_UINT2PTR_CAST(uint32_t, 0xE000ED04U) = (uint32_t)(1U << 28); \
+    } \
+    QF_INT_ENABLE(); \
+} while (0)
+
+/* port-specific initialization called from QF_init() */
+#define QK_INIT() QK_init()
+
+void QK_init(void);
+void QK_thread_ret(void);
+
+#include "qk.h" /* QK platform-independent public interface */
+
+/*****************************************************************************
+* NOTE1:
+* The IPSR register holds the number of the active exception, so the code
+* runs in the ISR context whenever it is not zero. This is cheaper and more
+* robust than counting the interrupt nesting in QK_ISR_ENTRY/QK_ISR_EXIT.
+*
+* NOTE2:
+* QK_ISR_ENTRY() does nothing and QK_ISR_EXIT() only pends the PendSV
+* exception when an active object of a higher priority than the preempted
+* one became ready. PendSV has the lowest priority, so it runs after all
+* nested interrupts have completed (tail-chaining) and only then switches
+* to the thread mode to run the QK activator, see qk_port.c.
+*/
+
+#endif /* qk_port_h */
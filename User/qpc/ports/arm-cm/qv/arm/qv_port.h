@@ -0,0 +1,74 @@
+/**
+* @file
+* @brief QV/C port to ARM Cortex-M3, ARM-KEIL toolset
+* @ingroup ports
+* @cond
+******************************************************************************
+* Last Updated for Version: 6.4.0
+* Date of the Last Update:  2019-02-10
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, LLC. state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* https://www.state-machine.com
+* mailto:info@state-machine.com
+******************************************************************************
+* @endcond
+*/
+#ifndef qv_port_h
+#define qv_port_h
+
+/* macro to put the CPU to sleep inside QV_onIdle(), see NOTE1 */
+#define QV_CPU_SLEEP() do { \
+    __disable_irq(); \
+    QF_INT_ENABLE(); \
+    __wfi(); \
+    __enable_irq(); \
+} while (0)
+
+/* port-specific initialization called from QF_init() */
+#define QV_INIT() QV_init()
+
+void QV_init(void);
+
+#include "qv.h" /* QV platform-independent public interface */
+
+/*****************************************************************************
+* NOTE1:
+* QV_onIdle() is called with interrupts disabled (BASEPRI), because an
+* interrupt may post an event at any time after the idle condition has been
+* determined. Enabling the interrupts and then executing WFI would let such
+* an interrupt run in between and the CPU would sleep with an event waiting
+* until the next interrupt. QV_CPU_SLEEP() first sets PRIMASK, then clears
+* BASEPRI and executes WFI: a pending interrupt still wakes the CPU from WFI
+* although PRIMASK keeps it from being taken, and it runs as soon as
+* PRIMASK is cleared after the wake-up. The application calls it as
+*
+*     void QV_onIdle(void) {
+*         QV_CPU_SLEEP(); // atomically go to sleep and enable interrupts
+*     }
+*/
+
+#endif /* qv_port_h */
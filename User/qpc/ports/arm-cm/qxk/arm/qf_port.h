@@ -0,0 +1,105 @@
+/**
+* @file
+* @brief QF/C port to ARM Cortex-M3, dual-mode QXK kernel, ARM-KEIL toolset
+* @ingroup ports
+* @cond
+******************************************************************************
+* Last Updated for Version: 6.4.0
+* Date of the Last Update:  2019-02-10
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, LLC. state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* https://www.state-machine.com
+* mailto:info@state-machine.com
+******************************************************************************
+* @endcond
+*/
+#ifndef qf_port_h
+#define qf_port_h
+
+/* The maximum number of active objects in the application, see NOTE1 */
+#define QF_MAX_ACTIVE           32
+
+/* The maximum number of system clock tick rates */
+#define QF_MAX_TICK_RATE        2
+
+/* QF interrupt disable/enable, see NOTE2 */
+#define QF_INT_DISABLE() do { \
+    __disable_irq(); \
+    QF_set_BASEPRI(QF_BASEPRI); \
+    __enable_irq(); \
+} while (0)
+#define QF_INT_ENABLE()         QF_set_BASEPRI(0U)
+
+/* QF critical section entry/exit (unconditional interrupt disabling) */
+/*#define QF_CRIT_STAT_TYPE not defined */
+#define QF_CRIT_ENTRY(dummy)    QF_INT_DISABLE()
+#define QF_CRIT_EXIT(dummy)     QF_INT_ENABLE()
+
+/* BASEPRI threshold for "QF-aware" interrupts, see NOTE3 */
+#define QF_BASEPRI              0x50
+
+/* CMSIS threshold for "QF-aware" interrupts, see NOTE3 */
+#define QF_AWARE_ISR_CMSIS_PRI  (QF_BASEPRI >> (8 - __NVIC_PRIO_BITS))
+
+/* Cortex-M3 provides the CLZ instruction for fast LOG2 */
+#define QF_LOG2(n_) ((uint_fast8_t)(32U - __clz(n_)))
+
+/* inline function for setting the BASEPRI register */
+static __inline void QF_set_BASEPRI(unsigned basePri) {
+    register unsigned volatile __regBasePri __asm("basepri");
+    __regBasePri = basePri;
+}
+
+#define QF_CRIT_EXIT_NOP()      __asm("isb")
+
+#include "qep_port.h" /* QEP port */
+#include "qxk_port.h" /* QXK dual-mode kernel port */
+#include "qf.h"       /* QF platform-independent public interface */
+#include "qxthread.h" /* QXK extended thread interface */
+
+/*****************************************************************************
+* NOTE1:
+* The maximum number of active objects QF_MAX_ACTIVE can be increased to 64,
+* inclusive, but it can be reduced to save some memory. The basic threads
+* (active objects) share the main stack (MSP), only the extended (blocking)
+* threads have their own stacks, see qxk_port.c.
+*
+* NOTE2:
+* On Cortex-M3 the QF critical section masks only the interrupts with the
+* priority numbers at or above QF_BASEPRI (BASEPRI register). The brief
+* PRIMASK disabling around setting BASEPRI is the recommended workaround
+* of the Cortex-M7 r0p1 erratum and costs nothing on the M3.
+*
+* NOTE3:
+* QF_BASEPRI is the same threshold as configMAX_SYSCALL_INTERRUPT_PRIORITY
+* of the FreeRTOS port (priority 5 with 4 priority bits), so the interrupt
+* priorities of the drivers (6 and 7) stay valid with either kernel. Only
+* the "QF-aware" interrupts (NVIC priority >= QF_AWARE_ISR_CMSIS_PRI) may
+* call QP services, the "kernel-unaware" ones above it are never masked.
+*/
+
+#endif /* qf_port_h */
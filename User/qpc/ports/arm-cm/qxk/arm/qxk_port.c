@@ -0,0 +1,301 @@
+/**
+* @file
+* @brief QXK/C port to ARM Cortex-M3, ARM-KEIL toolset
+* @ingroup ports
+* @cond
+******************************************************************************
+* Last Updated for Version: 6.4.0
+* Date of the Last Update:  2019-02-10
+*
+*                    Q u a n t u m     L e a P s
+*                    ---------------------------
+*                    innovating embedded systems
+*
+* Copyright (C) Quantum Leaps, LLC. state-machine.com.
+*
+* This program is open source software: you can redistribute it and/or
+* modify it under the terms of the GNU General Public License as published
+* by the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* Alternatively, this program may be distributed and modified under the
+* terms of Quantum Leaps commercial licenses, which expressly supersede
+* the GNU General Public License and are specifically designed for
+* licensees interested in retaining the proprietary status of their code.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program. If not, see <http://www.gnu.org/licenses/>.
+*
+* Contact information:
+* https://www.state-machine.com
+* mailto:info@state-machine.com
+******************************************************************************
+* @endcond
+*/
+#include <stddef.h>       /* offsetof() for the embedded assembly */
+
+#define QP_IMPL           /* this is QP implementation */
+#include "qf_port.h"      /* QF port */
+#include "qxk_pkg.h"      /* QXK package-scope interface */
+
+#define SCB_SYSPRI  ((uint32_t volatile *)0xE000ED18U)
+#define NVIC_IP     ((uint32_t volatile *)0xE000E400U)
+#define SCnSCB_ICTR ((uint32_t volatile *)0xE000E004U)
+
+/* prototypes --------------------------------------------------------------*/
+void PendSV_Handler(void);
+void NMI_Handler(void);
+
+/*
+* Initialize the exception priorities and IRQ priorities to safe values.
+*
+* Description:
+* On Cortex-M3, this QXK port disables interrupts by means of the BASEPRI
+* register. However, this method cannot disable interrupt priority zero,
+* which is the default for all interrupts out of reset. The following code
+* changes the SysTick priority and all IRQ priorities to the safe value
+* QF_BASEPRI, which the QF critical section can disable. This avoids
+* breaching of the QF critical sections in case the application programmer
+* forgets to explicitly set priorities of all "kernel aware" interrupts.
+*
+* The interrupt priorities established in QXK_init() can be later
+* changed by the application-level code.
+*/
+void QXK_init(void) {
+    uint32_t n;
+
+    /* set exception priorities to QF_BASEPRI...
+    * SCB_SYSPRI1: Usage-fault, Bus-fault, Memory-fault
+    */
+    SCB_SYSPRI[1] |= (QF_BASEPRI << 24) | (QF_BASEPRI << 16) | (QF_BASEPRI << 8);
+
+    /* SCB_SYSPRI2: SVCall */
+    SCB_SYSPRI[2] |= (QF_BASEPRI << 24);
+
+    /* SCB_SYSPRI3:  SysTick, PendSV, Debug */
+    SCB_SYSPRI[3] |= (QF_BASEPRI << 24) | (QF_BASEPRI << 16) | QF_BASEPRI;
+
+    /* set all implemented IRQ priories to QF_BASEPRI... */
+    n = 8U + ((*SCnSCB_ICTR & 0x7U) << 3); /* (# NVIC_PRIO registers)/4 */
+    do {
+        --n;
+        NVIC_IP[n] = (QF_BASEPRI << 24) | (QF_BASEPRI << 16)
+                     | (QF_BASEPRI << 8) | QF_BASEPRI;
+    } while (n != 0U);
+
+    /* set PendSV priority to the lowest level 0xFF */
+    SCB_SYSPRI[3] |= (0xFFU << 16);
+}
+
+/*****************************************************************************
+* Initialize the private stack of an extended thread with the exception
+* frame and the registers R4-R11 that PendSV_Handler restores the first
+* time the thread is switched in, see NOTE1.
+*/
+void QXK_stackInit_(void *thr, QXThreadHandler handler,
+                    void *stkSto, uint_fast16_t stkSize)
+{
+    /* round down the stack top to the 8-byte boundary
+    * NOTE: ARM Cortex-M stack grows down from hi -> low memory
+    */
+    uint32_t *sp =
+        (uint32_t *)((((uint32_t)stkSto + stkSize) >> 3) << 3);
+    uint32_t *sp_limit;
+
+    /* synthesize the ARM Cortex-M exception stack frame...*/
+    *(--sp) = (1U << 24);    /* xPSR  (just the THUMB bit) */
+    *(--sp) = (uint32_t)handler & ~1U; /* PC (the thread handler) */
+    *(--sp) = (uint32_t)&QXK_threadRet_; /* LR (return from thread) */
+    *(--sp) = 0x0000000CU;   /* R12 */
+    *(--sp) = 0x00000003U;   /* R3  */
+    *(--sp) = 0x00000002U;   /* R2  */
+    *(--sp) = 0x00000001U;   /* R1  */
+    *(--sp) = (uint32_t)thr; /* R0 (argument to the thread handler) */
+    *(--sp) = 0x0000000BU;   /* R11 */
+    *(--sp) = 0x0000000AU;   /* R10 */
+    *(--sp) = 0x00000009U;   /* R9  */
+    *(--sp) = 0x00000008U;   /* R8  */
+    *(--sp) = 0x00000007U;   /* R7  */
+    *(--sp) = 0x00000006U;   /* R6  */
+    *(--sp) = 0x00000005U;   /* R5  */
+    *(--sp) = 0x00000004U;   /* R4  */
+
+    /* save the top of the stack in the thread's attibute register */
+    ((QActive *)thr)->osObject = sp;
+
+    /* pre-fill the unused part of the stack with 0xDEADBEEF */
+    sp_limit = (uint32_t *)(((((uint32_t)stkSto - 1U) >> 3) + 1U) << 3);
+    for (--sp; sp >= sp_limit; --sp) {
+        *sp = 0xDEADBEEFU;
+    }
+}
+
+/*****************************************************************************
+* The PendSV_Handler exception handler performs all context switches of
+* QXK, see NOTE1. It has the lowest priority (0xFF, see QXK_init), so it
+* runs only after the last nested interrupt has completed. It is entered
+* with the next thread in QXK_attr_.next and handles three cases:
+*
+* - the next thread is extended: the context of the current extended
+*   thread (if any) is saved on its private stack (PSP), the next one is
+*   restored from its private stack;
+* - the next thread is a basic thread of a higher priority than the active
+*   one: the basic threads are activated on the main stack (MSP) through
+*   a fabricated exception frame, exactly as in the QK port;
+* - otherwise the preempted basic thread (or the idle loop) simply resumes
+*   from its exception frame on the main stack.
+*/
+__asm void PendSV_Handler(void) {
+    IMPORT  QXK_activate_   /* external reference */
+
+    /* <<<<<<<<<<<<<<<<<<<<<<< CRITICAL SECTION BEGIN <<<<<<<<<<<<<<<<<<<<< */
+    CPSID   i               /* disable interrupts with PRIMASK */
+    MOVS    r0,#QF_BASEPRI
+    MSR     BASEPRI,r0      /* disable interrupts at processor level */
+    CPSIE   i               /* enable interrupts with PRIMASK */
+
+    /* The PendSV exception handler can be preempted by an interrupt,
+    * which might pend PendSV exception again. The following write to
+    * ICSR[27] un-pends any such spurious instance of PendSV.
+    */
+    LDR     r3,=0xE000ED04  /* Interrupt Control and State Register */
+    MOVS    r1,#1
+    LSLS    r1,r1,#27       /* r1 := (1 << 27) (UNPENDSVSET bit) */
+    STR     r1,[r3]         /* ICSR[27] := 1 (unpend PendSV) */
+
+    LDR     r3,=__cpp(&QXK_attr_)
+    LDR     r0,[r3,#__cpp(offsetof(QXK_Attr, next))] /* r0 := next */
+    CBZ     r0,PendSV_return /* no next thread? (stale PendSV) */
+
+    /* save the context of the current extended thread, if any */
+    LDR     r1,[r3,#__cpp(offsetof(QXK_Attr, curr))] /* r1 := curr */
+    CBZ     r1,PendSV_next  /* basic thread: its frame stays on the MSP */
+    MRS     r2,PSP
+    STMDB   r2!,{r4-r11}    /* save R4-R11 on the private stack */
+    STR     r2,[r1,#__cpp(offsetof(QActive, osObject))]
+
+PendSV_next
+    LDR     r2,[r0,#__cpp(offsetof(QActive, osObject))] /* r2 := next sp */
+    CBZ     r2,PendSV_basic /* next is a basic thread? */
+
+    /* switch to the next extended thread */
+    STR     r0,[r3,#__cpp(offsetof(QXK_Attr, curr))] /* curr := next */
+    MOVS    r1,#0
+    STR     r1,[r3,#__cpp(offsetof(QXK_Attr, next))] /* next := 0 */
+    LDMIA   r2!,{r4-r11}    /* restore R4-R11 from the private stack */
+    MSR     PSP,r2
+    MOVS    r0,#0
+    MSR     BASEPRI,r0      /* enable interrupts (clear BASEPRI) */
+    /* >>>>>>>>>>>>>>>>>>>>>>>> CRITICAL SECTION END >>>>>>>>>>>>>>>>>>>>>>>> */
+    MVN     lr,#2           /* lr := ~2 == 0xFFFFFFFD (thread mode, PSP) */
+    DSB                     /* ARM Erratum 838869 */
+    BX      lr              /* exception-return to the extended thread */
+
+PendSV_basic
+    MOVS    r1,#0
+    STR     r1,[r3,#__cpp(offsetof(QXK_Attr, curr))] /* curr := 0 (basic) */
+    LDRB    r1,[r0,#__cpp(offsetof(QActive, prio))]  /* r1 := next->prio */
+    LDRB    r2,[r3,#__cpp(offsetof(QXK_Attr, actPrio))]
+    CMP     r1,r2
+    BHI     PendSV_activate /* next->prio > actPrio? */
+    MOVS    r1,#0
+    STR     r1,[r3,#__cpp(offsetof(QXK_Attr, next))] /* next := 0 */
+
+    MVN     lr,#6           /* lr := ~6 == 0xFFFFFFF9 (thread mode, MSP) */
+
+PendSV_return               /* lr: EXC_RETURN of the thread to resume */
+    MOVS    r0,#0
+    MSR     BASEPRI,r0      /* enable interrupts (clear BASEPRI) */
+    /* >>>>>>>>>>>>>>>>>>>>>>>> CRITICAL SECTION END >>>>>>>>>>>>>>>>>>>>>>>> */
+    DSB                     /* ARM Erratum 838869 */
+    BX      lr              /* exception-return to the thread */
+
+PendSV_activate
+    /* The QXK activator must be called in a Thread mode, while this code
+    * executes in the Handler mode of the PendSV exception. The switch
+    * to the Thread mode is accomplished by returning from PendSV using
+    * a fabricated exception stack frame on the MSP, where the return
+    * address is QXK_activate_().
+    *
+    * NOTE: the QXK activator is called with interrupts DISABLED and also
+    * returns with interrupts DISABLED.
+    */
+    MOV     r3,#(1 << 24)   /* the T bit (new xpsr) */
+    LDR     r2,=QXK_activate_ /* address of QXK_activate_ */
+    SUBS    r2,r2,#1        /* align Thumb-address at halfword (new pc) */
+    LDR     r1,=QXK_thread_ret /* return address after the call (new lr) */
+
+    SUB     sp,sp,#(8*4)    /* reserve space for exception stack frame */
+    ADD     r0,sp,#(5*4)    /* r0 := 5 registers below the top of stack */
+    STM     r0!,{r1-r3}     /* save xpsr,pc,lr */
+
+    MVN     lr,#6           /* lr := ~6 == 0xFFFFFFF9 (thread mode, MSP) */
+    DSB                     /* ARM Erratum 838869 */
+    BX      lr              /* exception-return to the QXK activator */
+    ALIGN                   /* make sure the END is aligned */
+}
+
+/*****************************************************************************
+* QXK_thread_ret is a helper function executed when the QXK activator returns.
+*
+* NOTE: QXK_thread_ret does not execute in the PendSV context!
+* NOTE: QXK_thread_ret executes entirely with interrupts DISABLED.
+*/
+__asm void QXK_thread_ret(void) {
+    /* After the QXK activator returns, we need to resume the preempted
+    * basic thread. However, this must be accomplished by a return-from-
+    * exception, while we are still in the thread context. The switch to
+    * the exception contex is accomplished by triggering the NMI exception.
+    */
+    LDR     r0,=0xE000ED04  /* Interrupt Control and State Register */
+    MOVS    r1,#1
+    LSLS    r1,r1,#31       /* r1 := (1 << 31) (NMI bit) */
+    STR     r1,[r0]         /* ICSR[31] := 1 (pend NMI) */
+
+    /* NOTE! interrupts are still disabled when NMI is used */
+    B       .               /* wait for preemption by NMI */
+    ALIGN                   /* make sure the END is aligned */
+}
+
+/*****************************************************************************
+* The NMI_Handler exception handler is used for returning back to the
+* interrupted basic thread. The NMI exception simply removes its own
+* interrupt stack frame from the stack and returns to the preempted basic
+* thread using the interrupt stack frame that must be at the top of the MSP.
+*
+* NOTE: The NMI exception is entered with interrupts DISABLED, so it needs
+* to re-enable interrupts before it returns to the preempted thread. A
+* context switch to an extended thread requested by the activator is still
+* pending in PendSV and follows right after.
+*/
+__asm void NMI_Handler(void) {
+    ADD     sp,sp,#(8*4)    /* remove one 8-register exception frame */
+
+    MOVS    r0,#0
+    MSR     BASEPRI,r0      /* enable interrupts (clear BASEPRI) */
+    DSB                     /* ARM Erratum 838869 */
+    BX      lr              /* return to the preempted basic thread */
+    ALIGN                   /* make sure the END is aligned */
+}
+
+/*****************************************************************************
+* NOTE1:
+* The basic threads (active objects), the idle loop and the interrupts all
+* run on the main stack (MSP), nested in the same way as in the QK kernel.
+* Only the extended threads run on their private stacks through the process
+* stack pointer (PSP), which is saved in the osObject member of the thread
+* (NULL for the basic threads). When an extended thread preempts a basic
+* one, the exception frame of the basic thread simply stays on the MSP and
+* is popped again when the extended thread blocks. Only the extended
+* threads therefore need a stack of their own.
+*
+* NOTE2:
+* This port owns the PendSV_Handler and NMI_Handler exceptions, so it
+* cannot be linked together with the FreeRTOS port. The application
+* provides SysTick_Handler for the QF clock tick and QXK_onIdle().
+*/
@@ -57,8 +57,33 @@ Q_DEFINE_THIS_MODULE("qf_port")
     #error "FreeRTOS configMAX_PRIORITIES must not be less than QF_MAX_ACTIVE"
 #endif
 
+/* the scheduler lock reads the base priority of the task, see NOTE9 */
+#if ( configUSE_MUTEXES == 1 ) && ( configUSE_TRACE_FACILITY == 0 )
+    #error "FreeRTOS configUSE_TRACE_FACILITY is needed with configUSE_MUTEXES"
+#endif
+
 /* Local objects -----------------------------------------------------------*/
 static void task_function(void *pvParameters); /* FreeRTOS task signature */
+static UBaseType_t task_basePrio(void);
+
+/* preemption thresholds of the AOs (QF prio), see NOTE9 in qf_port.h */
+static uint8_t l_threshold[QF_MAX_ACTIVE + 1];
+
+#ifdef QF_SHARED_STACK
+/* the dispatcher of the AOs without own stack, see NOTE8 in qf_port.h */
+static struct {
+    QPSet aoSet;     /* QF priorities of the shared AOs */
+    QPSet readySet;  /* shared AOs with something to dispatch */
+    uint_fast8_t actPrio; /* prio of the running shared AO (threshold) */
+    uint_fast8_t loPrio;  /* the band of the shared AOs, 0 before QF_run() */
+    uint_fast8_t hiPrio;
+    StaticTask_t thread;  /* the FreeRTOS task of the dispatcher */
+    StackType_t stack[QF_SHARED_STACK_SIZE / sizeof(StackType_t)];
+} l_shared;
+
+static void shared_function(void *pvParameters); /* the dispatcher task */
+static void shared_activate(void);
+#endif /* QF_SHARED_STACK */
 
 /*==========================================================================*/
 void QF_init(void) {
@@ -66,6 +91,38 @@ void QF_init(void) {
 }
 /*..........................................................................*/
 int_t QF_run(void) {
+#ifdef QF_SHARED_STACK
+    if (QPSet_notEmpty(&l_shared.aoSet)) { /* any shared AOs? */
+        uint_fast8_t p;
+        uint_fast8_t lo;
+        TaskHandle_t thr;
+
+        QPSet_findMax(&l_shared.aoSet, p); /* the highest shared AO */
+        for (lo = (uint_fast8_t)1; !QPSet_hasElement(&l_shared.aoSet, lo);
+             ++lo)
+        {
+        }
+
+        /* no dedicated AO within the band of the shared AOs, see NOTE8 */
+        l_shared.loPrio = lo;
+        l_shared.hiPrio = p;
+        for (; lo < p; ++lo) {
+            Q_ASSERT_ID(115, (QF_active_[lo] == (QActive *)0)
+                             || QPSet_hasElement(&l_shared.aoSet, lo));
+        }
+
+        thr = xTaskCreateStatic(
+                  &shared_function,     /* the dispatcher function */
+                  "QF",                 /* the name of the task */
+                  (uint16_t)(QF_SHARED_STACK_SIZE/sizeof(portSTACK_TYPE)),
+                  (void *)0,            /* the 'pvParameters' parameter */
+                  (UBaseType_t)(p + tskIDLE_PRIORITY), /* FreeRTOS prio */
+                  &l_shared.stack[0],   /* stack storage */
+                  &l_shared.thread);    /* task buffer */
+        Q_ENSURE_ID(120, thr != (TaskHandle_t)0); /* must be created */
+    }
+#endif /* QF_SHARED_STACK */
+
     QF_onStartup();  /* the startup callback (configure/enable interrupts) */
     vTaskStartScheduler(); /* start the FreeRTOS scheduler */
     Q_ERROR_ID(110);       /* the FreeRTOS scheduler should never return */
@@ -85,20 +142,60 @@ void QActive_start_(QActive * const me, uint_fast8_t prio,
     /* task name provided by the user in QF_setTaskName() or default name */
     char_t const *taskName = (me->thread.pxDummy1 != (void *)0)
                              ? (char_t const *)me->thread.pxDummy1
-                             : (char_t const *)"AO";
+                             : (char_t const *)0;
+    char_t defName[5]; /* "AO" + QF priority, see NOTE1 */
+    /* threshold provided in QActive_setAttr() or none (the AO priority) */
+    uint_fast8_t thre = (me->thread.uxDummy5 > (UBaseType_t)prio)
+                        ? (uint_fast8_t)me->thread.uxDummy5
+                        : prio;
 
     Q_REQUIRE_ID(200, ((int_fast8_t)0 < prio)
         && (prio <= (uint_fast8_t)QF_MAX_ACTIVE) /* in range */
         && (qSto != (QEvt const **)0)    /* queue storage must be provided */
         && (qLen > (uint_fast16_t)0)     /* queue size must be provided */
+        && (thre <= (uint_fast8_t)QF_MAX_ACTIVE) /* threshold in range */
+#ifdef QF_SHARED_STACK
+        /* no stack at all (shared AO) or the stack storage and size */
+        && ((stkSto != (void *)0) == (stkSize > (uint_fast16_t)0))
+        /* the shared AOs must be known before the dispatcher is created */
+        && ((stkSto != (void *)0)
+            || (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED))
+        /* and a dedicated AO started later stays out of their band */
+        && ((stkSto == (void *)0)
+            || (prio < l_shared.loPrio) || (prio > l_shared.hiPrio)));
+#else
         && (stkSto != (void *)0)         /* stack storage must be provided */
         && (stkSize > (uint_fast16_t)0));/* stack size must be provided */
+#endif
+
+    /* no name provided, label the task with the QF priority */
+    if (taskName == (char_t const *)0) {
+        defName[0] = (char_t)'A';
+        defName[1] = (char_t)'O';
+        defName[2] = (char_t)('0' + (prio / (uint_fast8_t)10));
+        defName[3] = (char_t)('0' + (prio % (uint_fast8_t)10));
+        defName[4] = (char_t)'\0';
+        taskName = &defName[0];
+    }
 
     /* create the event queue for the AO */
     QEQueue_init(&me->eQueue, qSto, qLen);
 
+    QPSet_setEmpty(&me->osObject); /* no pending broadcasts */
+
     me->prio = prio;  /* save the QF priority */
+    l_threshold[prio] = (uint8_t)thre;
     QF_add_(me);      /* make QF aware of this active object */
+
+#ifdef QF_SHARED_STACK
+    if (stkSto == (void *)0) { /* run by the dispatcher task? */
+        QPSet_insert(&l_shared.aoSet, prio);
+        QHSM_INIT(&me->super, ie); /* take the top-most initial tran. */
+        QS_FLUSH(); /* flush the QS trace buffer to the host */
+        return;
+    }
+#endif /* QF_SHARED_STACK */
+
     QHSM_INIT(&me->super, ie); /* take the top-most initial tran. */
     QS_FLUSH(); /* flush the QS trace buffer to the host */
 
@@ -115,29 +212,215 @@ void QActive_start_(QActive * const me, uint_fast8_t prio,
 }
 /*..........................................................................*/
 void QActive_setAttr(QActive *const me, uint32_t attr1, void const *attr2) {
-    /* this function must be called before QACTIVE_START(),
-    * which implies that me->thread.pxDummy1 must not be used yet;
-    */
-    Q_REQUIRE_ID(300, me->thread.pxDummy1 == (void *)0);
     switch (attr1) {
         case TASK_NAME_ATTR:
+            /* this function must be called before QACTIVE_START(),
+            * which implies that me->thread.pxDummy1 must not be used yet;
+            */
+            Q_REQUIRE_ID(300, me->thread.pxDummy1 == (void *)0);
             /* temporarily store the name */
             me->thread.pxDummy1 = (void *)attr2; /* cast 'const' away */
             break;
+        case TASK_THRESHOLD_ATTR:
+            /* must be called before QACTIVE_START() (prio not set yet) */
+            Q_REQUIRE_ID(310, me->prio == (uint8_t)0);
+            /* temporarily store the threshold in the priority field */
+            me->thread.uxDummy5 = (UBaseType_t)(uint32_t)attr2;
+            break;
         /* ... */
     }
 }
 /*..........................................................................*/
 static void task_function(void *pvParameters) { /* FreeRTOS task signature */
     QActive *act = (QActive *)pvParameters;
+    UBaseType_t const prio = (UBaseType_t)act->prio + tskIDLE_PRIORITY;
+    UBaseType_t const thre = (UBaseType_t)l_threshold[act->prio]
+                             + tskIDLE_PRIORITY;
+    bool raised = false; /* running at the preemption threshold? */
 
     /* event-loop */
     for (;;) { /* for-ever */
         QEvt const *e = QActive_get_(act);
+
+        if ((thre != prio) && (!raised)) { /* see NOTE9 in qf_port.h */
+            vTaskPrioritySet((TaskHandle_t)0, thre);
+            raised = true;
+        }
+
         QHSM_DISPATCH(&act->super, e);
         QF_gc(e); /* check if the event is garbage, and collect it if so */
+
+        /* drop to the AO priority only before waiting for events */
+        if (raised && QACTIVE_IDLE_(act)) {
+            vTaskPrioritySet((TaskHandle_t)0, prio);
+            raised = false;
+        }
     }
 }
+/*..........................................................................*/
+/* the priority the calling task was given with vTaskPrioritySet(), not the
+* one it may have inherited from a mutex (uxTaskPriorityGet()), see NOTE9
+*/
+static UBaseType_t task_basePrio(void) {
+#if ( configUSE_MUTEXES == 1 )
+    TaskStatus_t status;
+
+    /* eRunning and pdFALSE: no state lookup and no stack scan */
+    vTaskGetInfo((TaskHandle_t)0, &status, pdFALSE, eRunning);
+    return status.uxBasePriority;
+#else
+    return uxTaskPriorityGet((TaskHandle_t)0);
+#endif
+}
+/*..........................................................................*/
+QSchedStatus QF_schedLock_(uint_fast8_t const ceiling) {
+    QSchedStatus stat;
+
+    /* no preemption before the start, nothing to lock */
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        stat = (QSchedStatus)0xFFFF;
+    }
+    else {
+        UBaseType_t const prio = task_basePrio();
+
+        /* the previous base priority in the upper byte */
+        stat = (QSchedStatus)((QSchedStatus)prio << 8);
+
+#ifdef QF_SHARED_STACK
+        if (xTaskGetCurrentTaskHandle() == (TaskHandle_t)&l_shared.thread) {
+            QF_CRIT_STAT_
+
+            QF_CRIT_ENTRY_();
+            stat |= (QSchedStatus)l_shared.actPrio; /* the threshold */
+            if (l_shared.actPrio < ceiling) {
+                l_shared.actPrio = ceiling;
+            }
+            QF_CRIT_EXIT_();
+        }
+#endif /* QF_SHARED_STACK */
+
+        if (prio < ((UBaseType_t)ceiling + tskIDLE_PRIORITY)) {
+            vTaskPrioritySet((TaskHandle_t)0,
+                             (UBaseType_t)ceiling + tskIDLE_PRIORITY);
+        }
+    }
+    return stat;
+}
+/*..........................................................................*/
+void QF_schedUnlock_(QSchedStatus const stat) {
+    if (stat != (QSchedStatus)0xFFFF) { /* was the lock taken? */
+        UBaseType_t const prio = (UBaseType_t)(stat >> 8);
+
+#ifdef QF_SHARED_STACK
+        if (xTaskGetCurrentTaskHandle() == (TaskHandle_t)&l_shared.thread) {
+            QF_CRIT_STAT_
+
+            QF_CRIT_ENTRY_();
+            l_shared.actPrio = (uint_fast8_t)(stat & (QSchedStatus)0xFF);
+            QF_CRIT_EXIT_();
+
+            shared_activate(); /* run the AOs readied under the lock */
+        }
+#endif /* QF_SHARED_STACK */
+
+        /* restore the base priority, possibly switching to another task */
+        if (task_basePrio() != prio) {
+            vTaskPrioritySet((TaskHandle_t)0, prio);
+        }
+    }
+}
+
+#ifdef QF_SHARED_STACK
+/*==========================================================================*/
+/* The dispatcher of the shared AOs, see NOTE8 in qf_port.h */
+static void shared_function(void *pvParameters) {
+    (void)pvParameters; /* unused parameter */
+
+    for (;;) {
+        shared_activate(); /* run all shared AOs with events */
+
+        /* a notification given during the activation is still pending */
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+/*..........................................................................*/
+/* run the ready shared AOs above the current threshold, highest first */
+static void shared_activate(void) {
+    uint_fast8_t const pin = l_shared.actPrio; /* the preempted prio */
+    uint_fast8_t p;
+    QF_CRIT_STAT_
+
+    QF_CRIT_ENTRY_();
+    QPSet_findMax(&l_shared.readySet, p); /* zero when none are ready */
+    while (p > pin) {
+        QActive *a = QF_active_[p];
+        QEvt const *e;
+
+        l_shared.actPrio = l_threshold[p]; /* the preemption threshold */
+        QF_CRIT_EXIT_();
+
+        e = QActive_get_(a); /* cannot block, the AO is ready */
+        QHSM_DISPATCH(&a->super, e);
+        QF_gc(e); /* check if the event is garbage, and collect it if so */
+
+        QF_CRIT_ENTRY_();
+        if (QACTIVE_IDLE_(a)) {
+            QPSet_remove(&l_shared.readySet, p);
+        }
+        QPSet_findMax(&l_shared.readySet, p);
+    }
+    l_shared.actPrio = pin; /* restore the threshold */
+    QF_CRIT_EXIT_();
+}
+/*..........................................................................*/
+/* called by QACTIVE_EQUEUE_SIGNAL_() outside the critical section */
+void QActive_notify_(QActive * const me) {
+    uint_fast8_t const p = (uint_fast8_t)me->prio;
+
+    if (QPSet_hasElement(&l_shared.aoSet, p)) { /* a shared AO? */
+        QF_CRIT_STAT_
+
+        QF_CRIT_ENTRY_();
+        QPSet_insert(&l_shared.readySet, p);
+        QF_CRIT_EXIT_();
+
+        if (xTaskGetCurrentTaskHandle() != (TaskHandle_t)&l_shared.thread) {
+            /* the AOs readied before the start run in the first pass */
+            if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+                (void)xTaskNotifyGive((TaskHandle_t)&l_shared.thread);
+            }
+        }
+        /* posted by a shared AO, under a scheduler lock only the AOs
+        * above the ceiling run, the rest when QF_schedUnlock_() releases it
+        */
+        else if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+            shared_activate(); /* preempt the sender if above threshold */
+        }
+    }
+    else {
+        (void)xTaskNotifyGive((TaskHandle_t)&me->thread);
+    }
+}
+/*..........................................................................*/
+void QActive_notifyFromISR_(QActive * const me,
+                            BaseType_t * const pxHigherPriorityTaskWoken)
+{
+    uint_fast8_t const p = (uint_fast8_t)me->prio;
+
+    if (QPSet_hasElement(&l_shared.aoSet, p)) { /* a shared AO? */
+        UBaseType_t uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
+        QPSet_insert(&l_shared.readySet, p);
+        taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+        vTaskNotifyGiveFromISR((TaskHandle_t)&l_shared.thread,
+                               pxHigherPriorityTaskWoken);
+    }
+    else {
+        vTaskNotifyGiveFromISR((TaskHandle_t)&me->thread,
+                               pxHigherPriorityTaskWoken);
+    }
+}
+#endif /* QF_SHARED_STACK */
 
 /*==========================================================================*/
 /* The "FromISR" QP APIs for the FreeRTOS port... */
@@ -208,8 +491,7 @@ bool QActive_postFromISR_(QActive * const me, QEvt const * const e,
             taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
 
             /* signal the event queue */
-            vTaskNotifyGiveFromISR((TaskHandle_t)&me->thread,
-                                   pxHigherPriorityTaskWoken);
+            QActive_notifyFromISR_(me, pxHigherPriorityTaskWoken);
         }
         /* queue is not empty, insert event into the ring-buffer */
         else {
@@ -243,6 +525,238 @@ bool QActive_postFromISR_(QActive * const me, QEvt const * const e,
     return status;
 }
 /*..........................................................................*/
+/* the "FromISR" variant of QActive_postCoalesce_() */
+#ifdef Q_SPY
+bool QActive_postCoalesceFromISR_(QActive * const me, QEvt const * const e,
+                          uint_fast16_t const margin,
+                          BaseType_t * const pxHigherPriorityTaskWoken,
+                          void const * const sender)
+#else
+bool QActive_postCoalesceFromISR_(QActive * const me, QEvt const * const e,
+                          uint_fast16_t const margin,
+                          BaseType_t * const pxHigherPriorityTaskWoken)
+#endif
+{
+    QEvt const *old;
+    QEQueueCtr nFree; /* temporary to avoid UB for volatile access */
+    bool status;
+    UBaseType_t uxSavedInterruptState;
+
+    /** @pre event pointer must be valid */
+    Q_REQUIRE_ID(450, e != (QEvt const *)0);
+
+    uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
+    old = QActive_coalesce_(me, e);
+
+    if (old != (QEvt const *)0) { /* replaced the waiting event? */
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_FIFO,
+                         QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();               /* timestamp */
+            QS_OBJ_(sender);          /* the sender object */
+            QS_SIG_(e->sig);          /* the signal of the event */
+            QS_OBJ_(me);              /* this active object (recipient) */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(me->eQueue.nFree); /* number of free entries */
+            QS_EQC_(me->eQueue.nMin);  /* min number of free entries */
+        QS_END_NOCRIT_()
+
+        taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+        /* the AO is already signaled, because the queue was not empty */
+        QF_gcFromISR(old);
+        status = true;
+    }
+    else {
+        /* no event to replace, FIFO posting in the same critical section,
+        * so that another producer cannot queue the same signal in between
+        */
+        nFree = me->eQueue.nFree; /* get volatile into the temporary */
+
+        if (margin == QF_NO_MARGIN) {
+            if (nFree > (QEQueueCtr)0) {
+                status = true; /* can post */
+            }
+            else {
+                status = false; /* cannot post */
+                Q_ERROR_ID(455); /* must be able to post the event */
+            }
+        }
+        else if (nFree > (QEQueueCtr)margin) {
+            status = true; /* can post */
+        }
+        else {
+            status = false; /* cannot post */
+        }
+
+        if (status) { /* can post the event? */
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_FIFO,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();               /* timestamp */
+                QS_OBJ_(sender);          /* the sender object */
+                QS_SIG_(e->sig);          /* the signal of the event */
+                QS_OBJ_(me);              /* this active object */
+                QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+                QS_EQC_(nFree);           /* number of free entries */
+                QS_EQC_(me->eQueue.nMin); /* min number of free entries */
+            QS_END_NOCRIT_()
+
+            /* is it a pool event? */
+            if (e->poolId_ != (uint8_t)0) {
+                QF_EVT_REF_CTR_INC_(e); /* increment the reference counter */
+            }
+
+            --nFree; /* one free entry just used up */
+            me->eQueue.nFree = nFree;       /* update the volatile */
+            if (me->eQueue.nMin > nFree) {
+                me->eQueue.nMin = nFree;    /* update minimum so far */
+            }
+
+            /* empty queue? */
+            if (me->eQueue.frontEvt == (QEvt const *)0) {
+                me->eQueue.frontEvt = e;    /* deliver event directly */
+                taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+                /* signal the event queue */
+                QActive_notifyFromISR_(me, pxHigherPriorityTaskWoken);
+            }
+            /* queue is not empty, insert event into the ring-buffer */
+            else {
+                QF_PTR_AT_(me->eQueue.ring, me->eQueue.head) = e;
+                if (me->eQueue.head == (QEQueueCtr)0) { /* wrap head? */
+                    me->eQueue.head = me->eQueue.end;   /* wrap around */
+                }
+                --me->eQueue.head; /* advance the head (counter clockwise) */
+                taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+            }
+        }
+        else {
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_ATTEMPT,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();           /* timestamp */
+                QS_OBJ_(sender);      /* the sender object */
+                QS_SIG_(e->sig);      /* the signal of the event */
+                QS_OBJ_(me);          /* this active object (recipient) */
+                QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+                QS_EQC_(nFree);       /* number of free entries */
+                QS_EQC_(margin);      /* margin requested */
+            QS_END_NOCRIT_()
+
+            taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+            QF_gcFromISR(e); /* recycle the event to avoid a leak */
+        }
+    }
+
+    return status;
+}
+#ifdef QF_ACTIVE_URGENT
+/*..........................................................................*/
+/* the "FromISR" variant of QActive_postUrgent_() */
+#ifdef Q_SPY
+bool QActive_postUrgentFromISR_(QActive * const me, QEvt const * const e,
+                          uint_fast16_t const margin,
+                          BaseType_t * const pxHigherPriorityTaskWoken,
+                          void const * const sender)
+#else
+bool QActive_postUrgentFromISR_(QActive * const me, QEvt const * const e,
+                          uint_fast16_t const margin,
+                          BaseType_t * const pxHigherPriorityTaskWoken)
+#endif
+{
+    QEQueueCtr nFree; /* temporary to avoid UB for volatile access */
+    bool status;
+    UBaseType_t uxSavedInterruptState;
+
+    /** @pre event pointer must be valid and the urgent lane initialized */
+    Q_REQUIRE_ID(460, (e != (QEvt const *)0)
+                      && (me->urgBurst != (uint8_t)0));
+
+    uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
+    nFree = me->urgQueue.nFree; /* get volatile into the temporary */
+
+    if (margin == QF_NO_MARGIN) {
+        if (nFree > (QEQueueCtr)0) {
+            status = true; /* can post */
+        }
+        else {
+            status = false; /* cannot post */
+            Q_ERROR_ID(470); /* must be able to post the event */
+        }
+    }
+    else if (nFree > (QEQueueCtr)margin) {
+        status = true; /* can post */
+    }
+    else {
+        status = false; /* cannot post */
+    }
+
+    if (status) { /* can post the event? */
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_FIFO,
+                         QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();               /* timestamp */
+            QS_OBJ_(sender);          /* the sender object */
+            QS_SIG_(e->sig);          /* the signal of the event */
+            QS_OBJ_(me);              /* this active object (recipient) */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(nFree);           /* number of free entries */
+            QS_EQC_(me->urgQueue.nMin); /* min number of free entries */
+        QS_END_NOCRIT_()
+
+        /* is it a pool event? */
+        if (e->poolId_ != (uint8_t)0) {
+            QF_EVT_REF_CTR_INC_(e); /* increment the reference counter */
+        }
+
+        --nFree; /* one free entry just used up */
+        me->urgQueue.nFree = nFree;     /* update the volatile */
+        if (me->urgQueue.nMin > nFree) {
+            me->urgQueue.nMin = nFree;  /* update minimum so far */
+        }
+
+        /* empty urgent lane? */
+        if (me->urgQueue.frontEvt == (QEvt const *)0) {
+            me->urgQueue.frontEvt = e;  /* deliver event directly */
+            taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+            /* signal the event queue */
+            QActive_notifyFromISR_(me, pxHigherPriorityTaskWoken);
+        }
+        /* lane is not empty, insert event into the ring-buffer */
+        else {
+            QF_PTR_AT_(me->urgQueue.ring, me->urgQueue.head) = e;
+            if (me->urgQueue.head == (QEQueueCtr)0) { /* wrap head? */
+                me->urgQueue.head = me->urgQueue.end; /* wrap around */
+            }
+            --me->urgQueue.head; /* advance the head (counter clockwise) */
+            taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+        }
+    }
+    else {
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_ATTEMPT,
+                         QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();           /* timestamp */
+            QS_OBJ_(sender);      /* the sender object */
+            QS_SIG_(e->sig);      /* the signal of the event */
+            QS_OBJ_(me);          /* this active object (recipient) */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(nFree);       /* number of free entries */
+            QS_EQC_(margin);      /* margin requested */
+        QS_END_NOCRIT_()
+
+        taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+        QF_gcFromISR(e); /* recycle the event to avoid a leak */
+    }
+
+    return status;
+}
+#endif /* QF_ACTIVE_URGENT */
+/*..........................................................................*/
 #ifdef Q_SPY
 void QF_publishFromISR_(QEvt const * const e,
                         BaseType_t * const pxHigherPriorityTaskWoken,
@@ -280,7 +794,7 @@ void QF_publishFromISR_(QEvt const * const e,
     }
 
     /* make a local, modifiable copy of the subscriber list */
-    subscrList = QF_PTR_AT_(QF_subscrList_, e->sig);
+    subscrList = QF_SUBSCR_LIST_(e->sig);
     taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
 
     if (QPSet_notEmpty(&subscrList)) { /* any subscribers? */
@@ -595,3 +1109,217 @@ void *QMPool_getFromISR(QMPool * const me, uint_fast16_t const margin) {
     return fb; /* return the pointer to memory block or NULL to the caller */
 }
 
+/*==========================================================================*/
+/* QF broadcast, see NOTE5 in qf_port.h */
+static QEvt const *l_bcastEvt[QF_MAX_ACTIVE + 1]; /* event of each channel */
+static QPSet l_bcastSubscr[QF_MAX_ACTIVE + 1];  /* subscribers of channels */
+
+/*..........................................................................*/
+void QF_bcastInit(uint_fast8_t const bcastId, QEvt const * const e) {
+    QF_CRIT_STAT_
+
+    /** @pre the channel must be in range and the event must be immutable
+    * (static), because it is shared by all the subscribers at all times
+    */
+    Q_REQUIRE_ID(1000, ((uint_fast8_t)0 < bcastId)
+                       && (bcastId <= (uint_fast8_t)QF_MAX_ACTIVE)
+                       && (e != (QEvt const *)0)
+                       && (e->poolId_ == (uint8_t)0));
+
+    QF_CRIT_ENTRY_();
+    l_bcastEvt[bcastId] = e;
+    QPSet_setEmpty(&l_bcastSubscr[bcastId]);
+    QF_CRIT_EXIT_();
+}
+/*..........................................................................*/
+void QActive_bcastSubscribe(QActive const * const me,
+                            uint_fast8_t const bcastId)
+{
+    uint_fast8_t p = (uint_fast8_t)me->prio;
+    QF_CRIT_STAT_
+
+    Q_REQUIRE_ID(1010, ((uint_fast8_t)0 < bcastId)
+              && (bcastId <= (uint_fast8_t)QF_MAX_ACTIVE)
+              && (l_bcastEvt[bcastId] != (QEvt const *)0)
+              && ((uint_fast8_t)0 < p) && (p <= (uint_fast8_t)QF_MAX_ACTIVE)
+              && (QF_active_[p] == me));
+
+    QF_CRIT_ENTRY_();
+    QPSet_insert(&l_bcastSubscr[bcastId], p);
+    QF_CRIT_EXIT_();
+}
+/*..........................................................................*/
+/* NOTE: a broadcast that is already pending for the AO is still delivered */
+void QActive_bcastUnsubscribe(QActive const * const me,
+                              uint_fast8_t const bcastId)
+{
+    uint_fast8_t p = (uint_fast8_t)me->prio;
+    QF_CRIT_STAT_
+
+    Q_REQUIRE_ID(1020, ((uint_fast8_t)0 < bcastId)
+              && (bcastId <= (uint_fast8_t)QF_MAX_ACTIVE)
+              && ((uint_fast8_t)0 < p) && (p <= (uint_fast8_t)QF_MAX_ACTIVE)
+              && (QF_active_[p] == me));
+
+    QF_CRIT_ENTRY_();
+    QPSet_remove(&l_bcastSubscr[bcastId], p);
+    QF_CRIT_EXIT_();
+}
+/*..........................................................................*/
+#ifdef Q_SPY
+void QF_bcast_(uint_fast8_t const bcastId, void const * const sender)
+#else
+void QF_bcast_(uint_fast8_t const bcastId)
+#endif
+{
+    QPSet subscrList; /* local, modifiable copy of the subscriber list */
+    QPSet idleList;   /* subscribers blocked on their empty queues */
+    QF_CRIT_STAT_
+
+    /** @pre the broadcast channel must be initialized */
+    Q_REQUIRE_ID(1100, ((uint_fast8_t)0 < bcastId)
+                       && (bcastId <= (uint_fast8_t)QF_MAX_ACTIVE)
+                       && (l_bcastEvt[bcastId] != (QEvt const *)0));
+
+    QPSet_setEmpty(&idleList);
+
+    QF_CRIT_ENTRY_();
+
+    QS_BEGIN_NOCRIT_(QS_QF_PUBLISH, (void *)0, (void *)0)
+        QS_TIME_();          /* the timestamp */
+        QS_OBJ_(sender);     /* the sender object */
+        QS_SIG_(l_bcastEvt[bcastId]->sig); /* the signal of the event */
+    QS_END_NOCRIT_()
+
+    /* mark the broadcast pending in all subscribers at once */
+    subscrList = l_bcastSubscr[bcastId];
+    while (QPSet_notEmpty(&subscrList)) {
+        uint_fast8_t p;
+        QActive *a;
+
+        QPSet_findMax(&subscrList, p);
+        a = QF_active_[p];
+
+        /* the prio of the AO must be registered with the framework */
+        Q_ASSERT_CRIT_(1110, a != (QActive *)0);
+
+        /* only the AOs waiting in QACTIVE_EQUEUE_WAIT_() need notifying */
+        if ((a->eQueue.frontEvt == (QEvt const *)0)
+            && QPSet_isEmpty(&a->osObject))
+        {
+            QPSet_insert(&idleList, p);
+        }
+        QPSet_insert(&a->osObject, bcastId);
+        QPSet_remove(&subscrList, p);
+    }
+
+    QF_CRIT_EXIT_();
+
+    if (QPSet_notEmpty(&idleList)) { /* any AOs to wake up? */
+        uint_fast8_t p;
+        QF_SCHED_STAT_
+
+        QPSet_findMax(&idleList, p); /* the highest-prio AO to wake up */
+
+        QF_SCHED_LOCK_(p); /* lock the scheduler up to prio 'p' */
+        do {
+            QActive_notify_(QF_active_[p]);
+
+            QPSet_remove(&idleList, p);
+            QPSet_findMax(&idleList, p); /* zero when no more AOs */
+        } while (p != (uint_fast8_t)0);
+        QF_SCHED_UNLOCK_(); /* unlock the scheduler */
+    }
+}
+/*..........................................................................*/
+#ifdef Q_SPY
+void QF_bcastFromISR_(uint_fast8_t const bcastId,
+                      BaseType_t * const pxHigherPriorityTaskWoken,
+                      void const * const sender)
+#else
+void QF_bcastFromISR_(uint_fast8_t const bcastId,
+                      BaseType_t * const pxHigherPriorityTaskWoken)
+#endif
+{
+    QPSet subscrList; /* local, modifiable copy of the subscriber list */
+    QPSet idleList;   /* subscribers blocked on their empty queues */
+    UBaseType_t uxSavedInterruptState;
+
+    /** @pre the broadcast channel must be initialized */
+    Q_REQUIRE_ID(1200, ((uint_fast8_t)0 < bcastId)
+                       && (bcastId <= (uint_fast8_t)QF_MAX_ACTIVE)
+                       && (l_bcastEvt[bcastId] != (QEvt const *)0));
+
+    QPSet_setEmpty(&idleList);
+
+    uxSavedInterruptState = taskENTER_CRITICAL_FROM_ISR();
+
+    QS_BEGIN_NOCRIT_(QS_QF_PUBLISH, (void *)0, (void *)0)
+        QS_TIME_();          /* the timestamp */
+        QS_OBJ_(sender);     /* the sender object */
+        QS_SIG_(l_bcastEvt[bcastId]->sig); /* the signal of the event */
+    QS_END_NOCRIT_()
+
+    subscrList = l_bcastSubscr[bcastId];
+    while (QPSet_notEmpty(&subscrList)) {
+        uint_fast8_t p;
+        QActive *a;
+
+        QPSet_findMax(&subscrList, p);
+        a = QF_active_[p];
+
+        /* the prio of the AO must be registered with the framework */
+        Q_ASSERT_ID(1210, a != (QActive *)0);
+
+        if ((a->eQueue.frontEvt == (QEvt const *)0)
+            && QPSet_isEmpty(&a->osObject))
+        {
+            QPSet_insert(&idleList, p);
+        }
+        QPSet_insert(&a->osObject, bcastId);
+        QPSet_remove(&subscrList, p);
+    }
+
+    taskEXIT_CRITICAL_FROM_ISR(uxSavedInterruptState);
+
+    /* no need to lock the scheduler in the ISR context */
+    while (QPSet_notEmpty(&idleList)) {
+        uint_fast8_t p;
+
+        QPSet_findMax(&idleList, p);
+        QActive_notifyFromISR_(QF_active_[p], pxHigherPriorityTaskWoken);
+        QPSet_remove(&idleList, p);
+    }
+}
+/*..........................................................................*/
+/* called from QActive_get_() inside the critical section */
+QEvt const *QF_bcastGet_(QActive * const me) {
+    QEvt const *e;
+
+    if (QPSet_notEmpty(&me->osObject)) {
+        uint_fast8_t b;
+
+        QPSet_findMax(&me->osObject, b); /* the highest pending channel */
+        QPSet_remove(&me->osObject, b);
+        e = l_bcastEvt[b];
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_GET, QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();                   /* timestamp */
+            QS_SIG_(e->sig);              /* the signal of this event */
+            QS_OBJ_(me);                  /* this active object */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(me->eQueue.nFree);    /* number of free entries */
+        QS_END_NOCRIT_()
+    }
+    else {
+        e = (QEvt const *)0;
+    }
+    return e;
+}
+
+/*****************************************************************************
+* NOTE1:
+* FreeRTOS copies the task name into the TCB, so the default name can be
+* built in a local buffer. The QF priority in the name lets the run-time
+* statistics tell the active objects apart (see rt_stats.c).
+*/
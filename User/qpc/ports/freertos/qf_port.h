@@ -44,9 +44,28 @@
 #define QF_EQUEUE_TYPE        QEQueue
 #define QF_THREAD_TYPE        StaticTask_t
 
+/* per-AO set of pending broadcasts, see NOTE5 */
+#define QF_OS_OBJECT_TYPE     QPSet
+
 /* The maximum number of active objects in the application, see NOTE1 */
 #define QF_MAX_ACTIVE         32
 
+/* define to keep the subscriber lists in a sparse table, see NOTE6 */
+/* #define QF_PS_SPARSE */
+
+/* define to give AOs an urgent lane in the event queue, see NOTE7 */
+/* #define QF_ACTIVE_URGENT */
+
+/* define to run the AOs started without a stack in one task, see NOTE8 */
+/* #define QF_SHARED_STACK */
+
+#ifdef QF_SHARED_STACK
+    /* stack of the dispatcher task of the shared AOs [bytes] */
+    #ifndef QF_SHARED_STACK_SIZE
+        #define QF_SHARED_STACK_SIZE  1024U
+    #endif
+#endif
+
 /* QF interrupt disabling/enabling (task level) */
 #define QF_INT_DISABLE()      taskDISABLE_INTERRUPTS()
 #define QF_INT_ENABLE()       taskENABLE_INTERRUPTS()
@@ -75,6 +94,16 @@
         (QActive_postFromISR_((me_), (e_), (margin_), \
                               (pxHigherPrioTaskWoken_), (sender_)))
 
+    #define QACTIVE_POST_COALESCE_FROM_ISR(me_, e_, \
+                                           pxHigherPrioTaskWoken_, sender_) \
+        ((void)QActive_postCoalesceFromISR_((me_), (e_), QF_NO_MARGIN, \
+                                    (pxHigherPrioTaskWoken_), (sender_)))
+
+    #define QACTIVE_POST_URGENT_FROM_ISR(me_, e_, \
+                                         pxHigherPrioTaskWoken_, sender_) \
+        ((void)QActive_postUrgentFromISR_((me_), (e_), QF_NO_MARGIN, \
+                                    (pxHigherPrioTaskWoken_), (sender_)))
+
     #define QF_PUBLISH_FROM_ISR(e_, pxHigherPrioTaskWoken_, sender_) \
         (QF_publishFromISR_((e_), (pxHigherPrioTaskWoken_), \
                             (void const *)(sender_)))
@@ -90,6 +119,18 @@
                               BaseType_t * const pxHigherPriorityTaskWoken,
                               void const * const sender);
 
+    bool QActive_postCoalesceFromISR_(QActive * const me,
+                              QEvt const * const e,
+                              uint_fast16_t const margin,
+                              BaseType_t * const pxHigherPriorityTaskWoken,
+                              void const * const sender);
+
+    bool QActive_postUrgentFromISR_(QActive * const me,
+                              QEvt const * const e,
+                              uint_fast16_t const margin,
+                              BaseType_t * const pxHigherPriorityTaskWoken,
+                              void const * const sender);
+
     void QF_publishFromISR_(QEvt const * const e,
                               BaseType_t * const pxHigherPriorityTaskWoken,
                               void const * const sender);
@@ -107,6 +148,16 @@
         (QActive_postFromISR_((me_), (e_), (margin_), \
                               (pxHigherPrioTaskWoken_)))
 
+    #define QACTIVE_POST_COALESCE_FROM_ISR(me_, e_, \
+                                           pxHigherPrioTaskWoken_, dummy) \
+        ((void)QActive_postCoalesceFromISR_((me_), (e_), QF_NO_MARGIN, \
+                                            (pxHigherPrioTaskWoken_)))
+
+    #define QACTIVE_POST_URGENT_FROM_ISR(me_, e_, \
+                                         pxHigherPrioTaskWoken_, dummy) \
+        ((void)QActive_postUrgentFromISR_((me_), (e_), QF_NO_MARGIN, \
+                                          (pxHigherPrioTaskWoken_)))
+
     #define QF_PUBLISH_FROM_ISR(e_, pxHigherPrioTaskWoken_, dummy) \
         (QF_publishFromISR_((e_), (pxHigherPrioTaskWoken_)))
 
@@ -117,6 +168,16 @@
                               uint_fast16_t const margin,
                               BaseType_t * const pxHigherPriorityTaskWoken);
 
+    bool QActive_postCoalesceFromISR_(QActive * const me,
+                              QEvt const * const e,
+                              uint_fast16_t const margin,
+                              BaseType_t * const pxHigherPriorityTaskWoken);
+
+    bool QActive_postUrgentFromISR_(QActive * const me,
+                              QEvt const * const e,
+                              uint_fast16_t const margin,
+                              BaseType_t * const pxHigherPriorityTaskWoken);
+
     void QF_publishFromISR_(QEvt const * const e,
                               BaseType_t * const pxHigherPriorityTaskWoken);
 
@@ -155,6 +216,38 @@
 
 void QF_gcFromISR(QEvt const * const e);
 
+/* QF broadcast (signal barrier) for high-rate multicasts, see NOTE5 */
+void QF_bcastInit(uint_fast8_t const bcastId, QEvt const * const e);
+void QActive_bcastSubscribe(QActive const * const me,
+                            uint_fast8_t const bcastId);
+void QActive_bcastUnsubscribe(QActive const * const me,
+                              uint_fast8_t const bcastId);
+
+#ifdef Q_SPY
+    #define QF_BCAST(bcastId_, sender_) \
+        (QF_bcast_((bcastId_), (void const *)(sender_)))
+
+    #define QF_BCAST_FROM_ISR(bcastId_, pxHigherPrioTaskWoken_, sender_) \
+        (QF_bcastFromISR_((bcastId_), (pxHigherPrioTaskWoken_), \
+                          (void const *)(sender_)))
+
+    void QF_bcast_(uint_fast8_t const bcastId, void const * const sender);
+
+    void QF_bcastFromISR_(uint_fast8_t const bcastId,
+                          BaseType_t * const pxHigherPriorityTaskWoken,
+                          void const * const sender);
+#else
+    #define QF_BCAST(bcastId_, dummy) (QF_bcast_(bcastId_))
+
+    #define QF_BCAST_FROM_ISR(bcastId_, pxHigherPrioTaskWoken_, dummy) \
+        (QF_bcastFromISR_((bcastId_), (pxHigherPrioTaskWoken_)))
+
+    void QF_bcast_(uint_fast8_t const bcastId);
+
+    void QF_bcastFromISR_(uint_fast8_t const bcastId,
+                          BaseType_t * const pxHigherPriorityTaskWoken);
+#endif
+
 /* this function only to be used through macros Q_NEW_FROM_ISR() and
 * Q_NEW_X_FROM_ISR().
 */
@@ -165,7 +258,8 @@ void *QMPool_getFromISR(QMPool * const me, uint_fast16_t const margin);
 void QMPool_putFromISR(QMPool * const me, void *b);
 
 enum FreeRTOS_TaskAttrs {
-    TASK_NAME_ATTR
+    TASK_NAME_ATTR,
+    TASK_THRESHOLD_ATTR /* preemption threshold (QF prio), see NOTE9 */
 };
 
 /* FreeRTOS hooks prototypes (not provided by FreeRTOS) */
@@ -188,24 +282,63 @@ enum FreeRTOS_TaskAttrs {
 * interface used only inside QF, but not in applications
 */
 #ifdef QP_IMPL
-    /* FreeRTOS blocking for event queue implementation (task level) */
+    /* FreeRTOS blocking for event queue implementation (task level),
+    * pending broadcasts and urgent events also unblock the AO, see NOTE5
+    */
     #define QACTIVE_EQUEUE_WAIT_(me_) \
-        while ((me_)->eQueue.frontEvt == (QEvt *)0) { \
+        while (QACTIVE_IDLE_(me_)) { \
             QF_CRIT_EXIT_(); \
             ulTaskNotifyTake(pdTRUE, portMAX_DELAY); \
             QF_CRIT_ENTRY_(); \
         }
 
+    /* nothing to dispatch: no events in any lane and no broadcasts */
+    #define QACTIVE_IDLE_(me_) \
+        (((me_)->eQueue.frontEvt == (QEvt *)0) \
+         && QACTIVE_URGENT_EMPTY_(me_) \
+         && QPSet_isEmpty(&(me_)->osObject))
+
+    /* is the urgent lane of the event queue empty? see NOTE7 */
+    #ifdef QF_ACTIVE_URGENT
+        #define QACTIVE_URGENT_EMPTY_(me_) \
+            ((me_)->urgQueue.frontEvt == (QEvt *)0)
+    #else
+        #define QACTIVE_URGENT_EMPTY_(me_) (1)
+    #endif
+
+    /* take a pending broadcast before the queued events (crit. section) */
+    #define QACTIVE_BCAST_GET_(me_) (QF_bcastGet_((me_)))
+    QEvt const *QF_bcastGet_(QActive * const me);
+
     /* FreeRTOS signaling (unblocking) for event queue (task level) */
     #define QACTIVE_EQUEUE_SIGNAL_(me_) do { \
         QF_CRIT_EXIT_(); \
-        xTaskNotifyGive((TaskHandle_t)&(me_)->thread); \
+        QActive_notify_((me_)); \
         QF_CRIT_ENTRY_(); \
     } while (0)
 
-    #define QF_SCHED_STAT_
-    #define QF_SCHED_LOCK_(dummy) vTaskSuspendAll()
-    #define QF_SCHED_UNLOCK_()    xTaskResumeAll()
+    /* priority-ceiling scheduler lock (task level), see NOTE9 */
+    typedef uint_fast16_t QSchedStatus;
+
+    #define QF_SCHED_STAT_ QSchedStatus lockStat_;
+    #define QF_SCHED_LOCK_(prio_) (lockStat_ = QF_schedLock_((prio_)))
+    #define QF_SCHED_UNLOCK_()    (QF_schedUnlock_(lockStat_))
+
+    QSchedStatus QF_schedLock_(uint_fast8_t const ceiling);
+    void QF_schedUnlock_(QSchedStatus const stat);
+
+    #ifdef QF_SHARED_STACK
+        /* the thread of a shared AO is the dispatcher task, see NOTE8 */
+        void QActive_notify_(QActive * const me);
+        void QActive_notifyFromISR_(QActive * const me,
+                              BaseType_t * const pxHigherPriorityTaskWoken);
+    #else
+        #define QActive_notify_(me_) \
+            ((void)xTaskNotifyGive((TaskHandle_t)&(me_)->thread))
+        #define QActive_notifyFromISR_(me_, pxHigherPrioTaskWoken_) \
+            (vTaskNotifyGiveFromISR((TaskHandle_t)&(me_)->thread, \
+                                    (pxHigherPrioTaskWoken_)))
+    #endif
 
     /* native QF event pool operations */
     #define QF_EPOOL_TYPE_            QMPool
@@ -234,6 +367,95 @@ enum FreeRTOS_TaskAttrs {
 * provides the "FromISR" variants for QP functions and "FROM_ISR" variants
 * for QP macros to be used inside ISRs. ONLY THESE "FROM_ISR" VARIANTS
 * ARE ALLOWED INSIDE ISRs AND CALLING THE TASK-LEVEL APIs IS AN ERROR.
+*
+* NOTE5:
+* The broadcast is a cheaper alternative to QF_PUBLISH() for very frequent
+* "tick-like" multicasts (e.g. a 1kHz control-loop sync). Each broadcast
+* channel (1..QF_MAX_ACTIVE) is bound to one immutable (static) event with
+* QF_bcastInit(). QF_BCAST() only inserts the channel into the pending set
+* (osObject) of every subscriber and notifies the AOs that were idle; it
+* does not use any queue entries and does not touch reference counters.
+* A pending broadcast is dispatched before the queued events, the higher
+* channels first. A broadcast that is still pending when the next one
+* arrives is delivered only once (the broadcasts are coalesced).
+*
+* NOTE6:
+* By default QF_psInit() takes a dense array of subscriber lists with one
+* QSubscrList (4 bytes for QF_MAX_ACTIVE 32) per signal up to the maximum
+* published signal. With QF_PS_SPARSE defined, QF_psInitSparse() takes a
+* table sorted by signal with one QSubscrEntry (8 bytes) per signal that
+* currently has subscribers. The sparse table is smaller as long as less
+* than half of the signals are subscribed. Publishing then costs a binary
+* search, and QActive_unsubscribeAll() visits only the subscribed signals
+* (one critical section) instead of every signal (one critical section
+* each).
+*
+* NOTE7:
+* With QF_ACTIVE_URGENT defined, every AO has a second (urgent) lane in its
+* event queue, which is enabled per AO by QActive_urgentInit() before
+* QACTIVE_START(). Events posted with QACTIVE_POST_URGENT() (or
+* QACTIVE_POST_URGENT_FROM_ISR()) are dispatched ahead of the events
+* waiting in the normal lane, so a fault or an emergency stop is not stuck
+* behind a deep backlog of routine traffic. To keep the normal lane from
+* starving, no more than the given burst of urgent events is dispatched in
+* a row while normal events wait. Pending broadcasts (NOTE5) still go
+* first. Both lanes share the task notification, so a post to a lane that
+* was empty notifies the AO thread even when the other lane is not empty;
+* the extra notification only costs one more pass of the wait loop.
+*
+* NOTE8:
+* With QF_SHARED_STACK defined, an AO started with a NULL stack storage
+* (and zero stack size) does not get its own FreeRTOS task. All such
+* "shared" AOs run to completion in one dispatcher task with a stack of
+* QF_SHARED_STACK_SIZE bytes, created in QF_run() at the FreeRTOS priority
+* of the highest shared AO. The dispatcher keeps a QPSet ready-set of the
+* shared AOs with events and schedules them like QK: a post from a shared
+* AO to a higher-priority shared AO runs the recipient right away, nested
+* on the same stack above the active priority (the preemption threshold),
+* while a post to a lower one waits until the sender's RTC step completes.
+* Posts from ISRs and from the dedicated tasks only ready the AO and
+* notify the dispatcher, so a shared AO readied that way waits for the RTC
+* step in progress, however low its priority. That is the price for the
+* stacks: each shared AO saves its whole stack (typically 256..512 bytes),
+* but its worst-case latency grows by the longest RTC step of the lower
+* shared AOs. Code that blocks (waits on a semaphore, delays) must keep a
+* dedicated task, and so should the AOs with tight deadlines. All shared
+* AOs must be started before QF_run().
+* The dispatcher runs every shared AO at the FreeRTOS priority of the
+* highest one, so the shared AOs must take a contiguous band of priorities
+* with no dedicated AO inside: a dedicated AO between two shared ones
+* would wait for the RTC step of the lower one, and for every task that
+* preempts the dispatcher meanwhile (an unbounded priority inversion).
+* Raising the dispatcher only while it runs a high AO does not help, the
+* posts from ISRs cannot change its priority. QF_run() and QACTIVE_START()
+* assert the band; the other tasks (e.g. the FreeRTOS timer task) must
+* not use a priority inside it either.
+*
+* NOTE9:
+* An AO of priority 'p' can be given a preemption threshold 't' (p <= t)
+* with QActive_setAttr(me, TASK_THRESHOLD_ATTR, (void const *)t) before
+* QACTIVE_START(). The AO waits for events at the FreeRTOS priority of
+* 'p', but once it runs it raises its task to the priority of 't' and
+* stays there until its queue is empty. Only the AOs above 't' can then
+* preempt it, so a group of AOs that exchange many events (for example a
+* producer and its consumer) is given the same threshold and each member
+* processes a burst of events before the next one is switched in, instead
+* of a context switch on every post. The shared AOs (NOTE8) use the
+* threshold as the active priority of the dispatcher, without changing
+* the task priority.
+* QF_SCHED_LOCK_(ceiling), used to multicast events in QF_publish_() and
+* QF_bcast_(), does not suspend all tasks. It raises the calling task to
+* the FreeRTOS priority of the ceiling (and the dispatcher threshold) for
+* the duration of the lock, so only the AOs and tasks above the ceiling
+* keep preempting. vTaskPrioritySet() changes the base priority of the
+* task, so the lock saves and restores the base priority too: a task that
+* holds a mutex may run at a priority inherited from a waiter, and
+* restoring that one would keep the task there after the mutex is given
+* back. FreeRTOS 10.2 has no getter for the base priority, the port reads
+* it with vTaskGetInfo() (configUSE_TRACE_FACILITY). The threshold of an
+* AO task is set the same way and survives an inherited priority.
+* The context switches of every task are counted in the run-time
+* statistics (rt_stats), which show the effect of a threshold.
 */
 
 #endif /* qf_port_h */
@@ -304,6 +304,363 @@ void QActive_postLIFO_(QActive * const me, QEvt const * const e) {
     QF_CRIT_EXIT_();
 }
 
+/****************************************************************************/
+/**
+* @description
+* Finds the event with the same signal as @p e, which still waits in the
+* event queue of the active object @p me (including the front event), and
+* replaces it in place by @p e.
+*
+* @param[in,out] me  pointer (see @ref oop)
+* @param[in]     e   pointer to the new event
+*
+* @returns
+* the replaced event, which the caller must recycle with QF_gc() after
+* leaving the critical section, or NULL if no event with the signal
+* @p e->sig waits in the queue (the queue is not changed then).
+*
+* @note
+* This function must be called inside a critical section. It scans the
+* used part of the queue, so its cost grows with the queue fill level.
+*/
+QEvt const *QActive_coalesce_(QActive * const me, QEvt const * const e) {
+    QEvt const *old = me->eQueue.frontEvt; /* temporary for volatile */
+
+    if (old != (QEvt const *)0) { /* any events waiting? */
+        if (old->sig == e->sig) {
+            me->eQueue.frontEvt = e; /* replace the front event */
+        }
+        else {
+            /* the number of events in the ring buffer */
+            QEQueueCtr n = me->eQueue.end - me->eQueue.nFree;
+            QEQueueCtr i = me->eQueue.tail;
+
+            old = (QEvt const *)0;
+            while (n != (QEQueueCtr)0) { /* from the oldest to the newest */
+                if (QF_PTR_AT_(me->eQueue.ring, i)->sig == e->sig) {
+                    old = QF_PTR_AT_(me->eQueue.ring, i);
+                    QF_PTR_AT_(me->eQueue.ring, i) = e; /* replace in place */
+                    break;
+                }
+                if (i == (QEQueueCtr)0) { /* need to wrap? */
+                    i = me->eQueue.end;
+                }
+                --i;
+                --n;
+            }
+        }
+
+        /* replaced a waiting event? */
+        if ((old != (QEvt const *)0) && (e->poolId_ != (uint8_t)0)) {
+            QF_EVT_REF_CTR_INC_(e); /* the queue holds a new reference */
+        }
+    }
+    return old;
+}
+
+/****************************************************************************/
+/**
+* @description
+* Posts the event @p e to the active object @p me, unless an event with the
+* same signal still waits in its queue, in which case the waiting event is
+* replaced in place by @p e (last value wins) and is recycled.
+*
+* @param[in,out] me     pointer (see @ref oop)
+* @param[in]     e      pointer to the event to be posted
+* @param[in]     margin number of required free slots in the queue after
+*                       posting the event, when the event needs a new slot.
+*                       The special value #QF_NO_MARGIN means that this
+*                       function will assert if posting fails.
+*
+* @returns
+* 'true' (success) if the event was coalesced or posted and 'false' when
+* the posting failed.
+*
+* @attention
+* This function should be called only via the macro QACTIVE_POST_COALESCE()
+* or QACTIVE_POST_COALESCE_X().
+*
+* @sa QActive_post_(), QActive_coalesce_()
+*/
+#ifndef Q_SPY
+bool QActive_postCoalesce_(QActive * const me, QEvt const * const e,
+                           uint_fast16_t const margin)
+#else
+bool QActive_postCoalesce_(QActive * const me, QEvt const * const e,
+                           uint_fast16_t const margin,
+                           void const * const sender)
+#endif
+{
+    QEvt const *old;
+    QEQueueCtr nFree; /* temporary to avoid UB for volatile access */
+    bool status;
+    QF_CRIT_STAT_
+
+    /** @pre event pointer must be valid */
+    Q_REQUIRE_ID(250, e != (QEvt const *)0);
+
+    QF_CRIT_ENTRY_();
+    old = QActive_coalesce_(me, e);
+
+    if (old != (QEvt const *)0) { /* replaced the waiting event? */
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_FIFO,
+                         QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();               /* timestamp */
+            QS_OBJ_(sender);          /* the sender object */
+            QS_SIG_(e->sig);          /* the signal of the event */
+            QS_OBJ_(me);              /* this active object (recipient) */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(me->eQueue.nFree); /* number of free entries */
+            QS_EQC_(me->eQueue.nMin);  /* min number of free entries */
+        QS_END_NOCRIT_()
+
+        QF_CRIT_EXIT_();
+
+        QF_gc(old); /* the queue no longer references the old event */
+        status = true;
+    }
+    else {
+        /* no event to replace, FIFO posting in the same critical section,
+        * so that another producer cannot queue the same signal in between
+        */
+        nFree = me->eQueue.nFree; /* get volatile into the temporary */
+
+        if (margin == QF_NO_MARGIN) {
+            if (nFree > (QEQueueCtr)0) {
+                status = true; /* can post */
+            }
+            else {
+                status = false; /* cannot post */
+                Q_ERROR_CRIT_(255); /* must be able to post the event */
+            }
+        }
+        else if (nFree > (QEQueueCtr)margin) {
+            status = true; /* can post */
+        }
+        else {
+            status = false; /* cannot post, but don't assert */
+        }
+
+        /* is it a dynamic event? */
+        if (e->poolId_ != (uint8_t)0) {
+            QF_EVT_REF_CTR_INC_(e); /* increment the reference counter */
+        }
+
+        if (status) { /* can post the event? */
+
+            --nFree; /* one free entry just used up */
+            me->eQueue.nFree = nFree; /* update the volatile */
+            if (me->eQueue.nMin > nFree) {
+                me->eQueue.nMin = nFree; /* increase minimum so far */
+            }
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_FIFO,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();               /* timestamp */
+                QS_OBJ_(sender);          /* the sender object */
+                QS_SIG_(e->sig);          /* the signal of the event */
+                QS_OBJ_(me);              /* this active object */
+                QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+                QS_EQC_(nFree);           /* number of free entries */
+                QS_EQC_(me->eQueue.nMin); /* min number of free entries */
+            QS_END_NOCRIT_()
+
+            /* empty queue? */
+            if (me->eQueue.frontEvt == (QEvt const *)0) {
+                me->eQueue.frontEvt = e;    /* deliver event directly */
+                QACTIVE_EQUEUE_SIGNAL_(me); /* signal the event queue */
+            }
+            /* queue is not empty, insert event into the ring-buffer */
+            else {
+                QF_PTR_AT_(me->eQueue.ring, me->eQueue.head) = e;
+
+                if (me->eQueue.head == (QEQueueCtr)0) { /* wrap head? */
+                    me->eQueue.head = me->eQueue.end;   /* wrap around */
+                }
+                --me->eQueue.head; /* advance the head (counter clockwise) */
+            }
+
+            QF_CRIT_EXIT_();
+        }
+        else { /* cannot post the event */
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_ATTEMPT,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();           /* timestamp */
+                QS_OBJ_(sender);      /* the sender object */
+                QS_SIG_(e->sig);      /* the signal of the event */
+                QS_OBJ_(me);          /* this active object (recipient) */
+                QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+                QS_EQC_(nFree);       /* number of free entries */
+                QS_EQC_((QEQueueCtr)margin); /* margin requested */
+            QS_END_NOCRIT_()
+
+            QF_CRIT_EXIT_();
+
+            QF_gc(e); /* recycle the event to avoid a leak */
+        }
+    }
+
+    return status;
+}
+
+#ifdef QF_ACTIVE_URGENT
+/****************************************************************************/
+/**
+* @description
+* Adds the urgent lane to the event queue of the active object @p me. Events
+* posted with QACTIVE_POST_URGENT() wait in this lane and are dispatched
+* ahead of the events waiting in the normal lane, but no more than
+* @p maxBurst urgent events in a row when normal events are waiting, so
+* the normal lane cannot starve.
+*
+* @param[in,out] me       pointer (see @ref oop)
+* @param[in]     qSto     pointer to the storage for the urgent lane
+* @param[in]     qLen     length of the urgent lane (in events)
+* @param[in]     maxBurst max. number of urgent events dispatched in a row
+*                         while normal events are waiting (must be > 0)
+*
+* @note
+* Must be called before QACTIVE_START(), because QActive_ctor() clears
+* the lane and the lane is not protected by a critical section here.
+*/
+void QActive_urgentInit(QActive * const me, QEvt const *qSto[],
+                        uint_fast16_t const qLen, uint8_t const maxBurst)
+{
+    /** @pre the burst limit must not be zero */
+    Q_REQUIRE_ID(290, maxBurst != (uint8_t)0);
+
+    QEQueue_init(&me->urgQueue, qSto, qLen);
+    me->urgBurst = maxBurst;
+    me->urgRun   = (uint8_t)0;
+}
+
+/****************************************************************************/
+/**
+* @description
+* Posts the event @p e to the urgent lane of the active object @p me
+* (FIFO within the lane). The active object must have the urgent lane
+* initialized with QActive_urgentInit().
+*
+* @param[in,out] me     pointer (see @ref oop)
+* @param[in]     e      pointer to the event to be posted
+* @param[in]     margin number of required free slots in the urgent lane
+*                       after posting the event. The special value
+*                       #QF_NO_MARGIN means that this function will assert
+*                       if posting fails.
+*
+* @returns
+* 'true' (success) if the posting succeeded (with the provided margin) and
+* 'false' (failure) when the posting fails.
+*
+* @attention
+* This function should be called only via the macro QACTIVE_POST_URGENT()
+* or QACTIVE_POST_URGENT_X().
+*
+* @sa QActive_post_(), QActive_get_()
+*/
+#ifndef Q_SPY
+bool QActive_postUrgent_(QActive * const me, QEvt const * const e,
+                         uint_fast16_t const margin)
+#else
+bool QActive_postUrgent_(QActive * const me, QEvt const * const e,
+                         uint_fast16_t const margin,
+                         void const * const sender)
+#endif
+{
+    QEQueueCtr nFree; /* temporary to avoid UB for volatile access */
+    bool status;
+    QF_CRIT_STAT_
+
+    /** @pre event pointer must be valid */
+    Q_REQUIRE_ID(260, e != (QEvt const *)0);
+
+    QF_CRIT_ENTRY_();
+
+    /* the urgent lane must be initialized */
+    Q_ASSERT_CRIT_(270, me->urgBurst != (uint8_t)0);
+
+    nFree = me->urgQueue.nFree; /* get volatile into the temporary */
+
+    if (margin == QF_NO_MARGIN) {
+        if (nFree > (QEQueueCtr)0) {
+            status = true; /* can post */
+        }
+        else {
+            status = false; /* cannot post */
+            Q_ERROR_CRIT_(280); /* must be able to post the event */
+        }
+    }
+    else if (nFree > (QEQueueCtr)margin) {
+        status = true; /* can post */
+    }
+    else {
+        status = false; /* cannot post, but don't assert */
+    }
+
+    /* is it a dynamic event? */
+    if (e->poolId_ != (uint8_t)0) {
+        QF_EVT_REF_CTR_INC_(e); /* increment the reference counter */
+    }
+
+    if (status) { /* can post the event? */
+
+        --nFree; /* one free entry just used up */
+        me->urgQueue.nFree = nFree; /* update the volatile */
+        if (me->urgQueue.nMin > nFree) {
+            me->urgQueue.nMin = nFree; /* increase minimum so far */
+        }
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_FIFO,
+                         QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();               /* timestamp */
+            QS_OBJ_(sender);          /* the sender object */
+            QS_SIG_(e->sig);          /* the signal of the event */
+            QS_OBJ_(me);              /* this active object (recipient) */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(nFree);           /* number of free entries */
+            QS_EQC_(me->urgQueue.nMin); /* min number of free entries */
+        QS_END_NOCRIT_()
+
+        /* empty urgent lane? */
+        if (me->urgQueue.frontEvt == (QEvt const *)0) {
+            me->urgQueue.frontEvt = e;  /* deliver event directly */
+            QACTIVE_EQUEUE_SIGNAL_(me); /* signal the event queue */
+        }
+        /* lane is not empty, insert event into the ring-buffer */
+        else {
+            QF_PTR_AT_(me->urgQueue.ring, me->urgQueue.head) = e;
+
+            if (me->urgQueue.head == (QEQueueCtr)0) { /* wrap head? */
+                me->urgQueue.head = me->urgQueue.end; /* wrap around */
+            }
+            --me->urgQueue.head; /* advance the head (counter clockwise) */
+        }
+    }
+    else { /* cannot post the event */
+
+        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_POST_ATTEMPT,
+                         QS_priv_.locFilter[AO_OBJ], me)
+            QS_TIME_();           /* timestamp */
+            QS_OBJ_(sender);      /* the sender object */
+            QS_SIG_(e->sig);      /* the signal of the event */
+            QS_OBJ_(me);          /* this active object (recipient) */
+            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_EQC_(nFree);       /* number of free entries */
+            QS_EQC_((QEQueueCtr)margin); /* margin requested */
+        QS_END_NOCRIT_()
+    }
+    QF_CRIT_EXIT_();
+
+    if (!status) { /* failed to post the event? */
+        QF_gc(e); /* recycle the event to avoid a leak */
+    }
+
+    return status;
+}
+#endif /* QF_ACTIVE_URGENT */
+
 /****************************************************************************/
 /**
 * @description
@@ -334,41 +691,68 @@ QEvt const *QActive_get_(QActive * const me) {
     QF_CRIT_ENTRY_();
     QACTIVE_EQUEUE_WAIT_(me);  /* wait for event to arrive directly */
 
-    e = me->eQueue.frontEvt; /* always remove event from the front location */
-    nFree = me->eQueue.nFree + (QEQueueCtr)1; /* get volatile into tmp */
-    me->eQueue.nFree = nFree; /* update the number of free */
+#ifdef QACTIVE_BCAST_GET_
+    e = QACTIVE_BCAST_GET_(me); /* pending broadcast event, if any */
+#else
+    e = (QEvt const *)0;
+#endif
 
-    /* any events in the ring buffer? */
-    if (nFree <= me->eQueue.end) {
+    if (e == (QEvt const *)0) { /* no broadcast, take the queued event */
+        QEQueue *eq = &me->eQueue; /* the lane to take the event from */
 
-        /* remove event from the tail */
-        me->eQueue.frontEvt = QF_PTR_AT_(me->eQueue.ring, me->eQueue.tail);
-        if (me->eQueue.tail == (QEQueueCtr)0) { /* need to wrap the tail? */
-            me->eQueue.tail = me->eQueue.end;   /* wrap around */
+#ifdef QF_ACTIVE_URGENT
+        if (me->urgQueue.frontEvt != (QEvt const *)0) { /* urgent event? */
+            if (me->eQueue.frontEvt == (QEvt const *)0) { /* nothing else? */
+                eq = &me->urgQueue;
+                me->urgRun = (uint8_t)0; /* normal lane is not starving */
+            }
+            else if (me->urgRun < me->urgBurst) { /* burst not used up? */
+                eq = &me->urgQueue;
+                ++me->urgRun;
+            }
+            else { /* burst used up, let one normal event through */
+                me->urgRun = (uint8_t)0;
+            }
         }
-        --me->eQueue.tail;
+#endif /* QF_ACTIVE_URGENT */
 
-        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_GET, QS_priv_.locFilter[AO_OBJ], me)
-            QS_TIME_();                   /* timestamp */
-            QS_SIG_(e->sig);              /* the signal of this event */
-            QS_OBJ_(me);                  /* this active object */
-            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
-            QS_EQC_(nFree);               /* number of free entries */
-        QS_END_NOCRIT_()
-    }
-    else {
-        me->eQueue.frontEvt = (QEvt const *)0; /* queue becomes empty */
+        e = eq->frontEvt; /* always remove event from the front */
+        nFree = eq->nFree + (QEQueueCtr)1; /* get volatile into tmp */
+        eq->nFree = nFree; /* update the number of free */
 
-        /* all entries in the queue must be free (+1 for fronEvt) */
-        Q_ASSERT_CRIT_(310, nFree == (me->eQueue.end + (QEQueueCtr)1));
+        /* any events in the ring buffer? */
+        if (nFree <= eq->end) {
 
-        QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_GET_LAST,
-                         QS_priv_.locFilter[AO_OBJ], me)
-            QS_TIME_();                   /* timestamp */
-            QS_SIG_(e->sig);              /* the signal of this event */
-            QS_OBJ_(me);                  /* this active object */
-            QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
-        QS_END_NOCRIT_()
+            /* remove event from the tail */
+            eq->frontEvt = QF_PTR_AT_(eq->ring, eq->tail);
+            if (eq->tail == (QEQueueCtr)0) { /* wrap the tail? */
+                eq->tail = eq->end; /* wrap around */
+            }
+            --eq->tail;
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_GET,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();                   /* timestamp */
+                QS_SIG_(e->sig);              /* the signal of this event */
+                QS_OBJ_(me);                  /* this active object */
+                QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+                QS_EQC_(nFree);               /* number of free entries */
+            QS_END_NOCRIT_()
+        }
+        else {
+            eq->frontEvt = (QEvt const *)0; /* queue becomes empty */
+
+            /* all entries in the queue must be free (+1 for fronEvt) */
+            Q_ASSERT_CRIT_(310, nFree == (eq->end + (QEQueueCtr)1));
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_GET_LAST,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();                   /* timestamp */
+                QS_SIG_(e->sig);              /* the signal of this event */
+                QS_OBJ_(me);                  /* this active object */
+                QS_2U8_(e->poolId_, e->refCtr_); /* pool Id & ref Count */
+            QS_END_NOCRIT_()
+        }
     }
     QF_CRIT_EXIT_();
     return e;
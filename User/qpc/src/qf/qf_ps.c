@@ -54,6 +54,17 @@ Q_DEFINE_THIS_MODULE("qf_ps")
 QSubscrList *QF_subscrList_;
 enum_t QF_maxPubSignal_;
 
+#ifdef QF_PS_SPARSE
+/* Local objects ***********************************************************/
+static QSubscrEntry *l_subscrSto;  /* sparse table sorted by signal */
+static uint_fast16_t l_subscrMax;  /* capacity of the sparse table */
+static uint_fast16_t l_subscrLen;  /* entries in use in the sparse table */
+
+static uint_fast16_t QF_psIndex_(QSignal const sig);
+#endif /* QF_PS_SPARSE */
+
+#ifndef QF_PS_SPARSE
+
 /****************************************************************************/
 /**
 * @description
@@ -96,6 +107,87 @@ void QF_psInit(QSubscrList * const subscrSto, enum_t const maxSignal) {
                            * (uint_fast16_t)sizeof(QSubscrList)));
 }
 
+#else /* QF_PS_SPARSE */
+
+/****************************************************************************/
+/**
+* @description
+* This function initializes the publish-subscribe facilities of QF with
+* the sparse subscriber table (macro #QF_PS_SPARSE defined in qf_port.h).
+* It replaces QF_psInit() and must be called exactly once before any
+* subscriptions/publications occur in the application.
+*
+* @param[in] subscrSto storage for the sparse subscriber table
+* @param[in] stoLen    number of entries in @p subscrSto, which is the
+*                      maximum number of signals subscribed at the same time
+* @param[in] maxSignal the maximum signal that can be published or
+*                      subscribed (exclusive).
+*
+* @note
+* The dense array of QF_psInit() needs @p maxSignal * sizeof(QSubscrList)
+* bytes, while the sparse table needs @p stoLen * sizeof(QSubscrEntry)
+* bytes. Finding the subscribers in QF_publish_() costs a binary search
+* (O(log @p stoLen)) instead of an array access. Subscribing to a new signal
+* or dropping the last subscriber of a signal moves the entries above it.
+*/
+void QF_psInitSparse(QSubscrEntry * const subscrSto,
+                     uint_fast16_t const stoLen, enum_t const maxSignal)
+{
+    /** @pre the storage must be provided */
+    Q_REQUIRE_ID(110, (subscrSto != (QSubscrEntry *)0)
+                      && (stoLen > (uint_fast16_t)0));
+
+    l_subscrSto = subscrSto;
+    l_subscrMax = stoLen;
+    l_subscrLen = (uint_fast16_t)0;
+    QF_maxPubSignal_ = maxSignal;
+
+    QF_bzero(subscrSto,
+             (uint_fast16_t)(stoLen * (uint_fast16_t)sizeof(QSubscrEntry)));
+}
+
+/****************************************************************************/
+/* index of the first entry with signal >= @p sig (binary search) */
+static uint_fast16_t QF_psIndex_(QSignal const sig) {
+    uint_fast16_t lo = (uint_fast16_t)0;
+    uint_fast16_t hi = l_subscrLen;
+
+    while (lo < hi) {
+        uint_fast16_t mid = (uint_fast16_t)((lo + hi) >> 1);
+        if (QF_PTR_AT_(l_subscrSto, mid).sig < sig) {
+            lo = mid + (uint_fast16_t)1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/****************************************************************************/
+/**
+* @description
+* Returns a copy of the subscriber list of the signal @p sig, which is empty
+* when the signal has no subscribers.
+*
+* @note
+* Must be called inside a critical section (via the macro QF_SUBSCR_LIST_()).
+*/
+QSubscrList QF_psFindSparse_(QSignal const sig) {
+    QSubscrList set;
+    uint_fast16_t i = QF_psIndex_(sig);
+
+    if ((i < l_subscrLen) && (QF_PTR_AT_(l_subscrSto, i).sig == sig)) {
+        set = QF_PTR_AT_(l_subscrSto, i).set;
+    }
+    else {
+        QPSet_setEmpty(&set);
+    }
+    return set;
+}
+
+#endif /* QF_PS_SPARSE */
+
 /****************************************************************************/
 /**
 * @description
@@ -150,7 +242,7 @@ void QF_publish_(QEvt const * const e, void const * const sender)
     }
 
     /* make a local, modifiable copy of the subscriber list */
-    subscrList = QF_PTR_AT_(QF_subscrList_, e->sig);
+    subscrList = QF_SUBSCR_LIST_(e->sig);
     QF_CRIT_EXIT_();
 
     if (QPSet_notEmpty(&subscrList)) { /* any subscribers? */
@@ -221,8 +313,36 @@ void QActive_subscribe(QActive const * const me, enum_t const sig) {
         QS_OBJ_(me);            /* this active object */
     QS_END_NOCRIT_()
 
+#ifndef QF_PS_SPARSE
     /* set the priority bit */
     QPSet_insert(&QF_PTR_AT_(QF_subscrList_, sig), p);
+#else
+    {
+        uint_fast16_t i = QF_psIndex_((QSignal)sig);
+
+        /* signal without subscribers so far? */
+        if ((i == l_subscrLen)
+            || (QF_PTR_AT_(l_subscrSto, i).sig != (QSignal)sig))
+        {
+            uint_fast16_t n;
+
+            /* the sparse table must not overflow */
+            Q_ASSERT_CRIT_(310, l_subscrLen < l_subscrMax);
+
+            /* make room for the new entry, keeping the table sorted */
+            for (n = l_subscrLen; n > i; --n) {
+                QF_PTR_AT_(l_subscrSto, n) =
+                    QF_PTR_AT_(l_subscrSto, n - (uint_fast16_t)1);
+            }
+            QF_PTR_AT_(l_subscrSto, i).sig = (QSignal)sig;
+            QPSet_setEmpty(&QF_PTR_AT_(l_subscrSto, i).set);
+            ++l_subscrLen;
+        }
+
+        /* set the priority bit */
+        QPSet_insert(&QF_PTR_AT_(l_subscrSto, i).set, p);
+    }
+#endif /* QF_PS_SPARSE */
 
     QF_CRIT_EXIT_();
 }
@@ -272,8 +392,30 @@ void QActive_unsubscribe(QActive const * const me, enum_t const sig) {
         QS_OBJ_(me);            /* this active object */
     QS_END_NOCRIT_()
 
+#ifndef QF_PS_SPARSE
     /* clear priority bit */
     QPSet_remove(&QF_PTR_AT_(QF_subscrList_, sig), p);
+#else
+    {
+        uint_fast16_t i = QF_psIndex_((QSignal)sig);
+
+        if ((i < l_subscrLen)
+            && (QF_PTR_AT_(l_subscrSto, i).sig == (QSignal)sig))
+        {
+            /* clear priority bit */
+            QPSet_remove(&QF_PTR_AT_(l_subscrSto, i).set, p);
+
+            /* the last subscriber gone? drop the entry */
+            if (QPSet_isEmpty(&QF_PTR_AT_(l_subscrSto, i).set)) {
+                --l_subscrLen;
+                for (; i < l_subscrLen; ++i) {
+                    QF_PTR_AT_(l_subscrSto, i) =
+                        QF_PTR_AT_(l_subscrSto, i + (uint_fast16_t)1);
+                }
+            }
+        }
+    }
+#endif /* QF_PS_SPARSE */
 
     QF_CRIT_EXIT_();
 }
@@ -303,12 +445,45 @@ void QActive_unsubscribe(QActive const * const me, enum_t const sig) {
 */
 void QActive_unsubscribeAll(QActive const * const me) {
     uint_fast8_t p = (uint_fast8_t)me->prio;
+#ifndef QF_PS_SPARSE
     enum_t sig;
+#else
+    uint_fast16_t i;
+    uint_fast16_t n;
+    QF_CRIT_STAT_
+#endif
 
     Q_REQUIRE_ID(500, ((uint_fast8_t)0 < p)
                         && (p <= (uint_fast8_t)QF_MAX_ACTIVE)
                         && (QF_active_[p] == me));
 
+#ifdef QF_PS_SPARSE
+    /* one pass over the subscribed signals only, compacting the table
+    * in place (the entries left without subscribers are dropped)
+    */
+    QF_CRIT_ENTRY_();
+    n = (uint_fast16_t)0;
+    for (i = (uint_fast16_t)0; i < l_subscrLen; ++i) {
+        if (QPSet_hasElement(&QF_PTR_AT_(l_subscrSto, i).set, p)) {
+            QPSet_remove(&QF_PTR_AT_(l_subscrSto, i).set, p);
+
+            QS_BEGIN_NOCRIT_(QS_QF_ACTIVE_UNSUBSCRIBE,
+                             QS_priv_.locFilter[AO_OBJ], me)
+                QS_TIME_();            /* timestamp */
+                QS_SIG_(QF_PTR_AT_(l_subscrSto, i).sig); /* the signal */
+                QS_OBJ_(me);           /* this active object */
+            QS_END_NOCRIT_()
+        }
+        if (QPSet_notEmpty(&QF_PTR_AT_(l_subscrSto, i).set)) {
+            if (n != i) {
+                QF_PTR_AT_(l_subscrSto, n) = QF_PTR_AT_(l_subscrSto, i);
+            }
+            ++n;
+        }
+    }
+    l_subscrLen = n;
+    QF_CRIT_EXIT_();
+#else
     for (sig = (enum_t)Q_USER_SIG; sig < QF_maxPubSignal_; ++sig) {
         QF_CRIT_STAT_
         QF_CRIT_ENTRY_();
@@ -327,5 +502,6 @@ void QActive_unsubscribeAll(QActive const * const me) {
         /* prevent merging critical sections */
         QF_CRIT_EXIT_NOP();
     }
+#endif /* QF_PS_SPARSE */
 }
 
@@ -137,6 +137,9 @@ QEvt const *QActive_get_(QActive *const me);
 /*! Implementation of the active object post LIFO operation */
 void QActive_postLIFO_(QActive * const me, QEvt const * const e);
 
+/*! Replace the waiting event with the same signal in the AO queue */
+QEvt const *QActive_coalesce_(QActive * const me, QEvt const * const e);
+
 
 /****************************************************************************/
 /*! heads of linked lists of time events, one for every clock tick rate */
@@ -158,6 +161,16 @@ extern uint_fast8_t QF_maxPool_;     /*!< # of initialized event pools */
 extern QSubscrList *QF_subscrList_;  /*!< the subscriber list array */
 extern enum_t QF_maxPubSignal_;      /*!< the maximum published signal */
 
+#ifndef QF_PS_SPARSE
+    /*! the subscriber list of signal @p sig_ (inside critical section) */
+    #define QF_SUBSCR_LIST_(sig_)   (QF_PTR_AT_(QF_subscrList_, (sig_)))
+#else
+    #define QF_SUBSCR_LIST_(sig_)   (QF_psFindSparse_((QSignal)(sig_)))
+
+    /*! look up the subscribers in the sparse table (inside crit. section) */
+    QSubscrList QF_psFindSparse_(QSignal const sig);
+#endif
+
 /*! structure representing a free block in the Native QF Memory Pool */
 typedef struct QFreeBlock {
     struct QFreeBlock * volatile next;
@@ -121,6 +121,9 @@ int_t QF_run(void) {
         QEvt const *e;
         QActive *a;
         uint_fast8_t p;
+#ifdef QV_DISPATCH_BATCH
+        uint_fast8_t n;
+#endif
 
         /* find the maximum priority AO ready to run */
         if (QPSet_notEmpty(&QV_readySet_)) {
@@ -145,9 +148,25 @@ int_t QF_run(void) {
             * 2. dispatch the event to the AO's state machine.
             * 3. determine if event is garbage and collect it if so
             */
+#ifdef QV_DISPATCH_BATCH
+            /* dispatch a batch of events of this AO, see qf_port.h.
+            * frontEvt is read outside of the critical section: interrupts
+            * only add events and only this loop takes them out, so a
+            * non-NULL front still holds when QActive_get_() runs.
+            */
+            n = (uint_fast8_t)QV_DISPATCH_BATCH;
+            do {
+                e = QActive_get_(a);
+                QHSM_DISPATCH(&a->super, e);
+                QF_gc(e);
+                --n;
+            } while ((n != (uint_fast8_t)0)
+                     && (a->eQueue.frontEvt != (QEvt const *)0));
+#else
             e = QActive_get_(a);
             QHSM_DISPATCH(&a->super, e);
             QF_gc(e);
+#endif /* QV_DISPATCH_BATCH */
 
             QF_INT_DISABLE();
 
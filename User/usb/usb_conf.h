@@ -0,0 +1,41 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _USB_CONF_H
+#define _USB_CONF_H
+
+/*
+ * configuration of the STM32 USB-FS device library for the CDC stream:
+ * endpoint 0 control, 1 stream IN, 2 stream OUT, 3 CDC notification IN.
+ */
+#define EP_NUM				4
+
+/* packet memory, 512 bytes:
+ * 0x000 buffer table, 8 bytes per endpoint
+ * 0x040 endpoint 0 RX, 0x080 endpoint 0 TX, 64 bytes each
+ * 0x0C0 endpoint 3 TX, 8 bytes
+ * 0x100 the double buffers of the stream, see bsp_usb_stream.h
+ */
+#define BTABLE_ADDRESS		0x00
+#define ENDP0_RXADDR		0x40
+#define ENDP0_TXADDR		0x80
+#define ENDP3_TXADDR		0xC0
+
+#define USB_EP0_MAX_PACKET	64
+#define USB_EP3_MAX_PACKET	8
+
+/* endpoint 0 data saved by CTR_LP_Capture(), one packet. */
+#define CTR_EVENT_RX_SIZE	USB_EP0_MAX_PACKET
+
+/* correct transfer and reset only, suspend is not handled: the device
+ * keeps running while the bus is suspended.
+ */
+#define IMR_MSK				( CNTR_CTRM | CNTR_RESETM )
+
+#endif /* _USB_CONF_H */
@@ -0,0 +1,101 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "usb_conf.h"
+
+#include "bsp_usb_stream.h"
+#include "usb_desc.h"
+
+/*
+ * a CDC ACM device, so the stream shows up as a serial port without a
+ * driver. the line coding is accepted and ignored, the data interface
+ * carries the stream endpoints.
+ */
+
+const uint8_t usb_device_desc[ USB_DEVICE_DESC_SIZE ] =
+{
+	18,							/* bLength */
+	0x01,						/* bDescriptorType: device */
+	0x00, 0x02,					/* bcdUSB 2.00 */
+	0x02,						/* bDeviceClass: CDC */
+	0x00,						/* bDeviceSubClass */
+	0x00,						/* bDeviceProtocol */
+	USB_EP0_MAX_PACKET,			/* bMaxPacketSize0 */
+	0x83, 0x04,					/* idVendor 0x0483 */
+	0x40, 0x57,					/* idProduct 0x5740, the ST virtual COM port */
+	0x00, 0x02,					/* bcdDevice 2.00 */
+	1,							/* iManufacturer */
+	2,							/* iProduct */
+	3,							/* iSerialNumber */
+	1,							/* bNumConfigurations */
+};
+
+const uint8_t usb_config_desc[ USB_CONFIG_DESC_SIZE ] =
+{
+	9,							/* bLength */
+	0x02,						/* bDescriptorType: configuration */
+	USB_CONFIG_DESC_SIZE, 0x00,	/* wTotalLength */
+	2,							/* bNumInterfaces */
+	1,							/* bConfigurationValue */
+	0,							/* iConfiguration */
+	0x80,						/* bmAttributes: bus powered */
+	50,							/* bMaxPower: 100mA */
+
+	/* interface 0: communication class */
+	9, 0x04, 0, 0, 1,			/* bLength, interface, number, alternate, endpoints */
+	0x02, 0x02, 0x01, 0,		/* CDC, abstract control model, AT commands, iInterface */
+
+	5, 0x24, 0x00, 0x10, 0x01,	/* header functional descriptor, CDC 1.10 */
+	5, 0x24, 0x01, 0x00, 1,		/* call management, data interface 1 */
+	4, 0x24, 0x02, 0x02,		/* ACM: line coding and control line state */
+	5, 0x24, 0x06, 0, 1,		/* union: master 0, slave 1 */
+
+	7, 0x05, 0x83, 0x03,		/* endpoint 3 IN, interrupt */
+	USB_EP3_MAX_PACKET, 0x00, 0xFF,
+
+	/* interface 1: data class */
+	9, 0x04, 1, 0, 2,
+	0x0A, 0x00, 0x00, 0,
+
+	7, 0x05, USB_STREAM_OUT_EP, 0x02,			/* stream OUT, bulk */
+	USB_STREAM_MAX_PACKET, 0x00, 0,
+	7, 0x05, 0x80 | USB_STREAM_IN_EP, 0x02,		/* stream IN, bulk */
+	USB_STREAM_MAX_PACKET, 0x00, 0,
+};
+
+static const uint8_t usb_string_lang[] =
+{
+	4, 0x03, 0x09, 0x04,		/* US english */
+};
+
+static const uint8_t usb_string_vendor[] =
+{
+	18, 0x03,
+	's', 0, 'u', 0, 'o', 0, 'z', 0, 'h', 0, 'a', 0, 'n', 0, 'g', 0,
+};
+
+static const uint8_t usb_string_product[] =
+{
+	26, 0x03,
+	'S', 0, 'T', 0, 'M', 0, '3', 0, '2', 0, ' ', 0,
+	'S', 0, 't', 0, 'r', 0, 'e', 0, 'a', 0, 'm', 0,
+};
+
+static const uint8_t usb_string_serial[] =
+{
+	10, 0x03,
+	'0', 0, '0', 0, '0', 0, '1', 0,
+};
+
+const uint8_t * const usb_string_desc[ USB_STRING_DESC_NUM ] =
+{
+	usb_string_lang,
+	usb_string_vendor,
+	usb_string_product,
+	usb_string_serial,
+};
@@ -0,0 +1,23 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _USB_DESC_H
+#define _USB_DESC_H
+
+#include <stdint.h>
+
+#define USB_DEVICE_DESC_SIZE	18
+#define USB_CONFIG_DESC_SIZE	67
+#define USB_STRING_DESC_NUM		4	/* language, vendor, product, serial */
+
+extern const uint8_t usb_device_desc[ USB_DEVICE_DESC_SIZE ];
+extern const uint8_t usb_config_desc[ USB_CONFIG_DESC_SIZE ];
+extern const uint8_t * const usb_string_desc[ USB_STRING_DESC_NUM ];
+
+#endif /* _USB_DESC_H */
@@ -0,0 +1,65 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "usb_lib.h"
+
+#include "usb_istr.h"
+#include "usb_hw.h"
+
+/*
+ * only the low priority line is used: it fires for every event, the
+ * correct transfers of the double buffered stream endpoints included.
+ * the high priority line would add a second handler that preempts nothing
+ * (same priority) and CTR_HP() does not know endpoint 0.
+ */
+
+/**
+ * clock the USB peripheral and start the device library, the active
+ * object behind USB_Istr() must have been started.
+ */
+void usb_hw_init( void )
+{
+	NVIC_InitTypeDef NVIC_InitStructure;
+
+	/* 72MHz PLL / 1.5 = 48MHz */
+	RCC_USBCLKConfig( RCC_USBCLKSource_PLLCLK_1Div5 );
+	RCC_APB1PeriphClockCmd( RCC_APB1Periph_USB, ENABLE );
+
+	NVIC_InitStructure.NVIC_IRQChannel = USB_LP_CAN1_RX0_IRQn;
+	NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = USB_HW_IRQ_PRIO;
+	NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+	NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init( &NVIC_InitStructure );
+
+	USB_Init();
+}
+
+/**
+ * keep the USB interrupt out, the other interrupts and tasks still run.
+ * the barriers make sure it is masked before the next register access.
+ */
+void usb_hw_irq_mask( void )
+{
+	NVIC_DisableIRQ( USB_LP_CAN1_RX0_IRQn );
+	__DSB();
+	__ISB();
+}
+
+void usb_hw_irq_unmask( void )
+{
+	NVIC_EnableIRQ( USB_LP_CAN1_RX0_IRQn );
+}
+
+#if BSP_USB_DEVICE
+
+void USB_LP_CAN1_RX0_IRQHandler( void )
+{
+	USB_Istr();
+}
+
+#endif /* BSP_USB_DEVICE */
@@ -0,0 +1,28 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _USB_HW_H
+#define _USB_HW_H
+
+#include "stm32f10x.h"
+
+/* must not be above configMAX_SYSCALL_INTERRUPT_PRIORITY (5). */
+#define USB_HW_IRQ_PRIO		6
+
+/* D+ has a fixed 1.5k pull-up on the board, the device attaches as soon
+ * as it is powered and answers the bus reset after usb_hw_init().
+ */
+
+void usb_hw_init( void );
+
+/* for the read-modify-write of endpoint registers at task level. */
+void usb_hw_irq_mask( void );
+void usb_hw_irq_unmask( void );
+
+#endif /* _USB_HW_H */
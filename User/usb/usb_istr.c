@@ -0,0 +1,61 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "usb_lib.h"
+
+#include "bsp_usb_stream.h"
+#include "usb_ao.h"
+#include "usb_istr.h"
+
+/* the callback tables below are indexed by endpoint - 1 */
+Q_ASSERT_COMPILE( USB_STREAM_IN_EP == 1 && USB_STREAM_OUT_EP == 2 );
+
+__IO uint16_t wIstr;	/* ISTR register last read value */
+
+void (*pEpInt_IN[7])(void) =
+{
+	bsp_usb_stream_in_callback,		/* 1 stream IN */
+	NOP_Process,
+	NOP_Process,					/* 3 CDC notification, never sent */
+	NOP_Process,
+	NOP_Process,
+	NOP_Process,
+	NOP_Process,
+};
+
+void (*pEpInt_OUT[7])(void) =
+{
+	NOP_Process,
+	bsp_usb_stream_out_callback,	/* 2 stream OUT */
+	NOP_Process,
+	NOP_Process,
+	NOP_Process,
+	NOP_Process,
+	NOP_Process,
+};
+
+/**
+ * USB_LP_CAN1_RX0 interrupt, the bus reset and the control transfers
+ * go to the usb active object, the stream endpoints are serviced here.
+ */
+void USB_Istr( void )
+{
+	wIstr = _GetISTR();
+
+	if( wIstr & ISTR_CTR & wInterrupt_Mask )
+	{
+		/* clears the endpoint flags, ISTR_CTR follows them */
+		usb_ao_ctr_isr();
+	}
+
+	if( wIstr & ISTR_RESET & wInterrupt_Mask )
+	{
+		_SetISTR( (uint16_t)CLR_RESET );
+		usb_ao_reset_isr();
+	}
+}
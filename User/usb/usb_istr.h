@@ -0,0 +1,15 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _USB_ISTR_H
+#define _USB_ISTR_H
+
+void USB_Istr( void );
+
+#endif /* _USB_ISTR_H */
@@ -0,0 +1,216 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+#include "usb_lib.h"
+
+#include "bsp_usb_stream.h"
+#include "usb_desc.h"
+#include "usb_prop.h"
+
+/*
+ * the device callbacks of the library. Reset() and the requests run in
+ * the usb active object, Init() from usb_hw_init().
+ */
+
+/* 115200 8N1, only kept to be read back, the stream has no baud rate */
+static uint8_t usb_line_coding[ 7 ] = { 0x00, 0xC2, 0x01, 0x00, 0x00, 0x00, 0x08 };
+
+static void usb_prop_init( void );
+static void usb_prop_reset( void );
+static RESULT usb_prop_data_setup( uint8_t request );
+static RESULT usb_prop_nodata_setup( uint8_t request );
+static RESULT usb_prop_get_interface_setting( uint8_t interface, uint8_t alternate );
+static uint8_t *usb_prop_get_device_desc( uint16_t length );
+static uint8_t *usb_prop_get_config_desc( uint16_t length );
+static uint8_t *usb_prop_get_string_desc( uint16_t length );
+
+DEVICE Device_Table =
+{
+	EP_NUM,
+	1
+};
+
+DEVICE_PROP Device_Property =
+{
+	usb_prop_init,
+	usb_prop_reset,
+	NOP_Process,
+	NOP_Process,
+	usb_prop_data_setup,
+	usb_prop_nodata_setup,
+	usb_prop_get_interface_setting,
+	usb_prop_get_device_desc,
+	usb_prop_get_config_desc,
+	usb_prop_get_string_desc,
+	0,
+	USB_EP0_MAX_PACKET
+};
+
+USER_STANDARD_REQUESTS User_Standard_Requests =
+{
+	NOP_Process,	/* GetConfiguration */
+	NOP_Process,	/* SetConfiguration */
+	NOP_Process,	/* GetInterface */
+	NOP_Process,	/* SetInterface */
+	NOP_Process,	/* GetStatus */
+	NOP_Process,	/* ClearFeature */
+	NOP_Process,	/* SetEndPointFeature */
+	NOP_Process,	/* SetDeviceFeature */
+	NOP_Process		/* SetDeviceAddress */
+};
+
+static ONE_DESCRIPTOR usb_device_descriptor =
+{
+	(uint8_t *)usb_device_desc,
+	USB_DEVICE_DESC_SIZE
+};
+
+static ONE_DESCRIPTOR usb_config_descriptor =
+{
+	(uint8_t *)usb_config_desc,
+	USB_CONFIG_DESC_SIZE
+};
+
+static void usb_prop_init( void )
+{
+	pInformation->Current_Configuration = 0;
+
+	/* out of power down, then release the reset as PowerOn() of the
+	 * reference examples does
+	 */
+	_SetCNTR( CNTR_FRES );
+	_SetCNTR( 0 );
+
+	/* ISTR = 0, CNTR = IMR_MSK */
+	USB_SIL_Init();
+}
+
+static void usb_prop_reset( void )
+{
+	pInformation->Current_Configuration = 0;
+	pInformation->Current_Feature = usb_config_desc[ 7 ];
+	pInformation->Current_Interface = 0;
+
+	SetBTABLE( BTABLE_ADDRESS );
+
+	SetEPType( ENDP0, EP_CONTROL );
+	SetEPTxStatus( ENDP0, EP_TX_STALL );
+	SetEPRxAddr( ENDP0, ENDP0_RXADDR );
+	SetEPTxAddr( ENDP0, ENDP0_TXADDR );
+	Clear_Status_Out( ENDP0 );
+	SetEPRxCount( ENDP0, USB_EP0_MAX_PACKET );
+	SetEPRxValid( ENDP0 );
+
+	/* the notification endpoint never has anything to send */
+	SetEPType( ENDP3, EP_INTERRUPT );
+	SetEPTxAddr( ENDP3, ENDP3_TXADDR );
+	SetEPRxStatus( ENDP3, EP_RX_DIS );
+	SetEPTxStatus( ENDP3, EP_TX_NAK );
+
+	bsp_usb_stream_reset();
+
+	SetDeviceAddress( 0 );
+}
+
+static uint8_t *usb_prop_line_coding_in( uint16_t length )
+{
+	if( 0 == length )
+	{
+		pInformation->Ctrl_Info.Usb_wLength = sizeof( usb_line_coding );
+		return NULL;
+	}
+
+	return usb_line_coding;
+}
+
+static uint8_t *usb_prop_line_coding_out( uint16_t length )
+{
+	if( 0 == length )
+	{
+		pInformation->Ctrl_Info.Usb_rLength = sizeof( usb_line_coding );
+		return NULL;
+	}
+
+	return usb_line_coding;
+}
+
+static RESULT usb_prop_data_setup( uint8_t request )
+{
+	uint8_t *( *copy )( uint16_t ) = NULL;
+
+	if( Type_Recipient == ( CLASS_REQUEST | INTERFACE_RECIPIENT ) )
+	{
+		if( USB_CDC_GET_LINE_CODING == request )
+		{
+			copy = usb_prop_line_coding_in;
+		}
+		else if( USB_CDC_SET_LINE_CODING == request )
+		{
+			copy = usb_prop_line_coding_out;
+		}
+	}
+
+	if( NULL == copy )
+	{
+		return USB_UNSUPPORT;
+	}
+
+	pInformation->Ctrl_Info.CopyData = copy;
+	pInformation->Ctrl_Info.Usb_wOffset = 0;
+	pInformation->Ctrl_Info.Usb_rOffset = 0;
+	( *copy )( 0 );
+
+	return USB_SUCCESS;
+}
+
+static RESULT usb_prop_nodata_setup( uint8_t request )
+{
+	if( Type_Recipient == ( CLASS_REQUEST | INTERFACE_RECIPIENT ) &&
+		( USB_CDC_SET_CONTROL_LINE_STATE == request || USB_CDC_SEND_BREAK == request ) )
+	{
+		return USB_SUCCESS;
+	}
+
+	return USB_UNSUPPORT;
+}
+
+static RESULT usb_prop_get_interface_setting( uint8_t interface, uint8_t alternate )
+{
+	if( alternate > 0 || interface > 1 )
+	{
+		return USB_UNSUPPORT;
+	}
+
+	return USB_SUCCESS;
+}
+
+static uint8_t *usb_prop_get_device_desc( uint16_t length )
+{
+	return Standard_GetDescriptorData( length, &usb_device_descriptor );
+}
+
+static uint8_t *usb_prop_get_config_desc( uint16_t length )
+{
+	return Standard_GetDescriptorData( length, &usb_config_descriptor );
+}
+
+static uint8_t *usb_prop_get_string_desc( uint16_t length )
+{
+	ONE_DESCRIPTOR desc;
+	uint8_t index = pInformation->USBwValue0;
+
+	if( index >= USB_STRING_DESC_NUM )
+	{
+		return NULL;
+	}
+
+	desc.Descriptor = (uint8_t *)usb_string_desc[ index ];
+	desc.Descriptor_Size = usb_string_desc[ index ][ 0 ];
+
+	return Standard_GetDescriptorData( length, &desc );
+}
@@ -0,0 +1,23 @@
+/*
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2019-6-11     suozhang      the first version
+ *
+ */
+
+
+#ifndef _USB_PROP_H
+#define _USB_PROP_H
+
+/* CDC class requests */
+#define USB_CDC_SET_LINE_CODING			0x20
+#define USB_CDC_GET_LINE_CODING			0x21
+#define USB_CDC_SET_CONTROL_LINE_STATE	0x22
+#define USB_CDC_SEND_BREAK				0x23
+
+/* Device_Property, User_Standard_Requests and Device_Table are the
+ * entries of the device library, declared in usb_core.h.
+ */
+
+#endif /* _USB_PROP_H */